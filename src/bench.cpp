@@ -0,0 +1,407 @@
+// Benchmarks of the hot paths on synthetic meshes of increasing size and with increasing numbers of threads, results
+// are printed as a table and written as JSON, so runs on different commits can be compared to catch regressions
+//
+// Usage: geobox_bench [--sizes 1000,10000,...] [--threads 1,2,...] [--filter name] [--min-time seconds]
+//                     [--mesh Torus|Sphere|Terrain|Slivers|Soup] [--output file.json]
+
+#include <algorithm> // for std::sort, std::min and std::max
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio> // for std::remove
+#include <filesystem>
+#include <fstream>
+#include <functional> // for std::function
+#include <iomanip>    // for std::setw and std::setprecision
+#include <iostream>
+#include <limits>
+#include <memory> // for std::shared_ptr
+#include <optional>
+#include <sstream> // for std::istringstream
+#include <string>
+#include <thread>
+#include <utility> // for std::move
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "indexed_triangle_mesh.hpp"
+#include "intersection.hpp"
+#include "math.hpp"
+#include "mesh_generators.hpp"
+#include "parallel.hpp"
+#include "primitives.hpp"
+#include "ray.hpp"
+#include "ray_aabb_intersection.hpp"
+#include "read_stl.hpp"
+#include "sampling.hpp"
+#include "task_scheduler.hpp"
+#include "vertex_welder.hpp"
+#include "write_mesh.hpp"
+
+constexpr size_t DEFAULT_BENCH_SIZES[] = {1000, 10000, 100000, 1000000, 10000000};
+// ASCII files of larger meshes take gigabytes of disk
+constexpr size_t MAX_ASCII_STL_BENCH_TRIANGLES = 1000000;
+constexpr double DEFAULT_BENCH_MIN_TIME_SECONDS = 0.5;
+constexpr size_t MAX_BENCH_REPETITIONS = 20;
+constexpr size_t NUM_BENCH_RAYS = 1000;
+constexpr size_t NUM_BENCH_SURFACE_POINTS = 1 << 20;
+constexpr size_t NUM_BENCH_VOLUME_POINTS = 1 << 12;
+constexpr size_t NUM_BENCH_VOLUME_RAYS = 5;
+constexpr uint64_t BENCH_SEED = 1;
+
+namespace {
+struct Bench_Settings {
+  std::vector<size_t> sizes;
+  std::vector<size_t> thread_counts;
+  std::string filter;
+  double min_time_seconds = DEFAULT_BENCH_MIN_TIME_SECONDS;
+  Mesh_Generator_Type mesh_type = Mesh_Generator_Type::Torus;
+  std::string output_file_path = "geobox_bench_results.json";
+};
+
+struct Bench_Result {
+  std::string name;
+  size_t num_triangles;
+  size_t num_threads;
+  size_t num_repetitions;
+  double min_seconds;
+  double median_seconds;
+  // Items processed per repetition, e.g. triangles or rays
+  size_t num_items;
+};
+
+// Everything a benchmark of one mesh size needs, created once per size
+struct Bench_Mesh {
+  Indexed_Triangle_Mesh mesh;
+  std::vector<Triangle> triangles;
+  std::vector<AABB> triangle_bounding_boxes;
+  std::vector<glm::vec3> triangle_normals;
+  std::vector<float> triangle_areas;
+  std::shared_ptr<BVH> triangles_bvh;
+  std::vector<Ray> rays;
+  std::string binary_stl_file_path;
+  std::string ascii_stl_file_path;
+};
+
+struct Bench {
+  const char *name;
+  // Serial benchmarks only run once, with a single thread
+  bool is_parallel;
+  // Returns the number of items processed
+  std::function<size_t(const Bench_Mesh &)> run;
+};
+} // namespace
+
+[[nodiscard]] static Bench_Mesh create_bench_mesh(Mesh_Generator_Type mesh_type, size_t num_triangles) {
+  Bench_Mesh bench_mesh;
+  bench_mesh.mesh = generate_mesh(mesh_type, num_triangles, BENCH_SEED);
+  const std::vector<glm::vec3> &vertices = bench_mesh.mesh.vertices;
+  const std::vector<unsigned int> &indices = bench_mesh.mesh.indices;
+  size_t num_mesh_triangles = indices.size() / 3;
+  bench_mesh.triangles.resize(num_mesh_triangles);
+  bench_mesh.triangle_bounding_boxes.resize(num_mesh_triangles);
+  bench_mesh.triangle_normals.resize(num_mesh_triangles);
+  bench_mesh.triangle_areas.resize(num_mesh_triangles);
+  for (size_t i = 0; i < num_mesh_triangles; i++) {
+    Triangle t{vertices[indices[i * 3 + 0]], vertices[indices[i * 3 + 1]], vertices[indices[i * 3 + 2]]};
+    bench_mesh.triangles[i] = t;
+    bench_mesh.triangle_bounding_boxes[i] = {glm::min(t.m_a, glm::min(t.m_b, t.m_c)),
+                                             glm::max(t.m_a, glm::max(t.m_b, t.m_c))};
+    glm::vec3 cross = glm::cross(t.m_b - t.m_a, t.m_c - t.m_a);
+    bench_mesh.triangle_areas[i] = glm::length(cross) * 0.5f;
+    bench_mesh.triangle_normals[i] = glm::normalize(cross);
+  }
+  bench_mesh.triangles_bvh = std::make_shared<BVH>(bench_mesh.triangle_bounding_boxes);
+
+  // Rays from points in the bounding box, so most of them hit the torus
+  std::vector<glm::vec3> directions = sample_directions(NUM_BENCH_RAYS, BENCH_SEED);
+  std::vector<glm::vec3> origins = sample_directions(NUM_BENCH_RAYS, BENCH_SEED + 1);
+  for (size_t i = 0; i < NUM_BENCH_RAYS; i++) {
+    bench_mesh.rays.push_back({origins[i] * glm::vec3(1.2f, 1.2f, 0.3f), directions[i]});
+  }
+
+  std::filesystem::path directory = std::filesystem::temp_directory_path();
+  std::string file_name = "geobox_bench_" + std::to_string(num_triangles);
+  bench_mesh.binary_stl_file_path = (directory / (file_name + "_binary.stl")).string();
+  if (!write_stl_mesh_file_binary(bench_mesh.binary_stl_file_path, bench_mesh.mesh)) {
+    bench_mesh.binary_stl_file_path.clear();
+  }
+  if (num_triangles <= MAX_ASCII_STL_BENCH_TRIANGLES) {
+    bench_mesh.ascii_stl_file_path = (directory / (file_name + "_ascii.stl")).string();
+    if (!write_stl_mesh_file_ascii(bench_mesh.ascii_stl_file_path, bench_mesh.mesh)) {
+      bench_mesh.ascii_stl_file_path.clear();
+    }
+  }
+  return bench_mesh;
+}
+
+// Closest triangle hit by the ray, the traversal used by volume sampling and picking
+[[nodiscard]] static std::optional<float> find_closest_hit(const Bench_Mesh &bench_mesh, const Ray &ray) {
+  std::optional<float> closest_hit;
+  const Tolerance_Context tc = TC::get_default();
+  bench_mesh.triangles_bvh->foreach_primitive(
+      [&](unsigned int i) {
+        std::optional<glm::vec3> p =
+            intersect(tc, bench_mesh.triangles[i], {ray.origin, ray.origin + 100.0f * ray.direction});
+        if (!p.has_value()) return;
+        float t = glm::dot(p.value() - ray.origin, ray.direction);
+        if (!closest_hit.has_value() || t < closest_hit.value()) closest_hit = t;
+      },
+      [&ray](const AABB &aabb) {
+        bool is_origin_inside = glm::all(glm::greaterThanEqual(ray.origin, aabb.min)) &&
+                                glm::all(glm::lessThanEqual(ray.origin, aabb.max));
+        return is_origin_inside || ray_aabb_intersection(ray, aabb).has_value();
+      },
+      [](unsigned int) { return true; });
+  return closest_hit;
+}
+
+// Stores a result of a kernel, so the optimizer can not remove the work being timed
+static void keep_result(size_t value) {
+  static std::atomic<size_t> sink;
+  sink.store(value, std::memory_order_relaxed);
+}
+
+[[nodiscard]] static std::vector<Bench> create_benches() {
+  return {
+      {"stl_read_binary", true,
+       [](const Bench_Mesh &m) {
+         if (m.binary_stl_file_path.empty()) return size_t(0);
+         return read_stl_mesh_file(m.binary_stl_file_path).value_or(std::vector<Triangle>{}).size();
+       }},
+      {"stl_read_ascii", true,
+       [](const Bench_Mesh &m) {
+         if (m.ascii_stl_file_path.empty()) return size_t(0);
+         return read_stl_mesh_file(m.ascii_stl_file_path).value_or(std::vector<Triangle>{}).size();
+       }},
+      {"stl_read_binary_welded", true,
+       [](const Bench_Mesh &m) {
+         if (m.binary_stl_file_path.empty()) return size_t(0);
+         std::optional<Indexed_Triangle_Mesh> mesh = read_stl_mesh_file_welded(m.binary_stl_file_path);
+         return mesh.has_value() ? mesh->indices.size() / 3 : size_t(0);
+       }},
+      {"weld", false,
+       [](const Bench_Mesh &m) {
+         Vertex_Welder welder;
+         welder.reserve(m.triangles.size());
+         for (const Triangle &triangle : m.triangles) {
+           welder.add_triangle(triangle);
+         }
+         return welder.finish().indices.size() / 3;
+       }},
+      {"bvh_build", true,
+       [](const Bench_Mesh &m) {
+         BVH bvh(m.triangle_bounding_boxes);
+         return bvh.get_primitive_indices().size();
+       }},
+      {"bvh_refit", false,
+       [](const Bench_Mesh &m) {
+         BVH bvh(m.triangles_bvh->get_nodes(), m.triangles_bvh->get_primitive_indices());
+         bvh.refit(m.triangle_bounding_boxes);
+         return bvh.get_primitive_indices().size();
+       }},
+      {"bvh_restore", false,
+       [](const Bench_Mesh &m) {
+         BVH bvh(m.triangles_bvh->get_nodes(), m.triangles_bvh->get_primitive_indices());
+         return bvh.get_primitive_indices().size();
+       }},
+      {"ray_aabb_kernel", false,
+       [](const Bench_Mesh &m) {
+         size_t num_hits = 0;
+         for (size_t i = 0; i < m.triangle_bounding_boxes.size(); i++) {
+           if (ray_aabb_intersection(m.rays[i % m.rays.size()], m.triangle_bounding_boxes[i]).has_value()) num_hits++;
+         }
+         keep_result(num_hits);
+         return m.triangle_bounding_boxes.size();
+       }},
+      {"ray_triangle_kernel", false,
+       [](const Bench_Mesh &m) {
+         const Tolerance_Context tc = TC::get_default();
+         size_t num_hits = 0;
+         for (size_t i = 0; i < m.triangles.size(); i++) {
+           const Ray &ray = m.rays[i % m.rays.size()];
+           if (intersect(tc, m.triangles[i], {ray.origin, ray.origin + 100.0f * ray.direction}).has_value()) {
+             num_hits++;
+           }
+         }
+         keep_result(num_hits);
+         return m.triangles.size();
+       }},
+      {"closest_hit", true,
+       [](const Bench_Mesh &m) {
+         std::vector<unsigned char> is_hit(m.rays.size());
+         parallel_for(0, m.rays.size(), 256, [&](size_t begin, size_t end) {
+           for (size_t i = begin; i < end; i++) {
+             is_hit[i] = find_closest_hit(m, m.rays[i]).has_value();
+           }
+         });
+         keep_result(is_hit.size());
+         return m.rays.size();
+       }},
+      {"sample_surface", true,
+       [](const Bench_Mesh &m) {
+         return sample_points_on_surface(m.mesh.vertices, m.mesh.indices, m.triangle_areas, NUM_BENCH_SURFACE_POINTS,
+                                         BENCH_SEED)
+             .size();
+       }},
+      {"sample_volume", true,
+       [](const Bench_Mesh &m) {
+         std::vector<glm::vec3> directions = sample_directions(NUM_BENCH_VOLUME_RAYS, BENCH_SEED);
+         std::vector<glm::vec3> points =
+             sample_points_in_volume(m.mesh.vertices, m.mesh.indices, m.triangle_normals, *m.triangles_bvh,
+                                     NUM_BENCH_VOLUME_POINTS, directions, BENCH_SEED);
+         keep_result(points.size());
+         return NUM_BENCH_VOLUME_POINTS;
+       }},
+  };
+}
+
+// Repeats the benchmark until it ran for the minimum time, with at least one and at most MAX_BENCH_REPETITIONS
+// repetitions, the first repetition counts too, so large meshes are not processed more often than needed
+[[nodiscard]] static Bench_Result run_bench(const Bench &bench, const Bench_Mesh &bench_mesh, size_t num_threads,
+                                            const Bench_Settings &settings) {
+  std::vector<double> seconds;
+  double total_seconds = 0.0;
+  size_t num_items = 0;
+  while (seconds.size() < MAX_BENCH_REPETITIONS && (seconds.empty() || total_seconds < settings.min_time_seconds)) {
+    auto begin = std::chrono::steady_clock::now();
+    num_items = bench.run(bench_mesh);
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+    seconds.push_back(duration.count());
+    total_seconds += duration.count();
+  }
+  std::sort(seconds.begin(), seconds.end());
+  return {
+      .name = bench.name,
+      .num_triangles = bench_mesh.triangles.size(),
+      .num_threads = num_threads,
+      .num_repetitions = seconds.size(),
+      .min_seconds = seconds.front(),
+      .median_seconds = seconds[seconds.size() / 2],
+      .num_items = num_items,
+  };
+}
+
+[[nodiscard]] static std::optional<std::vector<size_t>> parse_size_list(const std::string &text) {
+  std::vector<size_t> values;
+  std::istringstream stream(text);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    try {
+      size_t num_parsed_chars = 0;
+      unsigned long long value = std::stoull(item, &num_parsed_chars);
+      if (num_parsed_chars != item.size() || value == 0) return {};
+      values.push_back(static_cast<size_t>(value));
+    } catch (const std::exception &) {
+      return {};
+    }
+  }
+  if (values.empty()) return {};
+  return values;
+}
+
+[[nodiscard]] static std::optional<Bench_Settings> parse_bench_settings(int argc, char **argv) {
+  Bench_Settings settings;
+  settings.sizes.assign(std::begin(DEFAULT_BENCH_SIZES), std::end(DEFAULT_BENCH_SIZES));
+  size_t num_hardware_threads = get_num_worker_threads();
+  for (size_t n = 1; n < num_hardware_threads; n *= 2) {
+    settings.thread_counts.push_back(n);
+  }
+  settings.thread_counts.push_back(num_hardware_threads);
+
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    if (i + 1 >= argc) return {};
+    std::string value = argv[++i];
+    if (argument == "--sizes" || argument == "--threads") {
+      std::optional<std::vector<size_t>> values = parse_size_list(value);
+      if (!values.has_value()) return {};
+      (argument == "--sizes" ? settings.sizes : settings.thread_counts) = std::move(values.value());
+    } else if (argument == "--filter") {
+      settings.filter = value;
+    } else if (argument == "--min-time") {
+      try {
+        settings.min_time_seconds = std::stod(value);
+      } catch (const std::exception &) {
+        return {};
+      }
+    } else if (argument == "--mesh") {
+      size_t type = 0;
+      while (type < NUM_MESH_GENERATOR_TYPES &&
+             value != get_mesh_generator_type_name(static_cast<Mesh_Generator_Type>(type))) {
+        type++;
+      }
+      if (type == NUM_MESH_GENERATOR_TYPES) return {};
+      settings.mesh_type = static_cast<Mesh_Generator_Type>(type);
+    } else if (argument == "--output") {
+      settings.output_file_path = value;
+    } else {
+      return {};
+    }
+  }
+  return settings;
+}
+
+static void write_bench_results(std::ostream &stream, Mesh_Generator_Type mesh_type,
+                                const std::vector<Bench_Result> &results) {
+  stream << "{\n  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n  \"mesh\": \""
+         << get_mesh_generator_type_name(mesh_type) << "\",\n  \"results\": [";
+  stream << std::setprecision(9);
+  for (size_t i = 0; i < results.size(); i++) {
+    const Bench_Result &result = results[i];
+    stream << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name
+           << "\", \"triangles\": " << result.num_triangles << ", \"threads\": " << result.num_threads
+           << ", \"repetitions\": " << result.num_repetitions << ", \"min_seconds\": " << result.min_seconds
+           << ", \"median_seconds\": " << result.median_seconds << ", \"items\": " << result.num_items
+           << ", \"items_per_second\": " << static_cast<double>(result.num_items) / result.median_seconds << "}";
+  }
+  stream << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv) {
+  std::optional<Bench_Settings> settings = parse_bench_settings(argc, argv);
+  if (!settings.has_value()) {
+    std::cerr << "Usage: geobox_bench [--sizes 1000,10000,...] [--threads 1,2,...] [--filter name] "
+                 "[--min-time seconds] [--mesh Torus|Sphere|Terrain|Slivers|Soup] [--output file.json]"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<Bench> benches = create_benches();
+  std::vector<Bench_Result> results;
+  std::cout << std::left << std::setw(24) << "Benchmark" << std::right << std::setw(12) << "Triangles"
+            << std::setw(9) << "Threads" << std::setw(14) << "Median ms" << std::setw(16) << "Items/s" << std::endl;
+  for (size_t size : settings->sizes) {
+    Bench_Mesh bench_mesh = create_bench_mesh(settings->mesh_type, size);
+    for (const Bench &bench : benches) {
+      if (bench.name == std::string("stl_read_ascii") && bench_mesh.ascii_stl_file_path.empty()) continue;
+      if (!settings->filter.empty() && std::string(bench.name).find(settings->filter) == std::string::npos) continue;
+      for (size_t num_threads : settings->thread_counts) {
+        if (!bench.is_parallel && num_threads != settings->thread_counts.front()) continue;
+        Task_Scheduler::get().set_max_concurrency(bench.is_parallel ? num_threads : 1);
+        Bench_Result result = run_bench(bench, bench_mesh, bench.is_parallel ? num_threads : 1, settings.value());
+        results.push_back(result);
+        std::cout << std::left << std::setw(24) << result.name << std::right << std::setw(12) << result.num_triangles
+                  << std::setw(9) << result.num_threads << std::setw(14) << std::fixed << std::setprecision(3)
+                  << result.median_seconds * 1000.0 << std::setw(16) << std::setprecision(0)
+                  << static_cast<double>(result.num_items) / result.median_seconds << std::endl;
+      }
+    }
+    for (const std::string &file_path : {bench_mesh.binary_stl_file_path, bench_mesh.ascii_stl_file_path}) {
+      if (!file_path.empty()) std::remove(file_path.c_str());
+    }
+  }
+  Task_Scheduler::get().set_max_concurrency(std::numeric_limits<size_t>::max());
+
+  std::ofstream file(settings->output_file_path);
+  write_bench_results(file, settings->mesh_type, results);
+  if (!file) {
+    std::cerr << "Failed to write results to " << settings->output_file_path << std::endl;
+    return 1;
+  }
+  std::cout << "Results written to " << settings->output_file_path << std::endl;
+  return 0;
+}
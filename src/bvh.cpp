@@ -1,8 +1,11 @@
 #include <algorithm> // for std::partition, std::min, std::max, std::minmax, std::min_element and std::max_element
 #include <cstdlib>   // for std::malloc, std::free, std::abort and std::abs
-#include <stack>
-#include <type_traits>
-#include <utility> // for std::as_const
+#include <cstring>   // for std::memcpy
+#include <limits>
+#include <memory> // for std::shared_ptr
+#include <memory_resource>
+#include <span>
+#include <utility> // for std::move
 #include <vector>
 
 #include <glm/common.hpp> // for glm::min and glm::max
@@ -10,10 +13,16 @@
 
 #include "bvh.hpp"
 #include "geobox_exceptions.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "scratch_arena.hpp"
+#include "task_scheduler.hpp"
 
-BVH::Node *BVH::new_node() { return m_current_free_node++; }
+// Subtrees with fewer primitives are built by the task that split their parent
+constexpr size_t MIN_PARALLEL_SUBTREE_SIZE = 4096;
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 16384;
 
-[[nodiscard]] static AABB calc_aabb_indirect(const std::vector<AABB> &bounding_boxes, const unsigned int *first,
+[[nodiscard]] static AABB calc_aabb_indirect(std::span<const AABB> bounding_boxes, const unsigned int *first,
                                              const unsigned int *last) {
   AABB aabb = bounding_boxes[*first];
   for (const unsigned int *i = first; i <= last; i++) {
@@ -26,61 +35,104 @@ BVH::Node *BVH::new_node() { return m_current_free_node++; }
   return aabb;
 }
 
-BVH::BVH(const std::vector<AABB> &bounding_boxes) {
+BVH::BVH(std::span<const AABB> bounding_boxes) {
+  GEOBOX_PROFILE_SCOPE("Build BVH");
   size_t num_primitives = bounding_boxes.size();
   if (num_primitives == 0) {
     throw GeoBox_Error("Zero number of primitives, aborting creation of BVH...");
   }
 
+  // Build temporaries are only needed until the end of the constructor
+  Scratch_Scope scratch;
+
   // Calculate bounding box centers
-  std::vector<glm::vec3> bounding_box_centers;
-  bounding_box_centers.reserve(bounding_boxes.size());
-  for (const AABB &aabb : bounding_boxes) {
-    // We multiply by 0.5f first (as opposed to multiplying after adding min and max) to reduce the values of min and
-    // max to support larger values of min and max
-    bounding_box_centers.emplace_back(aabb.min * 0.5f + aabb.max * 0.5f);
+  std::pmr::vector<glm::vec3> bounding_box_centers(num_primitives, scratch.get_resource());
+  parallel_for(0, num_primitives, MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      // We multiply by 0.5f first (as opposed to multiplying after adding min and max) to reduce the values of min and
+      // max to support larger values of min and max
+      bounding_box_centers[i] = bounding_boxes[i].min * 0.5f + bounding_boxes[i].max * 0.5f;
+    }
+  });
+
+  if (num_primitives > std::numeric_limits<unsigned int>::max() / 2) {
+    throw Overflow_Check_Error("Too many primitives, aborting creation of BVH...");
   }
 
-  // Pre-allocate nodes
-  m_pre_allocated_nodes = (Node *)malloc(sizeof(Node) * (2 * num_primitives - 1));
-  m_current_free_node = m_pre_allocated_nodes;
+  // Pre-allocate nodes, a subtree of n primitives has at most 2n - 1 nodes, so subtrees get fixed ranges of nodes in
+  // depth-first order and can be built in parallel without sharing a node counter
+  size_t max_num_nodes = 2 * num_primitives - 1;
+  m_nodes = (Node *)malloc(sizeof(Node) * max_num_nodes);
+  std::pmr::vector<unsigned char> is_node_used(max_num_nodes, 0, scratch.get_resource());
 
   // Build initial indices array
+  m_num_primitives = num_primitives;
   m_primitive_indices = (unsigned int *)malloc(sizeof(unsigned int) * num_primitives);
   for (unsigned int i = 0; i < num_primitives; i++) {
     m_primitive_indices[i] = i;
   }
 
   // Create root
-  m_root = new_node();
-  *m_root = {
-      .first = m_primitive_indices,
-      .last = m_primitive_indices + num_primitives - 1,
-      .left = nullptr,
-      .right = nullptr,
+  m_nodes[0] = {
+      .first = 0,
+      .last = static_cast<unsigned int>(num_primitives - 1),
+      .left = 0,
+      .right = 0,
   };
 
   // Build tree
-  std::stack<Node *> stack;
-  stack.push(m_root);
+  Task_Group task_group;
+  build_subtree(0, bounding_boxes, bounding_box_centers, is_node_used, task_group);
+  task_group.wait();
+
+  // Leaves that could not be split leave their subtree ranges unused, nodes are moved down to close the gaps, which
+  // keeps them in depth-first order, so children stay after their parents and the tree does not depend on timing
+  std::pmr::vector<unsigned int> new_indices(max_num_nodes, scratch.get_resource());
+  unsigned int num_nodes = 0;
+  for (size_t i = 0; i < max_num_nodes; i++) {
+    if (is_node_used[i]) new_indices[i] = num_nodes++;
+  }
+  for (size_t i = 0; i < max_num_nodes; i++) {
+    if (!is_node_used[i]) continue;
+    Node node = m_nodes[i];
+    if (!node.is_leaf()) {
+      node.left = new_indices[node.left];
+      node.right = new_indices[node.right];
+    }
+    m_nodes[new_indices[i]] = node;
+  }
+  m_num_nodes = num_nodes;
+}
+
+void BVH::build_subtree(unsigned int root, std::span<const AABB> bounding_boxes,
+                        std::span<const glm::vec3> bounding_box_centers, std::span<unsigned char> is_node_used,
+                        Task_Group &task_group) {
+  // Scratch arena of the thread running the task
+  Scratch_Scope scratch;
+  std::pmr::vector<unsigned int> stack(scratch.get_resource());
+  stack.push_back(root);
   while (!stack.empty()) {
-    Node *node = stack.top();
-    stack.pop();
-    assert(node->first <= node->last);
+    unsigned int node_index = stack.back();
+    Node &node = m_nodes[node_index];
+    stack.pop_back();
+    is_node_used[node_index] = 1;
+    assert(node.first <= node.last);
+    unsigned int *first = m_primitive_indices + node.first;
+    unsigned int *last = m_primitive_indices + node.last;
 
     // Calculate AABB
-    node->aabb = calc_aabb_indirect(bounding_boxes, node->first, node->last);
+    node.aabb = calc_aabb_indirect(bounding_boxes, first, last);
 
     // Skip splitting of nodes that contain a single primitive
-    if (node->first == node->last) {
+    if (node.first == node.last) {
       continue;
     }
 
     // Calculate variance
-    auto num_primitives_as_float = static_cast<float>(node->num_primitives());
+    auto num_primitives_as_float = static_cast<float>(node.num_primitives());
     glm::vec3 mean_of_squares(0);
     glm::vec3 mean(0);
-    for (const unsigned int *i = node->first; i <= node->last; i++) {
+    for (const unsigned int *i = first; i <= last; i++) {
       const glm::vec3 &v = bounding_box_centers[*i];
       glm::vec3 tmp = v / num_primitives_as_float;
       mean += tmp;
@@ -103,37 +155,114 @@ BVH::BVH(const std::vector<AABB> &bounding_boxes) {
     // so if we need to include the "last" value in partitioning, we pass last + 1 to std::partition as the "last"
     // parameter: https://en.cppreference.com/mwiki/index.php?title=cpp/algorithm/partition&oldid=150246
     auto *second_group_first =
-        std::partition(node->first, node->last + 1,
-                       [&bounding_box_centers_const = std::as_const(bounding_box_centers), axis,
-                        split_pos](unsigned int i) { return bounding_box_centers_const[i][axis] < split_pos; });
+        std::partition(first, last + 1, [&bounding_box_centers, axis, split_pos](unsigned int i) {
+          return bounding_box_centers[i][axis] < split_pos;
+        });
 
     // Abort current node if partitioning fails
-    if (second_group_first == node->first || second_group_first == (node->last + 1)) {
+    if (second_group_first == first || second_group_first == (last + 1)) {
       continue;
     }
 
-    node->left = new_node();
-    *(node->left) = {
-        .first = node->first,
-        .last = second_group_first - 1,
-        .left = nullptr,
-        .right = nullptr,
+    // Left subtree takes the nodes right after its parent, the right subtree takes the ones after those
+    auto second_group_offset = static_cast<unsigned int>(second_group_first - m_primitive_indices);
+    unsigned int num_left_primitives = second_group_offset - node.first;
+    node.left = node_index + 1;
+    m_nodes[node.left] = {
+        .first = node.first,
+        .last = second_group_offset - 1,
+        .left = 0,
+        .right = 0,
     };
-    node->right = new_node();
-    *(node->right) = {
-        .first = second_group_first,
-        .last = node->last,
-        .left = nullptr,
-        .right = nullptr,
+    node.right = node_index + 2 * num_left_primitives;
+    m_nodes[node.right] = {
+        .first = second_group_offset,
+        .last = node.last,
+        .left = 0,
+        .right = 0,
     };
-    stack.push(node->left);
-    stack.push(node->right);
+    for (unsigned int child : {node.left, node.right}) {
+      if (m_nodes[child].num_primitives() >= MIN_PARALLEL_SUBTREE_SIZE) {
+        task_group.run([this, child, bounding_boxes, bounding_box_centers, is_node_used, &task_group]() {
+          build_subtree(child, bounding_boxes, bounding_box_centers, is_node_used, task_group);
+        });
+      } else {
+        stack.push_back(child);
+      }
+    }
   }
 }
 
+BVH::BVH(std::span<const Node> nodes, std::span<const unsigned int> primitive_indices) {
+  if (nodes.empty() || primitive_indices.empty() || nodes.size() > 2 * primitive_indices.size() - 1) {
+    throw GeoBox_Error("Invalid BVH, wrong number of nodes or primitives");
+  }
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const Node &node = nodes[i];
+    // Children after parents also rules out cycles
+    bool are_children_valid = node.is_leaf() || (node.left > i && node.left < nodes.size() && node.right > i &&
+                                                 node.right < nodes.size());
+    if (!are_children_valid || node.first > node.last || node.last >= primitive_indices.size()) {
+      throw GeoBox_Error("Invalid BVH, node refers to missing nodes or primitives");
+    }
+  }
+  for (unsigned int primitive_index : primitive_indices) {
+    if (primitive_index >= primitive_indices.size()) {
+      throw GeoBox_Error("Invalid BVH, primitive index out of range");
+    }
+  }
+  m_num_nodes = nodes.size();
+  m_nodes = (Node *)malloc(sizeof(Node) * nodes.size());
+  std::memcpy(m_nodes, nodes.data(), sizeof(Node) * nodes.size());
+  m_num_primitives = primitive_indices.size();
+  m_primitive_indices = (unsigned int *)malloc(sizeof(unsigned int) * primitive_indices.size());
+  std::memcpy(m_primitive_indices, primitive_indices.data(), sizeof(unsigned int) * primitive_indices.size());
+}
+
+BVH::BVH(std::span<const Node> nodes, std::span<const unsigned int> primitive_indices,
+         std::shared_ptr<const void> storage_owner)
+    : m_storage_owner(std::move(storage_owner)) {
+  assert(m_storage_owner);
+  if (nodes.empty() || primitive_indices.empty() || nodes.size() > 2 * primitive_indices.size() - 1 ||
+      nodes[0].first != 0 || nodes[0].last != primitive_indices.size() - 1) {
+    throw GeoBox_Error("Invalid BVH, wrong number of nodes or primitives");
+  }
+  // Never written through while borrowed, see refit
+  m_num_nodes = nodes.size();
+  m_nodes = const_cast<Node *>(nodes.data());
+  m_num_primitives = primitive_indices.size();
+  m_primitive_indices = const_cast<unsigned int *>(primitive_indices.data());
+}
+
 BVH::~BVH() {
+  if (m_storage_owner) return;
   free(m_primitive_indices);
-  free(m_pre_allocated_nodes);
+  free(m_nodes);
+}
+
+void BVH::refit(std::span<const AABB> bounding_boxes) {
+  GEOBOX_PROFILE_SCOPE("Refit BVH");
+  assert(bounding_boxes.size() == m_num_primitives);
+  if (m_storage_owner) {
+    auto *nodes = (Node *)malloc(sizeof(Node) * m_num_nodes);
+    std::memcpy(nodes, m_nodes, sizeof(Node) * m_num_nodes);
+    auto *primitive_indices = (unsigned int *)malloc(sizeof(unsigned int) * m_num_primitives);
+    std::memcpy(primitive_indices, m_primitive_indices, sizeof(unsigned int) * m_num_primitives);
+    m_nodes = nodes;
+    m_primitive_indices = primitive_indices;
+    m_storage_owner.reset();
+  }
+  // Children are always allocated after their parent, so walking nodes in reverse allocation order
+  // visits children before parents
+  for (size_t i = m_num_nodes; i-- > 0;) {
+    Node &node = m_nodes[i];
+    if (node.is_leaf()) {
+      node.aabb = calc_aabb_indirect(bounding_boxes, m_primitive_indices + node.first, m_primitive_indices + node.last);
+    } else {
+      node.aabb.min = glm::min(m_nodes[node.left].aabb.min, m_nodes[node.right].aabb.min);
+      node.aabb.max = glm::max(m_nodes[node.left].aabb.max, m_nodes[node.right].aabb.max);
+    }
+  }
 }
 
 size_t BVH::count_nodes() const {
@@ -157,50 +286,113 @@ size_t BVH::count_primitives() const {
   return num_primitives;
 }
 
-template <typename R, typename Fn, typename... Arg_Types>
-static constexpr bool stricter_is_invocable_r_v = std::is_same_v<std::invoke_result_t<Fn, Arg_Types...>, R>;
+#ifdef GEOBOX_TEST_BVH
+#include <atomic>
+#include <new>
+#include <random>
 
-template <typename Callback_Type, typename AABB_Filter_Type>
-void BVH::foreach_node(Callback_Type callback, AABB_Filter_Type aabb_filter) const {
-  static_assert(stricter_is_invocable_r_v<void, Callback_Type, const Node *> &&
-                stricter_is_invocable_r_v<bool, AABB_Filter_Type, const AABB &>);
-  std::stack<const Node *> stack;
-  stack.push(m_root);
-  while (!stack.empty()) {
-    const Node *node = stack.top();
-    stack.pop();
+#include "testing.hpp"
 
-    if (!aabb_filter(node->aabb))
-      continue;
+static std::atomic<size_t> g_num_heap_allocations = 0;
 
-    callback(node);
-    if (!node->is_leaf()) {
-      assert(node->left && node->right);
-      stack.push(node->left);
-      stack.push(node->right);
-    }
-  }
+void *operator new(size_t num_bytes) {
+  g_num_heap_allocations++;
+  if (void *p = std::malloc(num_bytes == 0 ? 1 : num_bytes)) return p;
+  throw std::bad_alloc();
 }
 
-void BVH::foreach_leaf_node(const std::function<void(const Node *)> &callback,
-                            const std::function<bool(const AABB &aabb)> &aabb_filter) const {
-  foreach_node(
-      [&callback](const Node *node) {
-        if (node->is_leaf())
-          callback(node);
-      },
-      aabb_filter);
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+[[nodiscard]] static bool contains(const AABB &outer, const AABB &inner) {
+  return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
 }
 
-void BVH::foreach_primitive(const std::function<void(unsigned int)> &callback,
-                            const std::function<bool(const AABB &)> &aabb_filter,
-                            const std::function<bool(unsigned int)> &primitive_filter) const {
-  foreach_leaf_node(
-      [&callback, &primitive_filter](const Node *node) {
-        for (unsigned int const *i = node->first; i <= node->last; i++) {
-          if (primitive_filter(*i))
-            callback(*i);
-        }
-      },
-      aabb_filter);
+int main() {
+  // Large enough for subtrees to be built in parallel, with duplicate boxes that can not be split
+  std::mt19937 engine(1);
+  std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+  std::vector<AABB> bounding_boxes;
+  for (size_t i = 0; i < 100000; i++) {
+    glm::vec3 p(distribution(engine), distribution(engine), distribution(engine));
+    bounding_boxes.push_back({.min = p, .max = p + glm::vec3(0.5f)});
+  }
+  for (size_t i = 0; i < 5000; i++) {
+    bounding_boxes.push_back({.min = glm::vec3(1.0f), .max = glm::vec3(2.0f)});
+  }
+  BVH bvh(bounding_boxes);
+  std::span<const BVH::Node> nodes = bvh.get_nodes();
+
+  // Every primitive is in exactly one leaf, node boxes contain their children and primitives
+  std::vector<unsigned int> num_leaves_per_primitive(bounding_boxes.size(), 0);
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const BVH::Node &node = nodes[i];
+    if (node.is_leaf()) {
+      for (unsigned int p = node.first; p <= node.last; p++) {
+        unsigned int primitive = bvh.get_primitive_indices()[p];
+        num_leaves_per_primitive[primitive]++;
+        runtime_assert(contains(node.aabb, bounding_boxes[primitive]));
+      }
+    } else {
+      runtime_assert(node.left > i && node.right > i);
+      runtime_assert(nodes[node.left].first == node.first && nodes[node.right].last == node.last);
+      runtime_assert(nodes[node.left].last + 1 == nodes[node.right].first);
+      runtime_assert(contains(node.aabb, nodes[node.left].aabb) && contains(node.aabb, nodes[node.right].aabb));
+    }
+  }
+  for (unsigned int n : num_leaves_per_primitive) {
+    runtime_assert(n == 1);
+  }
+  runtime_assert(bvh.count_primitives() == bounding_boxes.size());
+  runtime_assert(bvh.count_nodes() == nodes.size());
+  // Duplicates end up in one leaf, so the tree has gaps that were closed
+  runtime_assert(bvh.calc_max_leaf_size() >= 5000 && nodes.size() < 2 * bounding_boxes.size() - 1);
+
+  // Build does not depend on timing
+  BVH rebuilt(bounding_boxes);
+  runtime_assert(rebuilt.get_nodes().size() == nodes.size());
+  runtime_assert(std::memcmp(rebuilt.get_nodes().data(), nodes.data(), nodes.size_bytes()) == 0);
+  runtime_assert(std::memcmp(rebuilt.get_primitive_indices().data(), bvh.get_primitive_indices().data(),
+                             bvh.get_primitive_indices().size_bytes()) == 0);
+
+  // Restoring validates the tree
+  BVH restored(nodes, bvh.get_primitive_indices());
+  runtime_assert(restored.get_nodes().size() == nodes.size());
+
+  // Borrowed trees view the storage until a refit copies it
+  auto storage = std::make_shared<std::vector<BVH::Node>>(nodes.begin(), nodes.end());
+  BVH borrowed(*storage, bvh.get_primitive_indices(), storage);
+  runtime_assert(!borrowed.owns_storage() && borrowed.get_nodes().data() == storage->data());
+  runtime_assert(borrowed.count_primitives() == bounding_boxes.size());
+  borrowed.refit(bounding_boxes);
+  runtime_assert(borrowed.owns_storage() && borrowed.get_nodes().data() != storage->data());
+  runtime_assert(std::memcmp(borrowed.get_nodes().data(), nodes.data(), nodes.size_bytes()) == 0);
+
+  // Queries make no heap allocations once the scratch arena of the thread is warmed up
+  auto query = [&bvh]() {
+    AABB box = {.min = glm::vec3(-10.0f), .max = glm::vec3(10.0f)};
+    size_t num_hits = 0;
+    bvh.foreach_primitive([&num_hits](unsigned int) { num_hits++; },
+                          [&box](const AABB &aabb) {
+                            return glm::all(glm::lessThanEqual(aabb.min, box.max)) &&
+                                   glm::all(glm::greaterThanEqual(aabb.max, box.min));
+                          },
+                          [](unsigned int) { return true; });
+    return num_hits;
+  };
+  size_t num_hits = query();
+  runtime_assert(num_hits > 0);
+  size_t num_heap_allocations = g_num_heap_allocations;
+  for (int i = 0; i < 100; i++) {
+    runtime_assert(query() == num_hits);
+  }
+  runtime_assert(bvh.count_nodes() == nodes.size());
+  runtime_assert(g_num_heap_allocations == num_heap_allocations);
+
+  // Single primitive
+  BVH single(std::vector<AABB>{{.min = glm::vec3(0.0f), .max = glm::vec3(1.0f)}});
+  runtime_assert(single.get_nodes().size() == 1 && single.get_nodes()[0].is_leaf());
+  return 0;
 }
+#endif
@@ -1,21 +1,31 @@
 #pragma once
 
 #include <cassert>
-#include <functional>
+#include <memory> // for std::shared_ptr
+#include <memory_resource>
+#include <span>
+#include <type_traits>
 #include <vector>
 
+#include <glm/vec3.hpp>
+
 #include "aabb.hpp"
+#include "scratch_arena.hpp"
+#include "task_scheduler.hpp"
 
 class BVH {
-private:
+public:
+  // Nodes refer to children and primitives by index rather than by pointer, so trees can be copied and stored as is
   struct Node {
     AABB aabb;
-    unsigned int *first;
-    unsigned int *last;
-    Node *left;
-    Node *right;
+    // Primitives of the node are the primitive indices first, ..., last
+    unsigned int first;
+    unsigned int last;
+    // Zero for leaves, root is node zero and never a child
+    unsigned int left;
+    unsigned int right;
 
-    [[nodiscard]] bool is_leaf() const { return (left == nullptr) && (right == nullptr); }
+    [[nodiscard]] bool is_leaf() const { return (left == 0) && (right == 0); }
 
     [[nodiscard]] size_t num_primitives() const {
       assert(last >= first);
@@ -23,15 +33,25 @@ private:
     }
   };
 
+private:
   unsigned int *m_primitive_indices = nullptr;
-  Node *m_current_free_node = nullptr;
-  Node *m_pre_allocated_nodes = nullptr;
-  Node *m_root = nullptr;
-  [[nodiscard]] Node *new_node();
+  size_t m_num_primitives = 0;
+  // Children are always allocated after their parent
+  Node *m_nodes = nullptr;
+  size_t m_num_nodes = 0;
+  // Set when nodes and primitive indices are borrowed from storage it keeps alive (e.g. a mapped mesh cache file)
+  // rather than allocated, borrowed storage is read-only
+  std::shared_ptr<const void> m_storage_owner;
+  // Splits the node and its descendants, large subtrees are forked into the task group
+  void build_subtree(unsigned int root, std::span<const AABB> bounding_boxes,
+                     std::span<const glm::vec3> bounding_box_centers, std::span<unsigned char> is_node_used,
+                     Task_Group &task_group);
+  // Traversal stack lives in the scratch arena of the calling thread, and callbacks are templates rather than
+  // std::function, so queries make no heap allocations
   template <typename Callback_Type, typename AABB_Filter_Type>
-  void foreach_node(Callback_Type callback, AABB_Filter_Type aabb_filter) const;
-  void foreach_leaf_node(const std::function<void(const Node *)> &callback,
-                         const std::function<bool(const AABB &aabb)> &aabb_filter) const;
+  void foreach_node(const Callback_Type &callback, const AABB_Filter_Type &aabb_filter) const;
+  template <typename Callback_Type, typename AABB_Filter_Type>
+  void foreach_leaf_node(const Callback_Type &callback, const AABB_Filter_Type &aabb_filter) const;
 
 public:
   // Memory is freed in destructor,
@@ -41,14 +61,83 @@ public:
   BVH &operator=(const BVH &) = delete;
   ~BVH();
 
-  explicit BVH(const std::vector<AABB> &bounding_boxes);
+  explicit BVH(std::span<const AABB> bounding_boxes);
+  // Restores a tree from the nodes and primitive indices of another one without rebuilding it, both are validated
+  BVH(std::span<const Node> nodes, std::span<const unsigned int> primitive_indices);
+  // Views the nodes and primitive indices of trusted storage in place, storage_owner keeps them alive, only their sizes
+  // are checked, so opening is O(1), refitting copies them into owned memory first
+  BVH(std::span<const Node> nodes, std::span<const unsigned int> primitive_indices,
+      std::shared_ptr<const void> storage_owner);
+  // Recomputes node bounding boxes bottom-up for moved primitives, keeping the tree topology,
+  // much cheaper than a rebuild but tree quality degrades with large deformations
+  void refit(std::span<const AABB> bounding_boxes);
   [[nodiscard]] size_t count_nodes() const;
   [[nodiscard]] size_t calc_max_leaf_size() const;
   [[nodiscard]] size_t count_primitives() const;
+  // False for trees viewing borrowed storage, which takes no memory of its own
+  [[nodiscard]] bool owns_storage() const { return !m_storage_owner; }
+
+  // Calls callback(primitive_index) for primitives passing primitive_filter(primitive_index) in nodes whose bounding
+  // boxes pass aabb_filter(aabb)
+  template <typename Callback_Type, typename AABB_Filter_Type, typename Primitive_Filter_Type>
+  void foreach_primitive(const Callback_Type &callback, const AABB_Filter_Type &aabb_filter,
+                         const Primitive_Filter_Type &primitive_filter) const;
+
+  [[nodiscard]] const AABB &get_aabb() const { return m_nodes[0].aabb; };
 
-  void foreach_primitive(const std::function<void(unsigned int)> &callback,
-                         const std::function<bool(const AABB &aabb)> &aabb_filter,
-                         const std::function<bool(unsigned int)> &primitive_filter) const;
+  [[nodiscard]] std::span<const Node> get_nodes() const { return {m_nodes, m_num_nodes}; }
 
-  [[nodiscard]] const AABB &get_aabb() const { return m_root->aabb; };
+  [[nodiscard]] std::span<const unsigned int> get_primitive_indices() const {
+    return {m_primitive_indices, m_num_primitives};
+  }
 };
+
+template <typename R, typename Fn, typename... Arg_Types>
+inline constexpr bool stricter_is_invocable_r_v = std::is_same_v<std::invoke_result_t<Fn, Arg_Types...>, R>;
+
+template <typename Callback_Type, typename AABB_Filter_Type>
+void BVH::foreach_node(const Callback_Type &callback, const AABB_Filter_Type &aabb_filter) const {
+  static_assert(stricter_is_invocable_r_v<void, const Callback_Type &, const Node *> &&
+                stricter_is_invocable_r_v<bool, const AABB_Filter_Type &, const AABB &>);
+  Scratch_Scope scratch;
+  std::pmr::vector<unsigned int> stack(scratch.get_resource());
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const Node *node = &m_nodes[stack.back()];
+    stack.pop_back();
+
+    if (!aabb_filter(node->aabb))
+      continue;
+
+    callback(node);
+    if (!node->is_leaf()) {
+      assert(node->left && node->right);
+      stack.push_back(node->left);
+      stack.push_back(node->right);
+    }
+  }
+}
+
+template <typename Callback_Type, typename AABB_Filter_Type>
+void BVH::foreach_leaf_node(const Callback_Type &callback, const AABB_Filter_Type &aabb_filter) const {
+  foreach_node(
+      [&callback](const Node *node) {
+        if (node->is_leaf())
+          callback(node);
+      },
+      aabb_filter);
+}
+
+template <typename Callback_Type, typename AABB_Filter_Type, typename Primitive_Filter_Type>
+void BVH::foreach_primitive(const Callback_Type &callback, const AABB_Filter_Type &aabb_filter,
+                            const Primitive_Filter_Type &primitive_filter) const {
+  foreach_leaf_node(
+      [this, &callback, &primitive_filter](const Node *node) {
+        for (unsigned int const *i = m_primitive_indices + node->first; i <= m_primitive_indices + node->last; i++) {
+          if (primitive_filter(*i))
+            callback(*i);
+        }
+      },
+      aabb_filter);
+}
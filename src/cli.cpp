@@ -0,0 +1,400 @@
+// Headless batch processing of mesh files, e.g. thousands of parts on machines without a display, files are loaded
+// concurrently by the mesh loader and every operation runs in parallel on all cores, results and timings of each file
+// are written as one JSON object per line, so partial results survive an interrupted run
+//
+// Usage: geobox_cli [options] <mesh files or directories>...
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip> // for std::setprecision
+#include <iostream>
+#include <map>
+#include <memory> // for std::shared_ptr
+#include <optional>
+#include <sstream> // for std::ostringstream
+#include <string>
+#include <system_error> // for std::error_code
+#include <thread>       // for std::this_thread::sleep_for
+#include <utility>      // for std::pair and std::move
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "geobox_exceptions.hpp"
+#include "indexed_triangle_mesh.hpp"
+#include "indexed_triangle_mesh_object.hpp"
+#include "mass_properties.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_loader.hpp"
+#include "primitives.hpp"
+#include "read_mesh.hpp"
+#include "sampling.hpp"
+#include "task_scheduler.hpp"
+#include "vertex_welder.hpp"
+#include "write_mesh.hpp"
+
+constexpr size_t DEFAULT_CLI_NUM_VOLUME_RAYS = 5;
+constexpr const char *CLI_USAGE = R"(Usage: geobox_cli [options] <mesh files or directories>...
+
+Operations, run on every file in this order:
+  --weld <range>               Weld vertices closer than range again, after loading
+  --mass                       Surface area, volume, center of mass and inertia tensor (unit density)
+  --sample-surface <count>     Points on the surface, written as <name>_surface.ply
+  --sample-volume <count>      Points in the volume out of count candidates, written as <name>_volume.ply
+  --export <stl|ascii-stl|ply> Loaded (and welded) mesh, written as <name>.stl or <name>.ply
+
+Options:
+  --rays <count>               Rays per candidate for inside tests of --sample-volume (default 5)
+  --seed <seed>                Seed of the samplers, the same for every file (default 1)
+  --output-dir <directory>     Directory of written files (default .)
+  --results <file>             JSON lines results (default <output-dir>/geobox_cli_results.jsonl)
+  --threads <count>            Threads to use, including the main thread (default all)
+  --cache-dir <directory>      Directory of mesh cache files (default the user's cache directory, see mesh_cache.hpp)
+)";
+
+namespace {
+enum class CLI_Export_Format { None, Binary_STL, ASCII_STL, PLY };
+
+struct CLI_Settings {
+  std::vector<std::string> input_paths;
+  std::optional<float> weld_range;
+  bool is_mass_properties_enabled = false;
+  size_t num_surface_points = 0;
+  size_t num_volume_points_before_filtering = 0;
+  size_t num_volume_rays = DEFAULT_CLI_NUM_VOLUME_RAYS;
+  uint64_t seed = 1;
+  CLI_Export_Format export_format = CLI_Export_Format::None;
+  std::string output_directory = ".";
+  std::string results_file_path;
+  std::optional<size_t> num_threads;
+  std::optional<std::string> cache_directory;
+};
+
+// Times each operation of one file, in the order they ran
+class Operation_Timer {
+private:
+  std::vector<std::pair<const char *, double>> m_seconds;
+  std::chrono::steady_clock::time_point m_begin;
+
+public:
+  void begin() { m_begin = std::chrono::steady_clock::now(); }
+
+  void end(const char *name) {
+    m_seconds.emplace_back(name, std::chrono::duration<double>(std::chrono::steady_clock::now() - m_begin).count());
+  }
+
+  void add(const char *name, double seconds) { m_seconds.emplace_back(name, seconds); }
+
+  [[nodiscard]] const std::vector<std::pair<const char *, double>> &get_seconds() const { return m_seconds; }
+};
+} // namespace
+
+static void write_json_string(std::ostream &stream, const std::string &text) {
+  stream << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      stream << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec
+             << std::setfill(' ');
+    } else {
+      stream << c;
+    }
+  }
+  stream << '"';
+}
+
+static void write_json_vec3(std::ostream &stream, const glm::dvec3 &v) {
+  stream << '[' << v.x << ", " << v.y << ", " << v.z << ']';
+}
+
+[[nodiscard]] static std::optional<CLI_Settings> parse_cli_settings(int argc, char **argv) {
+  CLI_Settings settings;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string argument = argv[i];
+      if (argument.rfind("--", 0) != 0) {
+        settings.input_paths.push_back(argument);
+        continue;
+      }
+      if (argument == "--mass") {
+        settings.is_mass_properties_enabled = true;
+        continue;
+      }
+      if (i + 1 >= argc) return {};
+      std::string value = argv[++i];
+      if (argument == "--weld") {
+        settings.weld_range = std::stof(value);
+      } else if (argument == "--sample-surface") {
+        settings.num_surface_points = std::stoull(value);
+      } else if (argument == "--sample-volume") {
+        settings.num_volume_points_before_filtering = std::stoull(value);
+      } else if (argument == "--rays") {
+        settings.num_volume_rays = std::stoull(value);
+      } else if (argument == "--seed") {
+        settings.seed = std::stoull(value);
+      } else if (argument == "--export") {
+        if (value == "stl") {
+          settings.export_format = CLI_Export_Format::Binary_STL;
+        } else if (value == "ascii-stl") {
+          settings.export_format = CLI_Export_Format::ASCII_STL;
+        } else if (value == "ply") {
+          settings.export_format = CLI_Export_Format::PLY;
+        } else {
+          return {};
+        }
+      } else if (argument == "--output-dir") {
+        settings.output_directory = value;
+      } else if (argument == "--results") {
+        settings.results_file_path = value;
+      } else if (argument == "--threads") {
+        settings.num_threads = std::stoull(value);
+      } else if (argument == "--cache-dir") {
+        settings.cache_directory = value;
+      } else {
+        return {};
+      }
+    }
+  } catch (const std::exception &) {
+    return {};
+  }
+  if (settings.input_paths.empty() || settings.num_volume_rays == 0) return {};
+  if (settings.weld_range.has_value() && !(settings.weld_range.value() > 0.0f)) return {};
+  if (settings.results_file_path.empty()) {
+    settings.results_file_path =
+        (std::filesystem::path(settings.output_directory) / "geobox_cli_results.jsonl").string();
+  }
+  return settings;
+}
+
+// Files of directories are expanded, other paths are kept as is, so missing files are reported as failed loads
+[[nodiscard]] static std::vector<std::string> find_input_files(const std::vector<std::string> &input_paths) {
+  std::vector<std::string> file_paths;
+  for (const std::string &input_path : input_paths) {
+    std::error_code error_code;
+    if (std::filesystem::is_directory(input_path, error_code)) {
+      std::vector<std::string> directory_file_paths = find_mesh_files(input_path);
+      file_paths.insert(file_paths.end(), directory_file_paths.begin(), directory_file_paths.end());
+    } else {
+      file_paths.push_back(input_path);
+    }
+  }
+  return file_paths;
+}
+
+// Name of written files, parts with the same file name in different directories get a numbered suffix
+[[nodiscard]] static std::string get_unique_output_name(const std::string &file_path,
+                                                        std::map<std::string, size_t> &name_counts) {
+  std::string name = std::filesystem::path(file_path).stem().string();
+  size_t count = name_counts[name]++;
+  return count == 0 ? name : name + "_" + std::to_string(count);
+}
+
+[[nodiscard]] static Indexed_Triangle_Mesh_Data weld_mesh_data(const Indexed_Triangle_Mesh_Data &data, float range) {
+  Vertex_Welder welder(range);
+  welder.reserve(data.indices.size() / 3);
+  for (size_t i = 0; i < data.indices.size(); i += 3) {
+    welder.add_triangle(
+        {data.vertices[data.indices[i + 0]], data.vertices[data.indices[i + 1]], data.vertices[data.indices[i + 2]]});
+  }
+  Indexed_Triangle_Mesh_Data welded = Indexed_Triangle_Mesh_Data::from_mesh(welder.finish());
+  welded.update_normals_and_areas();
+  welded.build_triangles_bvh();
+  return welded;
+}
+
+// Runs the operations on one loaded mesh and writes its result line, throws on failure (e.g. GeoBox_Error when a
+// file cannot be written, std::bad_alloc for huge sample counts)
+static void process_mesh(Indexed_Triangle_Mesh_Data data, const std::string &output_name, const CLI_Settings &settings,
+                         Operation_Timer &timer, std::ostream &result) {
+  std::filesystem::path output_directory(settings.output_directory);
+  if (settings.weld_range.has_value()) {
+    timer.begin();
+    size_t num_vertices_before = data.vertices.size();
+    data = weld_mesh_data(data, settings.weld_range.value());
+    timer.end("weld");
+    result << ", \"vertices_before_weld\": " << num_vertices_before;
+  }
+  result << ", \"triangles\": " << data.indices.size() / 3 << ", \"vertices\": " << data.vertices.size();
+
+  if (settings.is_mass_properties_enabled) {
+    timer.begin();
+    Mass_Properties properties = calc_mass_properties(data.vertices, data.indices);
+    timer.end("mass_properties");
+    result << ", \"mass_properties\": {\"surface_area\": " << properties.surface_area
+           << ", \"volume\": " << properties.volume << ", \"center_of_mass\": ";
+    write_json_vec3(result, properties.center_of_mass);
+    result << ", \"inertia_tensor\": [";
+    for (int i = 0; i < 3; i++) {
+      if (i > 0) result << ", ";
+      write_json_vec3(result, properties.inertia_tensor[i]);
+    }
+    result << "]}";
+  }
+
+  auto write_points = [&](const char *key, const std::vector<glm::vec3> &points, const std::string &file_name) {
+    std::string file_path = (output_directory / file_name).string();
+    if (!write_ply_file(file_path, points, {})) throw GeoBox_Error("Failed to write " + file_path);
+    result << ", \"" << key << "\": {\"count\": " << points.size() << ", \"file\": ";
+    write_json_string(result, file_path);
+    result << "}";
+  };
+  if (settings.num_surface_points > 0) {
+    timer.begin();
+    std::vector<glm::vec3> points = sample_points_on_surface(data.vertices, data.indices, data.triangle_areas,
+                                                             settings.num_surface_points, settings.seed);
+    timer.end("sample_surface");
+    write_points("surface_points", points, output_name + "_surface.ply");
+  }
+  if (settings.num_volume_points_before_filtering > 0) {
+    timer.begin();
+    std::vector<glm::vec3> directions = sample_directions(settings.num_volume_rays, settings.seed);
+    std::vector<glm::vec3> points =
+        sample_points_in_volume(data.vertices, data.indices, data.triangle_normals, *data.triangles_bvh,
+                                settings.num_volume_points_before_filtering, directions, settings.seed);
+    timer.end("sample_volume");
+    write_points("volume_points", points, output_name + "_volume.ply");
+  }
+
+  if (settings.export_format != CLI_Export_Format::None) {
+    bool is_stl = settings.export_format != CLI_Export_Format::PLY;
+    std::string file_path = (output_directory / (output_name + (is_stl ? ".stl" : ".ply"))).string();
+    timer.begin();
+    Indexed_Triangle_Mesh mesh{.vertices = std::move(data.vertices), .indices = std::move(data.indices)};
+    bool is_written = false;
+    switch (settings.export_format) {
+    case CLI_Export_Format::Binary_STL:
+      is_written = write_stl_mesh_file_binary(file_path, mesh);
+      break;
+    case CLI_Export_Format::ASCII_STL:
+      is_written = write_stl_mesh_file_ascii(file_path, mesh);
+      break;
+    case CLI_Export_Format::PLY:
+      is_written = write_ply_file(file_path, mesh.vertices, mesh.indices);
+      break;
+    case CLI_Export_Format::None:
+      break;
+    }
+    timer.end("export");
+    if (!is_written) throw GeoBox_Error("Failed to write " + file_path);
+    result << ", \"export_file\": ";
+    write_json_string(result, file_path);
+  }
+}
+
+[[nodiscard]] static int run_cli(int argc, char **argv) {
+  std::optional<CLI_Settings> settings = parse_cli_settings(argc, argv);
+  if (!settings.has_value()) {
+    std::cerr << CLI_USAGE;
+    return 1;
+  }
+  if (settings->num_threads.has_value()) Task_Scheduler::get().set_max_concurrency(settings->num_threads.value());
+  std::error_code error_code;
+  std::filesystem::create_directories(settings->output_directory, error_code);
+  std::ofstream results_file(settings->results_file_path);
+  if (!results_file) {
+    std::cerr << "Failed to open results file: " << settings->results_file_path << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> file_paths = find_input_files(settings->input_paths);
+  auto begin = std::chrono::steady_clock::now();
+  std::optional<std::filesystem::path> cache_directory = get_default_mesh_cache_directory();
+  if (settings->cache_directory.has_value()) {
+    cache_directory = settings->cache_directory.value();
+    std::filesystem::create_directories(cache_directory.value(), error_code);
+  }
+  Mesh_Loader loader(DEFAULT_MESH_LOAD_MEMORY_BUDGET, Task_Scheduler::get(), cache_directory);
+  for (const std::string &file_path : file_paths) {
+    loader.load(file_path);
+  }
+  std::map<std::string, size_t> name_counts;
+  size_t num_done = 0;
+  size_t num_failed = 0;
+  // Loads of later files overlap the operations on earlier ones
+  while (!loader.get_tasks().empty()) {
+    for (const std::shared_ptr<Mesh_Load_Task> &task : loader.take_done_tasks()) {
+      Operation_Timer timer;
+      timer.add("load", task->get_load_seconds());
+      std::ostringstream result;
+      result << std::setprecision(9);
+      result << "{\"file\": ";
+      write_json_string(result, task->get_file_path());
+      std::optional<std::string> error;
+      if (task->get_mesh_data().has_value() || task->get_mesh_cache_file()) {
+        try {
+          // Operations take the mesh by value, so cache hits are copied out of the mapping
+          Indexed_Triangle_Mesh_Data data =
+              task->get_mesh_data().has_value()
+                  ? std::move(task->get_mesh_data().value())
+                  : Indexed_Triangle_Mesh_Data::from_mesh_cache(task->get_mesh_cache_file()->get_sections());
+          process_mesh(std::move(data), get_unique_output_name(task->get_file_path(), name_counts), settings.value(),
+                       timer, result);
+        } catch (const std::exception &e) {
+          // Only this file fails, the others are still processed
+          error = e.what();
+        }
+        task->get_mesh_data().reset();
+      } else {
+        error = task->get_point_cloud().has_value() ? "No triangles, only vertices" : "Failed to load";
+      }
+      if (error.has_value()) {
+        num_failed++;
+        result << ", \"error\": ";
+        write_json_string(result, error.value());
+        std::cerr << task->get_file_path() << ": " << error.value() << std::endl;
+      }
+      result << ", \"seconds\": {";
+      const std::vector<std::pair<const char *, double>> &seconds = timer.get_seconds();
+      for (size_t i = 0; i < seconds.size(); i++) {
+        result << (i == 0 ? "" : ", ") << '"' << seconds[i].first << "\": " << seconds[i].second;
+      }
+      result << "}}\n";
+      results_file << result.str() << std::flush;
+      num_done++;
+    }
+    // Loads are background tasks, with --threads 1 every worker sleeps and only the main thread can run them
+    if (!Task_Scheduler::get().try_run_task(Task_Priority::Background)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+  std::cout << "Processed " << num_done << " files, " << num_failed << " failed, in " << duration.count()
+            << " s, results written to " << settings->results_file_path << std::endl;
+  return num_failed == 0 && results_file ? 0 : 1;
+}
+
+#ifndef GEOBOX_TEST_CLI
+int main(int argc, char **argv) { return run_cli(argc, argv); }
+#else
+#include "testing.hpp"
+
+int main() {
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "geobox_test_cli";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  std::string file_path = (directory / "tetrahedron.obj").string();
+  std::ofstream(file_path) << "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 1\nf 1 3 2\nf 1 2 4\nf 1 4 3\nf 2 3 4\n";
+  std::string output_directory = directory.string();
+
+  // A single thread leaves the loads to the main thread, which used to wait on them forever
+  std::vector<std::string> arguments = {"geobox_cli", "--threads", "1", "--mass", "--output-dir", output_directory,
+                                        "--cache-dir", (directory / "cache").string(), file_path};
+  std::vector<char *> argv;
+  for (std::string &argument : arguments) {
+    argv.push_back(argument.data());
+  }
+  runtime_assert(run_cli(static_cast<int>(argv.size()), argv.data()) == 0);
+  std::ifstream results_file(directory / "geobox_cli_results.jsonl");
+  std::string line;
+  runtime_assert(std::getline(results_file, line) && line.find("\"volume\": ") != std::string::npos);
+  runtime_assert(line.find("\"error\"") == std::string::npos && !std::getline(results_file, line));
+  results_file.close();
+
+  std::filesystem::remove_all(directory);
+  return 0;
+}
+#endif
@@ -0,0 +1,90 @@
+#include <limits>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+
+#include "closest_point.hpp"
+
+glm::vec3 closest_point_in_aabb(const glm::vec3 &point, const AABB &aabb) {
+  return glm::clamp(point, aabb.min, aabb.max);
+}
+
+float point_aabb_distance_squared(const glm::vec3 &point, const AABB &aabb) {
+  return glm::distance2(point, closest_point_in_aabb(point, aabb));
+}
+
+glm::vec3 closest_point_on_segment(const glm::vec3 &point, const Segment &segment) {
+  glm::vec3 ab = segment.m_b - segment.m_a;
+  float length_squared = glm::dot(ab, ab);
+  if (length_squared == 0.0f) return segment.m_a;
+  float t = glm::clamp(glm::dot(point - segment.m_a, ab) / length_squared, 0.0f, 1.0f);
+  return segment.m_a + t * ab;
+}
+
+// Voronoi region classification, Christer Ericson, Real-Time Collision Detection, section 5.1.5
+glm::vec3 closest_point_on_triangle(const glm::vec3 &point, const Triangle &triangle) {
+  const glm::vec3 &a = triangle.m_a;
+  const glm::vec3 &b = triangle.m_b;
+  const glm::vec3 &c = triangle.m_c;
+  glm::vec3 ab = b - a;
+  glm::vec3 ac = c - a;
+
+  glm::vec3 ap = point - a;
+  float d1 = glm::dot(ab, ap);
+  float d2 = glm::dot(ac, ap);
+  if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+  glm::vec3 bp = point - b;
+  float d3 = glm::dot(ab, bp);
+  float d4 = glm::dot(ac, bp);
+  if (d3 >= 0.0f && d4 <= d3) return b;
+
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + (d1 / (d1 - d3)) * ab;
+
+  glm::vec3 cp = point - c;
+  float d5 = glm::dot(ab, cp);
+  float d6 = glm::dot(ac, cp);
+  if (d6 >= 0.0f && d5 <= d6) return c;
+
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + (d2 / (d2 - d6)) * ac;
+
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+    return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+  }
+
+  float sum = va + vb + vc;
+  if (sum <= 0.0f) {
+    // Degenerate triangle, closest point is on one of its edges
+    glm::vec3 best = closest_point_on_segment(point, {a, b});
+    for (const Segment &edge : {Segment{b, c}, Segment{c, a}}) {
+      glm::vec3 candidate = closest_point_on_segment(point, edge);
+      if (glm::distance2(point, candidate) < glm::distance2(point, best)) best = candidate;
+    }
+    return best;
+  }
+  // Inside face region
+  return a + ab * (vb / sum) + ac * (vc / sum);
+}
+
+glm::vec3 closest_point_on_mesh(const glm::vec3 &point, std::span<const glm::vec3> vertices,
+                                std::span<const unsigned int> indices, const BVH &triangles_bvh) {
+  glm::vec3 closest_point = point;
+  float closest_distance_squared = std::numeric_limits<float>::infinity();
+  // Nodes farther away than the closest point found so far are pruned
+  triangles_bvh.foreach_primitive(
+      [&](unsigned int i) {
+        Triangle triangle{vertices[indices[i * 3 + 0]], vertices[indices[i * 3 + 1]], vertices[indices[i * 3 + 2]]};
+        glm::vec3 candidate = closest_point_on_triangle(point, triangle);
+        float distance_squared = glm::distance2(point, candidate);
+        if (distance_squared < closest_distance_squared) {
+          closest_distance_squared = distance_squared;
+          closest_point = candidate;
+        }
+      },
+      [&](const AABB &aabb) { return point_aabb_distance_squared(point, aabb) < closest_distance_squared; },
+      [](unsigned int) { return true; });
+  return closest_point;
+}
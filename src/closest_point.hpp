@@ -0,0 +1,22 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "primitives.hpp"
+
+[[nodiscard]] glm::vec3 closest_point_in_aabb(const glm::vec3 &point, const AABB &aabb);
+
+[[nodiscard]] float point_aabb_distance_squared(const glm::vec3 &point, const AABB &aabb);
+
+[[nodiscard]] glm::vec3 closest_point_on_segment(const glm::vec3 &point, const Segment &segment);
+
+[[nodiscard]] glm::vec3 closest_point_on_triangle(const glm::vec3 &point, const Triangle &triangle);
+
+// Closest point on the surface of an indexed triangle mesh, the BVH must be built from the triangle bounding boxes
+[[nodiscard]] glm::vec3 closest_point_on_mesh(const glm::vec3 &point, std::span<const glm::vec3> vertices,
+                                              std::span<const unsigned int> indices, const BVH &triangles_bvh);
@@ -0,0 +1,404 @@
+#include <algorithm> // for std::max
+#include <array>
+#include <cassert>
+#include <cmath> // for std::abs
+#include <limits>
+#include <optional>
+#include <utility> // for std::move and std::pair
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+
+#include "convex_hull.hpp"
+#include "parallel.hpp"
+
+// Quickhull: https://doi.org/10.1145/235815.235821
+// Implementation details (horizon ordering, epsilon):
+// http://media.steampowered.com/apps/valve/2014/DirkGregorius_ImplementingQuickHull.pdf
+
+constexpr unsigned int INVALID_INDEX = std::numeric_limits<unsigned int>::max();
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 16384;
+
+namespace {
+struct Hull_Face {
+  std::array<unsigned int, 3> vertices{};
+  // neighbours[i] is the face across the edge from vertices[i] to vertices[(i + 1) % 3]
+  std::array<unsigned int, 3> neighbours{INVALID_INDEX, INVALID_INDEX, INVALID_INDEX};
+  glm::vec3 normal{0.0f};
+  float offset = 0.0f;
+  std::vector<unsigned int> outside_points;
+  unsigned int farthest_point = INVALID_INDEX;
+  float farthest_distance = 0.0f;
+  bool is_alive = true;
+  bool is_visible = false;
+
+  [[nodiscard]] float distance(const glm::vec3 &p) const { return glm::dot(normal, p) - offset; }
+
+  void add_outside_point(unsigned int point_index, float point_distance) {
+    outside_points.push_back(point_index);
+    if (point_distance > farthest_distance) {
+      farthest_distance = point_distance;
+      farthest_point = point_index;
+    }
+  }
+};
+
+struct Horizon_Edge {
+  unsigned int a, b;
+  // Face on the other side of the edge, it is not visible from the eye point and survives
+  unsigned int hidden_face;
+};
+
+class Quickhull {
+private:
+  std::span<const glm::vec3> m_points;
+  float m_epsilon = 0.0f;
+  // Faces live in one contiguous pool, dead faces are recycled through the free list so the pool does not grow
+  // with every expansion step
+  std::vector<Hull_Face> m_faces;
+  std::vector<unsigned int> m_free_faces;
+  // Faces that may still have outside points
+  std::vector<unsigned int> m_pending_faces;
+
+  // Scratch buffers reused across expansion steps
+  std::vector<unsigned int> m_visible_faces;
+  std::vector<Horizon_Edge> m_horizon;
+  std::vector<unsigned int> m_orphan_points;
+  std::vector<unsigned int> m_new_faces;
+
+  unsigned int create_face(unsigned int a, unsigned int b, unsigned int c) {
+    unsigned int face_index;
+    if (m_free_faces.empty()) {
+      face_index = static_cast<unsigned int>(m_faces.size());
+      m_faces.emplace_back();
+    } else {
+      face_index = m_free_faces.back();
+      m_free_faces.pop_back();
+      m_faces[face_index] = Hull_Face{};
+    }
+    Hull_Face &face = m_faces[face_index];
+    face.vertices = {a, b, c};
+    glm::vec3 normal = glm::cross(m_points[b] - m_points[a], m_points[c] - m_points[a]);
+    // Degenerate faces keep a zero normal, so no point is ever considered outside of them
+    if (glm::length2(normal) > 0.0f) face.normal = glm::normalize(normal);
+    face.offset = glm::dot(face.normal, m_points[a]);
+    return face_index;
+  }
+
+  [[nodiscard]] bool build_initial_simplex(std::array<unsigned int, 4> &simplex) const;
+  void assign_initial_outside_points();
+  void compute_horizon(unsigned int eye_point, unsigned int start_face);
+  void add_point(unsigned int eye_point, unsigned int start_face);
+
+public:
+  explicit Quickhull(std::span<const glm::vec3> points) : m_points(points) {}
+  [[nodiscard]] std::optional<Indexed_Triangle_Mesh> build();
+};
+
+// Index of the point maximizing the score, evaluated in parallel chunks and reduced on the calling thread
+template <typename Score_Type>
+[[nodiscard]] unsigned int parallel_arg_max(size_t num_points, const Score_Type &score) {
+  size_t num_chunks = calc_num_parallel_chunks(num_points, MIN_PARALLEL_CHUNK_SIZE);
+  std::vector<std::pair<float, unsigned int>> chunk_results(num_chunks, {-1.0f, INVALID_INDEX});
+  parallel_for_chunks(num_points, num_chunks, [&chunk_results, &score](size_t chunk_index, size_t begin, size_t end) {
+    std::pair<float, unsigned int> best{-1.0f, INVALID_INDEX};
+    for (size_t i = begin; i < end; i++) {
+      float s = score(i);
+      if (s > best.first) best = {s, static_cast<unsigned int>(i)};
+    }
+    chunk_results[chunk_index] = best;
+  });
+  std::pair<float, unsigned int> best{-1.0f, INVALID_INDEX};
+  for (const std::pair<float, unsigned int> &chunk_result : chunk_results) {
+    if (chunk_result.first > best.first) best = chunk_result;
+  }
+  return best.second;
+}
+} // namespace
+
+bool Quickhull::build_initial_simplex(std::array<unsigned int, 4> &simplex) const {
+  // Extreme points along each axis (min x, max x, min y, ...)
+  size_t num_chunks = calc_num_parallel_chunks(m_points.size(), MIN_PARALLEL_CHUNK_SIZE);
+  std::vector<std::array<unsigned int, 6>> chunk_extremes(num_chunks);
+  parallel_for_chunks(m_points.size(), num_chunks,
+                      [this, &chunk_extremes](size_t chunk_index, size_t begin, size_t end) {
+                        std::array<unsigned int, 6> extremes;
+                        extremes.fill(static_cast<unsigned int>(begin));
+                        for (size_t i = begin; i < end; i++) {
+                          for (int axis = 0; axis < 3; axis++) {
+                            if (m_points[i][axis] < m_points[extremes[axis * 2]][axis])
+                              extremes[axis * 2] = static_cast<unsigned int>(i);
+                            if (m_points[i][axis] > m_points[extremes[axis * 2 + 1]][axis])
+                              extremes[axis * 2 + 1] = static_cast<unsigned int>(i);
+                          }
+                        }
+                        chunk_extremes[chunk_index] = extremes;
+                      });
+  std::array<unsigned int, 6> extremes = chunk_extremes.front();
+  for (const std::array<unsigned int, 6> &chunk : chunk_extremes) {
+    for (int axis = 0; axis < 3; axis++) {
+      if (m_points[chunk[axis * 2]][axis] < m_points[extremes[axis * 2]][axis]) extremes[axis * 2] = chunk[axis * 2];
+      if (m_points[chunk[axis * 2 + 1]][axis] > m_points[extremes[axis * 2 + 1]][axis])
+        extremes[axis * 2 + 1] = chunk[axis * 2 + 1];
+    }
+  }
+
+  // Farthest pair among extreme points
+  float best_distance = -1.0f;
+  for (int i = 0; i < 6; i++) {
+    for (int j = i + 1; j < 6; j++) {
+      float distance = glm::distance2(m_points[extremes[i]], m_points[extremes[j]]);
+      if (distance > best_distance) {
+        best_distance = distance;
+        simplex[0] = extremes[i];
+        simplex[1] = extremes[j];
+      }
+    }
+  }
+  if (best_distance <= m_epsilon * m_epsilon) return false;
+
+  // Farthest point from the line
+  const glm::vec3 &a = m_points[simplex[0]];
+  glm::vec3 ab = glm::normalize(m_points[simplex[1]] - a);
+  simplex[2] = parallel_arg_max(m_points.size(),
+                                [this, &a, &ab](size_t i) { return glm::length2(glm::cross(m_points[i] - a, ab)); });
+  if (glm::length(glm::cross(m_points[simplex[2]] - a, ab)) <= m_epsilon) return false;
+
+  // Farthest point from the plane
+  glm::vec3 normal = glm::normalize(glm::cross(ab, m_points[simplex[2]] - a));
+  simplex[3] = parallel_arg_max(m_points.size(),
+                                [this, &a, &normal](size_t i) { return std::abs(glm::dot(m_points[i] - a, normal)); });
+  return std::abs(glm::dot(m_points[simplex[3]] - a, normal)) > m_epsilon;
+}
+
+void Quickhull::assign_initial_outside_points() {
+  // Parallel pass deciding for every point which initial face it is outside of, points inside the simplex are
+  // discarded here and never looked at again
+  constexpr unsigned char INSIDE = 4;
+  std::vector<unsigned char> assigned_faces(m_points.size());
+  std::vector<float> distances(m_points.size());
+  parallel_for(0, m_points.size(), MIN_PARALLEL_CHUNK_SIZE, [this, &assigned_faces, &distances](size_t b, size_t e) {
+    for (size_t i = b; i < e; i++) {
+      assigned_faces[i] = INSIDE;
+      for (unsigned char f = 0; f < 4; f++) {
+        float distance = m_faces[f].distance(m_points[i]);
+        if (distance > m_epsilon) {
+          assigned_faces[i] = f;
+          distances[i] = distance;
+          break;
+        }
+      }
+    }
+  });
+  for (size_t i = 0; i < m_points.size(); i++) {
+    if (assigned_faces[i] == INSIDE) continue;
+    m_faces[assigned_faces[i]].add_outside_point(static_cast<unsigned int>(i), distances[i]);
+  }
+  for (unsigned int f = 0; f < 4; f++) {
+    if (!m_faces[f].outside_points.empty()) m_pending_faces.push_back(f);
+  }
+}
+
+void Quickhull::compute_horizon(unsigned int eye_point, unsigned int start_face) {
+  // Iterative depth first search over visible faces, crossing each face's edges in order starting after the edge it
+  // was entered from, this yields horizon edges as a closed, consistently ordered loop
+  struct Frame {
+    unsigned int face;
+    int first_edge;
+    int num_edges;
+    int num_visited_edges;
+  };
+  const glm::vec3 &eye = m_points[eye_point];
+  m_visible_faces.clear();
+  m_horizon.clear();
+  std::vector<Frame> stack;
+  m_faces[start_face].is_visible = true;
+  m_visible_faces.push_back(start_face);
+  stack.push_back({start_face, 0, 3, 0});
+  while (!stack.empty()) {
+    Frame &frame = stack.back();
+    if (frame.num_visited_edges == frame.num_edges) {
+      stack.pop_back();
+      continue;
+    }
+    unsigned int face_index = frame.face;
+    int edge = (frame.first_edge + frame.num_visited_edges) % 3;
+    frame.num_visited_edges++;
+    unsigned int neighbour_index = m_faces[face_index].neighbours[edge];
+    Hull_Face &neighbour = m_faces[neighbour_index];
+    if (neighbour.is_visible) continue;
+    if (neighbour.distance(eye) > m_epsilon) {
+      neighbour.is_visible = true;
+      m_visible_faces.push_back(neighbour_index);
+      int entry_edge = 0;
+      while (neighbour.neighbours[entry_edge] != face_index) {
+        entry_edge++;
+      }
+      stack.push_back({neighbour_index, (entry_edge + 1) % 3, 2, 0});
+    } else {
+      const Hull_Face &face = m_faces[face_index];
+      m_horizon.push_back({face.vertices[edge], face.vertices[(edge + 1) % 3], neighbour_index});
+    }
+  }
+}
+
+void Quickhull::add_point(unsigned int eye_point, unsigned int start_face) {
+  compute_horizon(eye_point, start_face);
+
+  // Remove visible faces, keeping their outside points for reassignment
+  m_orphan_points.clear();
+  for (unsigned int face_index : m_visible_faces) {
+    Hull_Face &face = m_faces[face_index];
+    m_orphan_points.insert(m_orphan_points.end(), face.outside_points.begin(), face.outside_points.end());
+    face.outside_points = {};
+    face.is_alive = false;
+    m_free_faces.push_back(face_index);
+  }
+
+  // Build a cone of new faces from the horizon to the eye point
+  m_new_faces.clear();
+  for (const Horizon_Edge &edge : m_horizon) {
+    unsigned int new_face_index = create_face(edge.a, edge.b, eye_point);
+    m_new_faces.push_back(new_face_index);
+    m_faces[new_face_index].neighbours[0] = edge.hidden_face;
+    Hull_Face &hidden_face = m_faces[edge.hidden_face];
+    for (int i = 0; i < 3; i++) {
+      if (hidden_face.vertices[i] == edge.b && hidden_face.vertices[(i + 1) % 3] == edge.a) {
+        hidden_face.neighbours[i] = new_face_index;
+      }
+    }
+  }
+  size_t num_new_faces = m_new_faces.size();
+  for (size_t i = 0; i < num_new_faces; i++) {
+    assert(m_horizon[i].b == m_horizon[(i + 1) % num_new_faces].a);
+    Hull_Face &face = m_faces[m_new_faces[i]];
+    face.neighbours[1] = m_new_faces[(i + 1) % num_new_faces];
+    face.neighbours[2] = m_new_faces[(i + num_new_faces - 1) % num_new_faces];
+  }
+
+  for (unsigned int point_index : m_orphan_points) {
+    if (point_index == eye_point) continue;
+    for (unsigned int face_index : m_new_faces) {
+      float distance = m_faces[face_index].distance(m_points[point_index]);
+      if (distance > m_epsilon) {
+        m_faces[face_index].add_outside_point(point_index, distance);
+        break;
+      }
+    }
+  }
+  for (unsigned int face_index : m_new_faces) {
+    if (!m_faces[face_index].outside_points.empty()) m_pending_faces.push_back(face_index);
+  }
+}
+
+std::optional<Indexed_Triangle_Mesh> Quickhull::build() {
+  if (m_points.size() < 4) return std::nullopt;
+
+  // Scale dependent tolerance, from qhull
+  glm::vec3 max_abs(0.0f);
+  for (const glm::vec3 &p : m_points) {
+    max_abs = glm::max(max_abs, glm::abs(p));
+  }
+  m_epsilon = 3.0f * std::numeric_limits<float>::epsilon() * (max_abs.x + max_abs.y + max_abs.z);
+
+  std::array<unsigned int, 4> simplex{};
+  if (!build_initial_simplex(simplex)) return std::nullopt;
+  auto [a, b, c, d] = simplex;
+  // Orient the base so the apex is behind it, the remaining faces then follow from consistent edge orientation
+  if (glm::dot(glm::cross(m_points[b] - m_points[a], m_points[c] - m_points[a]), m_points[d] - m_points[a]) > 0.0f) {
+    std::swap(b, c);
+  }
+  create_face(a, b, c);
+  create_face(b, a, d);
+  create_face(c, b, d);
+  create_face(a, c, d);
+  m_faces[0].neighbours = {1, 2, 3};
+  m_faces[1].neighbours = {0, 3, 2};
+  m_faces[2].neighbours = {0, 1, 3};
+  m_faces[3].neighbours = {0, 2, 1};
+
+  assign_initial_outside_points();
+
+  while (!m_pending_faces.empty()) {
+    unsigned int face_index = m_pending_faces.back();
+    m_pending_faces.pop_back();
+    const Hull_Face &face = m_faces[face_index];
+    if (!face.is_alive || face.outside_points.empty()) continue;
+    add_point(face.farthest_point, face_index);
+  }
+
+  // Compact hull vertices
+  Indexed_Triangle_Mesh mesh;
+  std::vector<unsigned int> remap(m_points.size(), INVALID_INDEX);
+  for (const Hull_Face &face : m_faces) {
+    if (!face.is_alive) continue;
+    for (unsigned int point_index : face.vertices) {
+      if (remap[point_index] == INVALID_INDEX) {
+        remap[point_index] = static_cast<unsigned int>(mesh.vertices.size());
+        mesh.vertices.push_back(m_points[point_index]);
+      }
+      mesh.indices.push_back(remap[point_index]);
+    }
+  }
+  return mesh;
+}
+
+std::optional<Indexed_Triangle_Mesh> convex_hull(std::span<const glm::vec3> points) {
+  return Quickhull(points).build();
+}
+
+#ifdef GEOBOX_TEST_CONVEX_HULL
+#include <random>
+
+#include "math.hpp"
+#include "testing.hpp"
+
+int main() {
+  Tolerance_Context tc(1e-4f, 1e-4f);
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<float> dist(0.01f, 0.99f);
+
+  // Degenerate inputs
+  runtime_assert(!convex_hull({}).has_value());
+  runtime_assert(!convex_hull(std::vector<glm::vec3>{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}}).has_value());
+
+  // Cube corners hiding many interior points, enough to go through the parallel pass
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 100000; i++) {
+    points.emplace_back(dist(engine), dist(engine), dist(engine));
+  }
+  for (int i = 0; i < 8; i++) {
+    points.emplace_back(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+  }
+  std::optional<Indexed_Triangle_Mesh> cube = convex_hull(points);
+  runtime_assert(cube.has_value());
+  runtime_assert(cube->vertices.size() == 8);
+  runtime_assert(cube->indices.size() == 12 * 3);
+  runtime_assert(is_watertight(cube.value()));
+  runtime_assert(is_close(tc, calc_volume(cube.value()), 1.0f));
+
+  // Points on a sphere are all hull vertices
+  std::vector<glm::vec3> sphere_points;
+  std::normal_distribution<float> normal_dist;
+  for (int i = 0; i < 2000; i++) {
+    sphere_points.push_back(glm::normalize(glm::vec3(normal_dist(engine), normal_dist(engine), normal_dist(engine))));
+  }
+  std::optional<Indexed_Triangle_Mesh> sphere = convex_hull(sphere_points);
+  runtime_assert(sphere.has_value());
+  runtime_assert(is_watertight(sphere.value()));
+  // Euler characteristic of a closed triangulated sphere: F = 2V - 4
+  runtime_assert(sphere->indices.size() / 3 == 2 * sphere->vertices.size() - 4);
+  for (size_t i = 0; i < sphere->indices.size(); i += 3) {
+    const glm::vec3 &a = sphere->vertices[sphere->indices[i + 0]];
+    const glm::vec3 &b = sphere->vertices[sphere->indices[i + 1]];
+    const glm::vec3 &c = sphere->vertices[sphere->indices[i + 2]];
+    glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+    for (const glm::vec3 &p : sphere_points) {
+      runtime_assert(glm::dot(normal, p - a) <= 1e-4f);
+    }
+  }
+
+  return 0;
+}
+#endif
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <optional>
+#include <span>
+
+#include <glm/vec3.hpp>
+
+#include "indexed_triangle_mesh.hpp"
+
+// 3D Quickhull, returns an empty optional if the points are degenerate (fewer than 4 non-coplanar points),
+// resulting triangles are counter-clockwise when viewed from outside the hull
+[[nodiscard]] std::optional<Indexed_Triangle_Mesh> convex_hull(std::span<const glm::vec3> points);
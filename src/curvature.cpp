@@ -0,0 +1,224 @@
+#include <algorithm> // for std::nth_element, std::find and std::clamp
+#include <cmath>     // for std::atan2 and std::abs
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "curvature.hpp"
+#include "parallel.hpp"
+#include "vertex_adjacency.hpp"
+
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 16384;
+
+namespace {
+// Quantities of triangle corners, corner 3 * t + k is at vertex indices[3 * t + k]
+struct Corner_Attributes {
+  std::vector<float> angles;
+  std::vector<float> cotangents;
+  // Share of the triangle area in the mixed Voronoi area of the corner's vertex
+  std::vector<float> areas;
+};
+} // namespace
+
+[[nodiscard]] static Corner_Attributes calc_corner_attributes(std::span<const glm::vec3> vertices,
+                                                              std::span<const unsigned int> indices) {
+  Corner_Attributes corners;
+  corners.angles.resize(indices.size());
+  corners.cotangents.resize(indices.size());
+  corners.areas.resize(indices.size());
+  parallel_for(0, indices.size() / 3, MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++) {
+      glm::vec3 p[3] = {vertices[indices[t * 3 + 0]], vertices[indices[t * 3 + 1]], vertices[indices[t * 3 + 2]]};
+      float dot_products[3];
+      float edge_lengths_squared[3]; // Edge k is opposite to corner k
+      float double_area = glm::length(glm::cross(p[1] - p[0], p[2] - p[0]));
+      for (size_t k = 0; k < 3; k++) {
+        glm::vec3 u = p[(k + 1) % 3] - p[k];
+        glm::vec3 w = p[(k + 2) % 3] - p[k];
+        dot_products[k] = glm::dot(u, w);
+        edge_lengths_squared[(k + 2) % 3] = glm::dot(u, u);
+        corners.angles[t * 3 + k] = std::atan2(double_area, dot_products[k]);
+        // Degenerate triangles do not contribute to the Laplacian
+        corners.cotangents[t * 3 + k] = (double_area > 0.0f) ? dot_products[k] / double_area : 0.0f;
+      }
+
+      // Voronoi areas are only valid for non-obtuse triangles, obtuse ones are split half and quarters instead
+      float area = double_area * 0.5f;
+      int obtuse_corner = -1;
+      for (int k = 0; k < 3; k++) {
+        if (dot_products[k] < 0.0f) obtuse_corner = k;
+      }
+      for (size_t k = 0; k < 3; k++) {
+        float corner_area;
+        if (obtuse_corner == -1) {
+          corner_area = (edge_lengths_squared[(k + 1) % 3] * corners.cotangents[t * 3 + (k + 1) % 3] +
+                         edge_lengths_squared[(k + 2) % 3] * corners.cotangents[t * 3 + (k + 2) % 3]) /
+                        8.0f;
+        } else {
+          corner_area = (static_cast<int>(k) == obtuse_corner) ? area * 0.5f : area * 0.25f;
+        }
+        corners.areas[t * 3 + k] = corner_area;
+      }
+    }
+  });
+  return corners;
+}
+
+Vertex_Curvatures calc_vertex_curvatures(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices) {
+  Corner_Attributes corners = calc_corner_attributes(vertices, indices);
+  Vertex_Triangles vertex_triangles = build_vertex_triangles(vertices.size(), indices);
+
+  Vertex_Curvatures curvatures;
+  curvatures.mean.resize(vertices.size());
+  curvatures.gaussian.resize(vertices.size());
+  curvatures.areas.resize(vertices.size());
+  parallel_for(0, vertices.size(), MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    // Next (a) and previous (b) vertices of the one-ring, reused across vertices of the chunk
+    std::vector<unsigned int> ring_next;
+    std::vector<unsigned int> ring_previous;
+    for (size_t v = begin; v < end; v++) {
+      const glm::vec3 &position = vertices[v];
+      glm::vec3 laplacian(0.0f);
+      glm::vec3 normal(0.0f);
+      float angle_sum = 0.0f;
+      float area = 0.0f;
+      ring_next.clear();
+      ring_previous.clear();
+      for (unsigned int i = vertex_triangles.offsets[v]; i < vertex_triangles.offsets[v + 1]; i++) {
+        unsigned int t = vertex_triangles.triangles[i];
+        size_t k = (indices[t * 3 + 0] == v) ? 0 : ((indices[t * 3 + 1] == v) ? 1 : 2);
+        size_t corner_a = t * 3 + (k + 1) % 3;
+        size_t corner_b = t * 3 + (k + 2) % 3;
+        unsigned int a = indices[corner_a];
+        unsigned int b = indices[corner_b];
+        if (a == v || b == v) continue;
+        ring_next.push_back(a);
+        ring_previous.push_back(b);
+
+        laplacian += corners.cotangents[corner_b] * (position - vertices[a]) +
+                     corners.cotangents[corner_a] * (position - vertices[b]);
+        normal += glm::cross(vertices[a] - position, vertices[b] - position);
+        angle_sum += corners.angles[t * 3 + k];
+        area += corners.areas[t * 3 + k];
+      }
+      // One-ring is closed when every next vertex is also the previous vertex of another triangle
+      bool is_boundary = false;
+      for (unsigned int a : ring_next) {
+        is_boundary = is_boundary || (std::find(ring_previous.begin(), ring_previous.end(), a) == ring_previous.end());
+      }
+
+      curvatures.areas[v] = area;
+      float normal_length = glm::length(normal);
+      if (is_boundary || area <= 0.0f || normal_length == 0.0f) {
+        curvatures.mean[v] = 0.0f;
+        curvatures.gaussian[v] = 0.0f;
+        continue;
+      }
+      // Laplacian / (2 * area) is the mean curvature normal, which is 2 * mean curvature * normal
+      curvatures.mean[v] = glm::dot(laplacian, normal / normal_length) / (4.0f * area);
+      curvatures.gaussian[v] = (glm::two_pi<float>() - angle_sum) / area;
+    }
+  });
+  return curvatures;
+}
+
+float calc_robust_range(const std::vector<float> &values, float fraction) {
+  if (values.empty()) return 0.0f;
+  std::vector<float> magnitudes(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    magnitudes[i] = std::abs(values[i]);
+  }
+  auto nth = magnitudes.begin() +
+             static_cast<ptrdiff_t>(std::clamp(fraction, 0.0f, 1.0f) * static_cast<float>(magnitudes.size() - 1));
+  std::nth_element(magnitudes.begin(), nth, magnitudes.end());
+  return *nth;
+}
+
+#ifdef GEOBOX_TEST_CURVATURE
+#include <map>
+#include <utility> // for std::pair
+
+#include "math.hpp"
+#include "testing.hpp"
+
+// Icosahedron subdivided num_subdivisions times, projected onto a sphere
+static void build_icosphere(float radius, int num_subdivisions, std::vector<glm::vec3> &vertices,
+                            std::vector<unsigned int> &indices) {
+  float phi = (1.0f + std::sqrt(5.0f)) / 2.0f;
+  vertices = {
+      {-1, phi, 0}, {1, phi, 0}, {-1, -phi, 0}, {1, -phi, 0}, {0, -1, phi}, {0, 1, phi},
+      {0, -1, -phi}, {0, 1, -phi}, {phi, 0, -1}, {phi, 0, 1}, {-phi, 0, -1}, {-phi, 0, 1},
+  };
+  indices = {
+      0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+      3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+  };
+  for (int s = 0; s < num_subdivisions; s++) {
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+    auto get_midpoint = [&](unsigned int a, unsigned int b) {
+      auto [it, is_new] = midpoints.try_emplace({std::min(a, b), std::max(a, b)}, vertices.size());
+      if (is_new) vertices.push_back((vertices[a] + vertices[b]) * 0.5f);
+      return it->second;
+    };
+    std::vector<unsigned int> subdivided;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      unsigned int a = indices[i + 0];
+      unsigned int b = indices[i + 1];
+      unsigned int c = indices[i + 2];
+      unsigned int ab = get_midpoint(a, b);
+      unsigned int bc = get_midpoint(b, c);
+      unsigned int ca = get_midpoint(c, a);
+      subdivided.insert(subdivided.end(), {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca});
+    }
+    indices = std::move(subdivided);
+  }
+  for (glm::vec3 &v : vertices) {
+    v = glm::normalize(v) * radius;
+  }
+}
+
+int main() {
+  // Sphere of radius 2, mean curvature 1 / 2 and Gaussian curvature 1 / 4 everywhere
+  std::vector<glm::vec3> vertices;
+  std::vector<unsigned int> indices;
+  build_icosphere(2.0f, 4, vertices, indices);
+  Vertex_Curvatures curvatures = calc_vertex_curvatures(vertices, indices);
+  double total_angle_deficit = 0.0;
+  double total_area = 0.0;
+  for (size_t v = 0; v < vertices.size(); v++) {
+    runtime_assert(std::abs(curvatures.mean[v] - 0.5f) < 0.01f);
+    runtime_assert(std::abs(curvatures.gaussian[v] - 0.25f) < 0.02f);
+    total_angle_deficit += curvatures.gaussian[v] * curvatures.areas[v];
+    total_area += curvatures.areas[v];
+  }
+  // Discrete Gauss-Bonnet theorem holds exactly, total angle deficit is 2 * pi * Euler characteristic
+  runtime_assert(is_close(TC(1e-9f, 1e-3f), static_cast<float>(total_angle_deficit), 4.0f * glm::pi<float>()));
+  // Mixed areas tile the surface, close to the area of the sphere
+  runtime_assert(std::abs(total_area - 16.0 * glm::pi<double>()) < 0.1);
+
+  // Flipping orientation flips the sign of mean curvature only
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    std::swap(indices[i + 1], indices[i + 2]);
+  }
+  Vertex_Curvatures flipped = calc_vertex_curvatures(vertices, indices);
+  for (size_t v = 0; v < vertices.size(); v++) {
+    runtime_assert(is_close(TC::get_default(), flipped.mean[v], -curvatures.mean[v]));
+    runtime_assert(is_close(TC::get_default(), flipped.gaussian[v], curvatures.gaussian[v]));
+  }
+
+  // Flat square with a center vertex, flat interior and boundary vertices get zero curvature
+  std::vector<glm::vec3> square_vertices = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0.5f, 0.5f, 0}};
+  std::vector<unsigned int> square_indices = {0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
+  Vertex_Curvatures square = calc_vertex_curvatures(square_vertices, square_indices);
+  for (size_t v = 0; v < square_vertices.size(); v++) {
+    runtime_assert(is_close(TC::get_default(), square.mean[v], 0.0f));
+    runtime_assert(is_close(TC::get_default(), square.gaussian[v], 0.0f));
+  }
+  runtime_assert(is_close(TC::get_default(), square.areas[4], 0.5f));
+
+  // Robust range ignores the largest values
+  runtime_assert(calc_robust_range({1, -2, 3, -4, 100}, 0.75f) == 4.0f);
+  return 0;
+}
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+enum class Curvature_Type { Mean, Gaussian };
+
+struct Vertex_Curvatures {
+  // Signed, positive where the surface is convex (bulges towards the triangle normals)
+  std::vector<float> mean;
+  std::vector<float> gaussian;
+  // Mixed Voronoi area of each vertex, curvatures are averages over these areas
+  std::vector<float> areas;
+
+  [[nodiscard]] const std::vector<float> &get(Curvature_Type type) const {
+    return (type == Curvature_Type::Mean) ? mean : gaussian;
+  }
+};
+
+// Discrete curvatures of a welded mesh, mean curvature from the cotangent Laplacian and Gaussian curvature from the
+// angle deficit, boundary vertices and vertices with no area get zero curvature
+// Mark Meyer et al., Discrete Differential-Geometry Operators for Triangulated 2-Manifolds, VisMath 2002
+[[nodiscard]] Vertex_Curvatures calc_vertex_curvatures(std::span<const glm::vec3> vertices,
+                                                       std::span<const unsigned int> indices);
+
+// Magnitude below which the given fraction of absolute values fall, a colour map range that ignores outliers
+[[nodiscard]] float calc_robust_range(const std::vector<float> &values, float fraction);
@@ -1,10 +1,15 @@
+#include <algorithm>  // for std::clamp
 #include <cassert>
 #include <cmath>
-#include <cstdlib> // for std::exit
+#include <cstdlib>    // for std::exit
+#include <exception>
+#include <filesystem> // for std::filesystem::temp_directory_path
 #include <format>
 #include <iostream>
+#include <limits>
 #include <optional>
-#include <random> // for std::discrete_distribution
+#include <random> // for std::random_device
+#include <span>
 #include <string>
 #include <vector>
 
@@ -20,18 +25,24 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 #include "common.hpp"
+#include "convex_hull.hpp"
 #include "geobox_app.hpp"
 #include "geobox_exceptions.hpp"
-#include "intersection.hpp"
 #include "math.hpp"
+#include "mesh_loader.hpp"
+#include "plane_cut.hpp"
 #include "point_cloud_object.hpp"
-#include "random_generator.hpp"
-#include "ray_aabb_intersection.hpp"
-#include "read_stl.hpp"
+#include "profiler.hpp"
+#include "read_mesh.hpp"
+#include "remeshing.hpp"
+#include "render_state.hpp"
+#include "sampling.hpp"
 #include "shader.hpp"
 #include "primitives.hpp"
+#include "write_mesh.hpp"
 
 #ifdef ENABLE_SUPERLUMINAL_PERF_API
 #include <Superluminal/PerformanceAPI.h>
@@ -41,8 +52,13 @@ constexpr int INIT_WINDOW_WIDTH = 800;
 constexpr int INIT_WINDOW_HEIGHT = 600;
 constexpr const char *WINDOW_TITLE = "GeoBox";
 
-constexpr const char *LOAD_STL_DIALOG_KEY = "Load_STL_Dialog_Key";
-constexpr const char *LOAD_STL_BUTTON_AND_DIALOG_TITLE = "Load .stl";
+constexpr const char *LOAD_MESH_DIALOG_KEY = "Load_Mesh_Dialog_Key";
+constexpr const char *LOAD_MESH_BUTTON_AND_DIALOG_TITLE = "Load mesh";
+constexpr const char *LOAD_MESH_DIALOG_FILTERS = "Mesh files{.stl,.obj,.ply},.stl,.obj,.ply";
+constexpr const char *IMPORT_DIRECTORY_DIALOG_KEY = "Import_Directory_Dialog_Key";
+constexpr const char *IMPORT_DIRECTORY_BUTTON_AND_DIALOG_TITLE = "Import directory";
+constexpr const char *EXPORT_DIALOG_KEY = "Export_Dialog_Key";
+constexpr const char *EXPORT_DIALOG_TITLE = "Export";
 
 constexpr ImVec2 INITIAL_IMGUI_FILE_DIALOG_WINDOW_OFFSET(100, 100);
 constexpr ImVec2 INITIAL_IMGUI_FILE_DIALOG_WINDOW_SIZE(600, 500);
@@ -70,6 +86,7 @@ GeoBox_App::GeoBox_App() {
     shutdown();
     std::exit(-1);
   }
+  m_geometry_pool = std::make_shared<Geometry_Pool>();
 
   // Enable depth testing
   glEnable(GL_DEPTH_TEST);
@@ -86,17 +103,34 @@ GeoBox_App::GeoBox_App() {
   // Set point size
   glPointSize(DEFAULT_POINT_SIZE);
 
-  // Enable polygon depth offset, useful for avoiding z-fighting in specific scenarios (e.g. rendering point cloud and
-  // wireframe overlays)
+  // Avoid z-fighting with point clouds by pushing polygon depth away a bit, set once since nothing else changes it,
+  // thankfully this does not affect GL_POINTS or GL_LINES (if we ever need to draw them while GL_OFFSET is more than
+  // one), however when GL_POLYGON_OFFSET_POINT or GL_POLYGON_OFFSET_LINE is enabled on some implementations, it will
+  // affect GL_POINTS, and I suppose GL_LINES, so we adhere to specification and push polygons away instead of pulling
+  // points/lines closer
+  //
+  // Note: polygons in line or point mode are not the same as lines and points according to OpenGL specification, (i.e.
+  // glPolygonMode(GL_FRONT_AND_BACK, GL_POINT); glDrawArrays(GL_TRIANGLES, ...) vs glDrawArrays(GL_POINTS, ...))
   glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset(0.0f, 1.0f);
 }
 
 void GeoBox_App::main_loop() {
   while (!glfwWindowShouldClose(m_window)) {
-    // Update delta time
+    if (m_is_rendering_on_demand && !is_redraw_needed()) {
+      // Events wake the loop through the callbacks, which request a redraw
+      glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT_SECONDS);
+      m_was_idle = true;
+      continue;
+    }
+    if (m_num_frames_to_render > 0) m_num_frames_to_render--;
+
+    // Update delta time, time spent idle is left out so the camera does not jump on the first frame after it
     auto current_frame_time = static_cast<float>(glfwGetTime());
-    m_delta_time = current_frame_time - m_last_frame_time;
+    m_delta_time = m_was_idle ? 0.0f : current_frame_time - m_last_frame_time;
     m_last_frame_time = current_frame_time;
+    if (!m_was_idle) m_perf_hud.add_frame_time(m_delta_time);
+    m_was_idle = false;
 
     // Poll events
     glfwPollEvents();
@@ -105,18 +139,40 @@ void GeoBox_App::main_loop() {
     process_input();
 
     // Update state
+    {
+      Perf_HUD::Phase_Scope phase(m_perf_hud, Frame_Phase::Update);
+      update_mesh_loads();
+    }
 
     // Render to framebuffer
     render();
 
     // Swap/Present framebuffer to screen
-    glfwSwapBuffers(m_window);
+    {
+      GEOBOX_PROFILE_SCOPE("Swap buffers");
+      glfwSwapBuffers(m_window);
+    }
 
     // Delay to control FPS if needed
+    wait_for_next_frame();
   }
   shutdown();
 }
 
+bool GeoBox_App::is_redraw_needed() const {
+  // Loads in flight keep rendering, for their progress bars and to pick them up once done
+  return m_num_frames_to_render > 0 || !m_mesh_loader.get_tasks().empty();
+}
+
+void GeoBox_App::wait_for_next_frame() const {
+  if (m_max_frames_per_second <= 0) return;
+  double next_frame_time = m_last_frame_time + 1.0 / m_max_frames_per_second;
+  // Waiting on events instead of sleeping handles input as it arrives
+  for (double time = glfwGetTime(); time < next_frame_time; time = glfwGetTime()) {
+    glfwWaitEventsTimeout(next_frame_time - time);
+  }
+}
+
 void GeoBox_App::init_glfw() {
   glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -180,21 +236,36 @@ void GeoBox_App::init_imgui() {
 
 bool GeoBox_App::init_shaders() {
   try {
-    m_phong_shader = std::make_shared<Shader>("resources/shaders/phong.vert", "resources/shaders/phong.frag");
+    m_phong_shader = std::make_shared<Shader>("resources/shaders/phong.vert", "resources/shaders/phong.geom",
+                                              "resources/shaders/phong.frag");
     m_unlit_shader = std::make_shared<Shader>("resources/shaders/unlit.vert", "resources/shaders/unlit.frag");
+    m_curvature_shader = std::make_shared<Shader>("resources/shaders/curvature.vert",
+                                                  "resources/shaders/curvature.geom",
+                                                  "resources/shaders/curvature.frag");
+    m_phong_object_color_uniform = m_phong_shader->get_uniform<glm::vec3>("object_color");
+    m_unlit_model_matrix_uniform = m_unlit_shader->get_uniform<glm::mat4>("model_matrix");
   } catch (const GeoBox_Error &) {
     return false;
   }
+  m_frame_uniform_buffer = std::make_shared<Uniform_Buffer>(sizeof(Frame_Uniforms), FRAME_UNIFORMS_BINDING);
   return true;
 }
 
-void framebuffer_size_callback(const GLFWwindow * /*window*/, int width, int height) {
+void framebuffer_size_callback(const GLFWwindow *window, int width, int height) {
   glViewport(0, 0, width, height);
+  auto app = static_cast<GeoBox_App *>(glfwGetWindowUserPointer(const_cast<GLFWwindow *>(window)));
+  app->request_redraw();
+}
+
+void redraw_callback(GLFWwindow *window) {
+  auto app = static_cast<GeoBox_App *>(glfwGetWindowUserPointer(window));
+  app->request_redraw();
 }
 
 void key_callback(GLFWwindow *window, int key, int /*scancode*/, int action, int mods) {
-  if (const ImGuiIO &imgui_io = ImGui::GetIO(); imgui_io.WantCaptureKeyboard) return;
   auto app = static_cast<GeoBox_App *>(glfwGetWindowUserPointer(window));
+  app->request_redraw();
+  if (const ImGuiIO &imgui_io = ImGui::GetIO(); imgui_io.WantCaptureKeyboard) return;
   if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
     if (mods & GLFW_MOD_SHIFT) {
       app->redo();
@@ -207,6 +278,14 @@ void key_callback(GLFWwindow *window, int key, int /*scancode*/, int action, int
 void GeoBox_App::init_glfw_callbacks() {
   glfwSetFramebufferSizeCallback(m_window, (GLFWframebuffersizefun)framebuffer_size_callback);
   glfwSetKeyCallback(m_window, (GLFWkeyfun)key_callback);
+  // Any other input may change the UI or move the camera, and exposed windows must be repainted
+  glfwSetCursorPosCallback(m_window, [](GLFWwindow *window, double, double) { redraw_callback(window); });
+  glfwSetMouseButtonCallback(m_window, [](GLFWwindow *window, int, int, int) { redraw_callback(window); });
+  glfwSetScrollCallback(m_window, [](GLFWwindow *window, double, double) { redraw_callback(window); });
+  glfwSetCharCallback(m_window, [](GLFWwindow *window, unsigned int) { redraw_callback(window); });
+  glfwSetCursorEnterCallback(m_window, [](GLFWwindow *window, int) { redraw_callback(window); });
+  glfwSetWindowFocusCallback(m_window, [](GLFWwindow *window, int) { redraw_callback(window); });
+  glfwSetWindowRefreshCallback(m_window, [](GLFWwindow *window) { redraw_callback(window); });
 }
 
 void GeoBox_App::process_input() {
@@ -259,46 +338,25 @@ void GeoBox_App::process_input() {
     m_last_mouse_pos.reset();
     glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
   }
-  if (update_camera) m_camera.update();
+  if (update_camera) {
+    m_camera.update();
+    // Keys and buttons held down move the camera every frame without sending events
+    request_redraw();
+  }
 }
 
-// https://www.pbr-book.org/3ed-2018/Monte_Carlo_Integration/2D_Sampling_with_Multidimensional_Transformations#SamplingaTriangle
-[[nodiscard]] static glm::vec2 random_triangle_barycentric_coords_transform(float u0, float u1) {
-  assert(u0 >= 0.0f && u0 <= 1.0f);
-  assert(u1 >= 0.0f && u1 <= 1.0f);
-  float su0 = std::sqrt(u0);
-  return {1 - su0, u1 * su0};
+// Seed for one sampling operation, samplers derive a random engine per chunk from it
+[[nodiscard]] static uint64_t generate_seed(std::random_device &random_device) {
+  return (static_cast<uint64_t>(random_device()) << 32) | random_device();
 }
 
 std::vector<glm::vec3> GeoBox_App::generate_points_on_surface() {
   std::vector<glm::vec3> points;
-
-  Random_Generator<std::random_device, std::default_random_engine, std::uniform_real_distribution<float>> u0_gen(
-      m_random_device, std::uniform_real_distribution(0.0f, 1.0f));
-  Random_Generator<std::random_device, std::default_random_engine, std::uniform_real_distribution<float>> u1_gen(
-      m_random_device, std::uniform_real_distribution(0.0f, 1.0f));
-
   for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
-    const std::vector<glm::vec3> &vertices = object->get_vertices();
-    const std::vector<unsigned int> &indices = object->get_indices();
-    const std::vector<float> &triangle_areas = object->get_triangle_areas();
-    // Pick a triangle randomly
-    assert(!indices.empty());
-    assert(indices.size() % 3 == 0);
-    Random_Generator<std::random_device, std::default_random_engine, std::discrete_distribution<size_t>>
-        random_index_generator(m_random_device, {triangle_areas.begin(), triangle_areas.end()});
-    // Sample points
-    for (uint32_t i = 0; i < m_points_on_surface_count; i++) {
-      size_t triangle_index = random_index_generator.generate();
-      const glm::vec3 &a = vertices[indices[triangle_index * 3 + 0]];
-      const glm::vec3 &b = vertices[indices[triangle_index * 3 + 1]];
-      const glm::vec3 &c = vertices[indices[triangle_index * 3 + 2]];
-      glm::vec3 ab = b - a;
-      glm::vec3 ac = c - a;
-      glm::vec2 uv = random_triangle_barycentric_coords_transform(u0_gen.generate(), u1_gen.generate());
-      glm::vec3 p = ab * uv.x + ac * uv.y + a;
-      points.push_back(p);
-    }
+    std::vector<glm::vec3> object_points =
+        sample_points_on_surface(object->get_vertices(), object->get_indices(), object->get_triangle_areas(),
+                                 m_points_on_surface_count, generate_seed(m_random_device));
+    points.insert(points.end(), object_points.begin(), object_points.end());
   }
   return points;
 }
@@ -317,99 +375,15 @@ void GeoBox_App::on_generate_points_on_surface_button_click() {
   }
 }
 
-// https://www.pbr-book.org/3ed-2018/Monte_Carlo_Integration/2D_Sampling_with_Multidimensional_Transformations#UniformSampleSphere
-[[nodiscard]] static glm::vec3 random_sphere_coords_transform(float u0, float u1) {
-  assert(u0 >= 0.0f && u0 <= 1.0f);
-  assert(u1 >= 0.0f && u1 <= 1.0f);
-  float z = 1.0f - 2.0f * u0;
-  float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
-  float phi = 2 * glm::pi<float>() * u1;
-  return {r * std::cos(phi), r * std::sin(phi), z};
-}
-
-[[nodiscard]] static bool is_point_in_aabb(const glm::vec3 &p, const AABB &aabb) {
-  return glm::all(glm::greaterThanEqual(p, aabb.min) && glm::lessThanEqual(p, aabb.max));
-}
-
 std::vector<glm::vec3> GeoBox_App::generate_points_in_volume() {
   std::vector<glm::vec3> result;
-  result.reserve(m_points_in_volume_count_before_filtering * m_objects.size());
-  std::vector<glm::vec3> directions;
-  directions.reserve(m_points_in_volume_num_rays);
-  {
-    std::mt19937 e1(m_random_device());
-    std::mt19937 e2(m_random_device());
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    for (uint32_t i = 0; i < m_points_in_volume_num_rays; i++) {
-      float u0 = dist(e1);
-      float u1 = dist(e2);
-      glm::vec3 d = random_sphere_coords_transform(u0, u1);
-      assert(is_close(TC::get_default(), glm::length(d), 1.0f));
-      directions.push_back(d);
-    }
-  }
+  std::vector<glm::vec3> directions = sample_directions(m_points_in_volume_num_rays, generate_seed(m_random_device));
   for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
-    const std::vector<glm::vec3> &vertices = object->get_vertices();
-    const std::vector<unsigned int> &indices = object->get_indices();
-    const std::vector<glm::vec3> &triangle_normals = object->get_triangle_normals();
-    const std::shared_ptr<BVH> &bvh = object->get_triangles_bvh();
-    const AABB &object_aabb = bvh->get_aabb();
-    std::mt19937 e1(m_random_device());
-    std::mt19937 e2(m_random_device());
-    std::mt19937 e3(m_random_device());
-    assert(object_aabb.max.x >= object_aabb.min.x);
-    assert(object_aabb.max.y >= object_aabb.min.y);
-    assert(object_aabb.max.z >= object_aabb.min.z);
-    std::uniform_real_distribution<float> x_dist(object_aabb.min.x, object_aabb.max.x);
-    std::uniform_real_distribution<float> y_dist(object_aabb.min.y, object_aabb.max.y);
-    std::uniform_real_distribution<float> z_dist(object_aabb.min.z, object_aabb.max.z);
-    for (uint32_t pi = 0; pi < m_points_in_volume_count_before_filtering; pi++) {
-      glm::vec3 p{x_dist(e1), y_dist(e2), z_dist(e3)};
-      uint32_t num_positive_hits = 0;
-      for (const glm::vec3 &rd : directions) {
-        Ray ray{p, rd};
-        float closest_hit = 100000.0f;
-        bool closest_hit_is_ray_triangle_normal_dot_product_positive = false;
-        unsigned int closest_hit_triangle_index = -1;
-        bvh->foreach_primitive(
-            [&cray = std::as_const(ray), &c_triangle_normals = std::as_const(triangle_normals),
-             &c_vertices = std::as_const(vertices), &c_indices = std::as_const(indices), &closest_hit,
-             &closest_hit_is_ray_triangle_normal_dot_product_positive, &closest_hit_triangle_index](unsigned int i) {
-              float dot_product = glm::dot(cray.direction, c_triangle_normals[i]);
-              if (is_close(TC::get_default(), dot_product, 0.0f)) {
-                // Skip triangles that are parallel and coplanar to the ray
-                return;
-              }
-              const glm::vec3 &a = c_vertices[c_indices[i * 3 + 0]];
-              const glm::vec3 &b = c_vertices[c_indices[i * 3 + 1]];
-              const glm::vec3 &c = c_vertices[c_indices[i * 3 + 2]];
-              std::optional<glm::vec3> v = intersect(TC::get_default(), Triangle{a, b, c}, {cray.origin, cray.origin + 99999.0f * cray.direction});
-              if (!v.has_value()) {
-                return;
-              }
-              float t = glm::dot((v.value() - cray.origin), cray.direction);
-              if (t < closest_hit) {
-                closest_hit = t;
-                closest_hit_is_ray_triangle_normal_dot_product_positive = (dot_product > 0.0f);
-                closest_hit_triangle_index = i;
-              }
-            },
-            [&c_ray = std::as_const(ray)](const AABB &aabb) {
-              if (is_point_in_aabb(c_ray.origin, aabb))
-                // Rays from inside the AABB necessarily intersect the AABB
-                return true;
-              std::optional<float> t = ray_aabb_intersection(c_ray, aabb);
-              if (!t.has_value()) return false;
-              assert(t.value() >= 0.0f);
-              return true;
-            },
-            [](unsigned int) { return true; });
-        if (closest_hit_is_ray_triangle_normal_dot_product_positive) num_positive_hits++;
-      }
-      if (num_positive_hits > (directions.size() / 2)) result.push_back(p);
-    }
+    std::vector<glm::vec3> object_points = sample_points_in_volume(
+        object->get_vertices(), object->get_indices(), object->get_triangle_normals(), *object->get_triangles_bvh(),
+        m_points_in_volume_count_before_filtering, directions, generate_seed(m_random_device));
+    result.insert(result.end(), object_points.begin(), object_points.end());
   }
-  result.shrink_to_fit();
   return result;
 }
 
@@ -427,62 +401,198 @@ void GeoBox_App::on_generate_points_in_volume_button_click() {
   }
 }
 
-void GeoBox_App::draw_phong_objects(const glm::mat4 &view, const glm::mat4 &projection) const {
-  m_phong_shader->use();
-  m_phong_shader->get_uniform_setter<glm::vec3>("object_color")({1.0f, 1.0f, 1.0f});
-  m_phong_shader->get_uniform_setter<glm::vec3>("light_color")({1.0f, 1.0f, 1.0f});
-  m_phong_shader->get_uniform_setter<glm::vec3>("camera_position")(m_camera.get_camera_pos());
-  m_phong_shader->get_uniform_setter<glm::mat4>("view_matrix")(view);
-  m_phong_shader->get_uniform_setter<glm::mat4>("projection_matrix")(projection);
-  auto model_matrix_uniform_setter = m_phong_shader->get_uniform_setter<glm::mat4>("model_matrix");
-  auto normal_matrix_uniform_setter = m_phong_shader->get_uniform_setter<glm::mat3>("normal_matrix");
-
-  // Avoid z-fighting with point clouds and wireframes by pushing polygon depth away a bit,
-  // thankfully this does not affect GL_POINTS or GL_LINES (if we ever need to draw them while GL_OFFSET is more than
-  // one), however when GL_POLYGON_OFFSET_POINT or GL_POLYGON_OFFSET_LINE is enabled on some implementations, it will
-  // affect GL_POINTS, and I suppose GL_LINES, so we adhere to specification and push polygons and polygons in line and
-  // point mode away instead of pulling points/lines closer
-  //
-  // Note: polygons in line or point mode are not the same as lines and points according to OpenGL specification, (i.e.
-  // glPolygonMode(GL_FRONT_AND_BACK, GL_POINT); glDrawArrays(GL_TRIANGLES, ...) vs glDrawArrays(GL_POINTS, ...))
-  float original_polygon_offset_factor;
-  float original_polygon_offset_units;
-  glGetFloatv(GL_POLYGON_OFFSET_FACTOR, &original_polygon_offset_factor);
-  glGetFloatv(GL_POLYGON_OFFSET_UNITS, &original_polygon_offset_units);
-  glPolygonOffset(0.0f, 1.0f);
+void GeoBox_App::on_plane_cut_button_click() {
+  if (glm::length(m_plane_cut_normal) == 0.0f) {
+    std::cerr << "Plane normal can not be a zero vector" << std::endl;
+    return;
+  }
+  glm::vec3 plane_normal = glm::normalize(m_plane_cut_normal);
+
+  std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> cut_objects;
+  std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> new_objects;
   for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
-    model_matrix_uniform_setter(object->get_model_matrix());
-    normal_matrix_uniform_setter(object->get_normal_matrix());
-    object->draw();
+    // Cut in object space, normals transform by the inverse transpose of the inverse model matrix (i.e. the transpose
+    // of the model matrix)
+    const glm::mat4 &model_matrix = object->get_model_matrix();
+    Plane plane{
+        .m_origin = glm::vec3(glm::inverse(model_matrix) * glm::vec4(m_plane_cut_origin, 1.0f)),
+        .m_normal = glm::normalize(glm::transpose(glm::mat3(model_matrix)) * plane_normal),
+    };
+    Plane_Cut_Result result =
+        cut_by_plane(object->get_vertices(), object->get_indices(), *object->get_triangles_bvh(), plane);
+    if (result.num_cut_triangles == 0) continue;
+    if (result.num_open_loops > 0) {
+      std::cerr << "Mesh is not watertight, " << result.num_open_loops << " cut loop(s) left uncapped" << std::endl;
+    }
+    try {
+      std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> halves;
+      for (Indexed_Triangle_Mesh *half : {&result.below, &result.above}) {
+        if (half->indices.empty()) continue;
+        halves.push_back(
+            std::make_shared<Indexed_Triangle_Mesh_Object>(std::move(*half), model_matrix, m_geometry_pool));
+      }
+      new_objects.insert(new_objects.end(), halves.begin(), halves.end());
+      cut_objects.push_back(object);
+    } catch (const GeoBox_Error &error) {
+      std::cerr << error.what() << std::endl;
+      std::cerr << "Failed to create cut object" << std::endl;
+    }
   }
-  // Restore original polygon depth offset
-  glPolygonOffset(original_polygon_offset_factor, original_polygon_offset_units);
+  if (cut_objects.empty()) return;
+  replace_objects_with_undo(cut_objects, new_objects);
 }
 
-void GeoBox_App::draw_unlit_objects(const glm::mat4 &view, const glm::mat4 &projection) const {
-  m_unlit_shader->use();
-  m_unlit_shader->get_uniform_setter<glm::mat4>("view_matrix")(view);
-  m_unlit_shader->get_uniform_setter<glm::mat4>("projection_matrix")(projection);
-  auto model_matrix_uniform_setter = m_unlit_shader->get_uniform_setter<glm::mat4>("model_matrix");
-
-  // Draw wireframes
-  int original_polygon_mode;
-  glGetIntegerv(GL_POLYGON_MODE, &original_polygon_mode);
-  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+void GeoBox_App::replace_objects(const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &old_objects,
+                                 const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &new_objects) {
+  for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : old_objects) {
+    std::erase(m_objects, object);
+  }
+  m_objects.insert(m_objects.end(), new_objects.begin(), new_objects.end());
+}
+
+void GeoBox_App::replace_objects_with_undo(
+    const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &old_objects,
+    const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &new_objects) {
+  replace_objects(old_objects, new_objects);
+  m_undo_stack.emplace([old_objects, new_objects, this]() { replace_objects(new_objects, old_objects); }, // Undo
+                       [old_objects, new_objects, this]() { replace_objects(old_objects, new_objects); }  // Redo
+  );
+}
+
+void GeoBox_App::on_convex_hull_button_click() {
+  // Hulls are built in object space and keep the model matrix of their source
+  std::vector<std::pair<std::span<const glm::vec3>, glm::mat4>> sources;
+  for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
+    sources.emplace_back(object->get_vertices(), object->get_model_matrix());
+  }
+  for (const std::shared_ptr<Point_Cloud_Object> &point_cloud_object : m_point_cloud_objects) {
+    sources.emplace_back(point_cloud_object->get_points(), point_cloud_object->get_model_matrix());
+  }
+
+  std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> hull_objects;
+  for (const auto &[points, model_matrix] : sources) {
+    std::optional<Indexed_Triangle_Mesh> hull = convex_hull(points);
+    if (!hull.has_value()) {
+      std::cerr << "Skipping convex hull of degenerate point set (fewer than 4 non-coplanar points)" << std::endl;
+      continue;
+    }
+    try {
+      hull_objects.push_back(
+          std::make_shared<Indexed_Triangle_Mesh_Object>(std::move(hull.value()), model_matrix, m_geometry_pool));
+    } catch (const GeoBox_Error &error) {
+      std::cerr << error.what() << std::endl;
+      std::cerr << "Failed to create convex hull object" << std::endl;
+    }
+  }
+  if (hull_objects.empty()) return;
+
+  m_objects.insert(m_objects.end(), hull_objects.begin(), hull_objects.end());
+  m_undo_stack.emplace(
+      [hull_objects, this]() { // Undo
+        for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : hull_objects) {
+          std::erase(m_objects, object);
+        }
+      },
+      [hull_objects, this]() { m_objects.insert(m_objects.end(), hull_objects.begin(), hull_objects.end()); } // Redo
+  );
+}
+
+void GeoBox_App::on_smooth_button_click() {
+  if (m_smoothing_settings.num_iterations == 0) return;
+  // Smoothing only moves vertices, so objects are updated in place and undo swaps vertex positions
+  std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> smoothed_objects;
+  std::vector<std::vector<glm::vec3>> old_vertices;
+  std::vector<std::vector<glm::vec3>> new_vertices;
+  for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
+    std::vector<glm::vec3> smoothed =
+        smooth(object->get_vertices(), object->get_vertex_adjacency(), m_smoothing_settings);
+    old_vertices.emplace_back(object->get_vertices().begin(), object->get_vertices().end());
+    object->set_vertices(smoothed);
+    new_vertices.push_back(std::move(smoothed));
+    smoothed_objects.push_back(object);
+  }
+  if (smoothed_objects.empty()) return;
+
+  auto set_vertices = [](const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &objects,
+                         const std::vector<std::vector<glm::vec3>> &vertices) {
+    for (size_t i = 0; i < objects.size(); i++) {
+      objects[i]->set_vertices(vertices[i]);
+    }
+  };
+  m_undo_stack.emplace(
+      [smoothed_objects, old_vertices, set_vertices]() { set_vertices(smoothed_objects, old_vertices); }, // Undo
+      [smoothed_objects, new_vertices, set_vertices]() { set_vertices(smoothed_objects, new_vertices); }  // Redo
+  );
+}
+
+void GeoBox_App::on_remesh_button_click() {
+  std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> remeshed_objects;
+  std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> new_objects;
   for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
-    model_matrix_uniform_setter(object->get_model_matrix());
-    object->draw();
+    try {
+      // Remeshed in object space, target edge length is in object space units too
+      Indexed_Triangle_Mesh mesh = remesh_isotropic(object->get_vertices(), object->get_indices(),
+                                                    *object->get_triangles_bvh(), m_remeshing_settings);
+      new_objects.push_back(std::make_shared<Indexed_Triangle_Mesh_Object>(std::move(mesh), object->get_model_matrix(),
+                                                                           m_geometry_pool));
+      remeshed_objects.push_back(object);
+    } catch (const GeoBox_Error &error) {
+      std::cerr << error.what() << std::endl;
+      std::cerr << "Failed to remesh object" << std::endl;
+    }
   }
-  glPolygonMode(GL_FRONT_AND_BACK, original_polygon_mode);
+  if (remeshed_objects.empty()) return;
+  replace_objects_with_undo(remeshed_objects, new_objects);
+}
 
-  // Draw point clouds
+void GeoBox_App::on_generate_mesh_button_click() {
+  // Generated on a worker like a loaded file, the object is created in update_mesh_loads
+  Mesh_Generator_Type type = m_generated_mesh_type;
+  uint32_t num_triangles = m_generated_mesh_num_triangles;
+  uint64_t seed = m_generated_mesh_seed;
+  m_mesh_loader.load_generated(std::string("Generated ") + get_mesh_generator_type_name(type), num_triangles,
+                               [type, num_triangles, seed]() { return generate_mesh(type, num_triangles, seed); });
+}
+
+std::vector<const Geometry_Pool::Allocation *> GeoBox_App::get_geometry_pool_allocations() const {
+  std::vector<const Geometry_Pool::Allocation *> allocations;
+  allocations.reserve(m_objects.size());
+  for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
+    allocations.push_back(&object->get_geometry_pool_allocation());
+  }
+  return allocations;
+}
+
+void GeoBox_App::draw_phong_objects() const {
+  GEOBOX_PROFILE_SCOPE("Draw shaded objects");
+  m_phong_shader->use();
+  m_phong_object_color_uniform.set({1.0f, 1.0f, 1.0f});
+  m_geometry_pool->draw(get_geometry_pool_allocations());
+}
+
+void GeoBox_App::draw_curvature_objects() const {
+  GEOBOX_PROFILE_SCOPE("Draw curvature objects");
+  assert(m_displayed_curvature_type.has_value());
+  for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
+    // Computed and uploaded on first use only
+    object->upload_vertex_curvatures(m_displayed_curvature_type.value());
+  }
+  m_curvature_shader->use();
+  m_geometry_pool->draw(get_geometry_pool_allocations());
+}
+
+void GeoBox_App::draw_point_cloud_objects() const {
+  GEOBOX_PROFILE_SCOPE("Draw point clouds");
+  m_unlit_shader->use();
   for (const std::shared_ptr<Point_Cloud_Object> &point_cloud_object : m_point_cloud_objects) {
-    model_matrix_uniform_setter(point_cloud_object->get_model_matrix());
+    m_unlit_model_matrix_uniform.set(point_cloud_object->get_model_matrix());
     point_cloud_object->draw();
   }
 }
 
 void GeoBox_App::render() {
+  GEOBOX_PROFILE_SCOPE("Render");
+  Render_State::get().reset_statistics();
   int width;
   int height;
   glfwGetFramebufferSize(m_window, &width, &height);
@@ -496,10 +606,27 @@ void GeoBox_App::render() {
   glm::mat4 view = m_camera.get_view_matrix();
   glm::mat4 projection =
       glm::perspective(glm::radians(m_perspective_fov_degrees), (float)width / (float)height, 0.01f, 1000.0f);
+  m_frame_uniform_buffer->update(Frame_Uniforms{.view_matrix = view,
+                                                .projection_matrix = projection,
+                                                .camera_position = m_camera.get_camera_pos(),
+                                                .light_color = {1.0f, 1.0f, 1.0f},
+                                                .wireframe_width = m_is_wireframe_shown ? WIREFRAME_WIDTH : 0.0f,
+                                                .viewport_size = {width, height}});
 
-  draw_phong_objects(view, projection);
-  draw_unlit_objects(view, projection);
+  {
+    Perf_HUD::Phase_Scope phase(m_perf_hud, Frame_Phase::Surfaces);
+    if (m_displayed_curvature_type.has_value()) {
+      draw_curvature_objects();
+    } else {
+      draw_phong_objects();
+    }
+  }
+  {
+    Perf_HUD::Phase_Scope phase(m_perf_hud, Frame_Phase::Point_Clouds);
+    draw_point_cloud_objects();
+  }
 
+  Perf_HUD::Phase_Scope ui_phase(m_perf_hud, Frame_Phase::UI);
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
@@ -508,11 +635,70 @@ void GeoBox_App::render() {
   // Thanks!: https://github.com/ocornut/imgui/issues/6307
   if (ImGui::BeginMainMenuBar()) {
     if (ImGui::BeginMenu("File")) {
-      if (ImGui::MenuItem(LOAD_STL_BUTTON_AND_DIALOG_TITLE)) {
+      if (ImGui::MenuItem(LOAD_MESH_BUTTON_AND_DIALOG_TITLE)) {
         IGFD::FileDialogConfig config;
         config.path = ".";
-        ImGuiFileDialog::Instance()->OpenDialog(LOAD_STL_DIALOG_KEY, LOAD_STL_BUTTON_AND_DIALOG_TITLE, ".stl", config);
+        // Any number of files, e.g. all parts of an assembly
+        config.countSelectionMax = 0;
+        ImGuiFileDialog::Instance()->OpenDialog(LOAD_MESH_DIALOG_KEY, LOAD_MESH_BUTTON_AND_DIALOG_TITLE,
+                                                LOAD_MESH_DIALOG_FILTERS, config);
       }
+      if (ImGui::MenuItem(IMPORT_DIRECTORY_BUTTON_AND_DIALOG_TITLE)) {
+        IGFD::FileDialogConfig config;
+        config.path = ".";
+        // No filters makes it a directory dialog
+        ImGuiFileDialog::Instance()->OpenDialog(IMPORT_DIRECTORY_DIALOG_KEY, IMPORT_DIRECTORY_BUTTON_AND_DIALOG_TITLE,
+                                                nullptr, config);
+      }
+      ImGui::Separator();
+      auto export_menu_item = [this](const char *label, Export_Format format, const char *extension, bool is_enabled) {
+        if (ImGui::MenuItem(label, nullptr, false, is_enabled)) {
+          m_export_format = format;
+          IGFD::FileDialogConfig config;
+          config.path = ".";
+          config.flags = ImGuiFileDialogFlags_ConfirmOverwrite;
+          ImGuiFileDialog::Instance()->OpenDialog(EXPORT_DIALOG_KEY, EXPORT_DIALOG_TITLE, extension, config);
+        }
+      };
+      export_menu_item("Export meshes as binary .stl", Export_Format::Binary_STL, ".stl", !m_objects.empty());
+      export_menu_item("Export meshes as ASCII .stl", Export_Format::ASCII_STL, ".stl", !m_objects.empty());
+      export_menu_item("Export meshes as .ply", Export_Format::Mesh_PLY, ".ply", !m_objects.empty());
+      export_menu_item("Export point clouds as .ply", Export_Format::Point_Cloud_PLY, ".ply",
+                       !m_point_cloud_objects.empty());
+#ifdef ENABLE_PROFILER
+      ImGui::Separator();
+      // Where the trace goes is shown next to the item instead of being reported after saving
+      std::string trace_file_path = (std::filesystem::temp_directory_path() / "geobox_trace.json").string();
+      if (ImGui::MenuItem("Save profiler trace", trace_file_path.c_str()) &&
+          !write_chrome_trace_file(trace_file_path)) {
+        std::cerr << "Failed to save profiler trace: " << trace_file_path << std::endl;
+      }
+#endif
+      ImGui::EndMenu();
+    }
+    if (ImGui::BeginMenu("View")) {
+      if (ImGui::MenuItem("Shaded", nullptr, !m_displayed_curvature_type.has_value())) {
+        m_displayed_curvature_type.reset();
+      }
+      if (ImGui::MenuItem("Mean curvature", nullptr, m_displayed_curvature_type == Curvature_Type::Mean)) {
+        m_displayed_curvature_type = Curvature_Type::Mean;
+      }
+      if (ImGui::MenuItem("Gaussian curvature", nullptr, m_displayed_curvature_type == Curvature_Type::Gaussian)) {
+        m_displayed_curvature_type = Curvature_Type::Gaussian;
+      }
+      ImGui::Separator();
+      if (ImGui::MenuItem("Wireframe", nullptr, m_is_wireframe_shown)) {
+        m_is_wireframe_shown = !m_is_wireframe_shown;
+      }
+      if (ImGui::MenuItem("Performance overlay", nullptr, m_perf_hud.is_shown())) {
+        m_perf_hud.set_shown(!m_perf_hud.is_shown());
+      }
+      ImGui::Separator();
+      if (ImGui::MenuItem("Render on demand", nullptr, m_is_rendering_on_demand)) {
+        m_is_rendering_on_demand = !m_is_rendering_on_demand;
+      }
+      ImGui::SliderInt("Frame rate cap", &m_max_frames_per_second, 0, MAX_FRAMES_PER_SECOND_LIMIT,
+                       m_max_frames_per_second > 0 ? "%d FPS" : "None");
       ImGui::EndMenu();
     }
     ImGui::EndMainMenuBar();
@@ -524,10 +710,29 @@ void GeoBox_App::render() {
                                  main_viewport->WorkPos.y + INITIAL_IMGUI_FILE_DIALOG_WINDOW_OFFSET.y),
                           ImGuiCond_Once);
   ImGui::SetNextWindowSize(INITIAL_IMGUI_FILE_DIALOG_WINDOW_SIZE, ImGuiCond_Once);
-  if (ImGuiFileDialog::Instance()->Display(LOAD_STL_DIALOG_KEY)) {
+  if (ImGuiFileDialog::Instance()->Display(LOAD_MESH_DIALOG_KEY)) {
+    if (ImGuiFileDialog::Instance()->IsOk()) {
+      std::vector<std::string> file_paths;
+      for (const auto &[file_name, file_path] : ImGuiFileDialog::Instance()->GetSelection()) {
+        file_paths.push_back(file_path);
+      }
+      // Selection is empty when a file name was typed instead of clicked
+      if (file_paths.empty()) file_paths.push_back(ImGuiFileDialog::Instance()->GetFilePathName());
+      on_load_mesh_dialog_ok(file_paths);
+    }
+    ImGuiFileDialog::Instance()->Close();
+  }
+  if (ImGuiFileDialog::Instance()->Display(IMPORT_DIRECTORY_DIALOG_KEY)) {
+    if (ImGuiFileDialog::Instance()->IsOk()) {
+      std::string directory_path = ImGuiFileDialog::Instance()->GetCurrentPath();
+      on_import_directory_dialog_ok(directory_path);
+    }
+    ImGuiFileDialog::Instance()->Close();
+  }
+  if (ImGuiFileDialog::Instance()->Display(EXPORT_DIALOG_KEY)) {
     if (ImGuiFileDialog::Instance()->IsOk()) {
       std::string file_path = ImGuiFileDialog::Instance()->GetFilePathName();
-      on_load_stl_dialog_ok(file_path);
+      on_export_dialog_ok(file_path);
     }
     ImGuiFileDialog::Instance()->Close();
   }
@@ -559,10 +764,104 @@ void GeoBox_App::render() {
       on_generate_points_on_surface_button_click();
     }
   }
+  if (ImGui::CollapsingHeader("Plane Cut", ImGuiTreeNodeFlags_DefaultOpen)) {
+    ImGui::InputFloat3("Plane origin", glm::value_ptr(m_plane_cut_origin));
+    ImGui::InputFloat3("Plane normal", glm::value_ptr(m_plane_cut_normal));
+    if (ImGui::Button("Cut##3")) {
+      on_plane_cut_button_click();
+    }
+  }
+  if (ImGui::CollapsingHeader("Convex Hull", ImGuiTreeNodeFlags_DefaultOpen)) {
+    if (ImGui::Button("Generate##4")) {
+      on_convex_hull_button_click();
+    }
+  }
+  if (ImGui::CollapsingHeader("Smoothing", ImGuiTreeNodeFlags_DefaultOpen)) {
+    const char *smoothing_methods[] = {"Laplacian", "Taubin"};
+    int smoothing_method = static_cast<int>(m_smoothing_settings.method);
+    if (ImGui::Combo("Method", &smoothing_method, smoothing_methods, IM_ARRAYSIZE(smoothing_methods))) {
+      m_smoothing_settings.method = static_cast<Smoothing_Method>(smoothing_method);
+    }
+    uint32_t step = 1;
+    uint32_t step_fast = 10;
+    ImGui::InputScalar("Iterations", ImGuiDataType_U32, &m_smoothing_settings.num_iterations, &step, &step_fast);
+    ImGui::InputFloat("Lambda", &m_smoothing_settings.lambda);
+    if (m_smoothing_settings.method == Smoothing_Method::Taubin) {
+      ImGui::InputFloat("Mu", &m_smoothing_settings.mu);
+    }
+    if (ImGui::Button("Smooth##5")) {
+      on_smooth_button_click();
+    }
+  }
+  if (ImGui::CollapsingHeader("Remeshing", ImGuiTreeNodeFlags_DefaultOpen)) {
+    ImGui::InputFloat("Target edge length (0 for mean edge length)", &m_remeshing_settings.target_edge_length);
+    if (m_remeshing_settings.target_edge_length < 0.0f) m_remeshing_settings.target_edge_length = 0.0f;
+    uint32_t step = 1;
+    uint32_t step_fast = 10;
+    ImGui::InputScalar("Iterations##remeshing", ImGuiDataType_U32, &m_remeshing_settings.num_iterations, &step,
+                       &step_fast);
+    if (ImGui::Button("Remesh##6")) {
+      on_remesh_button_click();
+    }
+  }
+  if (ImGui::CollapsingHeader("Generate Mesh", ImGuiTreeNodeFlags_DefaultOpen)) {
+    const char *mesh_types[NUM_MESH_GENERATOR_TYPES];
+    for (size_t i = 0; i < NUM_MESH_GENERATOR_TYPES; i++) {
+      mesh_types[i] = get_mesh_generator_type_name(static_cast<Mesh_Generator_Type>(i));
+    }
+    int mesh_type = static_cast<int>(m_generated_mesh_type);
+    if (ImGui::Combo("Shape", &mesh_type, mesh_types, IM_ARRAYSIZE(mesh_types))) {
+      m_generated_mesh_type = static_cast<Mesh_Generator_Type>(mesh_type);
+    }
+    uint32_t step = 1000;
+    uint32_t step_fast = 100000;
+    if (ImGui::InputScalar("Minimum triangles", ImGuiDataType_U32, &m_generated_mesh_num_triangles, &step,
+                           &step_fast)) {
+      m_generated_mesh_num_triangles =
+          std::clamp(m_generated_mesh_num_triangles, uint32_t(1), MAX_GENERATED_MESH_NUM_TRIANGLES);
+    }
+    ImGui::InputScalar("Seed", ImGuiDataType_U32, &m_generated_mesh_seed);
+    if (ImGui::Button("Generate##7")) {
+      on_generate_mesh_button_click();
+    }
+  }
   ImGui::End();
 
+  if (!m_mesh_loader.get_tasks().empty()) {
+    ImGui::SetNextWindowPos(ImVec2(main_viewport->WorkPos.x + main_viewport->WorkSize.x,
+                                   main_viewport->WorkPos.y + main_viewport->WorkSize.y),
+                            ImGuiCond_Always, ImVec2(1.0f, 1.0f));
+    ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize);
+    if (m_mesh_loader.get_tasks().size() > 1 && ImGui::Button("Cancel all")) {
+      for (const std::shared_ptr<Mesh_Load_Task> &task : m_mesh_loader.get_tasks()) {
+        m_mesh_loader.cancel(*task);
+      }
+    }
+    for (const std::shared_ptr<Mesh_Load_Task> &task : m_mesh_loader.get_tasks()) {
+      ImGui::PushID(task.get());
+      ImGui::TextUnformatted(task->get_file_path().c_str());
+      Mesh_Load_Stage stage = task->get_stage();
+      float fraction = static_cast<float>(stage) / static_cast<float>(Mesh_Load_Stage::Done);
+      ImGui::ProgressBar(fraction, ImVec2(300.0f, 0.0f),
+                         task->is_cancelled() ? "Cancelling" : get_mesh_load_stage_name(stage));
+      ImGui::SameLine();
+      ImGui::BeginDisabled(task->is_cancelled());
+      if (ImGui::Button("Cancel")) {
+        m_mesh_loader.cancel(*task);
+      }
+      ImGui::EndDisabled();
+      ImGui::PopID();
+    }
+    ImGui::End();
+  }
+
+  m_perf_hud.draw(m_objects, m_point_cloud_objects);
+
+  GEOBOX_PROFILE_SCOPE("Draw UI");
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  // ImGui restores what it changes, but through its own GL calls
+  Render_State::get().invalidate();
 }
 
 void GeoBox_App::shutdown() {
@@ -572,28 +871,124 @@ void GeoBox_App::shutdown() {
   glfwTerminate();
 }
 
-void GeoBox_App::on_load_stl_dialog_ok(const std::string &file_path) {
+void GeoBox_App::on_load_mesh_dialog_ok(const std::vector<std::string> &file_paths) {
+  for (const std::string &file_path : file_paths) {
+    m_mesh_loader.load(file_path);
+  }
+}
+
+void GeoBox_App::on_import_directory_dialog_ok(const std::string &directory_path) {
+  std::vector<std::string> file_paths = find_mesh_files(directory_path);
+  if (file_paths.empty()) {
+    std::cerr << "No mesh files in directory: " << directory_path << std::endl;
+    return;
+  }
+  on_load_mesh_dialog_ok(file_paths);
+}
+
+void GeoBox_App::update_mesh_loads() {
 #ifdef ENABLE_SUPERLUMINAL_PERF_API
   PERFORMANCEAPI_INSTRUMENT_FUNCTION();
 #endif
-  std::optional<std::vector<Triangle>> triangles = read_stl_mesh_file(file_path);
-  if (!triangles.has_value()) {
-    std::cerr << "Failed to import .stl mesh file: " << file_path << std::endl;
-    return;
+  GEOBOX_PROFILE_SCOPE("Update mesh loads");
+  for (const std::shared_ptr<Mesh_Load_Task> &task : m_mesh_loader.take_done_tasks()) {
+    request_redraw();
+    if (task->is_cancelled()) continue;
+    try {
+      // Files with vertices only (e.g. PLY point clouds) are loaded as point clouds
+      if (task->get_point_cloud().has_value()) {
+        auto point_cloud_object =
+            std::make_shared<Point_Cloud_Object>(task->get_point_cloud().value(), glm::mat4(1.0f));
+        m_point_cloud_objects.push_back(point_cloud_object);
+        m_undo_stack.emplace(
+            [point_cloud_object, this]() { std::erase(m_point_cloud_objects, point_cloud_object); }, // Undo
+            [point_cloud_object, this]() { m_point_cloud_objects.push_back(point_cloud_object); }    // Redo
+        );
+      } else if (task->get_mesh_data().has_value() || task->get_mesh_cache_file()) {
+        // GPU upload is the only part of loading left to the main thread, cache hits are viewed in place
+        auto object =
+            task->get_mesh_data().has_value()
+                ? std::make_shared<Indexed_Triangle_Mesh_Object>(std::move(task->get_mesh_data().value()),
+                                                                 glm::mat4(1.0f), m_geometry_pool)
+                : std::make_shared<Indexed_Triangle_Mesh_Object>(task->get_mesh_cache_file(), glm::mat4(1.0f),
+                                                                 m_geometry_pool);
+        m_objects.push_back(object);
+        m_undo_stack.emplace([object, this]() { std::erase(m_objects, object); }, // Undo
+                             [object, this]() { m_objects.push_back(object); }    // Redo
+        );
+      }
+    } catch (const std::exception &error) {
+      std::cerr << error.what() << std::endl;
+      std::cerr << "Failed to create object" << std::endl;
+    }
   }
-  if (triangles->empty()) {
-    std::cerr << "Empty mesh: " << file_path << std::endl;
-    return;
+}
+
+Indexed_Triangle_Mesh GeoBox_App::merge_objects_in_world_space() const {
+  size_t num_vertices = 0;
+  size_t num_indices = 0;
+  for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
+    num_vertices += object->get_vertices().size();
+    num_indices += object->get_indices().size();
+  }
+  // Indices of the merged mesh are 32-bit, so they can only address this many vertices
+  if (num_vertices > static_cast<size_t>(std::numeric_limits<unsigned int>::max())) {
+    throw Overflow_Check_Error("Aborting export, too many vertices in total, TODO: support larger meshes");
   }
+  Indexed_Triangle_Mesh merged;
+  merged.vertices.reserve(num_vertices);
+  merged.indices.reserve(num_indices);
+  for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : m_objects) {
+    auto first_index = static_cast<unsigned int>(merged.vertices.size());
+    const glm::mat4 &model_matrix = object->get_model_matrix();
+    for (const glm::vec3 &vertex : object->get_vertices()) {
+      merged.vertices.push_back(glm::vec3(model_matrix * glm::vec4(vertex, 1.0f)));
+    }
+    for (unsigned int index : object->get_indices()) {
+      merged.indices.push_back(first_index + index);
+    }
+  }
+  return merged;
+}
 
+std::vector<glm::vec3> GeoBox_App::merge_point_clouds_in_world_space() const {
+  std::vector<glm::vec3> merged;
+  for (const std::shared_ptr<Point_Cloud_Object> &object : m_point_cloud_objects) {
+    const glm::mat4 &model_matrix = object->get_model_matrix();
+    for (const glm::vec3 &point : object->get_points()) {
+      merged.push_back(glm::vec3(model_matrix * glm::vec4(point, 1.0f)));
+    }
+  }
+  return merged;
+}
+
+void GeoBox_App::on_export_dialog_ok(const std::string &file_path) const {
+#ifdef ENABLE_SUPERLUMINAL_PERF_API
+  PERFORMANCEAPI_INSTRUMENT_FUNCTION();
+#endif
+  GEOBOX_PROFILE_SCOPE("Export");
+  bool is_written = false;
   try {
-    auto object = std::make_shared<Indexed_Triangle_Mesh_Object>(triangles.value(), glm::mat4(1.0f));
-    m_objects.push_back(object);
-    m_undo_stack.emplace([object, this]() { std::erase(m_objects, object); }, // Undo
-                         [object, this]() { m_objects.push_back(object); }    // Redo
-    );
+    switch (m_export_format) {
+    case Export_Format::Binary_STL:
+      is_written = write_stl_mesh_file_binary(file_path, merge_objects_in_world_space());
+      break;
+    case Export_Format::ASCII_STL:
+      is_written = write_stl_mesh_file_ascii(file_path, merge_objects_in_world_space());
+      break;
+    case Export_Format::Mesh_PLY: {
+      Indexed_Triangle_Mesh mesh = merge_objects_in_world_space();
+      is_written = write_ply_file(file_path, mesh.vertices, mesh.indices);
+      break;
+    }
+    case Export_Format::Point_Cloud_PLY:
+      is_written = write_ply_file(file_path, merge_point_clouds_in_world_space(), {});
+      break;
+    }
   } catch (const GeoBox_Error &error) {
     std::cerr << error.what() << std::endl;
-    std::cerr << "Failed to create object" << std::endl;
+  }
+  if (!is_written) {
+    std::cerr << "Failed to export file: " << file_path << std::endl;
   }
 }
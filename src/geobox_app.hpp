@@ -14,10 +14,17 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "curvature.hpp"
+#include "geometry_pool.hpp"
 #include "indexed_triangle_mesh_object.hpp"
+#include "mesh_generators.hpp"
+#include "mesh_loader.hpp"
 #include "orbit_camera.hpp"
+#include "perf_hud.hpp"
 #include "point_cloud_object.hpp"
+#include "remeshing.hpp"
 #include "shader.hpp"
+#include "smoothing.hpp"
 
 constexpr float DEFAULT_ORBIT_CAMERA_INCLINATION_RADIANS = 0.0f;
 // Azimuth is relative to +X, so we can make default value -pi/2 (-90 degrees) to make the default camera right vector
@@ -31,8 +38,30 @@ constexpr uint32_t DEFAULT_POINTS_ON_SURFACE_COUNT = 100;
 constexpr uint32_t DEFAULT_POINTS_IN_VOLUME_COUNT_BEFORE_FILTERING = 10000;
 constexpr uint32_t DEFAULT_POINTS_IN_VOLUME_NUM_RAYS = 10;
 
+constexpr glm::vec3 DEFAULT_PLANE_CUT_ORIGIN = glm::vec3(0.0f);
+constexpr glm::vec3 DEFAULT_PLANE_CUT_NORMAL = glm::vec3(0.0f, 0.0f, 1.0f);
+
+constexpr uint32_t DEFAULT_SMOOTHING_NUM_ITERATIONS = 10;
+
+constexpr uint32_t DEFAULT_GENERATED_MESH_NUM_TRIANGLES = 100000;
+// Scale tests go up to 100M triangles, which with normals and BVH take over 10 GB
+constexpr uint32_t MAX_GENERATED_MESH_NUM_TRIANGLES = 100000000;
+
 constexpr float DEFAULT_PERSPECTIVE_FOV_DEGREES = 45.0f;
 
+// In pixels
+constexpr float WIREFRAME_WIDTH = 1.0f;
+
+// Zero for no cap
+constexpr int DEFAULT_MAX_FRAMES_PER_SECOND = 60;
+constexpr int MAX_FRAMES_PER_SECOND_LIMIT = 240;
+// ImGui needs a couple of frames after an event to settle (e.g. hover states and window sizes)
+constexpr int NUM_FRAMES_RENDERED_PER_REDRAW = 3;
+// Longest time spent blocked waiting for events while rendering on demand
+constexpr double IDLE_WAIT_TIMEOUT_SECONDS = 0.5;
+
+enum class Export_Format { Binary_STL, ASCII_STL, Mesh_PLY, Point_Cloud_PLY };
+
 struct Undo_Redo_Entry {
   std::function<void()> undo;
   std::function<void()> redo;
@@ -52,6 +81,20 @@ private:
 
   std::shared_ptr<Shader> m_phong_shader;
   std::shared_ptr<Shader> m_unlit_shader;
+  std::shared_ptr<Shader> m_curvature_shader;
+
+  // Resolved once in init_shaders
+  Uniform<glm::vec3> m_phong_object_color_uniform;
+  Uniform<glm::mat4> m_unlit_model_matrix_uniform;
+  // Backs the Frame_Uniforms block of all shaders
+  std::shared_ptr<Uniform_Buffer> m_frame_uniform_buffer;
+  // Holds the GPU meshes of all objects, including the ones only kept alive by the undo stack
+  std::shared_ptr<Geometry_Pool> m_geometry_pool;
+
+  // Objects are colour mapped by this curvature instead of Phong shaded when set
+  std::optional<Curvature_Type> m_displayed_curvature_type;
+  // Drawn over the surfaces in the same pass
+  bool m_is_wireframe_shown = true;
 
   std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> m_objects;
   std::vector<std::shared_ptr<Point_Cloud_Object>> m_point_cloud_objects;
@@ -64,6 +107,14 @@ private:
   float m_delta_time = 0.0f;      // Time between current frame and last frame
   float m_last_frame_time = 0.0f; // Time of last frame
 
+  // When set, frames are only rendered after something changed, and the main loop blocks on events in between
+  bool m_is_rendering_on_demand = true;
+  int m_max_frames_per_second = DEFAULT_MAX_FRAMES_PER_SECOND;
+  // Frames left to render before going idle again
+  int m_num_frames_to_render = NUM_FRAMES_RENDERED_PER_REDRAW;
+  // Whether the main loop blocked since the last frame, which then does not count as frame time
+  bool m_was_idle = false;
+
   std::optional<glm::vec2> m_last_mouse_pos;
 
   // Undo-Redo
@@ -103,18 +154,47 @@ private:
   // Callbacks
   friend void framebuffer_size_callback(const GLFWwindow *window, int width, int height);
   friend void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+  // For input that only needs a redraw
+  friend void redraw_callback(GLFWwindow *window);
 
   // Main-loop internals
   void process_input();
   void render();
+  // Input, camera movement, scene changes and finished loads call this, so the next frames are rendered
+  void request_redraw() { m_num_frames_to_render = NUM_FRAMES_RENDERED_PER_REDRAW; }
+  [[nodiscard]] bool is_redraw_needed() const;
+  // Blocks on events until the frame rate cap allows the next frame
+  void wait_for_next_frame() const;
   static void shutdown();
 
   // Rendering
-  void draw_phong_objects(const glm::mat4 &view, const glm::mat4 &projection) const;
-  void draw_unlit_objects(const glm::mat4 &view, const glm::mat4 &projection) const;
+  void draw_phong_objects() const;
+  void draw_curvature_objects() const;
+  // Of the objects in the scene, for drawing them all with one call
+  [[nodiscard]] std::vector<const Geometry_Pool::Allocation *> get_geometry_pool_allocations() const;
+  void draw_point_cloud_objects() const;
 
   // Dialogs
-  void on_load_stl_dialog_ok(const std::string &file_path);
+  void on_load_mesh_dialog_ok(const std::vector<std::string> &file_paths);
+  void on_import_directory_dialog_ok(const std::string &directory_path);
+  // Loads files in the background, polled every frame so finished loads become objects
+  Mesh_Loader m_mesh_loader;
+  // Frame timings, toggled from the View menu
+  Perf_HUD m_perf_hud;
+  void update_mesh_loads();
+  // Format chosen from the menu when the export dialog was opened
+  Export_Format m_export_format = Export_Format::Binary_STL;
+  void on_export_dialog_ok(const std::string &file_path) const;
+  // All mesh objects merged into one mesh in world space, throws Overflow_Check_Error when 32-bit indices can not
+  // address all of their vertices
+  [[nodiscard]] Indexed_Triangle_Mesh merge_objects_in_world_space() const;
+  [[nodiscard]] std::vector<glm::vec3> merge_point_clouds_in_world_space() const;
+
+  // Operations that turn objects into new objects, e.g. cutting and remeshing
+  void replace_objects(const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &old_objects,
+                       const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &new_objects);
+  void replace_objects_with_undo(const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &old_objects,
+                                 const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &new_objects);
 
   // Operations
   // Points on surface
@@ -127,4 +207,26 @@ private:
   uint32_t m_points_in_volume_num_rays = DEFAULT_POINTS_IN_VOLUME_NUM_RAYS;
   [[nodiscard]] std::vector<glm::vec3> generate_points_in_volume();
   void on_generate_points_in_volume_button_click();
+
+  // Plane cut
+  glm::vec3 m_plane_cut_origin = DEFAULT_PLANE_CUT_ORIGIN;
+  glm::vec3 m_plane_cut_normal = DEFAULT_PLANE_CUT_NORMAL;
+  void on_plane_cut_button_click();
+
+  // Convex hull
+  void on_convex_hull_button_click();
+
+  // Smoothing
+  Smoothing_Settings m_smoothing_settings{.num_iterations = DEFAULT_SMOOTHING_NUM_ITERATIONS};
+  void on_smooth_button_click();
+
+  // Remeshing
+  Remeshing_Settings m_remeshing_settings;
+  void on_remesh_button_click();
+
+  // Mesh generation
+  Mesh_Generator_Type m_generated_mesh_type = Mesh_Generator_Type::Sphere;
+  uint32_t m_generated_mesh_num_triangles = DEFAULT_GENERATED_MESH_NUM_TRIANGLES;
+  uint32_t m_generated_mesh_seed = 1;
+  void on_generate_mesh_button_click();
 };
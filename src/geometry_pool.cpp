@@ -0,0 +1,353 @@
+#include <algorithm> // for std::max and std::min
+#include <cassert>
+#include <iterator> // for std::prev
+#include <limits>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "geobox_exceptions.hpp"
+#include "geometry_pool.hpp"
+#include "profiler.hpp"
+#include "render_state.hpp"
+#include "shader.hpp"
+
+// Avoids regrowing the buffers for every small object
+constexpr size_t MIN_GEOMETRY_POOL_NUM_VERTICES = 65536;
+constexpr size_t MIN_GEOMETRY_POOL_NUM_INDICES = 3 * 65536;
+
+std::optional<size_t> Range_Allocator::allocate(size_t size) {
+  assert(size > 0);
+  for (auto it = m_free_ranges.begin(); it != m_free_ranges.end(); it++) {
+    auto [offset, free_size] = *it;
+    if (free_size < size) continue;
+    m_free_ranges.erase(it);
+    if (free_size > size) {
+      m_free_ranges.emplace(offset + size, free_size - size);
+    }
+    return offset;
+  }
+  return std::nullopt;
+}
+
+void Range_Allocator::free(size_t offset, size_t size) {
+  assert(size > 0 && offset + size <= m_capacity);
+  auto next = m_free_ranges.lower_bound(offset);
+  if (next != m_free_ranges.end() && offset + size == next->first) {
+    size += next->second;
+    next = m_free_ranges.erase(next);
+  }
+  if (next != m_free_ranges.begin()) {
+    auto previous = std::prev(next);
+    if (previous->first + previous->second == offset) {
+      previous->second += size;
+      return;
+    }
+  }
+  m_free_ranges.emplace(offset, size);
+}
+
+void Range_Allocator::grow(size_t capacity) {
+  assert(capacity >= m_capacity);
+  if (capacity == m_capacity) return;
+  size_t old_capacity = m_capacity;
+  m_capacity = capacity;
+  free(old_capacity, capacity - old_capacity);
+}
+
+size_t Range_Allocator::calc_grown_capacity(size_t size, size_t min_capacity, size_t max_capacity) const {
+  size_t free_size_at_end = 0;
+  if (!m_free_ranges.empty()) {
+    auto [offset, free_size] = *m_free_ranges.rbegin();
+    if (offset + free_size == m_capacity) free_size_at_end = free_size;
+  }
+  size_t needed_capacity = m_capacity + size - free_size_at_end;
+  size_t grown_capacity =
+      std::min(std::max({needed_capacity, m_capacity + m_capacity / 2, min_capacity}), max_capacity);
+  if (grown_capacity < needed_capacity) {
+    throw Overflow_Check_Error("Geometry pool is full");
+  }
+  return grown_capacity;
+}
+
+// Copies the contents of the old buffer into a new larger buffer, the old buffer is deleted
+[[nodiscard]] static unsigned int create_grown_buffer(unsigned int buffer_object, size_t old_size, size_t new_size,
+                                                      unsigned int usage) {
+  Render_State &render_state = Render_State::get();
+  unsigned int new_buffer_object;
+  glGenBuffers(1, &new_buffer_object);
+  render_state.bind_buffer(GL_COPY_WRITE_BUFFER, new_buffer_object);
+  glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(new_size), nullptr, usage);
+  if (old_size > 0) {
+    render_state.bind_buffer(GL_COPY_READ_BUFFER, buffer_object);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(old_size));
+  }
+  render_state.delete_buffer(buffer_object);
+  return new_buffer_object;
+}
+
+// Copy targets are used for uploads, so the element array binding of whichever VAO is bound is left alone
+template <typename T>
+static void upload_buffer_range(unsigned int buffer_object, size_t first, std::span<const T> data) {
+  Render_State::get().bind_buffer(GL_COPY_WRITE_BUFFER, buffer_object);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(first * sizeof(T)),
+                  static_cast<GLsizeiptr>(data.size() * sizeof(T)), data.data());
+}
+
+Geometry_Pool::Geometry_Pool() {
+  Render_State &render_state = Render_State::get();
+  glGenVertexArrays(1, &m_VAO);
+  glGenBuffers(1, &m_draw_data_buffer_object);
+  render_state.bind_buffer(GL_TEXTURE_BUFFER, m_draw_data_buffer_object);
+  glBufferData(GL_TEXTURE_BUFFER, sizeof(Draw_Data), nullptr, GL_DYNAMIC_DRAW);
+  glGenTextures(1, &m_draw_data_texture);
+  render_state.bind_texture(DRAW_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_draw_data_texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_draw_data_buffer_object);
+}
+
+Geometry_Pool::~Geometry_Pool() {
+  Render_State &render_state = Render_State::get();
+  render_state.delete_vertex_array(m_VAO);
+  render_state.delete_buffer(m_vertex_positions_buffer_object);
+  render_state.delete_buffer(m_vertex_normals_buffer_object);
+  render_state.delete_buffer(m_vertex_curvatures_buffer_object);
+  render_state.delete_buffer(m_vertex_draw_ids_buffer_object);
+  render_state.delete_buffer(m_EBO);
+  render_state.delete_texture(m_draw_data_texture);
+  render_state.delete_buffer(m_draw_data_buffer_object);
+}
+
+void Geometry_Pool::grow_vertex_buffers(size_t capacity) {
+  GEOBOX_PROFILE_SCOPE("Grow geometry pool vertex buffers");
+  size_t old_capacity = m_vertex_allocator.get_capacity();
+  m_vertex_positions_buffer_object = create_grown_buffer(
+      m_vertex_positions_buffer_object, old_capacity * sizeof(glm::vec3), capacity * sizeof(glm::vec3), GL_STATIC_DRAW);
+  m_vertex_normals_buffer_object = create_grown_buffer(
+      m_vertex_normals_buffer_object, old_capacity * sizeof(glm::vec3), capacity * sizeof(glm::vec3), GL_STATIC_DRAW);
+  if (m_vertex_curvatures_buffer_object != 0) {
+    m_vertex_curvatures_buffer_object = create_grown_buffer(
+        m_vertex_curvatures_buffer_object, old_capacity * sizeof(float), capacity * sizeof(float), GL_DYNAMIC_DRAW);
+  }
+  m_vertex_draw_ids_buffer_object =
+      create_grown_buffer(m_vertex_draw_ids_buffer_object, old_capacity * sizeof(unsigned int),
+                          capacity * sizeof(unsigned int), GL_STATIC_DRAW);
+
+  Render_State &render_state = Render_State::get();
+  render_state.bind_vertex_array(m_VAO);
+  render_state.bind_buffer(GL_ARRAY_BUFFER, m_vertex_positions_buffer_object);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+  glEnableVertexAttribArray(0);
+  render_state.bind_buffer(GL_ARRAY_BUFFER, m_vertex_normals_buffer_object);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+  glEnableVertexAttribArray(1);
+  if (m_vertex_curvatures_buffer_object != 0) {
+    render_state.bind_buffer(GL_ARRAY_BUFFER, m_vertex_curvatures_buffer_object);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), nullptr);
+    glEnableVertexAttribArray(2);
+  }
+  // Integer attribute, so IDs are not converted to floats
+  render_state.bind_buffer(GL_ARRAY_BUFFER, m_vertex_draw_ids_buffer_object);
+  glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(unsigned int), nullptr);
+  glEnableVertexAttribArray(3);
+
+  m_vertex_allocator.grow(capacity);
+}
+
+void Geometry_Pool::grow_index_buffer(size_t capacity) {
+  GEOBOX_PROFILE_SCOPE("Grow geometry pool index buffer");
+  size_t old_capacity = m_index_allocator.get_capacity();
+  m_EBO = create_grown_buffer(m_EBO, old_capacity * sizeof(unsigned int), capacity * sizeof(unsigned int),
+                              GL_STATIC_DRAW);
+  // Element array binding is part of the VAO, so it is bound directly
+  Render_State::get().bind_vertex_array(m_VAO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+
+  m_index_allocator.grow(capacity);
+}
+
+void Geometry_Pool::create_vertex_curvatures_buffer() {
+  // Zeroed, so objects without curvatures of their own still read zero
+  size_t capacity = m_vertex_allocator.get_capacity();
+  m_vertex_curvatures_buffer_object = create_grown_buffer(0, 0, capacity * sizeof(float), GL_DYNAMIC_DRAW);
+  upload_buffer_range<float>(m_vertex_curvatures_buffer_object, 0, std::vector<float>(capacity, 0.0f));
+  Render_State &render_state = Render_State::get();
+  render_state.bind_vertex_array(m_VAO);
+  render_state.bind_buffer(GL_ARRAY_BUFFER, m_vertex_curvatures_buffer_object);
+  glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), nullptr);
+  glEnableVertexAttribArray(2);
+}
+
+Geometry_Pool::Allocation Geometry_Pool::allocate(std::span<const glm::vec3> vertices,
+                                                  std::span<const glm::vec3> vertex_normals,
+                                                  std::span<const unsigned int> indices, const glm::mat4 &model_matrix,
+                                                  const glm::mat3 &normal_matrix) {
+  assert(vertex_normals.size() == vertices.size());
+  if (indices.size() > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    throw Overflow_Check_Error("Aborting GPU mesh creation, too many indices, TODO: support larger meshes");
+  }
+  Allocation allocation;
+  allocation.num_vertices = vertices.size();
+  allocation.num_indices = indices.size();
+
+  // Empty meshes take no range of the buffers, allocators only hand out non-empty ranges
+  std::optional<size_t> first_vertex =
+      vertices.empty() ? std::optional<size_t>(0) : m_vertex_allocator.allocate(vertices.size());
+  if (!first_vertex.has_value()) {
+    // Base vertices of the multi-draw call are ints
+    grow_vertex_buffers(m_vertex_allocator.calc_grown_capacity(
+        vertices.size(), MIN_GEOMETRY_POOL_NUM_VERTICES, static_cast<size_t>(std::numeric_limits<int>::max())));
+    first_vertex = m_vertex_allocator.allocate(vertices.size());
+  }
+  std::optional<size_t> first_index =
+      indices.empty() ? std::optional<size_t>(0) : m_index_allocator.allocate(indices.size());
+  if (!first_index.has_value()) {
+    // The vertex range would leak if the index buffer cannot grow
+    try {
+      size_t max_num_indices = std::numeric_limits<GLsizeiptr>::max() / sizeof(unsigned int);
+      grow_index_buffer(
+          m_index_allocator.calc_grown_capacity(indices.size(), MIN_GEOMETRY_POOL_NUM_INDICES, max_num_indices));
+    } catch (...) {
+      if (!vertices.empty()) m_vertex_allocator.free(first_vertex.value(), vertices.size());
+      throw;
+    }
+    first_index = m_index_allocator.allocate(indices.size());
+  }
+  assert(first_vertex.has_value() && first_index.has_value());
+  allocation.first_vertex = first_vertex.value();
+  allocation.first_index = first_index.value();
+
+  if (m_free_draw_ids.empty()) {
+    allocation.draw_id = static_cast<unsigned int>(m_draw_data.size());
+    m_draw_data.emplace_back();
+  } else {
+    allocation.draw_id = m_free_draw_ids.back();
+    m_free_draw_ids.pop_back();
+  }
+  Draw_Data &draw_data = m_draw_data[allocation.draw_id];
+  draw_data = {.model_matrix = model_matrix,
+               .normal_matrix_columns = {glm::vec4(normal_matrix[0], 0.0f), glm::vec4(normal_matrix[1], 0.0f),
+                                         glm::vec4(normal_matrix[2], 0.0f)}};
+  m_is_draw_data_dirty = true;
+
+  upload_buffer_range<glm::vec3>(m_vertex_positions_buffer_object, allocation.first_vertex, vertices);
+  upload_buffer_range<glm::vec3>(m_vertex_normals_buffer_object, allocation.first_vertex, vertex_normals);
+  // Freed ranges keep the curvatures of their previous object
+  if (m_vertex_curvatures_buffer_object != 0) {
+    upload_buffer_range<float>(m_vertex_curvatures_buffer_object, allocation.first_vertex,
+                               std::vector<float>(vertices.size(), 0.0f));
+  }
+  upload_buffer_range<unsigned int>(m_vertex_draw_ids_buffer_object, allocation.first_vertex,
+                                    std::vector<unsigned int>(vertices.size(), allocation.draw_id));
+  upload_buffer_range<unsigned int>(m_EBO, allocation.first_index, indices);
+  return allocation;
+}
+
+void Geometry_Pool::free(const Allocation &allocation) {
+  if (allocation.num_vertices > 0) m_vertex_allocator.free(allocation.first_vertex, allocation.num_vertices);
+  if (allocation.num_indices > 0) m_index_allocator.free(allocation.first_index, allocation.num_indices);
+  m_free_draw_ids.push_back(allocation.draw_id);
+}
+
+void Geometry_Pool::update_vertices(const Allocation &allocation, std::span<const glm::vec3> vertices,
+                                    std::span<const glm::vec3> vertex_normals) {
+  assert(vertices.size() == allocation.num_vertices && vertex_normals.size() == allocation.num_vertices);
+  upload_buffer_range<glm::vec3>(m_vertex_positions_buffer_object, allocation.first_vertex, vertices);
+  upload_buffer_range<glm::vec3>(m_vertex_normals_buffer_object, allocation.first_vertex, vertex_normals);
+}
+
+void Geometry_Pool::update_curvatures(const Allocation &allocation, const std::vector<float> &curvatures,
+                                      float curvature_range) {
+  assert(curvatures.size() == allocation.num_vertices);
+  if (m_vertex_curvatures_buffer_object == 0) create_vertex_curvatures_buffer();
+  upload_buffer_range<float>(m_vertex_curvatures_buffer_object, allocation.first_vertex, curvatures);
+  m_draw_data[allocation.draw_id].curvature_range = curvature_range;
+  m_is_draw_data_dirty = true;
+}
+
+void Geometry_Pool::draw(const std::vector<const Allocation *> &allocations) {
+  if (allocations.empty()) return;
+  Render_State &render_state = Render_State::get();
+  if (m_is_draw_data_dirty) {
+    render_state.bind_buffer(GL_TEXTURE_BUFFER, m_draw_data_buffer_object);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(m_draw_data.size() * sizeof(Draw_Data)),
+                 m_draw_data.data(), GL_DYNAMIC_DRAW);
+    m_is_draw_data_dirty = false;
+  }
+  render_state.bind_texture(DRAW_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER, m_draw_data_texture);
+
+  m_draw_counts.clear();
+  m_draw_index_offsets.clear();
+  m_draw_base_vertices.clear();
+  for (const Allocation *allocation : allocations) {
+    m_draw_counts.push_back(static_cast<int>(allocation->num_indices));
+    // Offsets into the bound element array buffer are passed as pointers
+    m_draw_index_offsets.push_back(reinterpret_cast<const void *>(allocation->first_index * sizeof(unsigned int)));
+    m_draw_base_vertices.push_back(static_cast<int>(allocation->first_vertex));
+  }
+  render_state.bind_vertex_array(m_VAO);
+  glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_draw_counts.data(), GL_UNSIGNED_INT, m_draw_index_offsets.data(),
+                                static_cast<int>(allocations.size()), m_draw_base_vertices.data());
+}
+
+#ifdef GEOBOX_TEST_GEOMETRY_POOL
+#include "testing.hpp"
+
+// Bookkeeping of a pool growing as objects are allocated, freed and reallocated, without GL buffers behind it
+static size_t allocate_growing(Range_Allocator &allocator, size_t size, size_t max_capacity = 1000000) {
+  std::optional<size_t> offset = allocator.allocate(size);
+  if (offset.has_value()) return offset.value();
+  allocator.grow(allocator.calc_grown_capacity(size, 100, max_capacity));
+  return allocator.allocate(size).value();
+}
+
+int main() {
+  Range_Allocator allocator;
+  runtime_assert(!allocator.allocate(1).has_value());
+  allocator.grow(100);
+  runtime_assert(allocator.allocate(30) == 0);
+  runtime_assert(allocator.allocate(30) == 30);
+  runtime_assert(allocator.allocate(30) == 60);
+  runtime_assert(!allocator.allocate(20).has_value());
+
+  // Freed ranges are reused first fit, and merged with their free neighbours
+  allocator.free(0, 30);
+  allocator.free(60, 30);
+  runtime_assert(!allocator.allocate(41).has_value());
+  runtime_assert(allocator.allocate(40) == 60);
+  allocator.free(60, 40);
+  allocator.free(30, 30);
+  runtime_assert(allocator.allocate(100) == 0);
+  allocator.free(0, 100);
+  runtime_assert(allocator.allocate(10) == 0);
+  runtime_assert(allocator.allocate(10) == 10);
+  allocator.free(0, 10);
+  runtime_assert(allocator.allocate(5) == 0);
+  runtime_assert(allocator.allocate(5) == 5);
+  runtime_assert(allocator.allocate(5) == 20);
+
+  // Growing merges the new space with a free range at the end
+  allocator.grow(200);
+  runtime_assert(allocator.allocate(175) == 25);
+  runtime_assert(!allocator.allocate(1).has_value());
+
+  Range_Allocator pool;
+  runtime_assert(allocate_growing(pool, 10) == 0 && pool.get_capacity() == 100);
+  runtime_assert(allocate_growing(pool, 80) == 10 && pool.get_capacity() == 100);
+  // Grows by half, the free range at the end counts towards the new allocation
+  runtime_assert(allocate_growing(pool, 20) == 90 && pool.get_capacity() == 150);
+  // Large allocations grow by what is missing only, not by a multiple of the capacity
+  runtime_assert(allocate_growing(pool, 1000) == 110 && pool.get_capacity() == 1110);
+  // Freed ranges are reused before growing
+  pool.free(10, 80);
+  runtime_assert(allocate_growing(pool, 50) == 10 && allocate_growing(pool, 30) == 60);
+  runtime_assert(pool.get_capacity() == 1110);
+  bool has_thrown = false;
+  try {
+    allocate_growing(pool, 1000, 2000);
+  } catch (const Overflow_Check_Error &) {
+    has_thrown = true;
+  }
+  runtime_assert(has_thrown && pool.get_capacity() == 1110);
+  return 0;
+}
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Texels of the draw data texture buffer per object
+constexpr int DRAW_DATA_NUM_TEXELS = 8;
+
+// Per object data read by the shaders from the draw data texture buffer at vertex draw ID * DRAW_DATA_NUM_TEXELS,
+// matches the texel fetches in the mesh shaders
+struct Draw_Data {
+  glm::mat4 model_matrix{1.0f};
+  // Columns are padded to whole texels
+  glm::vec4 normal_matrix_columns[3] = {};
+  float curvature_range = 0.0f;
+  float padding[3] = {};
+};
+static_assert(sizeof(Draw_Data) == DRAW_DATA_NUM_TEXELS * sizeof(glm::vec4), "Draw_Data must be whole texels");
+
+// First fit allocation of ranges in [0, capacity), adjacent free ranges are merged
+class Range_Allocator {
+private:
+  size_t m_capacity = 0;
+  // Offset to size
+  std::map<size_t, size_t> m_free_ranges;
+
+public:
+  // Offset of the range, empty if no free range is large enough
+  [[nodiscard]] std::optional<size_t> allocate(size_t size);
+  void free(size_t offset, size_t size);
+  // Appends free space to the end, capacity must not shrink
+  void grow(size_t capacity);
+  // Capacity that fits an allocation of size after growing, counting the free range at the end, grows by half at
+  // least so many small allocations only regrow a few times, throws Overflow_Check_Error beyond max_capacity
+  [[nodiscard]] size_t calc_grown_capacity(size_t size, size_t min_capacity, size_t max_capacity) const;
+
+  [[nodiscard]] size_t get_capacity() const { return m_capacity; }
+};
+
+// Vertex and index data of all mesh objects in shared GPU buffers, so any number of objects is drawn by a single
+// multi-draw call, each vertex carries the draw ID of its object to find its Draw_Data
+class Geometry_Pool {
+public:
+  struct Allocation {
+    unsigned int draw_id = 0;
+    size_t first_vertex = 0;
+    size_t num_vertices = 0;
+    size_t first_index = 0;
+    size_t num_indices = 0;
+  };
+
+private:
+  unsigned int m_VAO = 0;
+  unsigned int m_vertex_positions_buffer_object = 0;
+  unsigned int m_vertex_normals_buffer_object = 0;
+  // Created on the first curvature update, until then the curvature attribute is disabled and reads as zero
+  unsigned int m_vertex_curvatures_buffer_object = 0;
+  unsigned int m_vertex_draw_ids_buffer_object = 0;
+  unsigned int m_EBO = 0;
+  unsigned int m_draw_data_buffer_object = 0;
+  unsigned int m_draw_data_texture = 0;
+
+  Range_Allocator m_vertex_allocator;
+  Range_Allocator m_index_allocator;
+
+  // Indexed by draw ID, uploaded on the next draw when changed
+  std::vector<Draw_Data> m_draw_data;
+  std::vector<unsigned int> m_free_draw_ids;
+  bool m_is_draw_data_dirty = false;
+
+  // Arguments of the multi-draw call, kept to avoid allocating every frame
+  std::vector<int> m_draw_counts;
+  std::vector<const void *> m_draw_index_offsets;
+  std::vector<int> m_draw_base_vertices;
+
+  // Moves the contents to larger buffers, the VAO is updated to point at them
+  void grow_vertex_buffers(size_t capacity);
+  void grow_index_buffer(size_t capacity);
+  void create_vertex_curvatures_buffer();
+
+public:
+  // GPU memory is freed in destructor,
+  // avoid double free by disabling copy constructor and copy assignment operator
+  Geometry_Pool(const Geometry_Pool &) = delete;
+  Geometry_Pool &operator=(const Geometry_Pool &) = delete;
+
+  Geometry_Pool();
+  ~Geometry_Pool();
+
+  // Indices are relative to the object's own vertices, curvatures start zeroed
+  [[nodiscard]] Allocation allocate(std::span<const glm::vec3> vertices, std::span<const glm::vec3> vertex_normals,
+                                    std::span<const unsigned int> indices, const glm::mat4 &model_matrix,
+                                    const glm::mat3 &normal_matrix);
+  void free(const Allocation &allocation);
+
+  // Number of vertices must match the allocation
+  void update_vertices(const Allocation &allocation, std::span<const glm::vec3> vertices,
+                       std::span<const glm::vec3> vertex_normals);
+  void update_curvatures(const Allocation &allocation, const std::vector<float> &curvatures, float curvature_range);
+
+  // Draws the allocations with a single glMultiDrawElementsBaseVertex call, binds the pool's VAO and the draw data
+  // texture at DRAW_DATA_TEXTURE_UNIT
+  void draw(const std::vector<const Allocation *> &allocations);
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+// CPU-only indexed triangle mesh, every 3 consecutive indices form a triangle
+struct Indexed_Triangle_Mesh {
+  std::vector<glm::vec3> vertices;
+  std::vector<unsigned int> indices;
+};
@@ -1,229 +1,312 @@
 #include <cassert>
-#include <cstdlib> // for std::div
 #include <iostream>
 #include <memory>  // for std::make_shared
-#include <utility> // for std::as_const
-
-#include <glad/glad.h>
-#include <glm/gtx/norm.hpp>
+#include <utility> // for std::move
 
 #include "bvh.hpp"
 #include "geobox_exceptions.hpp"
+#include "geometry_pool.hpp"
+#include "indexed_triangle_mesh.hpp"
 #include "indexed_triangle_mesh_object.hpp"
+#include "mesh_cache.hpp"
+#include "parallel.hpp"
 #include "primitives.hpp"
+#include "profiler.hpp"
+#include "scratch_arena.hpp"
+#include "vertex_welder.hpp"
 
-[[nodiscard]] static glm::vec3 closest_point_in_aabb(const glm::vec3 &point, const AABB &aabb) {
-  return glm::clamp(point, aabb.min, aabb.max);
-}
-
-[[nodiscard]] static float point_aabb_distance_squared(const glm::vec3 &point, const AABB &aabb) {
-  return glm::distance2(point, closest_point_in_aabb(point, aabb));
-}
-
-struct Sphere {
-  glm::vec3 center;
-  float radius;
-};
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 16384;
 
-[[nodiscard]] static bool sphere_aabb_intersection(const Sphere &sphere, const AABB &aabb) {
-  return point_aabb_distance_squared(sphere.center, aabb) <= (sphere.radius * sphere.radius);
-}
-
-Indexed_Triangle_Mesh_Object::Indexed_Triangle_Mesh_Object(const std::vector<Triangle> &triangles,
-                                                           const glm::mat4 &model_matrix) {
+[[nodiscard]] static Indexed_Triangle_Mesh weld_vertices(const std::vector<Triangle> &triangles) {
+  GEOBOX_PROFILE_SCOPE("Weld vertices");
   if (triangles.empty()) {
     throw GeoBox_Error("Empty mesh");
   }
-
-  m_model_matrix = model_matrix;
-  m_normal_matrix = glm::transpose(glm::inverse(model_matrix));
-
-  size_t num_vertices = triangles.size() * 3;
-
-  std::vector<AABB> vertices_as_bounding_boxes;
-  vertices_as_bounding_boxes.reserve(num_vertices);
+  Scratch_Scope scratch;
+  Vertex_Welder welder(DEFAULT_WELD_RANGE, scratch.get_resource());
+  welder.reserve(triangles.size());
   for (const Triangle &triangle : triangles) {
-    for (int i = 0; i < 3; i++) {
-      const glm::vec3 &v = triangle[i];
-      AABB aabb{
-          .min = v,
-          .max = v,
-      };
-      vertices_as_bounding_boxes.push_back(aabb);
-    }
+    welder.add_triangle(triangle);
   }
+  return welder.finish();
+}
 
-  std::shared_ptr<BVH> bvh;
-  try {
-    bvh = std::make_shared<BVH>(vertices_as_bounding_boxes);
-  } catch (const GeoBox_Error &) {
-    std::cerr << "Failed to build vertices BVH" << std::endl;
-    throw; // rethrows original error
-  }
-  assert(bvh->count_primitives() == num_vertices);
-  std::cout << "Num nodes = " << bvh->count_nodes() << std::endl;
-  std::cout << "Max node size = " << bvh->calc_max_leaf_size() << std::endl;
-
-  std::vector<unsigned int> indices(num_vertices);
-  std::vector<bool> is_remapped_vec(num_vertices, false);
-  std::vector<glm::vec3> unique_vertices;
-  unique_vertices.reserve(num_vertices);
-
-  auto get_ith_vertex = [&triangles](unsigned int i) -> const glm::vec3 & {
-    auto div = std::ldiv(i, 3);
-    size_t triangle_index = div.quot;
-    assert(triangle_index >= 0 && triangle_index < triangles.size());
-    size_t vertex_index_in_triangle = div.rem;
-    assert(vertex_index_in_triangle >= 0 && vertex_index_in_triangle <= 2);
-    return triangles[triangle_index][vertex_index_in_triangle];
-  };
+[[nodiscard]] static std::pmr::vector<AABB> calc_triangle_bounding_boxes(std::span<const glm::vec3> vertices,
+                                                                         std::span<const unsigned int> indices,
+                                                                         std::pmr::memory_resource *resource) {
+  std::pmr::vector<AABB> triangle_bounding_boxes(indices.size() / 3, resource);
+  parallel_for(0, triangle_bounding_boxes.size(), MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const glm::vec3 &a = vertices[indices[i * 3 + 0]];
+      const glm::vec3 &b = vertices[indices[i * 3 + 1]];
+      const glm::vec3 &c = vertices[indices[i * 3 + 2]];
+      triangle_bounding_boxes[i] = {
+          .min = glm::min(a, glm::min(b, c)),
+          .max = glm::max(a, glm::max(b, c)),
+      };
+    }
+  });
+  return triangle_bounding_boxes;
+}
 
-  unsigned int final_unique_vertex_index = 0;
-  for (unsigned int original_unique_vertex_index = 0; original_unique_vertex_index < num_vertices;
-       original_unique_vertex_index++) {
-    // Skip already remapped vertex
-    if (is_remapped_vec[original_unique_vertex_index])
-      continue;
-    const glm::vec3 &unique_vertex = get_ith_vertex(original_unique_vertex_index);
-    constexpr float range = 0.0001f;
-    Sphere sphere{.center = unique_vertex, .radius = range};
-
-    auto duplicate_vertex_callback = [final_unique_vertex_index, &is_remapped_vec,
-                                      &indices](unsigned int duplicate_vertex_index) {
-      if (!is_remapped_vec[duplicate_vertex_index]) {
-        indices[duplicate_vertex_index] = final_unique_vertex_index;
-        is_remapped_vec[duplicate_vertex_index] = true;
-      }
-    };
-    auto aabb_filter = [&const_sphere = std::as_const(sphere)](const AABB &aabb) {
-      return sphere_aabb_intersection(const_sphere, aabb);
-    };
-    auto primitive_filter = [&unique_vertex, &get_ith_vertex](unsigned int potential_duplicate_vertex_index) {
-      return glm::distance2(unique_vertex, get_ith_vertex(potential_duplicate_vertex_index)) <= (range * range);
-    };
-    bvh->foreach_primitive(duplicate_vertex_callback, aabb_filter, primitive_filter);
-
-    final_unique_vertex_index++;
-    unique_vertices.push_back(unique_vertex);
-  }
-  unique_vertices.shrink_to_fit();
-
-  std::cout << "Num unique vertices = " << unique_vertices.size() << std::endl;
+Indexed_Triangle_Mesh_Object::Indexed_Triangle_Mesh_Object(const std::vector<Triangle> &triangles,
+                                                           const glm::mat4 &model_matrix,
+                                                           std::shared_ptr<Geometry_Pool> geometry_pool)
+    : Indexed_Triangle_Mesh_Object(weld_vertices(triangles), model_matrix, std::move(geometry_pool)) {}
+
+static void calc_normals_and_areas(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices,
+                                   std::vector<glm::vec3> &vertex_normals, std::vector<glm::vec3> &triangle_normals,
+                                   std::vector<float> &triangle_areas) {
+  GEOBOX_PROFILE_SCOPE("Calculate normals and areas");
+  size_t num_triangles = indices.size() / 3;
+  triangle_normals.resize(num_triangles);
+  triangle_areas.resize(num_triangles);
+  parallel_for(0, num_triangles, MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const glm::vec3 &a = vertices[indices[i * 3 + 0]];
+      const glm::vec3 &b = vertices[indices[i * 3 + 1]];
+      const glm::vec3 &c = vertices[indices[i * 3 + 2]];
+      glm::vec3 cross = glm::cross(b - a, c - a);
+      triangle_normals[i] = glm::normalize(cross);
+      triangle_areas[i] = glm::length(cross) * 0.5f;
+    }
+  });
 
   // Pre-calculate number of triangles per vertex (can be used later for weighting normals)
-  std::vector<float> num_triangles_per_vertex(unique_vertices.size(), 0.0f);
+  std::vector<float> num_triangles_per_vertex(vertices.size(), 0.0f);
   for (unsigned int vi : indices) {
     num_triangles_per_vertex[vi] += 1;
   }
 
-  std::vector<glm::vec3> vertex_normals(unique_vertices.size(), glm::vec3(0.0f));
-  m_triangle_normals.reserve(triangles.size());
-  for (unsigned int i = 0; i < indices.size(); i += 3) {
-    const glm::vec3 &a = unique_vertices[indices[i + 0]];
-    const glm::vec3 &b = unique_vertices[indices[i + 1]];
-    const glm::vec3 &c = unique_vertices[indices[i + 2]];
-    glm::vec3 triangle_normal = glm::normalize(glm::cross(b - a, c - a));
-    m_triangle_normals.push_back(triangle_normal);
-    for (int j = 0; j < 3; j++) {
-      unsigned int vi = indices[i + j];
+  vertex_normals.assign(vertices.size(), glm::vec3(0.0f));
+  for (size_t i = 0; i < num_triangles; i++) {
+    for (size_t j = 0; j < 3; j++) {
+      unsigned int vi = indices[i * 3 + j];
       // Avoid overflow by dividing values while accumulating them
-      vertex_normals[vi] += triangle_normal / num_triangles_per_vertex[vi];
+      vertex_normals[vi] += triangle_normals[i] / num_triangles_per_vertex[vi];
     }
   }
   // Ensure normalized normals, since weighted sum of normals can not be guaranteed to be normalized
   // (some normals can be zero, weights might not sum up to 1.0f, etc...)
-  for (glm::vec3 &vertex_normal : vertex_normals) {
-    vertex_normal = glm::normalize(vertex_normal);
-  }
-
-  if (unique_vertices.size() > (std::numeric_limits<unsigned int>::max() / sizeof(glm::vec3))) {
-    throw Overflow_Check_Error("Aborting GPU mesh creation, too many vertices, TODO: support larger meshes");
-  }
-  auto unique_vertices_buffer_size = static_cast<unsigned int>(unique_vertices.size() * sizeof(glm::vec3));
-
-  if (indices.size() > (std::numeric_limits<int>::max() / sizeof(unsigned int))) {
-    throw Overflow_Check_Error("Aborting GPU mesh creation, too many indices, TODO: support larger meshes");
-  }
-
-  // Set CPU mesh
-  m_vertices = unique_vertices;
-  m_indices = indices;
-  m_vertex_normals = vertex_normals;
-
-  // Create new GPU mesh data
-  unsigned int VAO;
-  glGenVertexArrays(1, &VAO);
-  glBindVertexArray(VAO);
-
-  unsigned int vertex_positions_buffer_object;
-  glGenBuffers(1, &vertex_positions_buffer_object);
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_positions_buffer_object);
-  glBufferData(GL_ARRAY_BUFFER, unique_vertices_buffer_size, unique_vertices.data(), GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
-  glEnableVertexAttribArray(0);
-
-  m_num_indices = static_cast<int>(indices.size());
-  int indices_buffer_size = m_num_indices * static_cast<int>(sizeof(unsigned int));
-  unsigned int EBO;
-  glGenBuffers(1, &EBO);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_buffer_size, indices.data(), GL_STATIC_DRAW);
-
-  // Vertex normals buffer has same size as vertex positions buffer if calculated properly
-  unsigned int vertex_normals_buffer_size = unique_vertices_buffer_size;
-  unsigned int vertex_normals_buffer_object;
-  glGenBuffers(1, &vertex_normals_buffer_object);
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_normals_buffer_object);
-  glBufferData(GL_ARRAY_BUFFER, vertex_normals_buffer_size, m_vertex_normals.data(), GL_STATIC_DRAW);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
-  glEnableVertexAttribArray(1);
-
-  m_VAO = VAO;
-  m_vertex_positions_buffer_object = vertex_positions_buffer_object;
-  m_vertex_normals_buffer_object = vertex_normals_buffer_object;
-  m_EBO = EBO;
-
-  // Build BVH for triangles
-  std::vector<AABB> triangle_bounding_boxes;
-  for (unsigned int i = 0; i < indices.size(); i += 3) {
-    const glm::vec3 &a = unique_vertices[indices[i + 0]];
-    const glm::vec3 &b = unique_vertices[indices[i + 1]];
-    const glm::vec3 &c = unique_vertices[indices[i + 2]];
-    AABB aabb{
-        .min = glm::min(a, glm::min(b, c)),
-        .max = glm::max(a, glm::max(b, c)),
-    };
-    triangle_bounding_boxes.push_back(aabb);
+  parallel_for(0, vertex_normals.size(), MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      vertex_normals[i] = glm::normalize(vertex_normals[i]);
+    }
+  });
+}
+
+Indexed_Triangle_Mesh_Data Indexed_Triangle_Mesh_Data::from_mesh(Indexed_Triangle_Mesh mesh) {
+  if (mesh.vertices.empty() || mesh.indices.empty()) {
+    throw GeoBox_Error("Empty mesh");
   }
+  if (mesh.indices.size() % 3 != 0) {
+    throw GeoBox_Error("Number of indices is not a multiple of 3");
+  }
+  for (unsigned int vi : mesh.indices) {
+    if (vi >= mesh.vertices.size()) {
+      throw GeoBox_Error("Vertex index out of range");
+    }
+  }
+  Indexed_Triangle_Mesh_Data data;
+  data.vertices = std::move(mesh.vertices);
+  data.indices = std::move(mesh.indices);
+  return data;
+}
+
+static void check_mesh_cache_section_sizes(const Mesh_Cache_Sections &sections) {
+  size_t num_triangles = sections.indices.size() / 3;
+  if (sections.vertices.empty() || sections.indices.empty()) {
+    throw GeoBox_Error("Empty mesh");
+  }
+  if (sections.indices.size() % 3 != 0) {
+    throw GeoBox_Error("Number of indices is not a multiple of 3");
+  }
+  if (sections.vertex_normals.size() != sections.vertices.size() || sections.triangle_normals.size() != num_triangles ||
+      sections.triangle_areas.size() != num_triangles || sections.bvh_primitive_indices.size() != num_triangles) {
+    throw GeoBox_Error("Mesh cache sections do not match");
+  }
+}
 
+Indexed_Triangle_Mesh_Data Indexed_Triangle_Mesh_Data::from_mesh_cache(const Mesh_Cache_Sections &sections) {
+  check_mesh_cache_section_sizes(sections);
+  for (unsigned int vi : sections.indices) {
+    if (vi >= sections.vertices.size()) {
+      throw GeoBox_Error("Vertex index out of range");
+    }
+  }
+  Indexed_Triangle_Mesh_Data data;
+  data.vertices.assign(sections.vertices.begin(), sections.vertices.end());
+  data.indices.assign(sections.indices.begin(), sections.indices.end());
+  data.vertex_normals.assign(sections.vertex_normals.begin(), sections.vertex_normals.end());
+  data.triangle_normals.assign(sections.triangle_normals.begin(), sections.triangle_normals.end());
+  data.triangle_areas.assign(sections.triangle_areas.begin(), sections.triangle_areas.end());
+  data.triangles_bvh = std::make_shared<BVH>(sections.bvh_nodes, sections.bvh_primitive_indices);
+  return data;
+}
+
+void Indexed_Triangle_Mesh_Data::update_normals_and_areas() {
+  calc_normals_and_areas(vertices, indices, vertex_normals, triangle_normals, triangle_areas);
+}
+
+void Indexed_Triangle_Mesh_Data::build_triangles_bvh() {
   try {
-    m_triangles_bvh = std::make_shared<BVH>(triangle_bounding_boxes);
+    Scratch_Scope scratch;
+    triangles_bvh = std::make_shared<BVH>(calc_triangle_bounding_boxes(vertices, indices, scratch.get_resource()));
   } catch (const GeoBox_Error &) {
     std::cerr << "Failed to build triangles BVH" << std::endl;
     throw; // rethrows original error
   }
+}
+
+Mesh_Cache_Sections Indexed_Triangle_Mesh_Data::get_mesh_cache_sections() const {
+  return {
+      .vertices = vertices,
+      .indices = indices,
+      .vertex_normals = vertex_normals,
+      .triangle_normals = triangle_normals,
+      .triangle_areas = triangle_areas,
+      .bvh_nodes = triangles_bvh->get_nodes(),
+      .bvh_primitive_indices = triangles_bvh->get_primitive_indices(),
+  };
+}
+
+[[nodiscard]] static Indexed_Triangle_Mesh_Data prepare_mesh_data(Indexed_Triangle_Mesh mesh) {
+  Indexed_Triangle_Mesh_Data data = Indexed_Triangle_Mesh_Data::from_mesh(std::move(mesh));
+  data.update_normals_and_areas();
+  data.build_triangles_bvh();
+  return data;
+}
+
+Indexed_Triangle_Mesh_Object::Indexed_Triangle_Mesh_Object(Indexed_Triangle_Mesh mesh, const glm::mat4 &model_matrix,
+                                                           std::shared_ptr<Geometry_Pool> geometry_pool)
+    : Indexed_Triangle_Mesh_Object(prepare_mesh_data(std::move(mesh)), model_matrix, std::move(geometry_pool)) {}
+
+Indexed_Triangle_Mesh_Object::Indexed_Triangle_Mesh_Object(std::shared_ptr<const Mesh_Cache_File> mesh_cache_file,
+                                                           const glm::mat4 &model_matrix,
+                                                           std::shared_ptr<Geometry_Pool> geometry_pool)
+    : m_geometry_pool(std::move(geometry_pool)), m_mesh_cache_file(std::move(mesh_cache_file)) {
+  const Mesh_Cache_Sections &sections = m_mesh_cache_file->get_sections();
+  check_mesh_cache_section_sizes(sections);
+  m_model_matrix = model_matrix;
+  m_normal_matrix = glm::transpose(glm::inverse(model_matrix));
+
+  m_vertices = sections.vertices;
+  m_indices = sections.indices;
+  m_vertex_normals = sections.vertex_normals;
+  m_triangle_normals = sections.triangle_normals;
+  m_triangle_areas = sections.triangle_areas;
+  m_triangles_bvh = std::make_shared<BVH>(sections.bvh_nodes, sections.bvh_primitive_indices, m_mesh_cache_file);
+  m_geometry_pool_allocation =
+      m_geometry_pool->allocate(m_vertices, m_vertex_normals, m_indices, m_model_matrix, m_normal_matrix);
+}
+
+Indexed_Triangle_Mesh_Object::Indexed_Triangle_Mesh_Object(Indexed_Triangle_Mesh_Data data,
+                                                           const glm::mat4 &model_matrix,
+                                                           std::shared_ptr<Geometry_Pool> geometry_pool)
+    : m_geometry_pool(std::move(geometry_pool)) {
+  assert(data.triangles_bvh && data.vertex_normals.size() == data.vertices.size());
+  m_model_matrix = model_matrix;
+  m_normal_matrix = glm::transpose(glm::inverse(model_matrix));
+
+  m_owned_vertices = std::move(data.vertices);
+  m_owned_indices = std::move(data.indices);
+  m_owned_vertex_normals = std::move(data.vertex_normals);
+  m_owned_triangle_normals = std::move(data.triangle_normals);
+  m_owned_triangle_areas = std::move(data.triangle_areas);
+  m_vertices = m_owned_vertices;
+  m_indices = m_owned_indices;
+  m_vertex_normals = m_owned_vertex_normals;
+  m_triangle_normals = m_owned_triangle_normals;
+  m_triangle_areas = m_owned_triangle_areas;
+  m_triangles_bvh = std::move(data.triangles_bvh);
+  m_geometry_pool_allocation =
+      m_geometry_pool->allocate(m_vertices, m_vertex_normals, m_indices, m_model_matrix, m_normal_matrix);
+}
 
-  // Compute and store triangle areas
-  m_triangle_areas.reserve(triangles.size());
-  for (unsigned int i = 0; i < indices.size(); i += 3) {
-    const glm::vec3 &a = unique_vertices[indices[i + 0]];
-    const glm::vec3 &b = unique_vertices[indices[i + 1]];
-    const glm::vec3 &c = unique_vertices[indices[i + 2]];
-    glm::vec3 ab = b - a;
-    glm::vec3 ac = c - a;
-    float area = glm::length(glm::cross(ab, ac)) * 0.5f;
-    m_triangle_areas.push_back(area);
+void Indexed_Triangle_Mesh_Object::update_normals_and_areas() {
+  calc_normals_and_areas(m_vertices, m_indices, m_owned_vertex_normals, m_owned_triangle_normals,
+                         m_owned_triangle_areas);
+  m_vertex_normals = m_owned_vertex_normals;
+  m_triangle_normals = m_owned_triangle_normals;
+  m_triangle_areas = m_owned_triangle_areas;
+}
+
+void Indexed_Triangle_Mesh_Object::set_vertices(std::vector<glm::vec3> vertices) {
+  if (vertices.size() != m_vertices.size()) {
+    throw GeoBox_Error("Number of vertices can not change, only vertex positions can be updated");
+  }
+  // Indices stay in the mesh cache file if the object was opened from one
+  m_owned_vertices = std::move(vertices);
+  m_vertices = m_owned_vertices;
+  update_normals_and_areas();
+
+  // Topology is unchanged, so only the changed buffers are updated in place and the BVH is refitted instead of rebuilt
+  m_geometry_pool->update_vertices(m_geometry_pool_allocation, m_vertices, m_vertex_normals);
+
+  Scratch_Scope scratch;
+  m_triangles_bvh->refit(calc_triangle_bounding_boxes(m_vertices, m_indices, scratch.get_resource()));
+
+  m_vertex_curvatures.reset();
+  m_uploaded_curvature_type.reset();
+}
+
+const Vertex_Adjacency &Indexed_Triangle_Mesh_Object::get_vertex_adjacency() const {
+  if (!m_vertex_adjacency.has_value()) {
+    m_vertex_adjacency = build_vertex_adjacency(m_vertices.size(), m_indices);
+  }
+  return m_vertex_adjacency.value();
+}
+
+const Vertex_Curvatures &Indexed_Triangle_Mesh_Object::get_vertex_curvatures() const {
+  if (!m_vertex_curvatures.has_value()) {
+    m_vertex_curvatures = calc_vertex_curvatures(m_vertices, m_indices);
   }
+  return m_vertex_curvatures.value();
+}
+
+void Indexed_Triangle_Mesh_Object::upload_vertex_curvatures(Curvature_Type type) {
+  if (m_uploaded_curvature_type == type) return;
+  const std::vector<float> &curvatures = get_vertex_curvatures().get(type);
+  // Curvatures blow up at sharp features, the 95th percentile keeps them from washing out the rest of the colour map
+  m_uploaded_curvature_range = calc_robust_range(curvatures, 0.95f);
+  m_geometry_pool->update_curvatures(m_geometry_pool_allocation, curvatures, m_uploaded_curvature_range);
+  m_uploaded_curvature_type = type;
+}
+
+template <typename T> [[nodiscard]] static size_t calc_vector_memory_usage(const std::vector<T> &v) {
+  return v.capacity() * sizeof(T);
 }
 
-void Indexed_Triangle_Mesh_Object::draw() const {
-  glBindVertexArray(m_VAO);
-  glDrawElements(GL_TRIANGLES, m_num_indices, GL_UNSIGNED_INT, nullptr);
+size_t Indexed_Triangle_Mesh_Object::calc_cpu_memory_usage() const {
+  // Sections of a mesh cache file are mapped from the page cache rather than held by the object
+  size_t num_bytes = calc_vector_memory_usage(m_owned_vertices) + calc_vector_memory_usage(m_owned_indices) +
+                     calc_vector_memory_usage(m_owned_vertex_normals) +
+                     calc_vector_memory_usage(m_owned_triangle_areas) +
+                     calc_vector_memory_usage(m_owned_triangle_normals);
+  if (m_triangles_bvh && m_triangles_bvh->owns_storage()) {
+    num_bytes += m_triangles_bvh->get_nodes().size_bytes() + m_triangles_bvh->get_primitive_indices().size_bytes();
+  }
+  if (m_vertex_adjacency.has_value()) {
+    num_bytes += calc_vector_memory_usage(m_vertex_adjacency->offsets) +
+                 calc_vector_memory_usage(m_vertex_adjacency->neighbours);
+  }
+  if (m_vertex_curvatures.has_value()) {
+    num_bytes += calc_vector_memory_usage(m_vertex_curvatures->mean) +
+                 calc_vector_memory_usage(m_vertex_curvatures->gaussian) +
+                 calc_vector_memory_usage(m_vertex_curvatures->areas);
+  }
+  return num_bytes;
 }
 
-Indexed_Triangle_Mesh_Object::~Indexed_Triangle_Mesh_Object() {
-  glDeleteVertexArrays(1, &m_VAO);
-  glDeleteBuffers(1, &m_vertex_positions_buffer_object);
-  glDeleteBuffers(1, &m_vertex_normals_buffer_object);
-  glDeleteBuffers(1, &m_EBO);
+size_t Indexed_Triangle_Mesh_Object::calc_gpu_memory_usage() const {
+  // Positions, normals and draw IDs of the vertices, curvatures once uploaded, and indices, all held in the geometry
+  // pool
+  size_t num_bytes = m_vertices.size() * (sizeof(glm::vec3) * 2 + sizeof(unsigned int)) +
+                     m_indices.size() * sizeof(unsigned int);
+  if (m_uploaded_curvature_type.has_value()) {
+    num_bytes += m_vertices.size() * sizeof(float);
+  }
+  return num_bytes;
 }
+
+Indexed_Triangle_Mesh_Object::~Indexed_Triangle_Mesh_Object() { m_geometry_pool->free(m_geometry_pool_allocation); }
@@ -1,57 +1,134 @@
 #pragma once
 
+#include <memory> // for std::shared_ptr
+#include <optional>
+#include <span>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "bvh.hpp"
+#include "curvature.hpp"
+#include "geometry_pool.hpp"
+#include "indexed_triangle_mesh.hpp"
+#include "mesh_cache.hpp"
 #include "primitives.hpp"
+#include "vertex_adjacency.hpp"
+
+// CPU side of a mesh object, prepared without any GL calls so it can be done on a worker thread
+struct Indexed_Triangle_Mesh_Data {
+  std::vector<glm::vec3> vertices;
+  std::vector<unsigned int> indices;
+  std::vector<glm::vec3> vertex_normals;
+  std::vector<glm::vec3> triangle_normals;
+  std::vector<float> triangle_areas;
+  std::shared_ptr<BVH> triangles_bvh;
+
+  // Validates the mesh, normals, areas and the BVH are left to the functions below
+  [[nodiscard]] static Indexed_Triangle_Mesh_Data from_mesh(Indexed_Triangle_Mesh mesh);
+  // Validates and copies everything, nothing is recalculated and the triangles BVH is not rebuilt
+  [[nodiscard]] static Indexed_Triangle_Mesh_Data from_mesh_cache(const Mesh_Cache_Sections &sections);
+  void update_normals_and_areas();
+  void build_triangles_bvh();
+
+  // Views into the data, for writing a mesh cache file
+  [[nodiscard]] Mesh_Cache_Sections get_mesh_cache_sections() const;
+};
 
 class Indexed_Triangle_Mesh_Object {
 private:
-  // GPU Mesh
-  unsigned int m_VAO = 0;
-  // We only need VAO for drawing, but we also store VBO and EBO to update them and free them later
-  // VAO references VBO and EBO so updates will be reflected when VAO is bound again
-  unsigned int m_vertex_positions_buffer_object = 0;
-  unsigned int m_vertex_normals_buffer_object = 0;
-  unsigned int m_EBO = 0;
-  int m_num_indices = 0;
-
-  // CPU Mesh
-  std::vector<glm::vec3> m_vertices;
-  std::vector<unsigned int> m_indices;
-  std::vector<glm::vec3> m_vertex_normals;
-  std::vector<float> m_triangle_areas;
-  std::vector<glm::vec3> m_triangle_normals;
+  // GPU Mesh, a range of the shared geometry pool buffers
+  std::shared_ptr<Geometry_Pool> m_geometry_pool;
+  Geometry_Pool::Allocation m_geometry_pool_allocation;
+
+  // CPU Mesh, views into either the owned vectors below or the mapped mesh cache file
+  std::span<const glm::vec3> m_vertices;
+  std::span<const unsigned int> m_indices;
+  std::span<const glm::vec3> m_vertex_normals;
+  std::span<const float> m_triangle_areas;
+  std::span<const glm::vec3> m_triangle_normals;
+  std::vector<glm::vec3> m_owned_vertices;
+  std::vector<unsigned int> m_owned_indices;
+  std::vector<glm::vec3> m_owned_vertex_normals;
+  std::vector<float> m_owned_triangle_areas;
+  std::vector<glm::vec3> m_owned_triangle_normals;
+  // Keeps the mapping alive for objects opened from a mesh cache file
+  std::shared_ptr<const Mesh_Cache_File> m_mesh_cache_file;
 
   glm::mat4 m_model_matrix{1.0f};
   glm::mat3 m_normal_matrix{1.0f};
 
   std::shared_ptr<BVH> m_triangles_bvh;
 
+  // Lazily computed, topology never changes after construction
+  mutable std::optional<Vertex_Adjacency> m_vertex_adjacency;
+  // Lazily computed, reset when vertices move
+  mutable std::optional<Vertex_Curvatures> m_vertex_curvatures;
+  std::optional<Curvature_Type> m_uploaded_curvature_type;
+  float m_uploaded_curvature_range = 0.0f;
+
+  // Recomputes triangle normals, triangle areas and vertex normals from current vertex positions
+  void update_normals_and_areas();
+
 public:
-  // GPU memory is freed in destructor,
+  // Geometry pool range is freed in destructor,
   // avoid double free by disabling copy constructor and copy assignment operator,
   // also known as the "Rule of three"
   Indexed_Triangle_Mesh_Object(const Indexed_Triangle_Mesh_Object &) = delete;
   Indexed_Triangle_Mesh_Object &operator=(const Indexed_Triangle_Mesh_Object &) = delete;
   ~Indexed_Triangle_Mesh_Object();
 
-  Indexed_Triangle_Mesh_Object(const std::vector<Triangle> &triangles, const glm::mat4 &model_matrix);
-  void draw() const;
+  // Welds duplicate vertices of the triangle soup
+  Indexed_Triangle_Mesh_Object(const std::vector<Triangle> &triangles, const glm::mat4 &model_matrix,
+                               std::shared_ptr<Geometry_Pool> geometry_pool);
+  // Uses the already indexed mesh as is, skipping vertex welding
+  Indexed_Triangle_Mesh_Object(Indexed_Triangle_Mesh mesh, const glm::mat4 &model_matrix,
+                               std::shared_ptr<Geometry_Pool> geometry_pool);
+  // Views the sections of a mesh cache file in place, nothing is copied or recalculated and the triangles BVH is not
+  // rebuilt, only section sizes are checked since cache files are trusted once their header checks out
+  Indexed_Triangle_Mesh_Object(std::shared_ptr<const Mesh_Cache_File> mesh_cache_file, const glm::mat4 &model_matrix,
+                               std::shared_ptr<Geometry_Pool> geometry_pool);
+  // Only uploads the GPU mesh into the geometry pool, data must have its normals, areas and triangles BVH already
+  Indexed_Triangle_Mesh_Object(Indexed_Triangle_Mesh_Data data, const glm::mat4 &model_matrix,
+                               std::shared_ptr<Geometry_Pool> geometry_pool);
+
+  // Bytes held by the CPU mesh, including the triangles BVH and lazily computed data
+  [[nodiscard]] size_t calc_cpu_memory_usage() const;
+  // Bytes of the GPU buffers
+  [[nodiscard]] size_t calc_gpu_memory_usage() const;
+
+  // Moves vertices (e.g. smoothing), the number of vertices must not change,
+  // normals, areas, GPU buffers and the triangles BVH are updated to match
+  void set_vertices(std::vector<glm::vec3> vertices);
+
+  // Uploads curvatures of the given type and their range into the geometry pool for colour mapped rendering, no-op if
+  // already uploaded
+  void upload_vertex_curvatures(Curvature_Type type);
+  // Robust magnitude of the uploaded curvatures, for scaling the colour map
+  [[nodiscard]] float get_uploaded_curvature_range() const { return m_uploaded_curvature_range; }
+
+  // Drawn by the geometry pool together with the other objects
+  [[nodiscard]] const Geometry_Pool::Allocation &get_geometry_pool_allocation() const {
+    return m_geometry_pool_allocation;
+  }
 
   [[nodiscard]] const glm::mat4 &get_model_matrix() const { return m_model_matrix; }
 
   [[nodiscard]] const glm::mat3 &get_normal_matrix() const { return m_normal_matrix; }
 
-  [[nodiscard]] const std::vector<glm::vec3> &get_vertices() const { return m_vertices; }
+  [[nodiscard]] std::span<const glm::vec3> get_vertices() const { return m_vertices; }
 
-  [[nodiscard]] const std::vector<unsigned int> &get_indices() const { return m_indices; }
+  [[nodiscard]] std::span<const unsigned int> get_indices() const { return m_indices; }
 
-  [[nodiscard]] const std::vector<float> &get_triangle_areas() const { return m_triangle_areas; }
+  [[nodiscard]] std::span<const float> get_triangle_areas() const { return m_triangle_areas; }
 
   [[nodiscard]] const std::shared_ptr<BVH> &get_triangles_bvh() const { return m_triangles_bvh; }
 
-  [[nodiscard]] const std::vector<glm::vec3> &get_triangle_normals() const { return m_triangle_normals; }
+  [[nodiscard]] std::span<const glm::vec3> get_triangle_normals() const { return m_triangle_normals; }
+
+  [[nodiscard]] std::span<const glm::vec3> get_vertex_normals() const { return m_vertex_normals; }
+
+  [[nodiscard]] const Vertex_Adjacency &get_vertex_adjacency() const;
+
+  [[nodiscard]] const Vertex_Curvatures &get_vertex_curvatures() const;
 };
@@ -0,0 +1,118 @@
+#include <algorithm> // for std::min
+#include <iostream>  // for std::cerr and std::endl
+#include <optional>
+#include <string>
+#include <utility>   // for std::exchange
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap, madvise and munmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+#endif
+
+#include "mapped_file.hpp"
+
+Mapped_File::Mapped_File(Mapped_File &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)) {}
+
+Mapped_File &Mapped_File::operator=(Mapped_File &&other) noexcept {
+  if (this != &other) {
+    Mapped_File old(std::move(*this)); // unmapped when going out of scope
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+  }
+  return *this;
+}
+
+#ifdef _WIN32
+Mapped_File::~Mapped_File() {
+  if (m_data != nullptr) UnmapViewOfFile(m_data);
+}
+
+std::optional<Mapped_File> Mapped_File::open(const std::string &file_path) {
+  HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    std::cerr << "Failed to open file: " << file_path << std::endl;
+    return {};
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    std::cerr << "Failed to get size of file: " << file_path << std::endl;
+    return {};
+  }
+  if (file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return Mapped_File(nullptr, 0);
+  }
+  // Mapping and view keep the file open, handles are not needed after mapping
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    std::cerr << "Failed to map file: " << file_path << std::endl;
+    return {};
+  }
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == nullptr) {
+    std::cerr << "Failed to map file: " << file_path << std::endl;
+    return {};
+  }
+  return Mapped_File(static_cast<const std::byte *>(data), static_cast<size_t>(file_size.QuadPart));
+}
+
+void Mapped_File::discard(size_t, size_t) const {
+  // No equivalent for read-only views, the system trims their pages under memory pressure
+}
+#else
+Mapped_File::~Mapped_File() {
+  if (m_data != nullptr) munmap(const_cast<std::byte *>(m_data), m_size);
+}
+
+std::optional<Mapped_File> Mapped_File::open(const std::string &file_path) {
+  int file_descriptor = ::open(file_path.c_str(), O_RDONLY);
+  if (file_descriptor == -1) {
+    std::cerr << "Failed to open file: " << file_path << std::endl;
+    return {};
+  }
+  struct stat file_status {};
+  if (fstat(file_descriptor, &file_status) == -1) {
+    close(file_descriptor);
+    std::cerr << "Failed to get size of file: " << file_path << std::endl;
+    return {};
+  }
+  auto file_size = static_cast<size_t>(file_status.st_size);
+  if (file_size == 0) {
+    close(file_descriptor);
+    return Mapped_File(nullptr, 0);
+  }
+  // Mapping keeps the file open, descriptor is not needed after mapping
+  void *data = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  close(file_descriptor);
+  if (data == MAP_FAILED) {
+    std::cerr << "Failed to map file: " << file_path << std::endl;
+    return {};
+  }
+  // Whole file is about to be read, start reading ahead right away
+  madvise(data, file_size, MADV_WILLNEED);
+  return Mapped_File(static_cast<const std::byte *>(data), file_size);
+}
+
+void Mapped_File::discard(size_t offset, size_t size) const {
+  // Only whole pages inside the range can be dropped
+  auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t begin = (offset + page_size - 1) / page_size * page_size;
+  size_t end = std::min(offset + size, m_size) / page_size * page_size;
+  if (begin < end) madvise(const_cast<std::byte *>(m_data) + begin, end - begin, MADV_DONTNEED);
+}
+#endif
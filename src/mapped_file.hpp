@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+// Read-only memory mapping of a whole file, unmapped in destructor
+class Mapped_File {
+private:
+  const std::byte *m_data = nullptr;
+  size_t m_size = 0;
+
+  Mapped_File(const std::byte *data, size_t size) : m_data(data), m_size(size) {}
+
+public:
+  // Mapping is unmapped in destructor,
+  // avoid double unmap by disabling copy constructor and copy assignment operator, moving transfers ownership
+  Mapped_File(const Mapped_File &) = delete;
+  Mapped_File &operator=(const Mapped_File &) = delete;
+  Mapped_File(Mapped_File &&other) noexcept;
+  Mapped_File &operator=(Mapped_File &&other) noexcept;
+  ~Mapped_File();
+
+  // Empty files are mapped as a null pointer with zero size
+  [[nodiscard]] static std::optional<Mapped_File> open(const std::string &file_path);
+
+  [[nodiscard]] const std::byte *get_data() const { return m_data; }
+
+  [[nodiscard]] size_t get_size() const { return m_size; }
+
+  // Hints that [offset, offset + size) is not needed anymore, its pages may be dropped from memory and are read from
+  // the file again if accessed, lets streaming readers keep memory usage bounded
+  void discard(size_t offset, size_t size) const;
+};
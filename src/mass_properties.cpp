@@ -0,0 +1,145 @@
+#include <array>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mass_properties.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
+constexpr size_t MASS_PROPERTIES_CHUNK_SIZE = 16384;
+
+namespace {
+// Surface area, then integrals of 1, x, y, z, x^2, y^2, z^2, xy, yz and zx over the volume, unscaled
+using Mass_Integrals = std::array<double, 11>;
+
+// Sums of powers of the triangle's coordinates along one axis
+struct Axis_Subexpressions {
+  double f1, f2, f3, g0, g1, g2;
+
+  Axis_Subexpressions(double w0, double w1, double w2) {
+    double temp0 = w0 + w1;
+    f1 = temp0 + w2;
+    double temp1 = w0 * w0;
+    double temp2 = temp1 + w1 * temp0;
+    f2 = temp2 + w2 * f1;
+    f3 = w0 * temp1 + w1 * temp2 + w2 * f2;
+    g0 = f2 + w0 * (f1 + w0);
+    g1 = f2 + w1 * (f1 + w1);
+    g2 = f2 + w2 * (f1 + w2);
+  }
+};
+} // namespace
+
+// Relative to the origin, which should be near the mesh, since the integrals of far away meshes cancel out badly
+static void add_triangle_integrals(const glm::dvec3 &p0, const glm::dvec3 &p1, const glm::dvec3 &p2,
+                                   Mass_Integrals &integrals) {
+  glm::dvec3 d = glm::cross(p1 - p0, p2 - p0);
+  Axis_Subexpressions x(p0.x, p1.x, p2.x);
+  Axis_Subexpressions y(p0.y, p1.y, p2.y);
+  Axis_Subexpressions z(p0.z, p1.z, p2.z);
+  integrals[0] += glm::length(d);
+  integrals[1] += d.x * x.f1;
+  integrals[2] += d.x * x.f2;
+  integrals[3] += d.y * y.f2;
+  integrals[4] += d.z * z.f2;
+  integrals[5] += d.x * x.f3;
+  integrals[6] += d.y * y.f3;
+  integrals[7] += d.z * z.f3;
+  integrals[8] += d.x * (p0.y * x.g0 + p1.y * x.g1 + p2.y * x.g2);
+  integrals[9] += d.y * (p0.z * y.g0 + p1.z * y.g1 + p2.z * y.g2);
+  integrals[10] += d.z * (p0.x * z.g0 + p1.x * z.g1 + p2.x * z.g2);
+}
+
+Mass_Properties calc_mass_properties(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &indices) {
+  GEOBOX_PROFILE_SCOPE("Calculate mass properties");
+  Mass_Properties properties;
+  if (vertices.empty()) return properties;
+  glm::dvec3 origin = vertices[0];
+  Mass_Integrals integrals = parallel_reduce(
+      0, indices.size() / 3, MASS_PROPERTIES_CHUNK_SIZE, Mass_Integrals{},
+      [&](size_t begin, size_t end) {
+        Mass_Integrals chunk_integrals{};
+        for (size_t i = begin; i < end; i++) {
+          add_triangle_integrals(glm::dvec3(vertices[indices[i * 3 + 0]]) - origin,
+                                 glm::dvec3(vertices[indices[i * 3 + 1]]) - origin,
+                                 glm::dvec3(vertices[indices[i * 3 + 2]]) - origin, chunk_integrals);
+        }
+        return chunk_integrals;
+      },
+      [](Mass_Integrals a, const Mass_Integrals &b) {
+        for (size_t i = 0; i < a.size(); i++) {
+          a[i] += b[i];
+        }
+        return a;
+      });
+
+  properties.surface_area = integrals[0] / 2.0;
+  double volume = integrals[1] / 6.0;
+  properties.volume = volume;
+  if (volume == 0.0) return properties;
+  glm::dvec3 center = glm::dvec3(integrals[2], integrals[3], integrals[4]) / 24.0 / volume;
+  glm::dvec3 second_moments = glm::dvec3(integrals[5], integrals[6], integrals[7]) / 60.0;
+  glm::dvec3 products = glm::dvec3(integrals[8], integrals[9], integrals[10]) / 120.0;
+  properties.center_of_mass = origin + center;
+  // Parallel axis theorem moves the inertia from the origin to the center of mass
+  double xx = second_moments.y + second_moments.z - volume * (center.y * center.y + center.z * center.z);
+  double yy = second_moments.z + second_moments.x - volume * (center.z * center.z + center.x * center.x);
+  double zz = second_moments.x + second_moments.y - volume * (center.x * center.x + center.y * center.y);
+  double xy = -(products.x - volume * center.x * center.y);
+  double yz = -(products.y - volume * center.y * center.z);
+  double zx = -(products.z - volume * center.z * center.x);
+  properties.inertia_tensor = glm::dmat3(xx, xy, zx, xy, yy, yz, zx, yz, zz);
+  return properties;
+}
+
+#ifdef GEOBOX_TEST_MASS_PROPERTIES
+#include <algorithm> // for std::reverse and std::max
+#include <cmath>     // for std::abs
+
+#include "testing.hpp"
+
+[[nodiscard]] static bool is_near(double a, double b) { return std::abs(a - b) < 1e-6 * std::max(1.0, std::abs(b)); }
+
+int main() {
+  // Box of 2 x 1 x 1 with outward facing triangles, far from the origin
+  glm::vec3 offset(1000.0f, -2000.0f, 500.0f);
+  std::vector<glm::vec3> vertices = {{0, 0, 0}, {2, 0, 0}, {2, 1, 0}, {0, 1, 0},
+                                     {0, 0, 1}, {2, 0, 1}, {2, 1, 1}, {0, 1, 1}};
+  for (glm::vec3 &vertex : vertices) {
+    vertex += offset;
+  }
+  std::vector<unsigned int> indices = {
+      0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 7, 6, 3, 6, 2, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5,
+  };
+  Mass_Properties properties = calc_mass_properties(vertices, indices);
+  runtime_assert(is_near(properties.surface_area, 10.0));
+  runtime_assert(is_near(properties.volume, 2.0));
+  glm::dvec3 center = glm::dvec3(offset) + glm::dvec3(1.0, 0.5, 0.5);
+  runtime_assert(is_near(properties.center_of_mass.x, center.x));
+  runtime_assert(is_near(properties.center_of_mass.y, center.y));
+  runtime_assert(is_near(properties.center_of_mass.z, center.z));
+  // Solid box: I_xx = m (b^2 + c^2) / 12, products are zero about the center
+  const glm::dmat3 &inertia = properties.inertia_tensor;
+  runtime_assert(is_near(inertia[0][0], 2.0 * (1.0 + 1.0) / 12.0));
+  runtime_assert(is_near(inertia[1][1], 2.0 * (4.0 + 1.0) / 12.0));
+  runtime_assert(is_near(inertia[2][2], 2.0 * (4.0 + 1.0) / 12.0));
+  runtime_assert(is_near(inertia[0][1], 0.0) && is_near(inertia[1][2], 0.0) && is_near(inertia[0][2], 0.0));
+
+  // Unit corner tetrahedron, center of mass at the mean of its corners
+  std::vector<glm::vec3> tetrahedron = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  std::vector<unsigned int> tetrahedron_indices = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3};
+  Mass_Properties tetrahedron_properties = calc_mass_properties(tetrahedron, tetrahedron_indices);
+  runtime_assert(is_near(tetrahedron_properties.volume, 1.0 / 6.0));
+  runtime_assert(is_near(tetrahedron_properties.center_of_mass.x, 0.25));
+  // About the origin I_xx = 1/30 and I_xy = -1/120, moved to the center of mass
+  double m = 1.0 / 6.0;
+  runtime_assert(is_near(tetrahedron_properties.inertia_tensor[0][0], 1.0 / 30.0 - m * (0.0625 + 0.0625)));
+  runtime_assert(is_near(tetrahedron_properties.inertia_tensor[0][1], -1.0 / 120.0 + m * 0.0625));
+
+  // Inward facing meshes have negative volume
+  std::reverse(indices.begin(), indices.end());
+  runtime_assert(is_near(calc_mass_properties(vertices, indices).volume, -2.0));
+  return 0;
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// For unit density, inertia is about the center of mass, scale the volume and inertia by the density for other
+// materials
+struct Mass_Properties {
+  double surface_area = 0.0;
+  double volume = 0.0;
+  glm::dvec3 center_of_mass{0.0};
+  glm::dmat3 inertia_tensor{0.0};
+};
+
+// Integrals over the enclosed volume by the divergence theorem (Eberly, "Polyhedral Mass Properties (Revisited)"), so
+// the mesh should be closed and consistently oriented, volume is negative for inward facing meshes, center of mass
+// and inertia are left zero for meshes enclosing no volume
+[[nodiscard]] Mass_Properties calc_mass_properties(const std::vector<glm::vec3> &vertices,
+                                                   const std::vector<unsigned int> &indices);
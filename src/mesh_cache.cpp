@@ -0,0 +1,391 @@
+#include <algorithm> // for std::min and std::sort
+#include <array>
+#include <cstdlib>    // for std::getenv
+#include <cstring>    // for std::memcpy and std::memcmp
+#include <filesystem> // for std::filesystem::exists, std::filesystem::rename, etc...
+#include <fstream>    // for std::ofstream
+#include <iomanip>    // for std::setw and std::setfill
+#include <iostream>   // for std::cerr and std::endl
+#include <optional>
+#include <random> // for std::random_device
+#include <span>
+#include <sstream> // for std::ostringstream
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "mesh_cache.hpp"
+#include "profiler.hpp"
+
+// Bumped whenever the layout of the file or of any section (e.g. BVH::Node) changes, or the meaning of the source key
+constexpr uint32_t MESH_CACHE_FORMAT_VERSION = 2;
+constexpr std::array<char, 8> MESH_CACHE_MAGIC = {'G', 'E', 'O', 'B', 'O', 'X', 'C', '\n'};
+constexpr size_t MESH_CACHE_SECTION_ALIGNMENT = 64;
+constexpr size_t NUM_MESH_CACHE_SECTIONS = 7;
+
+namespace {
+struct Mesh_Cache_Header {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t num_sections;
+  uint64_t source_key;
+  struct Section {
+    uint64_t offset;
+    uint64_t size; // In bytes
+  } sections[NUM_MESH_CACHE_SECTIONS];
+};
+} // namespace
+
+// Raw bytes of each section, in file order
+[[nodiscard]] static std::array<std::span<const std::byte>, NUM_MESH_CACHE_SECTIONS>
+get_section_bytes(const Mesh_Cache_Sections &sections) {
+  return {
+      std::as_bytes(sections.vertices),         std::as_bytes(sections.indices),
+      std::as_bytes(sections.vertex_normals),   std::as_bytes(sections.triangle_normals),
+      std::as_bytes(sections.triangle_areas),   std::as_bytes(sections.bvh_nodes),
+      std::as_bytes(sections.bvh_primitive_indices),
+  };
+}
+
+// Section bytes are aligned in the file and the mapping is page aligned, so they can be used as typed arrays in place
+template <typename T> [[nodiscard]] static std::span<const T> as_section(const std::byte *data, uint64_t size) {
+  return {reinterpret_cast<const T *>(data), static_cast<size_t>(size / sizeof(T))};
+}
+
+std::optional<Mesh_Cache_File> Mesh_Cache_File::open(const std::string &file_path) {
+  std::error_code error_code;
+  if (!std::filesystem::exists(file_path, error_code)) return {};
+  std::optional<Mapped_File> mapped_file = Mapped_File::open(file_path);
+  if (!mapped_file) return {};
+
+  Mesh_Cache_Header header;
+  if (mapped_file->get_size() < sizeof(Mesh_Cache_Header)) return {};
+  std::memcpy(&header, mapped_file->get_data(), sizeof(Mesh_Cache_Header));
+  if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_FORMAT_VERSION ||
+      header.num_sections != NUM_MESH_CACHE_SECTIONS) {
+    return {};
+  }
+  const size_t element_sizes[NUM_MESH_CACHE_SECTIONS] = {
+      sizeof(glm::vec3), sizeof(unsigned int), sizeof(glm::vec3),    sizeof(glm::vec3),
+      sizeof(float),     sizeof(BVH::Node),    sizeof(unsigned int),
+  };
+  for (size_t i = 0; i < NUM_MESH_CACHE_SECTIONS; i++) {
+    const Mesh_Cache_Header::Section &section = header.sections[i];
+    if (section.offset % MESH_CACHE_SECTION_ALIGNMENT != 0 || section.offset > mapped_file->get_size() ||
+        section.size > mapped_file->get_size() - section.offset || section.size % element_sizes[i] != 0) {
+      std::cerr << "Corrupt mesh cache file: " << file_path << std::endl;
+      return {};
+    }
+  }
+
+  // Modification times order files for trim_mesh_cache_directory, failing to update one is harmless
+  std::filesystem::last_write_time(file_path, std::filesystem::file_time_type::clock::now(), error_code);
+
+  Mesh_Cache_File file(std::move(*mapped_file));
+  file.m_source_key = header.source_key;
+  const std::byte *data = file.m_mapped_file.get_data();
+  auto section = [&header, data]<typename T>(size_t i, T) {
+    return as_section<T>(data + header.sections[i].offset, header.sections[i].size);
+  };
+  file.m_sections = {
+      .vertices = section(0, glm::vec3()),
+      .indices = section(1, 0u),
+      .vertex_normals = section(2, glm::vec3()),
+      .triangle_normals = section(3, glm::vec3()),
+      .triangle_areas = section(4, 0.0f),
+      .bvh_nodes = section(5, BVH::Node()),
+      .bvh_primitive_indices = section(6, 0u),
+  };
+  return file;
+}
+
+[[nodiscard]] static uint64_t align_up(uint64_t offset) {
+  return (offset + MESH_CACHE_SECTION_ALIGNMENT - 1) / MESH_CACHE_SECTION_ALIGNMENT * MESH_CACHE_SECTION_ALIGNMENT;
+}
+
+bool write_mesh_cache_file(const std::string &file_path, uint64_t source_key, const Mesh_Cache_Sections &sections) {
+  GEOBOX_PROFILE_SCOPE("Write mesh cache");
+  std::array<std::span<const std::byte>, NUM_MESH_CACHE_SECTIONS> section_bytes = get_section_bytes(sections);
+  Mesh_Cache_Header header{
+      .magic = MESH_CACHE_MAGIC,
+      .version = MESH_CACHE_FORMAT_VERSION,
+      .num_sections = NUM_MESH_CACHE_SECTIONS,
+      .source_key = source_key,
+      .sections = {},
+  };
+  uint64_t offset = align_up(sizeof(Mesh_Cache_Header));
+  for (size_t i = 0; i < NUM_MESH_CACHE_SECTIONS; i++) {
+    header.sections[i] = {.offset = offset, .size = section_bytes[i].size()};
+    offset = align_up(offset + section_bytes[i].size());
+  }
+
+  // Written to a temporary file first, so a failed write never leaves a truncated cache file behind, the name is unique
+  // to this write, so concurrent writes of the same cache file (e.g. the same file loaded twice, or another process)
+  // each rename their own complete file into place
+  std::random_device random_device;
+  std::ostringstream temporary_file_suffix;
+  temporary_file_suffix << std::hex << random_device() << random_device();
+  std::string temporary_file_path = file_path + "." + temporary_file_suffix.str() + ".tmp";
+  {
+    std::ofstream ofs(temporary_file_path, std::ofstream::binary | std::ofstream::trunc);
+    if (!ofs.is_open()) {
+      std::cerr << "Failed to open file for writing: " << temporary_file_path << std::endl;
+      return false;
+    }
+    const std::array<char, MESH_CACHE_SECTION_ALIGNMENT> padding{};
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(Mesh_Cache_Header));
+    uint64_t written = sizeof(Mesh_Cache_Header);
+    for (size_t i = 0; i < NUM_MESH_CACHE_SECTIONS; i++) {
+      ofs.write(padding.data(), static_cast<std::streamsize>(header.sections[i].offset - written));
+      ofs.write(reinterpret_cast<const char *>(section_bytes[i].data()),
+                static_cast<std::streamsize>(section_bytes[i].size()));
+      written = header.sections[i].offset + section_bytes[i].size();
+    }
+    ofs.close();
+    if (!ofs) {
+      std::cerr << "Failed to write file: " << temporary_file_path << std::endl;
+      std::filesystem::remove(temporary_file_path);
+      return false;
+    }
+  }
+  std::error_code error_code;
+  std::filesystem::rename(temporary_file_path, file_path, error_code);
+  if (error_code) {
+    std::cerr << "Failed to write file: " << file_path << std::endl;
+    std::filesystem::remove(temporary_file_path, error_code);
+    return false;
+  }
+  return true;
+}
+
+[[nodiscard]] static uint64_t mix_hash(uint64_t hash, uint64_t word) {
+  hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+  return hash ^ (hash >> 32);
+}
+
+std::optional<uint64_t> calc_source_file_key(const std::string &file_path) {
+  std::error_code error_code;
+  std::filesystem::path absolute_path = std::filesystem::absolute(file_path, error_code);
+  if (error_code) return {};
+  uintmax_t size = std::filesystem::file_size(absolute_path, error_code);
+  if (error_code) return {};
+  std::filesystem::file_time_type last_write_time = std::filesystem::last_write_time(absolute_path, error_code);
+  if (error_code) return {};
+  std::string path = absolute_path.lexically_normal().string();
+  uint64_t key = mix_hash(0, path.size());
+  for (size_t i = 0; i < path.size(); i += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    std::memcpy(&word, path.data() + i, std::min(sizeof(uint64_t), path.size() - i));
+    key = mix_hash(key, word);
+  }
+  key = mix_hash(key, size);
+  return mix_hash(key, static_cast<uint64_t>(last_write_time.time_since_epoch().count()));
+}
+
+std::optional<std::filesystem::path> get_default_mesh_cache_directory() {
+  std::filesystem::path directory;
+#ifdef _WIN32
+  const char *local_app_data = std::getenv("LOCALAPPDATA");
+  if (local_app_data == nullptr || *local_app_data == '\0') return {};
+  directory = std::filesystem::path(local_app_data) / "geobox";
+#else
+  // Relative values are invalid according to the XDG base directory specification and are ignored
+  const char *xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+  const char *home = std::getenv("HOME");
+  if (xdg_cache_home != nullptr && std::filesystem::path(xdg_cache_home).is_absolute()) {
+    directory = std::filesystem::path(xdg_cache_home) / "geobox";
+  } else if (home != nullptr && std::filesystem::path(home).is_absolute()) {
+    directory = std::filesystem::path(home) / ".cache" / "geobox";
+  } else {
+    return {};
+  }
+#endif
+  std::error_code error_code;
+  std::filesystem::create_directories(directory, error_code);
+  std::filesystem::permissions(directory, std::filesystem::perms::owner_all, error_code);
+  return directory;
+}
+
+std::string get_mesh_cache_file_path(const std::filesystem::path &directory, uint64_t source_key) {
+  std::ostringstream file_name;
+  file_name << std::hex << std::setw(16) << std::setfill('0') << source_key << MESH_CACHE_FILE_EXTENSION;
+  return (directory / file_name.str()).string();
+}
+
+void trim_mesh_cache_directory(const std::filesystem::path &directory, uintmax_t max_size) {
+  struct Cache_File_Entry {
+    std::filesystem::path path;
+    uintmax_t size;
+    std::filesystem::file_time_type last_write_time;
+  };
+  std::vector<Cache_File_Entry> entries;
+  uintmax_t total_size = 0;
+  std::error_code error_code;
+  for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory, error_code)) {
+    if (!entry.is_regular_file(error_code) || entry.path().extension() != MESH_CACHE_FILE_EXTENSION) continue;
+    uintmax_t size = entry.file_size(error_code);
+    if (error_code) continue;
+    std::filesystem::file_time_type last_write_time = entry.last_write_time(error_code);
+    if (error_code) continue;
+    entries.push_back({entry.path(), size, last_write_time});
+    total_size += size;
+  }
+  if (total_size <= max_size) return;
+
+  std::sort(entries.begin(), entries.end(), [](const Cache_File_Entry &a, const Cache_File_Entry &b) {
+    return a.last_write_time < b.last_write_time;
+  });
+  for (const Cache_File_Entry &entry : entries) {
+    if (total_size <= max_size) break;
+    if (std::filesystem::remove(entry.path, error_code)) total_size -= entry.size;
+  }
+}
+
+#ifdef GEOBOX_TEST_MESH_CACHE
+#include <chrono> // for std::chrono::hours
+#include <cstdio> // for std::remove
+#include <thread>
+
+#include <glm/glm.hpp>
+
+#include "testing.hpp"
+
+int main() {
+  std::string source_file_path = (std::filesystem::temp_directory_path() / "geobox_test_mesh_cache.bin").string();
+  std::string cache_file_path = (std::filesystem::temp_directory_path() / "geobox_test_mesh_cache.gbx").string();
+
+  // Source key changes with the size and the modification time of the file, and differs between paths
+  std::string content(1000, 'x');
+  auto write_source = [&](const std::string &text) {
+    std::ofstream ofs(source_file_path, std::ofstream::binary | std::ofstream::trunc);
+    ofs.write(text.data(), static_cast<std::streamsize>(text.size()));
+  };
+  write_source(content);
+  std::optional<uint64_t> key = calc_source_file_key(source_file_path);
+  runtime_assert(key.has_value());
+  runtime_assert(calc_source_file_key(source_file_path) == key);
+  write_source(content + '\0');
+  runtime_assert(calc_source_file_key(source_file_path) != key);
+  write_source(content);
+  std::filesystem::last_write_time(source_file_path, std::filesystem::file_time_type::clock::now() -
+                                                         std::chrono::hours(1));
+  std::optional<uint64_t> touched_key = calc_source_file_key(source_file_path);
+  runtime_assert(touched_key.has_value() && touched_key != key);
+  std::string other_source_file_path = source_file_path + ".other";
+  std::filesystem::copy_file(source_file_path, other_source_file_path);
+  std::filesystem::last_write_time(other_source_file_path, std::filesystem::last_write_time(source_file_path));
+  runtime_assert(calc_source_file_key(other_source_file_path) != touched_key);
+  std::filesystem::remove(other_source_file_path);
+  runtime_assert(!calc_source_file_key(source_file_path + ".missing").has_value());
+  runtime_assert(get_mesh_cache_file_path("cache", 0x1234).ends_with("0000000000001234.gbx"));
+
+#ifndef _WIN32
+  // Default cache directory follows XDG_CACHE_HOME and is private to its owner
+  std::filesystem::path cache_home = std::filesystem::temp_directory_path() / "geobox_test_cache_home";
+  std::filesystem::remove_all(cache_home);
+  setenv("XDG_CACHE_HOME", cache_home.c_str(), 1);
+  std::optional<std::filesystem::path> cache_directory = get_default_mesh_cache_directory();
+  runtime_assert(cache_directory == cache_home / "geobox" && std::filesystem::is_directory(cache_home / "geobox"));
+  std::filesystem::perms others = std::filesystem::perms::group_all | std::filesystem::perms::others_all;
+  runtime_assert((std::filesystem::status(cache_home / "geobox").permissions() & others) ==
+                 std::filesystem::perms::none);
+  std::filesystem::remove_all(cache_home);
+#endif
+
+  // Round trip of a tetrahedron with its BVH
+  std::vector<glm::vec3> vertices = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  std::vector<unsigned int> indices = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3};
+  std::vector<glm::vec3> vertex_normals = {{-1, -1, -1}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  std::vector<glm::vec3> triangle_normals = {{0, 0, -1}, {0, -1, 0}, {-1, 0, 0}, {0.5f, 0.5f, 0.5f}};
+  std::vector<float> triangle_areas = {0.5f, 0.5f, 0.5f, 0.8f};
+  std::vector<AABB> bounding_boxes;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const glm::vec3 &a = vertices[indices[i + 0]];
+    const glm::vec3 &b = vertices[indices[i + 1]];
+    const glm::vec3 &c = vertices[indices[i + 2]];
+    bounding_boxes.push_back({.min = glm::min(a, glm::min(b, c)), .max = glm::max(a, glm::max(b, c))});
+  }
+  BVH bvh(bounding_boxes);
+  Mesh_Cache_Sections sections = {
+      .vertices = vertices,
+      .indices = indices,
+      .vertex_normals = vertex_normals,
+      .triangle_normals = triangle_normals,
+      .triangle_areas = triangle_areas,
+      .bvh_nodes = bvh.get_nodes(),
+      .bvh_primitive_indices = bvh.get_primitive_indices(),
+  };
+  runtime_assert(write_mesh_cache_file(cache_file_path, 42, sections));
+  {
+    std::optional<Mesh_Cache_File> file = Mesh_Cache_File::open(cache_file_path);
+    runtime_assert(file.has_value());
+    runtime_assert(file->get_source_key() == 42);
+    const Mesh_Cache_Sections &read = file->get_sections();
+    auto is_equal = [](auto a, auto b) {
+      return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+    };
+    runtime_assert(is_equal(read.vertices, sections.vertices));
+    runtime_assert(is_equal(read.indices, sections.indices));
+    runtime_assert(is_equal(read.vertex_normals, sections.vertex_normals));
+    runtime_assert(is_equal(read.triangle_normals, sections.triangle_normals));
+    runtime_assert(is_equal(read.triangle_areas, sections.triangle_areas));
+    runtime_assert(is_equal(read.bvh_nodes, sections.bvh_nodes));
+    runtime_assert(is_equal(read.bvh_primitive_indices, sections.bvh_primitive_indices));
+    for (std::span<const std::byte> bytes : get_section_bytes(read)) {
+      runtime_assert(reinterpret_cast<uintptr_t>(bytes.data()) % MESH_CACHE_SECTION_ALIGNMENT == 0);
+    }
+    // Restored BVH is usable without a rebuild
+    BVH restored(read.bvh_nodes, read.bvh_primitive_indices);
+    runtime_assert(restored.get_aabb().min == bvh.get_aabb().min && restored.get_aabb().max == bvh.get_aabb().max);
+  }
+
+  // Concurrent writes of the same file each write their own temporary file, the one renamed last wins
+  {
+    std::vector<std::thread> threads;
+    std::vector<char> are_written(4, false);
+    for (size_t i = 0; i < are_written.size(); i++) {
+      threads.emplace_back([&, i]() { are_written[i] = write_mesh_cache_file(cache_file_path, 42, sections); });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    runtime_assert(std::find(are_written.begin(), are_written.end(), false) == are_written.end());
+    std::optional<Mesh_Cache_File> file = Mesh_Cache_File::open(cache_file_path);
+    runtime_assert(file.has_value() && file->get_sections().indices.size() == indices.size());
+    for (const std::filesystem::directory_entry &entry :
+         std::filesystem::directory_iterator(std::filesystem::temp_directory_path())) {
+      runtime_assert(!entry.path().filename().string().starts_with("geobox_test_mesh_cache.gbx."));
+    }
+  }
+
+  // Truncated and foreign files are rejected
+  std::filesystem::resize_file(cache_file_path, std::filesystem::file_size(cache_file_path) - 1);
+  runtime_assert(!Mesh_Cache_File::open(cache_file_path).has_value());
+  write_source(content);
+  runtime_assert(!Mesh_Cache_File::open(source_file_path).has_value());
+  runtime_assert(!Mesh_Cache_File::open(cache_file_path + ".missing").has_value());
+
+  std::remove(source_file_path.c_str());
+  std::remove(cache_file_path.c_str());
+
+  // Trimming removes the least recently used files first and leaves other files alone
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "geobox_test_mesh_cache_trim";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+  for (int i = 0; i < 4; i++) {
+    std::filesystem::path file_path = directory / (std::to_string(i) + MESH_CACHE_FILE_EXTENSION);
+    std::ofstream(file_path, std::ofstream::binary) << std::string(100, 'x');
+    std::filesystem::last_write_time(file_path, now - std::chrono::hours(4 - i));
+  }
+  std::ofstream(directory / "notes.txt") << std::string(1000, 'x');
+  trim_mesh_cache_directory(directory, 400);
+  runtime_assert(std::filesystem::exists(directory / "0.gbx"));
+  trim_mesh_cache_directory(directory, 250);
+  runtime_assert(!std::filesystem::exists(directory / "0.gbx") && !std::filesystem::exists(directory / "1.gbx"));
+  runtime_assert(std::filesystem::exists(directory / "2.gbx") && std::filesystem::exists(directory / "3.gbx"));
+  runtime_assert(std::filesystem::exists(directory / "notes.txt"));
+  std::filesystem::remove_all(directory);
+  return 0;
+}
+#endif
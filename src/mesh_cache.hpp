@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+
+#include <glm/vec3.hpp>
+
+#include "bvh.hpp"
+#include "mapped_file.hpp"
+
+constexpr const char *MESH_CACHE_FILE_EXTENSION = ".gbx";
+// Least recently used cache files are removed once the cache directory grows past this
+constexpr uintmax_t MAX_MESH_CACHE_DIRECTORY_SIZE = uintmax_t(4) << 30;
+
+// Everything a mesh object derives from its source file, so reopening the file skips reading, welding, calculating
+// normals and areas, and building the triangles BVH
+struct Mesh_Cache_Sections {
+  std::span<const glm::vec3> vertices;
+  std::span<const unsigned int> indices;
+  std::span<const glm::vec3> vertex_normals;
+  std::span<const glm::vec3> triangle_normals;
+  std::span<const float> triangle_areas;
+  std::span<const BVH::Node> bvh_nodes;
+  std::span<const unsigned int> bvh_primitive_indices;
+};
+
+// Memory mapped .gbx mesh cache file, sections point into the mapping and are valid as long as the file is open,
+// files are a header followed by the sections in order, each aligned to 64 bytes, in native byte order
+class Mesh_Cache_File {
+private:
+  Mapped_File m_mapped_file;
+  uint64_t m_source_key = 0;
+  Mesh_Cache_Sections m_sections;
+
+  Mesh_Cache_File(Mapped_File mapped_file) : m_mapped_file(std::move(mapped_file)) {}
+
+public:
+  // Empty if the file does not exist, is not a mesh cache file or was written by another version of the format,
+  // opening a valid file marks it as recently used
+  [[nodiscard]] static std::optional<Mesh_Cache_File> open(const std::string &file_path);
+
+  // Key of the source file the cache was made from, see calc_source_file_key
+  [[nodiscard]] uint64_t get_source_key() const { return m_source_key; }
+
+  [[nodiscard]] const Mesh_Cache_Sections &get_sections() const { return m_sections; }
+};
+
+[[nodiscard]] bool write_mesh_cache_file(const std::string &file_path, uint64_t source_key,
+                                         const Mesh_Cache_Sections &sections);
+
+// Hash of the absolute path, size and modification time of the file, so checking a cache file against its source
+// takes a stat rather than reading the whole source, any write to the source (even one keeping its content) changes it
+[[nodiscard]] std::optional<uint64_t> calc_source_file_key(const std::string &file_path);
+
+// Per user directory, $XDG_CACHE_HOME/geobox or ~/.cache/geobox (%LOCALAPPDATA%/geobox on Windows), created if missing
+// and only accessible by its owner, since cache files are trusted once their header checks out, empty if there is no
+// home directory
+[[nodiscard]] std::optional<std::filesystem::path> get_default_mesh_cache_directory();
+
+// Cache files are named after the key of their source file
+[[nodiscard]] std::string get_mesh_cache_file_path(const std::filesystem::path &directory, uint64_t source_key);
+
+// Removes the least recently used cache files of directory until the rest fit in max_size bytes,
+// files that cannot be removed (e.g. still mapped on some platforms) are skipped
+void trim_mesh_cache_directory(const std::filesystem::path &directory, uintmax_t max_size);
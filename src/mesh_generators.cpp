@@ -0,0 +1,414 @@
+#include <algorithm> // for std::max
+#include <cassert>
+#include <cmath> // for std::sqrt, std::cbrt, std::ceil, std::floor, std::cos and std::sin
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "geobox_exceptions.hpp"
+#include "indexed_triangle_mesh.hpp"
+#include "mesh_generators.hpp"
+#include "parallel.hpp"
+#include "primitives.hpp"
+#include "profiler.hpp"
+
+constexpr size_t MESH_GENERATOR_CHUNK_SIZE = 65536;
+constexpr float TORUS_MAJOR_RADIUS = 1.0f;
+constexpr float TORUS_MINOR_RADIUS = 0.4f;
+constexpr float TERRAIN_SIZE = 10.0f;
+constexpr float TERRAIN_HEIGHT = 1.5f;
+// Features of the first octave per unit of length, later octaves double it
+constexpr float TERRAIN_BASE_FREQUENCY = 0.4f;
+constexpr int TERRAIN_NUM_OCTAVES = 6;
+// Segments of the largest sliver cylinders, their side triangles are about 2600 times longer than wide
+constexpr size_t MAX_SLIVER_CYLINDER_SEGMENTS = 4096;
+constexpr float SLIVER_CYLINDER_RADIUS = 0.5f;
+constexpr float SLIVER_CYLINDER_HEIGHT = 2.0f;
+constexpr float SLIVER_CYLINDER_SPACING = 1.5f;
+constexpr size_t SOUP_SPHERE_RINGS = 8;
+
+const char *get_mesh_generator_type_name(Mesh_Generator_Type type) {
+  switch (type) {
+  case Mesh_Generator_Type::Sphere:
+    return "Sphere";
+  case Mesh_Generator_Type::Torus:
+    return "Torus";
+  case Mesh_Generator_Type::Terrain:
+    return "Terrain";
+  case Mesh_Generator_Type::Slivers:
+    return "Slivers";
+  case Mesh_Generator_Type::Soup:
+    return "Soup";
+  }
+  return "";
+}
+
+// Allocates the mesh, then calls vertex(k) and triangle(t, indices) for every vertex and triangle in parallel
+template <typename Vertex_Type, typename Triangle_Type>
+[[nodiscard]] static Indexed_Triangle_Mesh generate_indexed_mesh(size_t num_vertices, size_t num_triangles,
+                                                                 const Vertex_Type &vertex,
+                                                                 const Triangle_Type &triangle) {
+  if (num_vertices > std::numeric_limits<unsigned int>::max()) {
+    throw GeoBox_Error("Too many vertices to generate: " + std::to_string(num_vertices));
+  }
+  Indexed_Triangle_Mesh mesh;
+  mesh.vertices.resize(num_vertices);
+  mesh.indices.resize(num_triangles * 3);
+  parallel_for(0, num_vertices, MESH_GENERATOR_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t k = begin; k < end; k++) {
+      mesh.vertices[k] = vertex(k);
+    }
+  });
+  parallel_for(0, num_triangles, MESH_GENERATOR_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++) {
+      triangle(t, &mesh.indices[t * 3]);
+    }
+  });
+  return mesh;
+}
+
+// Two triangles of the quad a, b, c, d, counter-clockwise seen from the front
+static void write_quad_triangle(size_t half, unsigned int a, unsigned int b, unsigned int c, unsigned int d,
+                                unsigned int *indices) {
+  indices[0] = a;
+  indices[1] = half == 0 ? b : c;
+  indices[2] = half == 0 ? c : d;
+}
+
+namespace {
+// Latitude-longitude sphere, vertex 0 is the north pole, 1 the south pole, then rings from north to south
+struct Sphere_Grid {
+  size_t num_rings;
+  size_t num_segments;
+
+  [[nodiscard]] size_t get_num_vertices() const { return 2 + (num_rings - 1) * num_segments; }
+
+  [[nodiscard]] size_t get_num_triangles() const { return 2 * num_segments * (num_rings - 1); }
+
+  // Vertex of ring r in [1, num_rings - 1] and segment i, wrapping around
+  [[nodiscard]] unsigned int get_ring_vertex(size_t r, size_t i) const {
+    return static_cast<unsigned int>(2 + (r - 1) * num_segments + i % num_segments);
+  }
+
+  [[nodiscard]] glm::vec3 calc_vertex(size_t k) const {
+    if (k < 2) return {0.0f, 0.0f, k == 0 ? 1.0f : -1.0f};
+    size_t r = (k - 2) / num_segments + 1;
+    size_t i = (k - 2) % num_segments;
+    float phi = glm::pi<float>() * static_cast<float>(r) / static_cast<float>(num_rings);
+    float theta = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(num_segments);
+    return {std::sin(phi) * std::cos(theta), std::sin(phi) * std::sin(theta), std::cos(phi)};
+  }
+
+  // Caps first, then bands between rings
+  void write_triangle(size_t t, unsigned int first_vertex, unsigned int *indices) const {
+    if (t < num_segments) {
+      indices[0] = first_vertex;
+      indices[1] = first_vertex + get_ring_vertex(1, t);
+      indices[2] = first_vertex + get_ring_vertex(1, t + 1);
+      return;
+    }
+    if (t < 2 * num_segments) {
+      size_t i = t - num_segments;
+      indices[0] = first_vertex + get_ring_vertex(num_rings - 1, i);
+      indices[1] = first_vertex + 1;
+      indices[2] = first_vertex + get_ring_vertex(num_rings - 1, i + 1);
+      return;
+    }
+    size_t q = t - 2 * num_segments;
+    size_t r = q / (2 * num_segments) + 1;
+    size_t i = (q % (2 * num_segments)) / 2;
+    write_quad_triangle(q % 2, first_vertex + get_ring_vertex(r, i), first_vertex + get_ring_vertex(r + 1, i),
+                        first_vertex + get_ring_vertex(r + 1, i + 1), first_vertex + get_ring_vertex(r, i + 1),
+                        indices);
+  }
+};
+} // namespace
+
+// Twice as many segments as rings gives roughly square quads at the equator
+[[nodiscard]] static Sphere_Grid calc_sphere_grid(size_t num_triangles) {
+  auto num_rings =
+      static_cast<size_t>(std::ceil((1.0 + std::sqrt(1.0 + static_cast<double>(num_triangles))) / 2.0));
+  num_rings = std::max(num_rings, size_t(2));
+  while (4 * num_rings * (num_rings - 1) < num_triangles) num_rings++;
+  return {num_rings, 2 * num_rings};
+}
+
+Indexed_Triangle_Mesh generate_sphere(size_t num_triangles) {
+  Sphere_Grid grid = calc_sphere_grid(num_triangles);
+  return generate_indexed_mesh(
+      grid.get_num_vertices(), grid.get_num_triangles(), [&grid](size_t k) { return grid.calc_vertex(k); },
+      [&grid](size_t t, unsigned int *indices) { grid.write_triangle(t, 0, indices); });
+}
+
+Indexed_Triangle_Mesh generate_torus(size_t num_triangles) {
+  // Segments around the z axis outnumber rings around the tube by the ratio of the radii, for roughly square quads
+  auto num_rings = std::max(static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_triangles) / 5.0))),
+                            size_t(3));
+  size_t num_segments = std::max((num_triangles + 2 * num_rings - 1) / (2 * num_rings), size_t(3));
+  auto get_vertex = [num_rings, num_segments](size_t i, size_t j) {
+    return static_cast<unsigned int>((i % num_segments) * num_rings + j % num_rings);
+  };
+  return generate_indexed_mesh(
+      num_segments * num_rings, 2 * num_segments * num_rings,
+      [num_rings, num_segments](size_t k) {
+        float u = glm::two_pi<float>() * static_cast<float>(k / num_rings) / static_cast<float>(num_segments);
+        float v = glm::two_pi<float>() * static_cast<float>(k % num_rings) / static_cast<float>(num_rings);
+        float r = TORUS_MAJOR_RADIUS + TORUS_MINOR_RADIUS * std::cos(v);
+        return glm::vec3(r * std::cos(u), r * std::sin(u), TORUS_MINOR_RADIUS * std::sin(v));
+      },
+      [num_rings, &get_vertex](size_t t, unsigned int *indices) {
+        size_t i = (t / 2) / num_rings;
+        size_t j = (t / 2) % num_rings;
+        write_quad_triangle(t % 2, get_vertex(i, j), get_vertex(i + 1, j), get_vertex(i + 1, j + 1),
+                            get_vertex(i, j + 1), indices);
+      });
+}
+
+// SplitMix64 finalizer, a cheap hash with good avalanche, so noise is a pure function of the seed and position
+[[nodiscard]] static uint64_t mix_bits(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+// In [0, 1)
+[[nodiscard]] static float hash_to_unit_float(uint64_t seed, uint64_t a, uint64_t b) {
+  uint64_t hash = mix_bits(mix_bits(mix_bits(seed) ^ a) ^ b);
+  return static_cast<float>(hash >> 40) / static_cast<float>(1 << 24);
+}
+
+// Smoothly interpolated random values at integer coordinates
+[[nodiscard]] static float calc_value_noise(uint64_t seed, float x, float y) {
+  float x_floor = std::floor(x);
+  float y_floor = std::floor(y);
+  auto ix = static_cast<uint64_t>(static_cast<int64_t>(x_floor));
+  auto iy = static_cast<uint64_t>(static_cast<int64_t>(y_floor));
+  glm::vec2 f = glm::smoothstep(glm::vec2(0.0f), glm::vec2(1.0f), glm::vec2(x - x_floor, y - y_floor));
+  float v00 = hash_to_unit_float(seed, ix, iy);
+  float v10 = hash_to_unit_float(seed, ix + 1, iy);
+  float v01 = hash_to_unit_float(seed, ix, iy + 1);
+  float v11 = hash_to_unit_float(seed, ix + 1, iy + 1);
+  return glm::mix(glm::mix(v00, v10, f.x), glm::mix(v01, v11, f.x), f.y);
+}
+
+Indexed_Triangle_Mesh generate_terrain(size_t num_triangles, uint64_t seed) {
+  auto num_cells = std::max(static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_triangles) / 2.0))),
+                            size_t(1));
+  size_t num_columns = num_cells + 1;
+  auto get_vertex = [num_columns](size_t x, size_t y) { return static_cast<unsigned int>(y * num_columns + x); };
+  return generate_indexed_mesh(
+      num_columns * num_columns, 2 * num_cells * num_cells,
+      [num_cells, num_columns, seed](size_t k) {
+        float x = TERRAIN_SIZE * static_cast<float>(k % num_columns) / static_cast<float>(num_cells);
+        float y = TERRAIN_SIZE * static_cast<float>(k / num_columns) / static_cast<float>(num_cells);
+        float height = 0.0f;
+        float frequency = TERRAIN_BASE_FREQUENCY;
+        float amplitude = 0.5f;
+        for (int octave = 0; octave < TERRAIN_NUM_OCTAVES; octave++) {
+          height += amplitude * calc_value_noise(seed + static_cast<uint64_t>(octave), x * frequency, y * frequency);
+          frequency *= 2.0f;
+          amplitude *= 0.5f;
+        }
+        return glm::vec3(x, y, TERRAIN_HEIGHT * height);
+      },
+      [num_cells, &get_vertex](size_t t, unsigned int *indices) {
+        size_t x = (t / 2) % num_cells;
+        size_t y = (t / 2) / num_cells;
+        write_quad_triangle(t % 2, get_vertex(x, y), get_vertex(x + 1, y), get_vertex(x + 1, y + 1),
+                            get_vertex(x, y + 1), indices);
+      });
+}
+
+Indexed_Triangle_Mesh generate_slivers(size_t num_triangles) {
+  // Every cylinder has num_segments triangles in each cap and twice as many on its side
+  size_t num_cylinders = std::max((num_triangles + 4 * MAX_SLIVER_CYLINDER_SEGMENTS - 1) /
+                                      (4 * MAX_SLIVER_CYLINDER_SEGMENTS),
+                                  size_t(1));
+  size_t num_segments = std::max((num_triangles + 4 * num_cylinders - 1) / (4 * num_cylinders), size_t(3));
+  size_t num_cylinder_vertices = 2 + 2 * num_segments;
+  size_t num_cylinder_triangles = 4 * num_segments;
+  auto num_grid_columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_cylinders))));
+  // Vertex 0 is the bottom center, 1 the top center, then the bottom ring and the top ring
+  auto get_ring_vertex = [num_segments](size_t first_vertex, size_t ring, size_t i) {
+    return static_cast<unsigned int>(first_vertex + 2 + ring * num_segments + i % num_segments);
+  };
+  return generate_indexed_mesh(
+      num_cylinders * num_cylinder_vertices, num_cylinders * num_cylinder_triangles,
+      [=](size_t k) {
+        size_t cylinder = k / num_cylinder_vertices;
+        size_t local = k % num_cylinder_vertices;
+        glm::vec3 base(SLIVER_CYLINDER_SPACING * static_cast<float>(cylinder % num_grid_columns),
+                       SLIVER_CYLINDER_SPACING * static_cast<float>(cylinder / num_grid_columns), 0.0f);
+        if (local < 2) return base + glm::vec3(0.0f, 0.0f, local == 0 ? 0.0f : SLIVER_CYLINDER_HEIGHT);
+        size_t ring = (local - 2) / num_segments;
+        float theta =
+            glm::two_pi<float>() * static_cast<float>((local - 2) % num_segments) / static_cast<float>(num_segments);
+        return base + glm::vec3(SLIVER_CYLINDER_RADIUS * std::cos(theta), SLIVER_CYLINDER_RADIUS * std::sin(theta),
+                                ring == 0 ? 0.0f : SLIVER_CYLINDER_HEIGHT);
+      },
+      [=](size_t t, unsigned int *indices) {
+        size_t first_vertex = (t / num_cylinder_triangles) * num_cylinder_vertices;
+        size_t local = t % num_cylinder_triangles;
+        if (local < num_segments) {
+          indices[0] = static_cast<unsigned int>(first_vertex + 1);
+          indices[1] = get_ring_vertex(first_vertex, 1, local);
+          indices[2] = get_ring_vertex(first_vertex, 1, local + 1);
+        } else if (local < 2 * num_segments) {
+          size_t i = local - num_segments;
+          indices[0] = static_cast<unsigned int>(first_vertex);
+          indices[1] = get_ring_vertex(first_vertex, 0, i + 1);
+          indices[2] = get_ring_vertex(first_vertex, 0, i);
+        } else {
+          size_t i = (local - 2 * num_segments) / 2;
+          write_quad_triangle(local % 2, get_ring_vertex(first_vertex, 0, i), get_ring_vertex(first_vertex, 0, i + 1),
+                              get_ring_vertex(first_vertex, 1, i + 1), get_ring_vertex(first_vertex, 1, i), indices);
+        }
+      });
+}
+
+Indexed_Triangle_Mesh generate_soup(size_t num_triangles, uint64_t seed) {
+  const Sphere_Grid grid{SOUP_SPHERE_RINGS, 2 * SOUP_SPHERE_RINGS};
+  size_t num_sphere_vertices = grid.get_num_vertices();
+  size_t num_sphere_triangles = grid.get_num_triangles();
+  size_t num_spheres = std::max((num_triangles + num_sphere_triangles - 1) / num_sphere_triangles, size_t(1));
+  // Dense enough for neighbouring spheres to overlap
+  float extent = 2.0f * std::cbrt(static_cast<float>(num_spheres));
+  return generate_indexed_mesh(
+      num_spheres * num_sphere_vertices, num_spheres * num_sphere_triangles,
+      [&grid, num_sphere_vertices, extent, seed](size_t k) {
+        uint64_t sphere = k / num_sphere_vertices;
+        glm::vec3 center(hash_to_unit_float(seed, sphere, 0), hash_to_unit_float(seed, sphere, 1),
+                         hash_to_unit_float(seed, sphere, 2));
+        float radius = 0.5f + 0.5f * hash_to_unit_float(seed, sphere, 3);
+        return extent * center + radius * grid.calc_vertex(k % num_sphere_vertices);
+      },
+      [&grid, num_sphere_vertices, num_sphere_triangles](size_t t, unsigned int *indices) {
+        auto first_vertex = static_cast<unsigned int>((t / num_sphere_triangles) * num_sphere_vertices);
+        grid.write_triangle(t % num_sphere_triangles, first_vertex, indices);
+      });
+}
+
+Indexed_Triangle_Mesh generate_mesh(Mesh_Generator_Type type, size_t num_triangles, uint64_t seed) {
+  GEOBOX_PROFILE_SCOPE("Generate mesh");
+  switch (type) {
+  case Mesh_Generator_Type::Sphere:
+    return generate_sphere(num_triangles);
+  case Mesh_Generator_Type::Torus:
+    return generate_torus(num_triangles);
+  case Mesh_Generator_Type::Terrain:
+    return generate_terrain(num_triangles, seed);
+  case Mesh_Generator_Type::Slivers:
+    return generate_slivers(num_triangles);
+  case Mesh_Generator_Type::Soup:
+    return generate_soup(num_triangles, seed);
+  }
+  assert(false);
+  return {};
+}
+
+std::vector<Triangle> get_triangle_soup(const Indexed_Triangle_Mesh &mesh) {
+  GEOBOX_PROFILE_SCOPE("Get triangle soup");
+  std::vector<Triangle> triangles(mesh.indices.size() / 3);
+  parallel_for(0, triangles.size(), MESH_GENERATOR_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      triangles[i] = {mesh.vertices[mesh.indices[i * 3 + 0]], mesh.vertices[mesh.indices[i * 3 + 1]],
+                      mesh.vertices[mesh.indices[i * 3 + 2]]};
+    }
+  });
+  return triangles;
+}
+
+#ifdef GEOBOX_TEST_MESH_GENERATORS
+#include <map>
+#include <utility> // for std::pair
+
+#include "testing.hpp"
+
+// Six times the volume enclosed by the mesh, positive for closed outward facing meshes
+[[nodiscard]] static double calc_signed_volume(const Indexed_Triangle_Mesh &mesh) {
+  double volume = 0.0;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    glm::dvec3 a = mesh.vertices[mesh.indices[i + 0]];
+    glm::dvec3 b = mesh.vertices[mesh.indices[i + 1]];
+    glm::dvec3 c = mesh.vertices[mesh.indices[i + 2]];
+    volume += glm::dot(a, glm::cross(b, c));
+  }
+  return volume / 6.0;
+}
+
+// Every directed edge is used once and its opposite once, so the mesh is closed and consistently oriented
+[[nodiscard]] static bool is_closed_and_oriented(const Indexed_Triangle_Mesh &mesh) {
+  std::map<std::pair<unsigned int, unsigned int>, int> edge_counts;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    for (size_t j = 0; j < 3; j++) {
+      edge_counts[{mesh.indices[i + j], mesh.indices[i + (j + 1) % 3]}]++;
+    }
+  }
+  for (const auto &[edge, count] : edge_counts) {
+    if (count != 1) return false;
+    auto it = edge_counts.find({edge.second, edge.first});
+    if (it == edge_counts.end() || it->second != 1) return false;
+  }
+  return true;
+}
+
+int main() {
+  for (size_t num_triangles : {size_t(1), size_t(1000), size_t(12345)}) {
+    for (size_t i = 0; i < NUM_MESH_GENERATOR_TYPES; i++) {
+      auto type = static_cast<Mesh_Generator_Type>(i);
+      Indexed_Triangle_Mesh mesh = generate_mesh(type, num_triangles, 7);
+      size_t num_mesh_triangles = mesh.indices.size() / 3;
+      runtime_assert(num_mesh_triangles >= num_triangles);
+      // Rounding up to the grid adds at most a few rows
+      runtime_assert(num_triangles < 10000 || num_mesh_triangles < num_triangles * 11 / 10);
+      for (size_t j = 0; j < mesh.indices.size(); j += 3) {
+        runtime_assert(mesh.indices[j + 0] < mesh.vertices.size());
+        runtime_assert(mesh.indices[j + 1] < mesh.vertices.size());
+        runtime_assert(mesh.indices[j + 2] < mesh.vertices.size());
+        runtime_assert(mesh.indices[j + 0] != mesh.indices[j + 1] && mesh.indices[j + 1] != mesh.indices[j + 2] &&
+                       mesh.indices[j + 0] != mesh.indices[j + 2]);
+      }
+      if (type == Mesh_Generator_Type::Terrain) {
+        for (size_t j = 0; j < mesh.indices.size(); j += 3) {
+          const glm::vec3 &a = mesh.vertices[mesh.indices[j + 0]];
+          const glm::vec3 &b = mesh.vertices[mesh.indices[j + 1]];
+          const glm::vec3 &c = mesh.vertices[mesh.indices[j + 2]];
+          runtime_assert(glm::cross(b - a, c - a).z > 0.0f);
+        }
+      } else {
+        runtime_assert(is_closed_and_oriented(mesh));
+        runtime_assert(calc_signed_volume(mesh) > 0.0);
+      }
+
+      // Same seed, same mesh, whatever the thread timing
+      Indexed_Triangle_Mesh again = generate_mesh(type, num_triangles, 7);
+      runtime_assert(again.vertices == mesh.vertices && again.indices == mesh.indices);
+
+      std::vector<Triangle> soup = get_triangle_soup(mesh);
+      runtime_assert(soup.size() == num_mesh_triangles);
+      runtime_assert(soup.back().m_c == mesh.vertices[mesh.indices.back()]);
+    }
+  }
+
+  // Fine tessellations approach the analytic volumes
+  double sphere_volume = 4.0 / 3.0 * glm::pi<double>();
+  runtime_assert(std::abs(calc_signed_volume(generate_sphere(100000)) - sphere_volume) < sphere_volume * 0.01);
+  double torus_volume = 2.0 * glm::pi<double>() * glm::pi<double>() * TORUS_MAJOR_RADIUS * TORUS_MINOR_RADIUS *
+                        TORUS_MINOR_RADIUS;
+  runtime_assert(std::abs(calc_signed_volume(generate_torus(100000)) - torus_volume) < torus_volume * 0.01);
+
+  // Seeds change the random generators
+  runtime_assert(generate_terrain(1000, 1).vertices != generate_terrain(1000, 2).vertices);
+  runtime_assert(generate_soup(1000, 1).vertices != generate_soup(1000, 2).vertices);
+
+  // Sliver cylinders are split to keep the triangles from getting arbitrarily thin
+  Indexed_Triangle_Mesh slivers = generate_slivers(10 * 4 * MAX_SLIVER_CYLINDER_SEGMENTS);
+  runtime_assert(slivers.vertices.size() == 10 * (2 + 2 * MAX_SLIVER_CYLINDER_SEGMENTS));
+  return 0;
+}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "indexed_triangle_mesh.hpp"
+#include "primitives.hpp"
+
+// Synthetic meshes for benchmarks and stress tests, generated in parallel with every vertex and triangle written
+// independently, the requested number of triangles is a minimum, rounded up to fill the generator's grid
+enum class Mesh_Generator_Type { Sphere, Torus, Terrain, Slivers, Soup };
+constexpr size_t NUM_MESH_GENERATOR_TYPES = 5;
+
+[[nodiscard]] const char *get_mesh_generator_type_name(Mesh_Generator_Type type);
+
+// Closed unit sphere with poles on the z axis, outward facing
+[[nodiscard]] Indexed_Triangle_Mesh generate_sphere(size_t num_triangles);
+// Closed torus around the z axis with radii 1 and 0.4, outward facing
+[[nodiscard]] Indexed_Triangle_Mesh generate_torus(size_t num_triangles);
+// Open height field of fractal value noise over a 10 x 10 square, facing up
+[[nodiscard]] Indexed_Triangle_Mesh generate_terrain(size_t num_triangles, uint64_t seed);
+// Grid of closed cylinders with fans for caps and single-row sides, almost all triangles are long and thin, like
+// tessellations of CAD models
+[[nodiscard]] Indexed_Triangle_Mesh generate_slivers(size_t num_triangles);
+// Many small closed spheres at random positions, overlapping each other, as separate components of one mesh
+[[nodiscard]] Indexed_Triangle_Mesh generate_soup(size_t num_triangles, uint64_t seed);
+
+// Seed is ignored by the generators without randomness
+[[nodiscard]] Indexed_Triangle_Mesh generate_mesh(Mesh_Generator_Type type, size_t num_triangles, uint64_t seed);
+
+// Unindexed copy of the mesh, made in parallel, for the triangle soup pipelines
+[[nodiscard]] std::vector<Triangle> get_triangle_soup(const Indexed_Triangle_Mesh &mesh);
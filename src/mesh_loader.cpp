@@ -0,0 +1,339 @@
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem> // for std::filesystem::file_size
+#include <functional> // for std::function
+#include <iostream>   // for std::cerr and std::endl
+#include <memory>     // for std::make_shared
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <system_error> // for std::error_code
+#include <utility>      // for std::move
+#include <vector>
+
+#include "geobox_exceptions.hpp"
+#include "indexed_triangle_mesh.hpp"
+#include "indexed_triangle_mesh_object.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_loader.hpp"
+#include "profiler.hpp"
+#include "read_mesh.hpp"
+#include "read_stl.hpp"
+
+const char *get_mesh_load_stage_name(Mesh_Load_Stage stage) {
+  switch (stage) {
+  case Mesh_Load_Stage::Queued:
+    return "Queued";
+  case Mesh_Load_Stage::Reading_Cache:
+    return "Reading cache";
+  case Mesh_Load_Stage::Reading:
+    return "Reading";
+  case Mesh_Load_Stage::Welding:
+    return "Welding";
+  case Mesh_Load_Stage::Generating:
+    return "Generating";
+  case Mesh_Load_Stage::Calculating_Normals:
+    return "Calculating normals";
+  case Mesh_Load_Stage::Building_BVH:
+    return "Building BVH";
+  case Mesh_Load_Stage::Writing_Cache:
+    return "Writing cache";
+  case Mesh_Load_Stage::Done:
+    return "Done";
+  }
+  return "";
+}
+
+Mesh_Load_Task::Mesh_Load_Task(std::string file_path, std::optional<std::filesystem::path> cache_directory)
+    : m_file_path(std::move(file_path)), m_cache_directory(std::move(cache_directory)) {
+  std::error_code error_code;
+  uintmax_t file_size = std::filesystem::file_size(m_file_path, error_code);
+  m_memory_estimate = error_code ? 0 : static_cast<size_t>(file_size) * MESH_LOAD_MEMORY_PER_FILE_BYTE;
+}
+
+Mesh_Load_Task::Mesh_Load_Task(std::string name, size_t num_triangles, std::function<Indexed_Triangle_Mesh()> generate)
+    : m_file_path(std::move(name)), m_generate(std::move(generate)),
+      m_memory_estimate(num_triangles * MESH_LOAD_MEMORY_PER_TRIANGLE) {}
+
+void Mesh_Load_Task::run() {
+  auto begin = std::chrono::steady_clock::now();
+  // An exception escaping the worker would terminate the app
+  try {
+    load();
+  } catch (const std::exception &error) {
+    std::cerr << error.what() << std::endl;
+    std::cerr << "Failed to load mesh file: " << m_file_path << std::endl;
+    m_mesh_data.reset();
+    m_mesh_cache_file.reset();
+    m_point_cloud.reset();
+  }
+  m_load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  m_stage.store(Mesh_Load_Stage::Done, std::memory_order_release);
+}
+
+void Mesh_Load_Task::load() {
+  GEOBOX_PROFILE_SCOPE("Load mesh");
+  std::stop_token stop_token = m_stop_source.get_token();
+  if (stop_token.stop_requested()) return;
+  std::optional<Indexed_Triangle_Mesh> mesh;
+  std::optional<uint64_t> source_key;
+  std::string cache_file_path;
+  if (m_generate) {
+    m_stage.store(Mesh_Load_Stage::Generating, std::memory_order_release);
+    mesh = m_generate();
+  } else {
+    m_stage.store(Mesh_Load_Stage::Reading_Cache, std::memory_order_release);
+    // Cache files hold the welded mesh and its triangles BVH, so reopening a file only maps them, objects view the
+    // mapping in place
+    if (m_cache_directory.has_value()) source_key = calc_source_file_key(m_file_path);
+    if (source_key.has_value()) {
+      cache_file_path = get_mesh_cache_file_path(m_cache_directory.value(), source_key.value());
+      std::optional<Mesh_Cache_File> cache_file = Mesh_Cache_File::open(cache_file_path);
+      if (cache_file.has_value() && cache_file->get_source_key() == source_key.value()) {
+        m_mesh_cache_file = std::make_shared<const Mesh_Cache_File>(std::move(cache_file.value()));
+        return;
+      }
+    }
+    if (stop_token.stop_requested()) return;
+
+    m_stage.store(Mesh_Load_Stage::Reading, std::memory_order_release);
+    if (is_stl_file_path(m_file_path)) {
+      std::optional<STL_Triangle_Soup> soup = STL_Triangle_Soup::read(m_file_path);
+      if (stop_token.stop_requested()) return;
+      if (soup.has_value()) {
+        m_stage.store(Mesh_Load_Stage::Welding, std::memory_order_release);
+        mesh = soup->weld();
+      }
+    } else {
+      mesh = read_mesh_file(m_file_path);
+    }
+    if (!mesh.has_value()) {
+      std::cerr << "Failed to import mesh file: " << m_file_path << std::endl;
+      return;
+    }
+  }
+  if (mesh->vertices.empty()) {
+    std::cerr << "Empty mesh: " << m_file_path << std::endl;
+    return;
+  }
+  if (mesh->indices.empty()) {
+    m_point_cloud = std::move(mesh->vertices);
+    return;
+  }
+  if (stop_token.stop_requested()) return;
+
+  m_stage.store(Mesh_Load_Stage::Calculating_Normals, std::memory_order_release);
+  Indexed_Triangle_Mesh_Data mesh_data = Indexed_Triangle_Mesh_Data::from_mesh(std::move(mesh.value()));
+  mesh_data.update_normals_and_areas();
+  if (stop_token.stop_requested()) return;
+
+  m_stage.store(Mesh_Load_Stage::Building_BVH, std::memory_order_release);
+  mesh_data.build_triangles_bvh();
+  if (stop_token.stop_requested()) return;
+
+  // Not being able to cache only makes the next load slower
+  if (source_key.has_value()) {
+    m_stage.store(Mesh_Load_Stage::Writing_Cache, std::memory_order_release);
+    if (!write_mesh_cache_file(cache_file_path, source_key.value(), mesh_data.get_mesh_cache_sections())) {
+      std::cerr << "Failed to write mesh cache file: " << cache_file_path << std::endl;
+    }
+    trim_mesh_cache_directory(m_cache_directory.value(), MAX_MESH_CACHE_DIRECTORY_SIZE);
+  }
+  m_mesh_data = std::move(mesh_data);
+}
+
+Mesh_Loader::~Mesh_Loader() {
+  for (const std::shared_ptr<Mesh_Load_Task> &task : m_tasks) {
+    task->m_stop_source.request_stop();
+  }
+}
+
+void Mesh_Loader::load(const std::string &file_path) {
+  auto task = std::make_shared<Mesh_Load_Task>(file_path, m_cache_directory);
+  m_tasks.push_back(task);
+  m_queue.push_back(task);
+  start_loads();
+}
+
+void Mesh_Loader::load_generated(const std::string &name, size_t num_triangles,
+                                 std::function<Indexed_Triangle_Mesh()> generate) {
+  auto task = std::make_shared<Mesh_Load_Task>(name, num_triangles, std::move(generate));
+  m_tasks.push_back(task);
+  m_queue.push_back(task);
+  start_loads();
+}
+
+void Mesh_Loader::cancel(Mesh_Load_Task &task) {
+  task.m_stop_source.request_stop();
+  // Cancelled tasks skip the memory budget and finish straight away
+  start_loads();
+}
+
+std::vector<std::shared_ptr<Mesh_Load_Task>> Mesh_Loader::take_done_tasks() {
+  std::vector<std::shared_ptr<Mesh_Load_Task>> done_tasks;
+  std::erase_if(m_tasks, [&done_tasks](const std::shared_ptr<Mesh_Load_Task> &task) {
+    if (!task->is_done()) return false;
+    done_tasks.push_back(task);
+    return true;
+  });
+  for (const std::shared_ptr<Mesh_Load_Task> &task : done_tasks) {
+    m_memory_in_flight -= task->m_memory_estimate;
+  }
+  if (!done_tasks.empty()) start_loads();
+  return done_tasks;
+}
+
+void Mesh_Loader::start_loads() {
+  while (!m_queue.empty()) {
+    std::shared_ptr<Mesh_Load_Task> task = m_queue.front();
+    if (task->is_cancelled()) {
+      task->m_memory_estimate = 0;
+    } else if (m_memory_in_flight != 0 && m_memory_in_flight + task->m_memory_estimate > m_memory_budget) {
+      return;
+    }
+    m_queue.pop_front();
+    m_memory_in_flight += task->m_memory_estimate;
+    m_scheduler.submit([task]() { task->run(); }, Task_Priority::Background);
+  }
+}
+
+#ifdef GEOBOX_TEST_MESH_LOADER
+#include <chrono>
+#include <fstream> // for std::ofstream
+#include <new>     // for std::bad_alloc
+#include <thread>  // for std::this_thread::sleep_for
+
+#include "testing.hpp"
+
+// Waits for every queued load, taking done tasks as they finish
+static std::vector<std::shared_ptr<Mesh_Load_Task>> take_all_tasks(Mesh_Loader &loader) {
+  std::vector<std::shared_ptr<Mesh_Load_Task>> tasks;
+  while (!loader.get_tasks().empty()) {
+    for (std::shared_ptr<Mesh_Load_Task> &task : loader.take_done_tasks()) {
+      tasks.push_back(std::move(task));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return tasks;
+}
+
+int main() {
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "geobox_test_mesh_loader";
+  // Private cache directory, so the test neither reads nor fills the user's cache
+  std::filesystem::path cache_directory = directory / "cache";
+  std::filesystem::create_directories(cache_directory);
+  std::vector<std::string> file_paths;
+  for (int i = 0; i < 8; i++) {
+    std::string file_path = (directory / ("tetrahedron_" + std::to_string(i) + ".obj")).string();
+    // Scaled differently, so loads of different files can be told apart
+    std::ofstream(file_path) << "v 0 0 0\nv " << i + 1 << " 0 0\nv 0 1 0\nv 0 0 1\n"
+                             << "f 1 3 2\nf 1 2 4\nf 1 4 3\nf 2 3 4\n";
+    file_paths.push_back(file_path);
+  }
+  std::string points_file_path = (directory / "points.ply").string();
+  std::ofstream(points_file_path) << "ply\nformat ascii 1.0\nelement vertex 2\nproperty float x\nproperty float y\n"
+                                     "property float z\nend_header\n0 0 0\n1 2 3\n";
+  std::string bad_file_path = (directory / "bad.obj").string();
+  std::ofstream(bad_file_path) << "v 0 0 0\nf 1 2 3\n";
+
+  // Budget fits one file at a time, loads still all finish, in queue order once taken
+  {
+    Mesh_Loader loader(1, Task_Scheduler::get(), cache_directory);
+    for (const std::string &file_path : file_paths) {
+      loader.load(file_path);
+    }
+    loader.load(points_file_path);
+    loader.load(bad_file_path);
+    std::vector<std::shared_ptr<Mesh_Load_Task>> tasks = take_all_tasks(loader);
+    runtime_assert(tasks.size() == file_paths.size() + 2);
+    for (const std::shared_ptr<Mesh_Load_Task> &task : tasks) {
+      if (task->get_file_path() == points_file_path) {
+        runtime_assert(task->get_point_cloud().has_value() && task->get_point_cloud()->size() == 2);
+      } else if (task->get_file_path() == bad_file_path) {
+        runtime_assert(!task->get_mesh_data().has_value() && !task->get_point_cloud().has_value());
+      } else {
+        runtime_assert(task->get_mesh_data().has_value());
+        const Indexed_Triangle_Mesh_Data &data = task->get_mesh_data().value();
+        runtime_assert(data.vertices.size() == 4 && data.indices.size() == 12);
+        runtime_assert(data.vertex_normals.size() == 4 && data.triangle_areas.size() == 4 && data.triangles_bvh);
+      }
+    }
+  }
+
+  // Second load of the same files comes from the cache and matches the first
+  {
+    std::optional<uint64_t> source_key = calc_source_file_key(file_paths[3]);
+    runtime_assert(source_key.has_value());
+    runtime_assert(std::filesystem::exists(get_mesh_cache_file_path(cache_directory, source_key.value())));
+    Mesh_Loader loader(DEFAULT_MESH_LOAD_MEMORY_BUDGET, Task_Scheduler::get(), cache_directory);
+    loader.load(file_paths[3]);
+    std::vector<std::shared_ptr<Mesh_Load_Task>> tasks = take_all_tasks(loader);
+    runtime_assert(tasks.size() == 1 && !tasks[0]->get_mesh_data().has_value() && tasks[0]->get_mesh_cache_file());
+    const Mesh_Cache_Sections &sections = tasks[0]->get_mesh_cache_file()->get_sections();
+    runtime_assert(sections.vertices.size() == 4 && sections.vertices[1] == glm::vec3(4, 0, 0));
+  }
+
+  // STL files are read as a triangle soup and welded in a stage of their own
+  {
+    std::string stl_file_path = (directory / "triangles.stl").string();
+    std::ofstream(stl_file_path) << "solid triangles\n"
+                                 << "facet normal 0 0 1\nouter loop\nvertex 0 0 0\nvertex 1 0 0\nvertex 0 1 0\n"
+                                 << "endloop\nendfacet\n"
+                                 << "facet normal 0 0 1\nouter loop\nvertex 1 0 0\nvertex 1 1 0\nvertex 0 1 0\n"
+                                 << "endloop\nendfacet\n"
+                                 << "endsolid triangles\n";
+    Mesh_Loader loader(DEFAULT_MESH_LOAD_MEMORY_BUDGET, Task_Scheduler::get(), std::nullopt);
+    loader.load(stl_file_path);
+    std::vector<std::shared_ptr<Mesh_Load_Task>> tasks = take_all_tasks(loader);
+    runtime_assert(tasks.size() == 1 && tasks[0]->get_mesh_data().has_value());
+    runtime_assert(tasks[0]->get_mesh_data()->vertices.size() == 4 && tasks[0]->get_mesh_data()->indices.size() == 6);
+  }
+
+  // Cancelled loads finish without results, even when queued behind the budget
+  {
+    Mesh_Loader loader(1, Task_Scheduler::get(), cache_directory);
+    for (const std::string &file_path : file_paths) {
+      loader.load(file_path);
+    }
+    for (const std::shared_ptr<Mesh_Load_Task> &task : loader.get_tasks()) {
+      loader.cancel(*task);
+    }
+    for (const std::shared_ptr<Mesh_Load_Task> &task : take_all_tasks(loader)) {
+      runtime_assert(task->is_cancelled());
+    }
+  }
+
+  // Generated meshes get the same normals and BVH as files, a throwing generator only fails its own task
+  {
+    Mesh_Loader loader(1, Task_Scheduler::get(), cache_directory);
+    loader.load_generated("tetrahedron", 4, [] {
+      return Indexed_Triangle_Mesh{
+          .vertices = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+          .indices = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3},
+      };
+    });
+    loader.load_generated("throwing", 4, []() -> Indexed_Triangle_Mesh { throw std::bad_alloc(); });
+    std::vector<std::shared_ptr<Mesh_Load_Task>> tasks = take_all_tasks(loader);
+    runtime_assert(tasks.size() == 2);
+    for (const std::shared_ptr<Mesh_Load_Task> &task : tasks) {
+      if (task->get_file_path() == "tetrahedron") {
+        runtime_assert(task->get_mesh_data().has_value() && task->get_mesh_data()->triangles_bvh);
+      } else {
+        runtime_assert(!task->get_mesh_data().has_value() && !task->get_point_cloud().has_value());
+      }
+    }
+  }
+
+  // Destroying the loader cancels whatever is still queued
+  {
+    Mesh_Loader loader(1, Task_Scheduler::get(), cache_directory);
+    for (const std::string &file_path : file_paths) {
+      loader.load(file_path);
+    }
+  }
+
+  std::filesystem::remove_all(directory);
+  return 0;
+}
+#endif
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional> // for std::function
+#include <memory>     // for std::shared_ptr
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "indexed_triangle_mesh_object.hpp"
+#include "mesh_cache.hpp"
+#include "task_scheduler.hpp"
+
+// Bound on the estimated memory of loads in flight, so importing many large files at once does not run out of memory
+constexpr size_t DEFAULT_MESH_LOAD_MEMORY_BUDGET = size_t(2) << 30;
+// Peak memory of a load relative to its file size, binary STL files take 50 bytes per triangle and the welded mesh
+// with normals, areas and the triangles BVH about 150, text formats take more bytes per triangle
+constexpr size_t MESH_LOAD_MEMORY_PER_FILE_BYTE = 3;
+// Peak memory of generating a mesh and deriving its normals, areas and triangles BVH
+constexpr size_t MESH_LOAD_MEMORY_PER_TRIANGLE = 150;
+
+// Stages in the order a load goes through them, a cache hit skips from Reading_Cache to Done, only STL files are
+// welded, generated meshes go from Queued to Generating and are not cached
+enum class Mesh_Load_Stage {
+  Queued,
+  Reading_Cache,
+  Reading,
+  Welding,
+  Generating,
+  Calculating_Normals,
+  Building_BVH,
+  Writing_Cache,
+  Done
+};
+
+[[nodiscard]] const char *get_mesh_load_stage_name(Mesh_Load_Stage stage);
+
+// Load of one mesh file, everything but the GPU upload, which is left to the thread owning the GL context once the
+// task is done, cancelling stops the load at the next stage
+class Mesh_Load_Task {
+private:
+  friend class Mesh_Loader;
+
+  std::string m_file_path;
+  // Empty for loads that are not cached
+  std::optional<std::filesystem::path> m_cache_directory;
+  // Set for generated meshes, which have no file
+  std::function<Indexed_Triangle_Mesh()> m_generate;
+  size_t m_memory_estimate = 0;
+  std::atomic<Mesh_Load_Stage> m_stage = Mesh_Load_Stage::Queued;
+  // Loads only ever stop on their own, when cancelled
+  std::stop_source m_stop_source;
+  // Results are written by the worker before the stage becomes Done and only read after that
+  std::optional<Indexed_Triangle_Mesh_Data> m_mesh_data;
+  // Set instead of the mesh data on a cache hit, objects view its sections in place
+  std::shared_ptr<const Mesh_Cache_File> m_mesh_cache_file;
+  // Files with vertices only (e.g. PLY point clouds)
+  std::optional<std::vector<glm::vec3>> m_point_cloud;
+  // From the load starting on a worker, so time waiting in the queue is not counted
+  double m_load_seconds = 0.0;
+
+  void run();
+  void load();
+
+public:
+  explicit Mesh_Load_Task(std::string file_path, std::optional<std::filesystem::path> cache_directory = {});
+  Mesh_Load_Task(std::string name, size_t num_triangles, std::function<Indexed_Triangle_Mesh()> generate);
+
+  // Or the name of a generated mesh
+  [[nodiscard]] const std::string &get_file_path() const { return m_file_path; }
+
+  [[nodiscard]] Mesh_Load_Stage get_stage() const { return m_stage.load(std::memory_order_acquire); }
+
+  [[nodiscard]] bool is_done() const { return get_stage() == Mesh_Load_Stage::Done; }
+
+  [[nodiscard]] bool is_cancelled() const { return m_stop_source.stop_requested(); }
+
+  // Empty if the load failed or was cancelled, only valid once done
+  [[nodiscard]] std::optional<Indexed_Triangle_Mesh_Data> &get_mesh_data() { return m_mesh_data; }
+
+  // Null unless the load was served by the mesh cache, only valid once done
+  [[nodiscard]] const std::shared_ptr<const Mesh_Cache_File> &get_mesh_cache_file() const { return m_mesh_cache_file; }
+
+  [[nodiscard]] std::optional<std::vector<glm::vec3>> &get_point_cloud() { return m_point_cloud; }
+
+  // Only valid once done
+  [[nodiscard]] double get_load_seconds() const { return m_load_seconds; }
+};
+
+// Loads queued files concurrently as background tasks of the shared task scheduler, a load only starts once the
+// estimated memory of the loads in flight fits in the budget, or when nothing else is in flight, so files larger than
+// the budget still load, memory of a load counts until its done task is taken, since the task holds the CPU mesh
+class Mesh_Loader {
+private:
+  size_t m_memory_budget;
+  Task_Scheduler &m_scheduler;
+  std::optional<std::filesystem::path> m_cache_directory;
+  // In the order files were queued
+  std::vector<std::shared_ptr<Mesh_Load_Task>> m_tasks;
+  std::deque<std::shared_ptr<Mesh_Load_Task>> m_queue;
+  size_t m_memory_in_flight = 0;
+
+  // Submits queued loads that fit in the budget
+  void start_loads();
+
+public:
+  // Files are not cached without a cache directory
+  explicit Mesh_Loader(size_t memory_budget = DEFAULT_MESH_LOAD_MEMORY_BUDGET,
+                       Task_Scheduler &scheduler = Task_Scheduler::get(),
+                       std::optional<std::filesystem::path> cache_directory = get_default_mesh_cache_directory())
+      : m_memory_budget(memory_budget), m_scheduler(scheduler), m_cache_directory(std::move(cache_directory)) {}
+  // Cancels all loads, the ones already running stop at their next stage
+  ~Mesh_Loader();
+
+  Mesh_Loader(const Mesh_Loader &) = delete;
+  Mesh_Loader &operator=(const Mesh_Loader &) = delete;
+
+  void load(const std::string &file_path);
+  // Runs generate on a worker like a file load, num_triangles is for the memory budget
+  void load_generated(const std::string &name, size_t num_triangles, std::function<Indexed_Triangle_Mesh()> generate);
+
+  void cancel(Mesh_Load_Task &task);
+
+  // Tasks not taken yet, for showing progress
+  [[nodiscard]] const std::vector<std::shared_ptr<Mesh_Load_Task>> &get_tasks() const { return m_tasks; }
+
+  // Removes done tasks in the order they were queued, including failed and cancelled ones
+  [[nodiscard]] std::vector<std::shared_ptr<Mesh_Load_Task>> take_done_tasks();
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm> // for std::min, std::max and std::copy
+#include <cassert>
+#include <cstddef>
+#include <thread>
+#include <utility> // for std::move
+#include <vector>
+
+#include "task_scheduler.hpp"
+
+// Hardware threads, or fewer if the concurrency of the shared task scheduler is limited
+[[nodiscard]] inline size_t get_num_worker_threads() {
+  size_t num_hardware_threads =
+      std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1));
+  return std::min(num_hardware_threads, Task_Scheduler::get().get_max_concurrency());
+}
+
+// Number of contiguous chunks to split [0, num_items) into for parallel_for_chunks,
+// chunks are never smaller than min_chunk_size (except when there are fewer items than that)
+[[nodiscard]] inline size_t calc_num_parallel_chunks(size_t num_items, size_t min_chunk_size) {
+  if (num_items == 0) return 0;
+  min_chunk_size = std::max(min_chunk_size, static_cast<size_t>(1));
+  size_t max_num_chunks = (num_items + min_chunk_size - 1) / min_chunk_size;
+  return std::min(get_num_worker_threads(), max_num_chunks);
+}
+
+// Splits [0, num_items) into num_chunks contiguous chunks and calls callback(chunk_index, chunk_begin, chunk_end) for
+// each in parallel on the shared task scheduler, callers size per-chunk results with the same num_chunks, so it is
+// only calculated once even if the concurrency limit changes meanwhile, the calling thread processes the last chunk
+// and helps with the rest, the call returns once all chunks are done, the first exception thrown by callback is
+// rethrown
+template <typename Callback_Type>
+void parallel_for_chunks(size_t num_items, size_t num_chunks, const Callback_Type &callback) {
+  assert(num_chunks > 0 || num_items == 0);
+  if (num_chunks == 0) return;
+  size_t chunk_size = (num_items + num_chunks - 1) / num_chunks;
+  if (num_chunks == 1) {
+    callback(0, 0, num_items);
+    return;
+  }
+  Task_Group task_group;
+  for (size_t i = 0; i + 1 < num_chunks; i++) {
+    task_group.run([&callback, i, chunk_size, num_items]() {
+      callback(i, std::min(i * chunk_size, num_items), std::min((i + 1) * chunk_size, num_items));
+    });
+  }
+  size_t last = num_chunks - 1;
+  callback(last, std::min(last * chunk_size, num_items), num_items);
+  task_group.wait();
+}
+
+// Calls callback(chunk_begin, chunk_end) on contiguous chunks of [begin, end) in parallel
+template <typename Callback_Type>
+void parallel_for(size_t begin, size_t end, size_t min_chunk_size, const Callback_Type &callback) {
+  if (end <= begin) return;
+  parallel_for_chunks(end - begin, calc_num_parallel_chunks(end - begin, min_chunk_size),
+                      [&callback, begin](size_t, size_t chunk_begin, size_t chunk_end) {
+                        callback(begin + chunk_begin, begin + chunk_end);
+                      });
+}
+
+// Concatenates results of chunks in order, chunks are copied in parallel
+template <typename T> [[nodiscard]] std::vector<T> concatenate_chunks(const std::vector<std::vector<T>> &chunks) {
+  std::vector<size_t> offsets(chunks.size() + 1, 0);
+  for (size_t i = 0; i < chunks.size(); i++) {
+    offsets[i + 1] = offsets[i] + chunks[i].size();
+  }
+  std::vector<T> concatenated(offsets.back());
+  parallel_for(0, chunks.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      std::copy(chunks[i].begin(), chunks[i].end(), concatenated.begin() + static_cast<ptrdiff_t>(offsets[i]));
+    }
+  });
+  return concatenated;
+}
+
+// Reduces [begin, end) in parallel, map(chunk_begin, chunk_end) reduces one chunk and reduce(a, b) combines results,
+// results of chunks are combined in order starting from identity, so the result does not depend on timing
+template <typename T, typename Map_Type, typename Reduce_Type>
+[[nodiscard]] T parallel_reduce(size_t begin, size_t end, size_t min_chunk_size, T identity, const Map_Type &map,
+                                const Reduce_Type &reduce) {
+  if (end <= begin) return identity;
+  std::vector<T> chunk_results(calc_num_parallel_chunks(end - begin, min_chunk_size), identity);
+  parallel_for_chunks(end - begin, chunk_results.size(),
+                      [&chunk_results, &map, begin](size_t chunk_index, size_t chunk_begin, size_t chunk_end) {
+                        chunk_results[chunk_index] = map(begin + chunk_begin, begin + chunk_end);
+                      });
+  T result = std::move(identity);
+  for (T &chunk_result : chunk_results) {
+    result = reduce(std::move(result), std::move(chunk_result));
+  }
+  return result;
+}
@@ -0,0 +1,182 @@
+#include <algorithm> // for std::max and std::min
+#include <cassert>
+#include <numeric> // for std::accumulate
+
+#include <glad/glad.h>
+
+#include <imgui.h>
+
+#include "perf_hud.hpp"
+#include "render_state.hpp"
+
+// Rows of the objects table shown without scrolling
+constexpr int PERF_HUD_MAX_VISIBLE_OBJECT_ROWS = 8;
+constexpr float PERF_HUD_WINDOW_MARGIN = 10.0f;
+constexpr float BYTES_PER_MIB = 1024.0f * 1024.0f;
+
+const char *get_frame_phase_name(Frame_Phase phase) {
+  switch (phase) {
+  case Frame_Phase::Update:
+    return "Update";
+  case Frame_Phase::Surfaces:
+    return "Surfaces";
+  case Frame_Phase::Point_Clouds:
+    return "Point clouds";
+  case Frame_Phase::UI:
+    return "UI";
+  }
+  return "";
+}
+
+GPU_Timer::~GPU_Timer() {
+  if (m_queries[0] != 0) glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+
+void GPU_Timer::read_available_results() {
+  // Older query first, so the newest available result wins
+  for (size_t i : {m_next_query, 1 - m_next_query}) {
+    if (!m_is_query_pending[i]) continue;
+    GLint is_available = GL_FALSE;
+    glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &is_available);
+    if (is_available == GL_FALSE) continue;
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &nanoseconds);
+    m_milliseconds = static_cast<float>(static_cast<double>(nanoseconds) / 1e6);
+    m_is_query_pending[i] = false;
+  }
+}
+
+void GPU_Timer::begin() {
+  assert(!m_is_running);
+  if (m_queries[0] == 0) glGenQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+  read_available_results();
+  if (m_is_query_pending[m_next_query]) return;
+  glBeginQuery(GL_TIME_ELAPSED, m_queries[m_next_query]);
+  m_is_running = true;
+}
+
+void GPU_Timer::end() {
+  if (!m_is_running) return;
+  glEndQuery(GL_TIME_ELAPSED);
+  m_is_query_pending[m_next_query] = true;
+  m_next_query = 1 - m_next_query;
+  m_is_running = false;
+}
+
+void Perf_HUD::add_frame_time(float delta_time) {
+  m_frame_milliseconds[m_frame_index] = delta_time * 1000.0f;
+  m_frame_index = (m_frame_index + 1) % PERF_HUD_HISTORY_SIZE;
+}
+
+void Perf_HUD::begin_phase(Frame_Phase phase) {
+  m_phase_begin_time = std::chrono::steady_clock::now();
+  if (m_is_shown) m_phase_gpu_timers[static_cast<size_t>(phase)].begin();
+}
+
+void Perf_HUD::end_phase(Frame_Phase phase) {
+  m_phase_gpu_timers[static_cast<size_t>(phase)].end();
+  std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - m_phase_begin_time;
+  m_phase_cpu_milliseconds[static_cast<size_t>(phase)] = duration.count();
+}
+
+void Perf_HUD::draw(const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &objects,
+                    const std::vector<std::shared_ptr<Point_Cloud_Object>> &point_cloud_objects) const {
+  if (!m_is_shown) return;
+  const ImGuiViewport *main_viewport = ImGui::GetMainViewport();
+  ImGui::SetNextWindowPos(ImVec2(main_viewport->WorkPos.x + main_viewport->WorkSize.x - PERF_HUD_WINDOW_MARGIN,
+                                 main_viewport->WorkPos.y + PERF_HUD_WINDOW_MARGIN),
+                          ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+  ImGui::SetNextWindowBgAlpha(0.8f);
+  ImGui::Begin("Performance", nullptr,
+               ImGuiWindowFlags_NoMove | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing |
+                   ImGuiWindowFlags_NoSavedSettings);
+
+  // Frame times, oldest on the left
+  float latest = m_frame_milliseconds[(m_frame_index + PERF_HUD_HISTORY_SIZE - 1) % PERF_HUD_HISTORY_SIZE];
+  float average = std::accumulate(m_frame_milliseconds.begin(), m_frame_milliseconds.end(), 0.0f) /
+                  static_cast<float>(PERF_HUD_HISTORY_SIZE);
+  float max = *std::max_element(m_frame_milliseconds.begin(), m_frame_milliseconds.end());
+  ImGui::Text("Frame %.2f ms (%.0f FPS), average %.2f ms, max %.2f ms", latest,
+              latest > 0.0f ? 1000.0f / latest : 0.0f, average, max);
+  ImGui::PlotLines("##Frame times", m_frame_milliseconds.data(), static_cast<int>(PERF_HUD_HISTORY_SIZE),
+                   static_cast<int>(m_frame_index), nullptr, 0.0f, std::max(max, 1.0f),
+                   ImVec2(ImGui::GetContentRegionAvail().x, 60.0f));
+
+  if (ImGui::BeginTable("Phases", 3, ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_RowBg)) {
+    ImGui::TableSetupColumn("Phase");
+    ImGui::TableSetupColumn("CPU ms");
+    ImGui::TableSetupColumn("GPU ms");
+    ImGui::TableHeadersRow();
+    for (size_t i = 0; i < NUM_FRAME_PHASES; i++) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(get_frame_phase_name(static_cast<Frame_Phase>(i)));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", m_phase_cpu_milliseconds[i]);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", m_phase_gpu_timers[i].get_milliseconds());
+    }
+    ImGui::EndTable();
+  }
+  const Render_State &render_state = Render_State::get();
+  ImGui::Text("GL state changes %zu, skipped as redundant %zu", render_state.get_num_state_changes(),
+              render_state.get_num_skipped_state_changes());
+
+  size_t num_triangles = 0;
+  size_t num_points = 0;
+  size_t cpu_bytes = 0;
+  size_t gpu_bytes = 0;
+  int num_rows = static_cast<int>(objects.size() + point_cloud_objects.size());
+  ImVec2 table_size(0.0f, ImGui::GetTextLineHeightWithSpacing() *
+                              static_cast<float>(std::min(num_rows, PERF_HUD_MAX_VISIBLE_OBJECT_ROWS) + 1));
+  if (num_rows > 0 && ImGui::BeginTable("Objects", 5,
+                                        ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_RowBg |
+                                            ImGuiTableFlags_ScrollY,
+                                        table_size)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Object");
+    ImGui::TableSetupColumn("Triangles");
+    ImGui::TableSetupColumn("Vertices");
+    ImGui::TableSetupColumn("CPU MiB");
+    ImGui::TableSetupColumn("GPU MiB");
+    ImGui::TableHeadersRow();
+    auto add_row = [](const char *kind, size_t index, size_t row_triangles, size_t row_vertices, size_t row_cpu_bytes,
+                      size_t row_gpu_bytes) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%s %zu", kind, index);
+      ImGui::TableNextColumn();
+      ImGui::Text("%zu", row_triangles);
+      ImGui::TableNextColumn();
+      ImGui::Text("%zu", row_vertices);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", static_cast<float>(row_cpu_bytes) / BYTES_PER_MIB);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", static_cast<float>(row_gpu_bytes) / BYTES_PER_MIB);
+    };
+    for (size_t i = 0; i < objects.size(); i++) {
+      const Indexed_Triangle_Mesh_Object &object = *objects[i];
+      add_row("Mesh", i, object.get_indices().size() / 3, object.get_vertices().size(),
+              object.calc_cpu_memory_usage(), object.calc_gpu_memory_usage());
+    }
+    for (size_t i = 0; i < point_cloud_objects.size(); i++) {
+      const Point_Cloud_Object &object = *point_cloud_objects[i];
+      add_row("Points", i, 0, object.get_points().size(), object.calc_cpu_memory_usage(),
+              object.calc_gpu_memory_usage());
+    }
+    ImGui::EndTable();
+  }
+  for (const std::shared_ptr<Indexed_Triangle_Mesh_Object> &object : objects) {
+    num_triangles += object->get_indices().size() / 3;
+    cpu_bytes += object->calc_cpu_memory_usage();
+    gpu_bytes += object->calc_gpu_memory_usage();
+  }
+  for (const std::shared_ptr<Point_Cloud_Object> &object : point_cloud_objects) {
+    num_points += object->get_points().size();
+    cpu_bytes += object->calc_cpu_memory_usage();
+    gpu_bytes += object->calc_gpu_memory_usage();
+  }
+  ImGui::Text("Total: %zu triangles, %zu points, %.1f MiB CPU, %.1f MiB GPU", num_triangles, num_points,
+              static_cast<float>(cpu_bytes) / BYTES_PER_MIB, static_cast<float>(gpu_bytes) / BYTES_PER_MIB);
+  ImGui::End();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory> // for std::shared_ptr
+#include <vector>
+
+#include "indexed_triangle_mesh_object.hpp"
+#include "point_cloud_object.hpp"
+
+// Number of frames whose times are plotted
+constexpr size_t PERF_HUD_HISTORY_SIZE = 240;
+
+// Parts of a frame timed by the HUD, in the order they run
+enum class Frame_Phase { Update, Surfaces, Point_Clouds, UI };
+constexpr size_t NUM_FRAME_PHASES = 4;
+
+[[nodiscard]] const char *get_frame_phase_name(Frame_Phase phase);
+
+// GPU time of the GL commands between begin() and end() from GL_TIME_ELAPSED queries, two queries are used in turn and
+// results are only read once available, so timing never stalls the pipeline, at the cost of results being a frame or
+// two late, a query that is still pending when its turn comes again skips that frame
+class GPU_Timer {
+private:
+  std::array<unsigned int, 2> m_queries = {0, 0};
+  std::array<bool, 2> m_is_query_pending = {false, false};
+  size_t m_next_query = 0;
+  bool m_is_running = false;
+  float m_milliseconds = 0.0f;
+
+  void read_available_results();
+
+public:
+  GPU_Timer() = default;
+  // Queries are deleted in destructor,
+  // avoid double delete by disabling copy constructor and copy assignment operator
+  GPU_Timer(const GPU_Timer &) = delete;
+  GPU_Timer &operator=(const GPU_Timer &) = delete;
+  ~GPU_Timer();
+
+  // Queries are created on first use, a GL context must be current
+  void begin();
+  void end();
+
+  // Latest available result
+  [[nodiscard]] float get_milliseconds() const { return m_milliseconds; }
+};
+
+// Overlay with frame time history, CPU and GPU time per frame phase, and triangle, point and memory counts per object
+class Perf_HUD {
+private:
+  std::array<float, PERF_HUD_HISTORY_SIZE> m_frame_milliseconds{};
+  // Next history entry to overwrite, the oldest one
+  size_t m_frame_index = 0;
+  std::array<float, NUM_FRAME_PHASES> m_phase_cpu_milliseconds{};
+  std::array<GPU_Timer, NUM_FRAME_PHASES> m_phase_gpu_timers;
+  std::chrono::steady_clock::time_point m_phase_begin_time;
+  bool m_is_shown = false;
+
+public:
+  // Times the phase while alive
+  class Phase_Scope {
+  private:
+    Perf_HUD &m_hud;
+    Frame_Phase m_phase;
+
+  public:
+    Phase_Scope(Perf_HUD &hud, Frame_Phase phase) : m_hud(hud), m_phase(phase) { m_hud.begin_phase(m_phase); }
+    ~Phase_Scope() { m_hud.end_phase(m_phase); }
+
+    Phase_Scope(const Phase_Scope &) = delete;
+    Phase_Scope &operator=(const Phase_Scope &) = delete;
+  };
+
+  [[nodiscard]] bool is_shown() const { return m_is_shown; }
+
+  void set_shown(bool is_shown) { m_is_shown = is_shown; }
+
+  void add_frame_time(float delta_time);
+  // Phases must not overlap, GPU timers of hidden HUDs are not run
+  void begin_phase(Frame_Phase phase);
+  void end_phase(Frame_Phase phase);
+
+  // Must be called between ImGui::NewFrame() and ImGui::Render()
+  void draw(const std::vector<std::shared_ptr<Indexed_Triangle_Mesh_Object>> &objects,
+            const std::vector<std::shared_ptr<Point_Cloud_Object>> &point_cloud_objects) const;
+};
@@ -0,0 +1,660 @@
+#include <algorithm> // for std::sort, std::min and std::max
+#include <array>
+#include <cassert>
+#include <cmath> // for std::abs
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <unordered_map>
+#include <utility> // for std::move and std::pair
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "plane_cut.hpp"
+#include "scratch_arena.hpp"
+
+constexpr unsigned int INVALID_INDEX = std::numeric_limits<unsigned int>::max();
+
+// Slack for the plane/AABB test, so floating point error never makes the BVH skip a straddling triangle
+constexpr float PLANE_AABB_RELATIVE_SLACK = 1e-4f;
+
+[[nodiscard]] static float signed_distance(const Plane &plane, const glm::vec3 &p) {
+  return glm::dot(p - plane.m_origin, plane.m_normal);
+}
+
+// Vertices exactly on the plane are treated as above, this way every triangle is either above, below or straddling,
+// and a vertex on the plane is used as is as a cut point instead of creating a new vertex at the same position
+[[nodiscard]] static bool is_above(float signed_distance) { return signed_distance >= 0.0f; }
+
+namespace {
+enum class Plane_Side { Below, Above, Both };
+} // namespace
+
+// Side of the plane all of the box lies on, with slack so floating point error never places a straddling triangle on
+// one side only
+[[nodiscard]] static Plane_Side classify_aabb(const Plane &plane, const AABB &aabb) {
+  glm::vec3 center = aabb.min * 0.5f + aabb.max * 0.5f;
+  glm::vec3 half_extents = aabb.max * 0.5f - aabb.min * 0.5f;
+  float radius = glm::dot(half_extents, glm::abs(plane.m_normal));
+  float distance = signed_distance(plane, center);
+  float slack = PLANE_AABB_RELATIVE_SLACK * (radius + std::abs(distance));
+  if (distance - radius > slack) return Plane_Side::Above;
+  if (distance + radius < -slack) return Plane_Side::Below;
+  return Plane_Side::Both;
+}
+
+[[nodiscard]] static float cross_2d(const glm::vec2 &a, const glm::vec2 &b) { return a.x * b.y - a.y * b.x; }
+
+struct Cap_Point {
+  glm::vec2 position;
+  unsigned int id;
+};
+
+using Cap_Polygon = std::vector<Cap_Point>;
+
+// https://en.wikipedia.org/w/index.php?title=Shoelace_formula&oldid=1216424400
+[[nodiscard]] static float signed_area(const Cap_Polygon &polygon) {
+  float area = 0.0f;
+  for (size_t i = 0; i < polygon.size(); i++) {
+    area += cross_2d(polygon[i].position, polygon[(i + 1) % polygon.size()].position);
+  }
+  return area * 0.5f;
+}
+
+// Even-odd rule
+[[nodiscard]] static bool is_point_in_polygon(const glm::vec2 &p, const Cap_Polygon &polygon) {
+  bool inside = false;
+  for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+    const glm::vec2 &a = polygon[i].position;
+    const glm::vec2 &b = polygon[j].position;
+    if (((a.y > p.y) != (b.y > p.y)) && (p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+// Segments sharing an endpoint are not considered intersecting
+[[nodiscard]] static bool segments_properly_intersect(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &c,
+                                                      const glm::vec2 &d) {
+  if (a == c || a == d || b == c || b == d) return false;
+  float d1 = cross_2d(b - a, c - a);
+  float d2 = cross_2d(b - a, d - a);
+  float d3 = cross_2d(d - c, a - c);
+  float d4 = cross_2d(d - c, b - c);
+  return ((d1 > 0.0f) != (d2 > 0.0f)) && ((d3 > 0.0f) != (d4 > 0.0f));
+}
+
+[[nodiscard]] static bool segment_crosses_polygon(const glm::vec2 &a, const glm::vec2 &b, const Cap_Polygon &polygon) {
+  for (size_t i = 0; i < polygon.size(); i++) {
+    if (segments_properly_intersect(a, b, polygon[i].position, polygon[(i + 1) % polygon.size()].position)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Connects a hole to the outer polygon through a pair of coincident "bridge" edges, turning both into a single simple
+// polygon that can be ear clipped, the hole is expected to be wound opposite to the outer polygon
+static void merge_hole(Cap_Polygon &outer, const Cap_Polygon &hole, const std::vector<Cap_Polygon> &remaining_holes) {
+  size_t hole_vertex = 0;
+  for (size_t i = 1; i < hole.size(); i++) {
+    if (hole[i].position.x > hole[hole_vertex].position.x) hole_vertex = i;
+  }
+  const glm::vec2 &m = hole[hole_vertex].position;
+
+  std::vector<size_t> candidates(outer.size());
+  for (size_t i = 0; i < outer.size(); i++) {
+    candidates[i] = i;
+  }
+  auto distance_squared = [&outer, &m](size_t i) { return glm::dot(outer[i].position - m, outer[i].position - m); };
+  std::sort(candidates.begin(), candidates.end(),
+            [&distance_squared](size_t a, size_t b) { return distance_squared(a) < distance_squared(b); });
+  // Fallback to the closest vertex if no visible vertex is found (e.g. degenerate input)
+  size_t outer_vertex = candidates.front();
+  for (size_t candidate : candidates) {
+    const glm::vec2 &p = outer[candidate].position;
+    bool is_visible = !segment_crosses_polygon(m, p, outer) && !segment_crosses_polygon(m, p, hole);
+    for (size_t i = 0; is_visible && i < remaining_holes.size(); i++) {
+      is_visible = !segment_crosses_polygon(m, p, remaining_holes[i]);
+    }
+    if (is_visible) {
+      outer_vertex = candidate;
+      break;
+    }
+  }
+
+  Cap_Polygon merged;
+  merged.reserve(outer.size() + hole.size() + 2);
+  merged.insert(merged.end(), outer.begin(), outer.begin() + static_cast<std::ptrdiff_t>(outer_vertex) + 1);
+  for (size_t i = 0; i <= hole.size(); i++) {
+    merged.push_back(hole[(hole_vertex + i) % hole.size()]);
+  }
+  merged.insert(merged.end(), outer.begin() + static_cast<std::ptrdiff_t>(outer_vertex), outer.end());
+  outer = std::move(merged);
+}
+
+[[nodiscard]] static bool is_point_in_triangle(const glm::vec2 &p, const glm::vec2 &a, const glm::vec2 &b,
+                                               const glm::vec2 &c) {
+  if (p == a || p == b || p == c) return false;
+  return cross_2d(b - a, p - a) >= 0.0f && cross_2d(c - b, p - b) >= 0.0f && cross_2d(a - c, p - c) >= 0.0f;
+}
+
+// Ear clipping of a counter-clockwise simple polygon,
+// only reflex vertices can lie inside an ear, so only they are tested against candidate ears
+// https://www.geometrictools.com/Documentation/TriangulationByEarClipping.pdf
+static void ear_clip(const Cap_Polygon &polygon, std::vector<std::array<unsigned int, 3>> &triangles) {
+  size_t n = polygon.size();
+  if (n < 3) return;
+  std::vector<size_t> prev(n);
+  std::vector<size_t> next(n);
+  for (size_t i = 0; i < n; i++) {
+    prev[i] = (i + n - 1) % n;
+    next[i] = (i + 1) % n;
+  }
+  auto calc_turn = [&](size_t i) {
+    return cross_2d(polygon[i].position - polygon[prev[i]].position,
+                    polygon[next[i]].position - polygon[i].position);
+  };
+  std::vector<bool> is_removed(n, false);
+  std::vector<bool> is_reflex(n, false);
+  std::vector<size_t> reflex_vertices;
+  for (size_t i = 0; i < n; i++) {
+    if (calc_turn(i) <= 0.0f) {
+      is_reflex[i] = true;
+      reflex_vertices.push_back(i);
+    }
+  }
+  auto is_ear = [&](size_t i) {
+    if (is_reflex[i]) return false;
+    const glm::vec2 &a = polygon[prev[i]].position;
+    const glm::vec2 &b = polygon[i].position;
+    const glm::vec2 &c = polygon[next[i]].position;
+    for (size_t r : reflex_vertices) {
+      if (is_removed[r] || !is_reflex[r] || r == prev[i] || r == next[i]) continue;
+      if (is_point_in_triangle(polygon[r].position, a, b, c)) return false;
+    }
+    return true;
+  };
+  auto clip = [&](size_t i) {
+    triangles.push_back({polygon[prev[i]].id, polygon[i].id, polygon[next[i]].id});
+    is_removed[i] = true;
+    next[prev[i]] = next[i];
+    prev[next[i]] = prev[i];
+    // Clipping an ear can only turn its neighbours from reflex to convex, never the other way around
+    for (size_t neighbour : {prev[i], next[i]}) {
+      if (is_reflex[neighbour] && calc_turn(neighbour) > 0.0f) is_reflex[neighbour] = false;
+    }
+  };
+
+  size_t remaining = n;
+  size_t current = 0;
+  size_t num_rejected = 0;
+  while (remaining > 3) {
+    if (is_ear(current)) {
+      size_t following = next[current];
+      clip(current);
+      remaining--;
+      num_rejected = 0;
+      current = following;
+      continue;
+    }
+    current = next[current];
+    num_rejected++;
+    if (num_rejected > remaining) {
+      // No ear found (degenerate or self-intersecting input), clip the least reflex vertex to guarantee progress,
+      // this keeps the cap closed at the cost of a possibly folded triangle
+      size_t best = current;
+      float best_turn = calc_turn(current);
+      for (size_t i = next[current]; i != current; i = next[i]) {
+        if (float turn = calc_turn(i); turn > best_turn) {
+          best = i;
+          best_turn = turn;
+        }
+      }
+      current = next[best];
+      clip(best);
+      remaining--;
+      num_rejected = 0;
+    }
+  }
+  triangles.push_back({polygon[prev[current]].id, polygon[current].id, polygon[next[current]].id});
+}
+
+// Triangulates loops given in the (u, v) plane basis, counter-clockwise loops are outer boundaries and clockwise loops
+// are holes, resulting triangles are counter-clockwise
+[[nodiscard]] static std::vector<std::array<unsigned int, 3>> triangulate_cap(std::vector<Cap_Polygon> loops) {
+  std::vector<Cap_Polygon> outer_loops;
+  std::vector<Cap_Polygon> holes;
+  for (Cap_Polygon &loop : loops) {
+    if (loop.size() < 3) continue;
+    if (signed_area(loop) >= 0.0f) {
+      outer_loops.push_back(std::move(loop));
+    } else {
+      holes.push_back(std::move(loop));
+    }
+  }
+
+  // Assign each hole to the smallest outer loop containing it
+  std::vector<std::vector<Cap_Polygon>> holes_per_outer_loop(outer_loops.size());
+  for (Cap_Polygon &hole : holes) {
+    size_t best = INVALID_INDEX;
+    float best_area = std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < outer_loops.size(); i++) {
+      float area = signed_area(outer_loops[i]);
+      if (area < best_area && is_point_in_polygon(hole.front().position, outer_loops[i])) {
+        best = i;
+        best_area = area;
+      }
+    }
+    // Holes that are not inside any outer loop can not be capped
+    if (best != INVALID_INDEX) holes_per_outer_loop[best].push_back(std::move(hole));
+  }
+
+  std::vector<std::array<unsigned int, 3>> triangles;
+  for (size_t i = 0; i < outer_loops.size(); i++) {
+    std::vector<Cap_Polygon> &outer_loop_holes = holes_per_outer_loop[i];
+    // Merging holes from right to left keeps bridges from crossing previously merged holes
+    auto max_x = [](const Cap_Polygon &polygon) {
+      float result = -std::numeric_limits<float>::infinity();
+      for (const Cap_Point &point : polygon) {
+        result = std::max(result, point.position.x);
+      }
+      return result;
+    };
+    std::sort(outer_loop_holes.begin(), outer_loop_holes.end(),
+              [&max_x](const Cap_Polygon &a, const Cap_Polygon &b) { return max_x(a) > max_x(b); });
+    Cap_Polygon &polygon = outer_loops[i];
+    while (!outer_loop_holes.empty()) {
+      Cap_Polygon hole = std::move(outer_loop_holes.front());
+      outer_loop_holes.erase(outer_loop_holes.begin());
+      merge_hole(polygon, hole, outer_loop_holes);
+    }
+    ear_clip(polygon, triangles);
+  }
+  return triangles;
+}
+
+namespace {
+// Vertices off the plane are used by the half they lie in only, so both halves share one remap of the original
+// vertices, cut points (including vertices on the plane, which count as above but also close the below half) are
+// remapped sparsely per half, as there are only as many of them as cut triangles
+class Mesh_Half_Builder {
+private:
+  std::span<const glm::vec3> m_vertices;
+  std::span<const glm::vec3> m_cut_points;
+  const Plane &m_plane;
+  bool m_is_above;
+  std::span<unsigned int> m_vertex_remap;
+  std::unordered_map<unsigned int, unsigned int> m_cut_point_remap;
+  Indexed_Triangle_Mesh m_mesh;
+
+  [[nodiscard]] unsigned int add_vertex(const glm::vec3 &position) {
+    m_mesh.vertices.push_back(position);
+    return static_cast<unsigned int>(m_mesh.vertices.size() - 1);
+  }
+
+  // Vertex must lie in this half
+  [[nodiscard]] unsigned int get_local_index(unsigned int vertex) {
+    unsigned int &local_index = m_vertex_remap[vertex];
+    if (local_index == INVALID_INDEX) local_index = add_vertex(m_vertices[vertex]);
+    return local_index;
+  }
+
+  [[nodiscard]] unsigned int get_cut_local_index(unsigned int id) {
+    if (id < m_vertices.size() && is_above(signed_distance(m_plane, m_vertices[id])) == m_is_above) {
+      return get_local_index(id);
+    }
+    auto [it, is_inserted] = m_cut_point_remap.try_emplace(id, INVALID_INDEX);
+    if (is_inserted) {
+      it->second = add_vertex(id < m_vertices.size() ? m_vertices[id] : m_cut_points[id - m_vertices.size()]);
+    }
+    return it->second;
+  }
+
+public:
+  Mesh_Half_Builder(std::span<const glm::vec3> vertices, std::span<const glm::vec3> cut_points, const Plane &plane,
+                    bool is_above, std::span<unsigned int> vertex_remap)
+      : m_vertices(vertices), m_cut_points(cut_points), m_plane(plane), m_is_above(is_above),
+        m_vertex_remap(vertex_remap) {}
+
+  // Triangles that are not cut, passed through with their vertices as is
+  void add_triangles(std::span<const unsigned int> indices, std::span<const unsigned int> triangles) {
+    m_mesh.indices.reserve(m_mesh.indices.size() + triangles.size() * 3);
+    for (unsigned int triangle_index : triangles) {
+      unsigned int a = indices[triangle_index * 3 + 0];
+      unsigned int b = indices[triangle_index * 3 + 1];
+      unsigned int c = indices[triangle_index * 3 + 2];
+      if (a == b || b == c || c == a) continue;
+      m_mesh.indices.insert(m_mesh.indices.end(), {get_local_index(a), get_local_index(b), get_local_index(c)});
+    }
+  }
+
+  // Parts of cut triangles and cap triangles, their vertices may be cut points
+  void add_cut_triangle(unsigned int a, unsigned int b, unsigned int c) {
+    if (a == b || b == c || c == a) return;
+    m_mesh.indices.insert(m_mesh.indices.end(),
+                          {get_cut_local_index(a), get_cut_local_index(b), get_cut_local_index(c)});
+  }
+
+  [[nodiscard]] Indexed_Triangle_Mesh take_mesh() { return std::move(m_mesh); }
+};
+
+// Clipped part of a triangle on one side of the plane, at most 4 vertices
+struct Clipped_Polygon {
+  std::array<unsigned int, 4> ids;
+  size_t size = 0;
+
+  void push(unsigned int id) {
+    if (size > 0 && ids[size - 1] == id) return;
+    assert(size < ids.size());
+    ids[size++] = id;
+  }
+
+  void close() {
+    if (size > 1 && ids[size - 1] == ids[0]) size--;
+  }
+};
+} // namespace
+
+Plane_Cut_Result cut_by_plane(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices,
+                              const BVH &triangles_bvh, const Plane &plane) {
+  assert(indices.size() % 3 == 0);
+  Plane_Cut_Result result;
+  auto num_vertices = static_cast<unsigned int>(vertices.size());
+
+  // Sort triangles by side, nodes lying on one side of the plane pass all of their triangles through at once, only
+  // triangles of leaves the plane passes through are tested one by one
+  std::vector<unsigned int> below_triangles;
+  std::vector<unsigned int> above_triangles;
+  std::vector<unsigned int> cut_triangles;
+  if (!indices.empty()) {
+    std::span<const BVH::Node> nodes = triangles_bvh.get_nodes();
+    std::span<const unsigned int> primitive_indices = triangles_bvh.get_primitive_indices();
+    Scratch_Scope scratch;
+    std::pmr::vector<unsigned int> stack(scratch.get_resource());
+    stack.reserve(64);
+    stack.push_back(0);
+    while (!stack.empty()) {
+      const BVH::Node &node = nodes[stack.back()];
+      stack.pop_back();
+      Plane_Side side = classify_aabb(plane, node.aabb);
+      if (side == Plane_Side::Both && !node.is_leaf()) {
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+        continue;
+      }
+      std::span<const unsigned int> node_triangles = primitive_indices.subspan(node.first, node.num_primitives());
+      if (side != Plane_Side::Both) {
+        std::vector<unsigned int> &triangles = (side == Plane_Side::Above) ? above_triangles : below_triangles;
+        triangles.insert(triangles.end(), node_triangles.begin(), node_triangles.end());
+        continue;
+      }
+      for (unsigned int triangle_index : node_triangles) {
+        bool has_above = false;
+        bool has_below = false;
+        for (int i = 0; i < 3; i++) {
+          bool above = is_above(signed_distance(plane, vertices[indices[triangle_index * 3 + i]]));
+          has_above |= above;
+          has_below |= !above;
+        }
+        (has_above && has_below ? cut_triangles : (has_above ? above_triangles : below_triangles))
+            .push_back(triangle_index);
+      }
+    }
+  }
+  std::sort(cut_triangles.begin(), cut_triangles.end());
+  result.num_cut_triangles = cut_triangles.size();
+
+  // Split straddling triangles, cut points are identified by the edge they lie on (or by the vertex lying exactly on
+  // the plane), so neighbouring triangles share them and both halves stay watertight
+  std::vector<glm::vec3> cut_points;
+  std::unordered_map<uint64_t, unsigned int> edge_cut_points;
+  auto get_cut_point = [&](unsigned int above_vertex, float above_distance, unsigned int below_vertex,
+                           float below_distance) {
+    if (above_distance == 0.0f) return above_vertex;
+    uint64_t key = (static_cast<uint64_t>(std::min(above_vertex, below_vertex)) << 32) |
+                   static_cast<uint64_t>(std::max(above_vertex, below_vertex));
+    auto [it, is_inserted] =
+        edge_cut_points.try_emplace(key, num_vertices + static_cast<unsigned int>(cut_points.size()));
+    if (is_inserted) {
+      float t = above_distance / (above_distance - below_distance);
+      const glm::vec3 &a = vertices[above_vertex];
+      const glm::vec3 &b = vertices[below_vertex];
+      cut_points.push_back(a + t * (b - a));
+    }
+    return it->second;
+  };
+
+  std::vector<Clipped_Polygon> below_polygons;
+  std::vector<Clipped_Polygon> above_polygons;
+  below_polygons.reserve(cut_triangles.size());
+  above_polygons.reserve(cut_triangles.size());
+  // Cut edges as they appear in the below polygons, they are oriented as the above cap expects them to be
+  std::vector<std::pair<unsigned int, unsigned int>> cut_edges;
+  cut_edges.reserve(cut_triangles.size());
+  for (unsigned int triangle_index : cut_triangles) {
+    std::array<unsigned int, 3> triangle{indices[triangle_index * 3 + 0], indices[triangle_index * 3 + 1],
+                                         indices[triangle_index * 3 + 2]};
+    std::array<float, 3> distances{};
+    for (int i = 0; i < 3; i++) {
+      distances[i] = signed_distance(plane, vertices[triangle[i]]);
+    }
+    Clipped_Polygon &below = below_polygons.emplace_back();
+    Clipped_Polygon &above = above_polygons.emplace_back();
+    unsigned int exit_point = INVALID_INDEX;  // Where the triangle boundary leaves the below half
+    unsigned int entry_point = INVALID_INDEX; // Where the triangle boundary enters the below half
+    for (int i = 0; i < 3; i++) {
+      int j = (i + 1) % 3;
+      bool is_current_above = is_above(distances[i]);
+      if (is_current_above) {
+        above.push(triangle[i]);
+      } else {
+        below.push(triangle[i]);
+      }
+      if (is_current_above == is_above(distances[j])) continue;
+      unsigned int cut_point = is_current_above
+                                   ? get_cut_point(triangle[i], distances[i], triangle[j], distances[j])
+                                   : get_cut_point(triangle[j], distances[j], triangle[i], distances[i]);
+      above.push(cut_point);
+      below.push(cut_point);
+      (is_current_above ? entry_point : exit_point) = cut_point;
+    }
+    above.close();
+    below.close();
+    assert(exit_point != INVALID_INDEX && entry_point != INVALID_INDEX);
+    if (exit_point != entry_point) cut_edges.emplace_back(exit_point, entry_point);
+  }
+
+  auto get_position = [&vertices, &cut_points, num_vertices](unsigned int id) -> const glm::vec3 & {
+    return id < num_vertices ? vertices[id] : cut_points[id - num_vertices];
+  };
+
+  // Chain cut edges into loops
+  std::unordered_map<unsigned int, size_t> cut_edge_starting_at;
+  cut_edge_starting_at.reserve(cut_edges.size());
+  for (size_t i = 0; i < cut_edges.size(); i++) {
+    cut_edge_starting_at.try_emplace(cut_edges[i].first, i);
+  }
+  std::vector<bool> is_cut_edge_visited(cut_edges.size(), false);
+  std::vector<std::vector<unsigned int>> loops;
+  for (size_t first_edge = 0; first_edge < cut_edges.size(); first_edge++) {
+    if (is_cut_edge_visited[first_edge]) continue;
+    std::vector<unsigned int> loop;
+    size_t edge = first_edge;
+    bool is_closed = false;
+    while (true) {
+      is_cut_edge_visited[edge] = true;
+      loop.push_back(cut_edges[edge].first);
+      unsigned int end = cut_edges[edge].second;
+      if (end == cut_edges[first_edge].first) {
+        is_closed = true;
+        break;
+      }
+      auto it = cut_edge_starting_at.find(end);
+      if (it == cut_edge_starting_at.end() || is_cut_edge_visited[it->second]) break;
+      edge = it->second;
+    }
+    if (is_closed) {
+      loops.push_back(std::move(loop));
+    } else {
+      result.num_open_loops++;
+    }
+  }
+
+  // Project loops onto the plane, in a basis where counter-clockwise winding faces away from the above half
+  glm::vec3 cap_normal = -plane.m_normal;
+  glm::vec3 helper_axis = std::abs(cap_normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+  glm::vec3 u = glm::normalize(glm::cross(helper_axis, cap_normal));
+  glm::vec3 v = glm::cross(cap_normal, u);
+  std::vector<Cap_Polygon> cap_loops;
+  cap_loops.reserve(loops.size());
+  for (const std::vector<unsigned int> &loop : loops) {
+    Cap_Polygon &cap_loop = cap_loops.emplace_back();
+    cap_loop.reserve(loop.size());
+    for (unsigned int id : loop) {
+      glm::vec3 p = get_position(id) - plane.m_origin;
+      cap_loop.push_back({.position = {glm::dot(p, u), glm::dot(p, v)}, .id = id});
+    }
+  }
+  std::vector<std::array<unsigned int, 3>> cap_triangles = triangulate_cap(std::move(cap_loops));
+
+  // Assemble both halves
+  std::vector<unsigned int> vertex_remap(vertices.size(), INVALID_INDEX);
+  Mesh_Half_Builder below_builder(vertices, cut_points, plane, false, vertex_remap);
+  Mesh_Half_Builder above_builder(vertices, cut_points, plane, true, vertex_remap);
+  below_builder.add_triangles(indices, below_triangles);
+  above_builder.add_triangles(indices, above_triangles);
+  for (size_t i = 0; i < cut_triangles.size(); i++) {
+    for (auto [polygon, builder] :
+         {std::pair{&below_polygons[i], &below_builder}, std::pair{&above_polygons[i], &above_builder}}) {
+      for (size_t j = 1; j + 1 < polygon->size; j++) {
+        builder->add_cut_triangle(polygon->ids[0], polygon->ids[j], polygon->ids[j + 1]);
+      }
+    }
+  }
+  for (const std::array<unsigned int, 3> &triangle : cap_triangles) {
+    above_builder.add_cut_triangle(triangle[0], triangle[1], triangle[2]);
+    below_builder.add_cut_triangle(triangle[0], triangle[2], triangle[1]);
+  }
+  result.below = below_builder.take_mesh();
+  result.above = above_builder.take_mesh();
+  return result;
+}
+
+#ifdef GEOBOX_TEST_PLANE_CUT
+#include "math.hpp"
+#include "testing.hpp"
+
+[[nodiscard]] static Plane_Cut_Result cut(const Indexed_Triangle_Mesh &mesh, const Plane &plane) {
+  std::vector<AABB> triangle_bounding_boxes;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    const glm::vec3 &a = mesh.vertices[mesh.indices[i + 0]];
+    const glm::vec3 &b = mesh.vertices[mesh.indices[i + 1]];
+    const glm::vec3 &c = mesh.vertices[mesh.indices[i + 2]];
+    triangle_bounding_boxes.push_back({.min = glm::min(a, glm::min(b, c)), .max = glm::max(a, glm::max(b, c))});
+  }
+  BVH bvh(triangle_bounding_boxes);
+  return cut_by_plane(mesh.vertices, mesh.indices, bvh, plane);
+}
+
+int main() {
+  Tolerance_Context tc(1e-5f, 1e-5f);
+
+  // Unit cube with outward facing counter-clockwise triangles
+  Indexed_Triangle_Mesh cube{
+      .vertices = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}},
+      .indices = {0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+                  1, 2, 6, 1, 6, 5, 2, 3, 7, 2, 7, 6, 3, 0, 4, 3, 4, 7},
+  };
+  runtime_assert(is_watertight(cube));
+  runtime_assert(is_close(tc, calc_volume(cube), 1.0f));
+
+  // Oblique cut
+  Plane_Cut_Result oblique =
+      cut(cube, {.m_origin = {0.5f, 0.5f, 0.5f}, .m_normal = glm::normalize(glm::vec3(1, 2, 3))});
+  runtime_assert(oblique.num_cut_triangles > 0);
+  runtime_assert(oblique.num_open_loops == 0);
+  runtime_assert(is_watertight(oblique.below));
+  runtime_assert(is_watertight(oblique.above));
+  runtime_assert(is_close(tc, calc_volume(oblique.below) + calc_volume(oblique.above), 1.0f));
+  // The plane passes through the cube center, so by symmetry both halves have the same volume
+  runtime_assert(is_close(tc, calc_volume(oblique.below), 0.5f));
+
+  // Cut through existing vertices and edges
+  Plane_Cut_Result diagonal =
+      cut(cube, {.m_origin = {0.0f, 0.0f, 0.0f}, .m_normal = glm::normalize(glm::vec3(1, -1, 0))});
+  runtime_assert(diagonal.num_open_loops == 0);
+  runtime_assert(is_watertight(diagonal.below));
+  runtime_assert(is_watertight(diagonal.above));
+  runtime_assert(is_close(tc, calc_volume(diagonal.below), 0.5f));
+  runtime_assert(is_close(tc, calc_volume(diagonal.above), 0.5f));
+
+  // Plane missing the mesh leaves it intact
+  Plane_Cut_Result miss = cut(cube, {.m_origin = {0.0f, 0.0f, 2.0f}, .m_normal = {0.0f, 0.0f, 1.0f}});
+  runtime_assert(miss.num_cut_triangles == 0);
+  runtime_assert(miss.above.indices.empty());
+  runtime_assert(miss.below.indices.size() == cube.indices.size());
+
+  // Column of cubes, only the middle one is cut, the others are passed through by whole BVH nodes
+  Indexed_Triangle_Mesh column;
+  for (unsigned int i = 0; i < 16; i++) {
+    for (const glm::vec3 &v : cube.vertices) {
+      column.vertices.push_back(v + glm::vec3(0.0f, 0.0f, 2.0f * static_cast<float>(i)));
+    }
+    for (unsigned int index : cube.indices) {
+      column.indices.push_back(index + i * static_cast<unsigned int>(cube.vertices.size()));
+    }
+  }
+  Plane_Cut_Result middle = cut(column, {.m_origin = {0.0f, 0.0f, 16.5f}, .m_normal = {0.0f, 0.0f, 1.0f}});
+  runtime_assert(middle.num_cut_triangles == 8);
+  runtime_assert(middle.num_open_loops == 0);
+  runtime_assert(is_watertight(middle.below));
+  runtime_assert(is_watertight(middle.above));
+  runtime_assert(is_close(tc, calc_volume(middle.below), 8.5f));
+  runtime_assert(is_close(tc, calc_volume(middle.above), 7.5f));
+  // Halves only keep the vertices they use, plus a cut point on each vertical edge and side face diagonal
+  runtime_assert(middle.below.vertices.size() == 8 * 8 + 4 + 8);
+  runtime_assert(middle.above.vertices.size() == 7 * 8 + 4 + 8);
+
+  // Cap with a hole: cube with a square tunnel along z, cut across the tunnel
+  Indexed_Triangle_Mesh tube;
+  auto add_vertex = [&tube](const glm::vec3 &v) {
+    auto it = std::find(tube.vertices.begin(), tube.vertices.end(), v);
+    if (it != tube.vertices.end()) return static_cast<unsigned int>(it - tube.vertices.begin());
+    tube.vertices.push_back(v);
+    return static_cast<unsigned int>(tube.vertices.size() - 1);
+  };
+  auto add_quad = [&tube, &add_vertex](glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d) {
+    unsigned int ia = add_vertex(a), ib = add_vertex(b), ic = add_vertex(c), id = add_vertex(d);
+    tube.indices.insert(tube.indices.end(), {ia, ib, ic, ia, ic, id});
+  };
+  // Outer walls facing outwards and inner walls facing the tunnel
+  add_quad({0, 0, 0}, {3, 0, 0}, {3, 0, 1}, {0, 0, 1});
+  add_quad({3, 0, 0}, {3, 3, 0}, {3, 3, 1}, {3, 0, 1});
+  add_quad({3, 3, 0}, {0, 3, 0}, {0, 3, 1}, {3, 3, 1});
+  add_quad({0, 3, 0}, {0, 0, 0}, {0, 0, 1}, {0, 3, 1});
+  add_quad({1, 1, 0}, {1, 1, 1}, {2, 1, 1}, {2, 1, 0});
+  add_quad({2, 1, 0}, {2, 1, 1}, {2, 2, 1}, {2, 2, 0});
+  add_quad({2, 2, 0}, {2, 2, 1}, {1, 2, 1}, {1, 2, 0});
+  add_quad({1, 2, 0}, {1, 2, 1}, {1, 1, 1}, {1, 1, 0});
+  Plane_Cut_Result ring = cut(tube, {.m_origin = {0.0f, 0.0f, 0.5f}, .m_normal = {0.0f, 0.0f, 1.0f}});
+  runtime_assert(ring.num_open_loops == 0);
+  // Cap is the 3x3 square minus the 1x1 tunnel
+  for (const Indexed_Triangle_Mesh *half : {&ring.below, &ring.above}) {
+    float cap_area = 0.0f;
+    for (size_t i = 0; i < half->indices.size(); i += 3) {
+      const glm::vec3 &a = half->vertices[half->indices[i + 0]];
+      const glm::vec3 &b = half->vertices[half->indices[i + 1]];
+      const glm::vec3 &c = half->vertices[half->indices[i + 2]];
+      if (is_close(tc, a.z, 0.5f) && is_close(tc, b.z, 0.5f) && is_close(tc, c.z, 0.5f)) {
+        cap_area += glm::length(glm::cross(b - a, c - a)) * 0.5f;
+      }
+    }
+    runtime_assert(is_close(tc, cap_area, 8.0f));
+  }
+
+  return 0;
+}
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "bvh.hpp"
+#include "indexed_triangle_mesh.hpp"
+#include "primitives.hpp"
+
+struct Plane_Cut_Result {
+  // Part of the mesh in the half-space the plane normal points away from
+  Indexed_Triangle_Mesh below;
+  // Part of the mesh in the half-space the plane normal points to, vertices lying on the plane count as above
+  Indexed_Triangle_Mesh above;
+  size_t num_cut_triangles = 0;
+  // Cut loops that do not close (e.g. when the input mesh is not watertight), they are left uncapped
+  size_t num_open_loops = 0;
+};
+
+// Splits the mesh into two halves and closes each of them with a cap,
+// only triangles straddling the plane (found through the triangles BVH) are split,
+// the rest are copied as is into the half they lie in, a whole BVH node at a time when the plane misses the node
+[[nodiscard]] Plane_Cut_Result cut_by_plane(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices,
+                                            const BVH &triangles_bvh, const Plane &plane);
@@ -4,6 +4,7 @@
 
 #include "geobox_exceptions.hpp"
 #include "point_cloud_object.hpp"
+#include "render_state.hpp"
 
 Point_Cloud_Object::Point_Cloud_Object(const std::vector<glm::vec3> &points, const glm::mat4 &model_matrix)
     : m_points(points), m_model_matrix(model_matrix) {
@@ -19,22 +20,23 @@ Point_Cloud_Object::Point_Cloud_Object(const std::vector<glm::vec3> &points, con
   }
   auto points_buffer_size = static_cast<unsigned int>(m_points.size() * sizeof(glm::vec3));
 
+  Render_State &render_state = Render_State::get();
   glGenVertexArrays(1, &m_VAO);
-  glBindVertexArray(m_VAO);
+  render_state.bind_vertex_array(m_VAO);
 
   glGenBuffers(1, &m_VBO);
-  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  render_state.bind_buffer(GL_ARRAY_BUFFER, m_VBO);
   glBufferData(GL_ARRAY_BUFFER, points_buffer_size, m_points.data(), GL_STATIC_DRAW);
   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
   glEnableVertexAttribArray(0);
 }
 
 void Point_Cloud_Object::draw() const {
-  glBindVertexArray(m_VAO);
+  Render_State::get().bind_vertex_array(m_VAO);
   glDrawArrays(GL_POINTS, 0, static_cast<int>(m_points.size()));
 }
 
 Point_Cloud_Object::~Point_Cloud_Object() {
-  glDeleteVertexArrays(1, &m_VAO);
-  glDeleteBuffers(1, &m_VBO);
+  Render_State::get().delete_vertex_array(m_VAO);
+  Render_State::get().delete_buffer(m_VBO);
 }
@@ -23,6 +23,10 @@ public:
   Point_Cloud_Object(const std::vector<glm::vec3> &points, const glm::mat4 &model_matrix);
   void draw() const;
 
+  [[nodiscard]] size_t calc_cpu_memory_usage() const { return m_points.capacity() * sizeof(glm::vec3); }
+
+  [[nodiscard]] size_t calc_gpu_memory_usage() const { return m_points.size() * sizeof(glm::vec3); }
+
   [[nodiscard]] const std::vector<glm::vec3> &get_points() const { return m_points; }
 
   [[nodiscard]] const glm::mat4 &get_model_matrix() const { return m_model_matrix; }
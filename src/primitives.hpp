@@ -11,3 +11,9 @@ struct Triangle {
 struct Segment {
   glm::vec3 m_a, m_b;
 };
+
+struct Plane {
+  glm::vec3 m_origin;
+  // Expected to be normalized
+  glm::vec3 m_normal;
+};
@@ -0,0 +1,188 @@
+#include <algorithm> // for std::min
+#include <atomic>
+#include <fstream> // for std::ofstream
+#include <iomanip> // for std::setprecision
+#include <iostream>
+#include <limits>
+#include <memory> // for std::unique_ptr and std::make_unique
+#include <mutex>
+#include <vector>
+
+#include "profiler.hpp"
+
+namespace {
+// Fields are atomic, so the exporter can read slots the owning thread is overwriting, it drops such zones afterwards
+struct Profile_Zone_Slot {
+  std::atomic<const char *> name;
+  std::atomic<int64_t> begin_time;
+  std::atomic<int64_t> end_time;
+};
+
+struct Profile_Zone {
+  const char *name;
+  int64_t begin_time;
+  int64_t end_time;
+};
+
+// Written by its thread only, zone i is in slot i % PROFILER_BUFFER_CAPACITY
+struct Thread_Profile_Buffer {
+  size_t thread_index;
+  std::unique_ptr<Profile_Zone_Slot[]> slots = std::make_unique<Profile_Zone_Slot[]>(PROFILER_BUFFER_CAPACITY);
+  // Zones num_recorded, ..., num_started - 1 are being written
+  std::atomic<uint64_t> num_started = 0;
+  std::atomic<uint64_t> num_recorded = 0;
+};
+
+// Buffers are never freed, so zones of threads that exited are still exported
+struct Profiler_Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Thread_Profile_Buffer>> buffers;
+};
+} // namespace
+
+[[nodiscard]] static Profiler_Registry &get_profiler_registry() {
+  static Profiler_Registry registry;
+  return registry;
+}
+
+[[nodiscard]] static Thread_Profile_Buffer &get_thread_profile_buffer() {
+  thread_local Thread_Profile_Buffer *buffer = nullptr;
+  if (buffer == nullptr) {
+    Profiler_Registry &registry = get_profiler_registry();
+    std::lock_guard lock(registry.mutex);
+    registry.buffers.push_back(std::make_unique<Thread_Profile_Buffer>());
+    buffer = registry.buffers.back().get();
+    buffer->thread_index = registry.buffers.size() - 1;
+  }
+  return *buffer;
+}
+
+void record_profile_zone(const char *name, int64_t begin_time, int64_t end_time) {
+  Thread_Profile_Buffer &buffer = get_thread_profile_buffer();
+  uint64_t i = buffer.num_recorded.load(std::memory_order_relaxed);
+  buffer.num_started.store(i + 1, std::memory_order_relaxed);
+  // Orders marking zone i as being written before the writes to its slot, like a seqlock
+  std::atomic_thread_fence(std::memory_order_release);
+  Profile_Zone_Slot &slot = buffer.slots[i % PROFILER_BUFFER_CAPACITY];
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.begin_time.store(begin_time, std::memory_order_relaxed);
+  slot.end_time.store(end_time, std::memory_order_relaxed);
+  buffer.num_recorded.store(i + 1, std::memory_order_release);
+}
+
+// Zones of the buffer that were not overwritten while being copied
+[[nodiscard]] static std::vector<Profile_Zone> copy_profile_zones(const Thread_Profile_Buffer &buffer) {
+  uint64_t end = buffer.num_recorded.load(std::memory_order_acquire);
+  uint64_t begin = end - std::min(end, static_cast<uint64_t>(PROFILER_BUFFER_CAPACITY));
+  std::vector<Profile_Zone> zones;
+  zones.reserve(end - begin);
+  for (uint64_t i = begin; i < end; i++) {
+    const Profile_Zone_Slot &slot = buffer.slots[i % PROFILER_BUFFER_CAPACITY];
+    zones.push_back({slot.name.load(std::memory_order_relaxed), slot.begin_time.load(std::memory_order_relaxed),
+                     slot.end_time.load(std::memory_order_relaxed)});
+  }
+  // Zone i is overwritten by zone i + PROFILER_BUFFER_CAPACITY
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t num_started = buffer.num_started.load(std::memory_order_relaxed);
+  uint64_t first_intact = num_started - std::min(num_started, static_cast<uint64_t>(PROFILER_BUFFER_CAPACITY));
+  if (first_intact > begin) {
+    zones.erase(zones.begin(), zones.begin() + static_cast<ptrdiff_t>(std::min(first_intact, end) - begin));
+  }
+  return zones;
+}
+
+static void write_json_string(std::ostream &stream, const char *text) {
+  stream << '"';
+  for (const char *c = text; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') stream << '\\';
+    stream << *c;
+  }
+  stream << '"';
+}
+
+void write_chrome_trace(std::ostream &stream) {
+  std::vector<std::pair<size_t, std::vector<Profile_Zone>>> thread_zones;
+  {
+    Profiler_Registry &registry = get_profiler_registry();
+    std::lock_guard lock(registry.mutex);
+    for (const std::unique_ptr<Thread_Profile_Buffer> &buffer : registry.buffers) {
+      thread_zones.emplace_back(buffer->thread_index, copy_profile_zones(*buffer));
+    }
+  }
+  int64_t start_time = std::numeric_limits<int64_t>::max();
+  for (const auto &[thread_index, zones] : thread_zones) {
+    for (const Profile_Zone &zone : zones) {
+      start_time = std::min(start_time, zone.begin_time);
+    }
+  }
+
+  // Times are in microseconds, https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool is_first = true;
+  stream << std::fixed << std::setprecision(3);
+  for (const auto &[thread_index, zones] : thread_zones) {
+    for (const Profile_Zone &zone : zones) {
+      stream << (is_first ? "\n" : ",\n") << "{\"name\":";
+      write_json_string(stream, zone.name);
+      stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_index
+             << ",\"ts\":" << static_cast<double>(zone.begin_time - start_time) / 1000.0
+             << ",\"dur\":" << static_cast<double>(zone.end_time - zone.begin_time) / 1000.0 << "}";
+      is_first = false;
+    }
+  }
+  stream << "\n]}\n";
+}
+
+bool write_chrome_trace_file(const std::string &file_path) {
+  std::ofstream file(file_path);
+  if (!file) {
+    std::cerr << "Failed to open file for writing: " << file_path << std::endl;
+    return false;
+  }
+  write_chrome_trace(file);
+  return static_cast<bool>(file);
+}
+
+#ifdef GEOBOX_TEST_PROFILER
+#include <sstream> // for std::ostringstream
+#include <string>
+#include <thread>
+
+#include "testing.hpp"
+
+[[nodiscard]] static size_t count_occurrences(const std::string &text, const std::string &pattern) {
+  size_t count = 0;
+  for (size_t i = text.find(pattern); i != std::string::npos; i = text.find(pattern, i + 1)) {
+    count++;
+  }
+  return count;
+}
+
+int main() {
+  {
+    GEOBOX_PROFILE_SCOPE("Outer \"quoted\"");
+    GEOBOX_PROFILE_SCOPE("Inner");
+  }
+  // Ring buffer of the other thread wraps around while the trace is written, only whole zones are exported
+  std::thread thread([]() {
+    for (size_t i = 0; i < PROFILER_BUFFER_CAPACITY + 1000; i++) {
+      GEOBOX_PROFILE_SCOPE("Loop");
+    }
+  });
+  std::ostringstream concurrent_trace;
+  write_chrome_trace(concurrent_trace);
+  thread.join();
+  runtime_assert(count_occurrences(concurrent_trace.str(), "\"name\":\"Loop\"") <= PROFILER_BUFFER_CAPACITY);
+
+  std::ostringstream trace;
+  write_chrome_trace(trace);
+  std::string text = trace.str();
+  runtime_assert(text.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") && text.ends_with("]}\n"));
+  runtime_assert(count_occurrences(text, "\"name\":\"Outer \\\"quoted\\\"\",\"ph\":\"X\",\"pid\":1,\"tid\":0") == 1);
+  runtime_assert(count_occurrences(text, "\"name\":\"Inner\"") == 1);
+  runtime_assert(count_occurrences(text, "\"name\":\"Loop\",\"ph\":\"X\",\"pid\":1,\"tid\":1") ==
+                 PROFILER_BUFFER_CAPACITY);
+  runtime_assert(count_occurrences(text, "\"ph\":\"X\"") == PROFILER_BUFFER_CAPACITY + 2);
+  return 0;
+}
+#endif
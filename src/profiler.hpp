@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Scoped zones are recorded into a lock-free ring buffer per thread, which keeps the latest PROFILER_BUFFER_CAPACITY
+// zones of each thread, and exported as Chrome trace event JSON, readable by chrome://tracing and Perfetto
+// GEOBOX_PROFILE_SCOPE compiles to nothing unless ENABLE_PROFILER is defined, so it costs nothing in regular builds
+constexpr size_t PROFILER_BUFFER_CAPACITY = 65536;
+
+[[nodiscard]] inline int64_t get_profiler_time() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Name must outlive the profiler, e.g. a string literal, since only the pointer is stored
+void record_profile_zone(const char *name, int64_t begin_time, int64_t end_time);
+
+// Zones that are still in the ring buffers, including ones recorded while writing, times are relative to the earliest
+void write_chrome_trace(std::ostream &stream);
+[[nodiscard]] bool write_chrome_trace_file(const std::string &file_path);
+
+class Profile_Scope {
+private:
+  const char *m_name;
+  int64_t m_begin_time;
+
+public:
+  explicit Profile_Scope(const char *name) : m_name(name), m_begin_time(get_profiler_time()) {}
+  ~Profile_Scope() { record_profile_zone(m_name, m_begin_time, get_profiler_time()); }
+
+  Profile_Scope(const Profile_Scope &) = delete;
+  Profile_Scope &operator=(const Profile_Scope &) = delete;
+};
+
+#ifdef ENABLE_PROFILER
+#define GEOBOX_PROFILE_CONCATENATE_IMPL(a, b) a##b
+#define GEOBOX_PROFILE_CONCATENATE(a, b) GEOBOX_PROFILE_CONCATENATE_IMPL(a, b)
+#define GEOBOX_PROFILE_SCOPE(name) Profile_Scope GEOBOX_PROFILE_CONCATENATE(profile_scope_, __LINE__)(name)
+#else
+#define GEOBOX_PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
@@ -2,6 +2,7 @@
 #include <cassert>
 #include <iostream>
 #include <optional>
+#include <tuple> // for std::tie
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -0,0 +1,235 @@
+#include <algorithm>  // for std::transform and std::sort
+#include <cctype>     // for std::tolower
+#include <filesystem> // for std::filesystem::path and std::filesystem::recursive_directory_iterator
+#include <iostream>   // for std::cerr and std::endl
+#include <optional>
+#include <string>
+#include <system_error> // for std::error_code
+#include <vector>
+
+#include "indexed_triangle_mesh.hpp"
+#include "read_mesh.hpp"
+#include "read_obj.hpp"
+#include "read_ply.hpp"
+#include "read_stl.hpp"
+
+[[nodiscard]] static std::string get_lowercase_extension(const std::string &file_path) {
+  std::string extension = std::filesystem::path(file_path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return extension;
+}
+
+std::optional<Indexed_Triangle_Mesh> read_mesh_file(const std::string &file_path) {
+  std::string extension = get_lowercase_extension(file_path);
+  if (extension == ".stl") return read_stl_mesh_file_welded(file_path);
+  if (extension == ".obj") return read_obj_mesh_file(file_path);
+  if (extension == ".ply") return read_ply_mesh_file(file_path);
+  std::cerr << "Unsupported mesh file extension: " << file_path << std::endl;
+  return {};
+}
+
+bool is_stl_file_path(const std::string &file_path) { return get_lowercase_extension(file_path) == ".stl"; }
+
+bool is_mesh_file_path(const std::string &file_path) {
+  std::string extension = get_lowercase_extension(file_path);
+  return extension == ".stl" || extension == ".obj" || extension == ".ply";
+}
+
+std::vector<std::string> find_mesh_files(const std::string &directory_path) {
+  std::vector<std::string> file_paths;
+  std::error_code error_code;
+  // Unreadable subdirectories are skipped rather than failing the whole import
+  auto options = std::filesystem::directory_options::skip_permission_denied;
+  for (auto it = std::filesystem::recursive_directory_iterator(directory_path, options, error_code);
+       !error_code && it != std::filesystem::recursive_directory_iterator(); it.increment(error_code)) {
+    if (it->is_regular_file(error_code) && is_mesh_file_path(it->path().string())) {
+      file_paths.push_back(it->path().string());
+    }
+  }
+  if (error_code) {
+    std::cerr << "Failed to list directory: " << directory_path << std::endl;
+  }
+  std::sort(file_paths.begin(), file_paths.end());
+  return file_paths;
+}
+
+#ifdef GEOBOX_TEST_READ_MESH
+#include <cstdio>     // for std::remove
+#include <cstring>    // for std::memcpy
+#include <fstream>    // for std::ofstream
+#include <vector>
+
+#include "testing.hpp"
+#include "write_mesh.hpp"
+
+static std::string write_test_file(const std::string &file_name, const std::string &contents) {
+  std::string file_path = (std::filesystem::temp_directory_path() / file_name).string();
+  std::ofstream ofs(file_path, std::ofstream::binary);
+  ofs << contents;
+  return file_path;
+}
+
+// Triangles of the mesh as vertex positions, independent of vertex order
+static std::vector<glm::vec3> get_corners(const Indexed_Triangle_Mesh &mesh) {
+  std::vector<glm::vec3> corners;
+  for (unsigned int index : mesh.indices) {
+    corners.push_back(mesh.vertices[index]);
+  }
+  return corners;
+}
+
+int main() {
+  // Unit square made of a quad, with a trailing triangle using relative indices
+  std::vector<glm::vec3> expected_corners = {
+      {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 0, 0}, {1, 1, 0}, {0, 1, 0}, {1, 0, 0}, {2, 0, 0}, {1, 1, 0},
+  };
+  std::string obj_file_path = write_test_file("geobox_test.OBJ", "# comment\r\n"
+                                                                  "o square\r\n"
+                                                                  "v 0 0 0\r\n"
+                                                                  "v 1 0 0 1\r\n"
+                                                                  "v 1 1 0\r\n"
+                                                                  "v 0 1 0\r\n"
+                                                                  "vn 0 0 1\r\n"
+                                                                  "f 1/1/1 2/2/1 3//1 4\r\n"
+                                                                  "v 2 0 0\r\n"
+                                                                  "f -4 -1 -3\r\n");
+  std::optional<Indexed_Triangle_Mesh> obj_mesh = read_mesh_file(obj_file_path);
+  runtime_assert(obj_mesh.has_value() && obj_mesh->vertices.size() == 5);
+  runtime_assert(get_corners(*obj_mesh) == expected_corners);
+  std::remove(obj_file_path.c_str());
+  std::string bad_obj_file_path = write_test_file("geobox_test_bad.obj", "v 0 0 0\nf 1 2 3\n");
+  runtime_assert(!read_mesh_file(bad_obj_file_path).has_value());
+  std::remove(bad_obj_file_path.c_str());
+
+  std::string ascii_ply_file_path = write_test_file("geobox_test_ascii.ply", "ply\n"
+                                                                             "format ascii 1.0\n"
+                                                                             "comment square\n"
+                                                                             "element vertex 5\n"
+                                                                             "property float x\n"
+                                                                             "property float y\n"
+                                                                             "property uchar red\n"
+                                                                             "property float z\n"
+                                                                             "element face 2\n"
+                                                                             "property list uchar int vertex_indices\n"
+                                                                             "property list uchar float texcoord\n"
+                                                                             "end_header\n"
+                                                                             "0 0 255 0\n"
+                                                                             "1 0 255 0\n"
+                                                                             "1 1 255 0\n"
+                                                                             "0 1 255 0\n"
+                                                                             "2 0 255 0\n"
+                                                                             "4 0 1 2 3 0\n"
+                                                                             "3 1 4 2 2 0.5 0.5\n");
+  std::optional<Indexed_Triangle_Mesh> ascii_ply_mesh = read_mesh_file(ascii_ply_file_path);
+  runtime_assert(ascii_ply_mesh.has_value() && get_corners(*ascii_ply_mesh) == expected_corners);
+  std::remove(ascii_ply_file_path.c_str());
+
+  // Binary little endian files are written by the PLY writer
+  std::string binary_ply_file_path = (std::filesystem::temp_directory_path() / "geobox_test_binary.ply").string();
+  Indexed_Triangle_Mesh mesh{
+      .vertices = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 0, 0}},
+      .indices = {0, 1, 2, 0, 2, 3, 1, 4, 2},
+  };
+  runtime_assert(write_ply_file(binary_ply_file_path, mesh.vertices, mesh.indices));
+  std::optional<Indexed_Triangle_Mesh> binary_ply_mesh = read_mesh_file(binary_ply_file_path);
+  runtime_assert(binary_ply_mesh.has_value());
+  runtime_assert(binary_ply_mesh->vertices == mesh.vertices && binary_ply_mesh->indices == mesh.indices);
+  // Point clouds have no faces
+  runtime_assert(write_ply_file(binary_ply_file_path, mesh.vertices, {}));
+  binary_ply_mesh = read_mesh_file(binary_ply_file_path);
+  runtime_assert(binary_ply_mesh.has_value());
+  runtime_assert(binary_ply_mesh->vertices == mesh.vertices && binary_ply_mesh->indices.empty());
+  std::remove(binary_ply_file_path.c_str());
+
+  // Big endian with double positions and a polygon
+  std::string big_endian_ply = "ply\n"
+                               "format binary_big_endian 1.0\n"
+                               "element vertex 4\n"
+                               "property double x\n"
+                               "property double y\n"
+                               "property double z\n"
+                               "element face 1\n"
+                               "property list uchar ushort vertex_indices\n"
+                               "end_header\n";
+  auto append_big_endian = [&big_endian_ply]<typename T>(T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (size_t i = 0; i < sizeof(T); i++) {
+      big_endian_ply.push_back(bytes[sizeof(T) - 1 - i]);
+    }
+  };
+  for (size_t v = 0; v < 4; v++) {
+    for (int i = 0; i < 3; i++) {
+      append_big_endian(static_cast<double>(mesh.vertices[v][i]));
+    }
+  }
+  append_big_endian(uint8_t(4));
+  for (uint16_t index : {0, 1, 2, 3}) {
+    append_big_endian(index);
+  }
+  std::string big_endian_ply_file_path = write_test_file("geobox_test_big_endian.ply", big_endian_ply);
+  std::optional<Indexed_Triangle_Mesh> big_endian_ply_mesh = read_mesh_file(big_endian_ply_file_path);
+  runtime_assert(big_endian_ply_mesh.has_value());
+  runtime_assert(get_corners(*big_endian_ply_mesh) ==
+                 std::vector<glm::vec3>(expected_corners.begin(), expected_corners.begin() + 6));
+  std::remove(big_endian_ply_file_path.c_str());
+
+  // Lists with huge counts past the end of the data are rejected instead of allocated
+  big_endian_ply = "ply\n"
+                   "format binary_big_endian 1.0\n"
+                   "element vertex 3\n"
+                   "property float x\n"
+                   "property float y\n"
+                   "property float z\n"
+                   "element face 1\n"
+                   "property list uint int vertex_indices\n"
+                   "end_header\n";
+  for (size_t v = 0; v < 3; v++) {
+    for (int i = 0; i < 3; i++) {
+      append_big_endian(mesh.vertices[v][i]);
+    }
+  }
+  append_big_endian(uint32_t(4000000000));
+  for (int32_t index : {0, 1, 2}) {
+    append_big_endian(index);
+  }
+  std::string truncated_list_ply_file_path = write_test_file("geobox_test_truncated_list.ply", big_endian_ply);
+  runtime_assert(!read_mesh_file(truncated_list_ply_file_path).has_value());
+  std::remove(truncated_list_ply_file_path.c_str());
+  std::string ascii_truncated_list_ply = "ply\n"
+                                       "format ascii 1.0\n"
+                                       "element vertex 3\n"
+                                       "property float x\n"
+                                       "property float y\n"
+                                       "property float z\n"
+                                       "element face 1\n"
+                                       "property list uint int vertex_indices\n"
+                                       "end_header\n"
+                                       "0 0 0\n"
+                                       "1 0 0\n"
+                                       "1 1 0\n"
+                                       "4000000000 0 1 2\n";
+  truncated_list_ply_file_path = write_test_file("geobox_test_truncated_list.ply", ascii_truncated_list_ply);
+  runtime_assert(!read_mesh_file(truncated_list_ply_file_path).has_value());
+  std::remove(truncated_list_ply_file_path.c_str());
+
+  runtime_assert(!read_mesh_file("geobox_test.unknown").has_value());
+
+  // Directory import finds supported files in subdirectories and skips others
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "geobox_test_find_mesh_files";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory / "part" / ".stl");
+  for (const char *file_name : {"b.STL", "a.obj", "part/c.ply", "notes.txt", "stl"}) {
+    std::ofstream(directory / file_name) << "";
+  }
+  std::vector<std::string> mesh_file_paths = find_mesh_files(directory.string());
+  runtime_assert(mesh_file_paths.size() == 3);
+  runtime_assert(mesh_file_paths[0] == (directory / "a.obj").string());
+  runtime_assert(mesh_file_paths[1] == (directory / "b.STL").string());
+  runtime_assert(mesh_file_paths[2] == (directory / "part" / "c.ply").string());
+  runtime_assert(find_mesh_files((directory / "missing").string()).empty());
+  std::filesystem::remove_all(directory);
+  return 0;
+}
+#endif
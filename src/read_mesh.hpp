@@ -0,0 +1,21 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "indexed_triangle_mesh.hpp"
+
+// Reads .stl (welded while reading), .obj or .ply files, picked by the case insensitive file extension,
+// OBJ and PLY files are already indexed and are used as is
+[[nodiscard]] std::optional<Indexed_Triangle_Mesh> read_mesh_file(const std::string &file_path);
+
+// Whether read_mesh_file supports the file extension of the path
+[[nodiscard]] bool is_mesh_file_path(const std::string &file_path);
+
+// STL files are triangle soups that read_mesh_file welds, callers reading and welding them as separate steps use
+// STL_Triangle_Soup instead
+[[nodiscard]] bool is_stl_file_path(const std::string &file_path);
+
+// Supported mesh files in the directory and its subdirectories, sorted, so a whole assembly can be imported at once
+[[nodiscard]] std::vector<std::string> find_mesh_files(const std::string &directory_path);
@@ -0,0 +1,132 @@
+#include <climits>  // for UINT_MAX
+#include <cstdint>
+#include <iostream> // for std::cerr and std::endl
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "indexed_triangle_mesh.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "read_obj.hpp"
+#include "text_parsing.hpp"
+
+// In bytes
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 1 << 20;
+
+namespace {
+struct OBJ_Chunk {
+  std::vector<glm::vec3> vertices;
+  // Zero based, negative (relative) indices are stored relative to the first vertex of the chunk until fixed up
+  std::vector<int64_t> indices;
+  std::vector<size_t> relative_index_positions;
+};
+
+struct OBJ_Face_Corner {
+  int64_t index;
+  bool is_relative;
+};
+} // namespace
+
+// Start of the first line starting at or after offset
+[[nodiscard]] static size_t find_line_start(std::string_view text, size_t offset) {
+  if (offset == 0) return 0;
+  size_t line_break = text.find('\n', offset - 1);
+  return (line_break == std::string_view::npos) ? text.size() : line_break + 1;
+}
+
+// Parses lines starting in [begin, end), empty if any of them is malformed
+[[nodiscard]] static std::optional<OBJ_Chunk> parse_obj_chunk(std::string_view text, size_t begin, size_t end) {
+  OBJ_Chunk chunk;
+  std::vector<OBJ_Face_Corner> polygon;
+  Text_Cursor cursor{text.data() + find_line_start(text, begin), text.data() + text.size()};
+  while (cursor.current < text.data() + end) {
+    std::string_view keyword = cursor.read_token();
+    if (keyword == "v") {
+      glm::vec3 &vertex = chunk.vertices.emplace_back();
+      for (int i = 0; i < 3; i++) {
+        if (!parse_number(cursor.read_token(), vertex[i])) return {};
+      }
+    } else if (keyword == "f") {
+      polygon.clear();
+      for (std::string_view token = cursor.read_token(); !token.empty(); token = cursor.read_token()) {
+        int64_t index = 0;
+        // Only the position index of "v", "v/vt", "v//vn" and "v/vt/vn"
+        if (!parse_number(token.substr(0, token.find('/')), index) || index == 0) return {};
+        if (index > 0) {
+          polygon.push_back({.index = index - 1, .is_relative = false});
+        } else {
+          polygon.push_back({.index = static_cast<int64_t>(chunk.vertices.size()) + index, .is_relative = true});
+        }
+      }
+      if (polygon.size() < 3) return {};
+      for (size_t i = 1; i + 1 < polygon.size(); i++) {
+        for (const OBJ_Face_Corner &corner : {polygon[0], polygon[i], polygon[i + 1]}) {
+          if (corner.is_relative) chunk.relative_index_positions.push_back(chunk.indices.size());
+          chunk.indices.push_back(corner.index);
+        }
+      }
+    }
+    cursor.skip_line();
+  }
+  return chunk;
+}
+
+std::optional<Indexed_Triangle_Mesh> read_obj_mesh_file(const std::string &file_path) {
+  GEOBOX_PROFILE_SCOPE("Read OBJ");
+  std::optional<Mapped_File> mapped_file = Mapped_File::open(file_path);
+  if (!mapped_file) return {};
+  std::string_view text(reinterpret_cast<const char *>(mapped_file->get_data()), mapped_file->get_size());
+
+  size_t num_chunks = calc_num_parallel_chunks(text.size(), MIN_PARALLEL_CHUNK_SIZE);
+  std::vector<std::optional<OBJ_Chunk>> chunks(num_chunks);
+  parallel_for_chunks(text.size(), num_chunks, [&](size_t chunk_index, size_t begin, size_t end) {
+    chunks[chunk_index] = parse_obj_chunk(text, begin, end);
+  });
+
+  std::vector<size_t> vertex_offsets(num_chunks + 1, 0);
+  std::vector<size_t> index_offsets(num_chunks + 1, 0);
+  for (size_t i = 0; i < num_chunks; i++) {
+    if (!chunks[i]) {
+      std::cerr << "Malformed OBJ file: " << file_path << std::endl;
+      return {};
+    }
+    vertex_offsets[i + 1] = vertex_offsets[i] + chunks[i]->vertices.size();
+    index_offsets[i + 1] = index_offsets[i] + chunks[i]->indices.size();
+  }
+  size_t num_vertices = vertex_offsets.back();
+  if (num_vertices > UINT_MAX) {
+    std::cerr << "Too many vertices in OBJ file: " << file_path << std::endl;
+    return {};
+  }
+
+  Indexed_Triangle_Mesh mesh;
+  mesh.vertices.resize(num_vertices);
+  mesh.indices.resize(index_offsets.back());
+  std::vector<char> are_indices_valid(num_chunks, true);
+  parallel_for(0, num_chunks, 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      OBJ_Chunk &chunk = *chunks[i];
+      std::copy(chunk.vertices.begin(), chunk.vertices.end(), mesh.vertices.begin() + vertex_offsets[i]);
+      for (size_t position : chunk.relative_index_positions) {
+        chunk.indices[position] += static_cast<int64_t>(vertex_offsets[i]);
+      }
+      for (size_t k = 0; k < chunk.indices.size(); k++) {
+        int64_t index = chunk.indices[k];
+        are_indices_valid[i] = are_indices_valid[i] && (index >= 0) && (index < static_cast<int64_t>(num_vertices));
+        mesh.indices[index_offsets[i] + k] = static_cast<unsigned int>(index);
+      }
+    }
+  });
+  for (char is_valid : are_indices_valid) {
+    if (!is_valid) {
+      std::cerr << "Face refers to missing vertex in OBJ file: " << file_path << std::endl;
+      return {};
+    }
+  }
+  return mesh;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "indexed_triangle_mesh.hpp"
+
+// Vertex positions and faces of a Wavefront OBJ file, polygons are triangulated as fans and everything else (normals,
+// texture coordinates, groups, materials, ...) is ignored, vertices are used as is without welding
+[[nodiscard]] std::optional<Indexed_Triangle_Mesh> read_obj_mesh_file(const std::string &file_path);
@@ -0,0 +1,508 @@
+#include <algorithm> // for std::reverse, std::find, std::find_if and std::max
+#include <bit>       // for std::endian
+#include <climits>   // for UINT_MAX
+#include <cstdint>
+#include <cstring>   // for std::memcpy
+#include <iostream>  // for std::cerr and std::endl
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "indexed_triangle_mesh.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+#include "read_ply.hpp"
+#include "text_parsing.hpp"
+
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 65536;
+// In bytes, for finding lines of ASCII files
+constexpr size_t MIN_PARALLEL_TEXT_CHUNK_SIZE = 1 << 20;
+
+namespace {
+enum class PLY_Format { ASCII, Binary_Little_Endian, Binary_Big_Endian };
+
+enum class PLY_Type { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+struct PLY_Property {
+  std::string name;
+  PLY_Type type;
+  // Lists are a count of type list_count_type followed by that many values of type type
+  bool is_list = false;
+  PLY_Type list_count_type = PLY_Type::UInt8;
+};
+
+struct PLY_Element {
+  std::string name;
+  size_t count = 0;
+  std::vector<PLY_Property> properties;
+
+  // Index of the named property, or properties.size() if there is none
+  [[nodiscard]] size_t find_property(std::string_view property_name) const {
+    auto it = std::find_if(properties.begin(), properties.end(),
+                           [property_name](const PLY_Property &property) { return property.name == property_name; });
+    return static_cast<size_t>(it - properties.begin());
+  }
+
+  // Size of each item in bytes, empty if items have list properties and so vary in size
+  [[nodiscard]] std::optional<size_t> calc_binary_item_size() const;
+};
+
+struct PLY_Header {
+  PLY_Format format = PLY_Format::ASCII;
+  std::vector<PLY_Element> elements;
+  // Offset of the data right after "end_header"
+  size_t size = 0;
+};
+} // namespace
+
+[[nodiscard]] static std::optional<PLY_Type> parse_ply_type(std::string_view name) {
+  if (name == "char" || name == "int8") return PLY_Type::Int8;
+  if (name == "uchar" || name == "uint8") return PLY_Type::UInt8;
+  if (name == "short" || name == "int16") return PLY_Type::Int16;
+  if (name == "ushort" || name == "uint16") return PLY_Type::UInt16;
+  if (name == "int" || name == "int32") return PLY_Type::Int32;
+  if (name == "uint" || name == "uint32") return PLY_Type::UInt32;
+  if (name == "float" || name == "float32") return PLY_Type::Float32;
+  if (name == "double" || name == "float64") return PLY_Type::Float64;
+  return {};
+}
+
+[[nodiscard]] static size_t get_ply_type_size(PLY_Type type) {
+  switch (type) {
+  case PLY_Type::Int8:
+  case PLY_Type::UInt8:
+    return 1;
+  case PLY_Type::Int16:
+  case PLY_Type::UInt16:
+    return 2;
+  case PLY_Type::Int32:
+  case PLY_Type::UInt32:
+  case PLY_Type::Float32:
+    return 4;
+  case PLY_Type::Float64:
+    return 8;
+  }
+  return 0;
+}
+
+std::optional<size_t> PLY_Element::calc_binary_item_size() const {
+  size_t size = 0;
+  for (const PLY_Property &property : properties) {
+    if (property.is_list) return {};
+    size += get_ply_type_size(property.type);
+  }
+  return size;
+}
+
+// Empty if the header is malformed or uses unknown types
+[[nodiscard]] static std::optional<PLY_Header> parse_ply_header(std::string_view text) {
+  PLY_Header header;
+  Text_Cursor cursor{text.data(), text.data() + text.size()};
+  if (cursor.read_token() != "ply") return {};
+  cursor.skip_line();
+  while (!cursor.is_at_end()) {
+    std::string_view keyword = cursor.read_token();
+    if (keyword == "format") {
+      std::string_view format = cursor.read_token();
+      if (format == "ascii") {
+        header.format = PLY_Format::ASCII;
+      } else if (format == "binary_little_endian") {
+        header.format = PLY_Format::Binary_Little_Endian;
+      } else if (format == "binary_big_endian") {
+        header.format = PLY_Format::Binary_Big_Endian;
+      } else {
+        return {};
+      }
+    } else if (keyword == "element") {
+      PLY_Element &element = header.elements.emplace_back();
+      element.name = cursor.read_token();
+      if (!parse_number(cursor.read_token(), element.count)) return {};
+    } else if (keyword == "property") {
+      if (header.elements.empty()) return {};
+      PLY_Property &property = header.elements.back().properties.emplace_back();
+      std::string_view type_name = cursor.read_token();
+      if (type_name == "list") {
+        std::optional<PLY_Type> count_type = parse_ply_type(cursor.read_token());
+        if (!count_type) return {};
+        property.is_list = true;
+        property.list_count_type = *count_type;
+        type_name = cursor.read_token();
+      }
+      std::optional<PLY_Type> type = parse_ply_type(type_name);
+      if (!type) return {};
+      property.type = *type;
+      property.name = cursor.read_token();
+    } else if (keyword == "end_header") {
+      cursor.skip_line();
+      header.size = static_cast<size_t>(cursor.current - text.data());
+      return header;
+    }
+    // "comment" and "obj_info" lines are ignored
+    cursor.skip_line();
+  }
+  return {};
+}
+
+// Reads a binary scalar of the given type, byte order of the file is swapped when it differs from the native one
+[[nodiscard]] static double read_binary_ply_scalar(const std::byte *data, PLY_Type type, bool is_swapped) {
+  std::byte bytes[8];
+  size_t size = get_ply_type_size(type);
+  std::memcpy(bytes, data, size);
+  if (is_swapped) std::reverse(bytes, bytes + size);
+  auto load = [&bytes]<typename T>(T) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return static_cast<double>(value);
+  };
+  switch (type) {
+  case PLY_Type::Int8:
+    return load(int8_t());
+  case PLY_Type::UInt8:
+    return load(uint8_t());
+  case PLY_Type::Int16:
+    return load(int16_t());
+  case PLY_Type::UInt16:
+    return load(uint16_t());
+  case PLY_Type::Int32:
+    return load(int32_t());
+  case PLY_Type::UInt32:
+    return load(uint32_t());
+  case PLY_Type::Float32:
+    return load(float());
+  case PLY_Type::Float64:
+    return load(double());
+  }
+  return 0.0;
+}
+
+namespace {
+// Positions of x, y and z properties of the vertex element, and the vertex indices list of the face element
+struct PLY_Layout {
+  size_t vertex_element;
+  size_t position_properties[3];
+  std::optional<size_t> face_element;
+  size_t vertex_indices_property = 0;
+};
+} // namespace
+
+[[nodiscard]] static std::optional<PLY_Layout> find_ply_layout(const PLY_Header &header) {
+  PLY_Layout layout{};
+  auto find_element = [&header](std::string_view name) {
+    auto it = std::find_if(header.elements.begin(), header.elements.end(),
+                           [name](const PLY_Element &element) { return element.name == name; });
+    return static_cast<size_t>(it - header.elements.begin());
+  };
+  layout.vertex_element = find_element("vertex");
+  if (layout.vertex_element == header.elements.size()) return {};
+  const PLY_Element &vertex_element = header.elements[layout.vertex_element];
+  const char *position_names[3] = {"x", "y", "z"};
+  for (int i = 0; i < 3; i++) {
+    layout.position_properties[i] = vertex_element.find_property(position_names[i]);
+    if (layout.position_properties[i] == vertex_element.properties.size()) return {};
+    if (vertex_element.properties[layout.position_properties[i]].is_list) return {};
+  }
+  if (size_t face_element = find_element("face"); face_element != header.elements.size()) {
+    const PLY_Element &element = header.elements[face_element];
+    size_t property = element.find_property("vertex_indices");
+    if (property == element.properties.size()) property = element.find_property("vertex_index");
+    if (property == element.properties.size() || !element.properties[property].is_list) return {};
+    layout.face_element = face_element;
+    layout.vertex_indices_property = property;
+  }
+  return layout;
+}
+
+// Appends fan triangulation of a polygon, false if it has fewer than 3 vertices or refers to missing vertices
+[[nodiscard]] static bool append_ply_polygon(const std::vector<int64_t> &polygon, size_t num_vertices,
+                                             std::vector<unsigned int> &indices) {
+  if (polygon.size() < 3) return false;
+  for (int64_t index : polygon) {
+    if (index < 0 || index >= static_cast<int64_t>(num_vertices)) return false;
+  }
+  for (size_t i = 1; i + 1 < polygon.size(); i++) {
+    indices.push_back(static_cast<unsigned int>(polygon[0]));
+    indices.push_back(static_cast<unsigned int>(polygon[i]));
+    indices.push_back(static_cast<unsigned int>(polygon[i + 1]));
+  }
+  return true;
+}
+
+namespace {
+// Binary data with bounds checked reads
+struct Binary_Cursor {
+  const std::byte *current;
+  const std::byte *end;
+  bool is_swapped;
+
+  [[nodiscard]] bool read(PLY_Type type, double &value) {
+    size_t size = get_ply_type_size(type);
+    if (static_cast<size_t>(end - current) < size) return false;
+    value = read_binary_ply_scalar(current, type, is_swapped);
+    current += size;
+    return true;
+  }
+
+  [[nodiscard]] size_t get_remaining_size() const { return static_cast<size_t>(end - current); }
+
+  [[nodiscard]] bool skip(size_t size) {
+    if (get_remaining_size() < size) return false;
+    current += size;
+    return true;
+  }
+};
+} // namespace
+
+// Walks one item, reading a list property into list when list_property is the index of one
+[[nodiscard]] static bool read_binary_ply_item(Binary_Cursor &cursor, const PLY_Element &element,
+                                               size_t list_property, std::vector<int64_t> &list) {
+  for (size_t p = 0; p < element.properties.size(); p++) {
+    const PLY_Property &property = element.properties[p];
+    if (!property.is_list) {
+      if (!cursor.skip(get_ply_type_size(property.type))) return false;
+      continue;
+    }
+    double count = 0.0;
+    if (!cursor.read(property.list_count_type, count) || count < 0.0) return false;
+    // Count comes from the file, lists longer than the data left are rejected before allocating anything
+    size_t value_size = get_ply_type_size(property.type);
+    if (count > static_cast<double>(cursor.get_remaining_size() / value_size)) return false;
+    if (p != list_property) {
+      if (!cursor.skip(static_cast<size_t>(count) * value_size)) return false;
+      continue;
+    }
+    list.resize(static_cast<size_t>(count));
+    for (int64_t &value : list) {
+      double number = 0.0;
+      if (!cursor.read(property.type, number)) return false;
+      value = static_cast<int64_t>(number);
+    }
+  }
+  return true;
+}
+
+// Triangle faces of the common "list uchar int vertex_indices" kind have a fixed size and are read in parallel,
+// empty if the element is not laid out that way or any face is not a triangle
+[[nodiscard]] static std::optional<std::vector<unsigned int>>
+read_binary_ply_triangles(Binary_Cursor cursor, const PLY_Element &element, size_t num_vertices) {
+  if (element.properties.size() != 1) return {};
+  const PLY_Property &property = element.properties[0];
+  size_t count_size = get_ply_type_size(property.list_count_type);
+  size_t index_size = get_ply_type_size(property.type);
+  size_t record_size = count_size + 3 * index_size;
+  if (static_cast<size_t>(cursor.end - cursor.current) / record_size < element.count) return {};
+
+  std::vector<unsigned int> indices(element.count * 3);
+  size_t num_chunks = calc_num_parallel_chunks(element.count, MIN_PARALLEL_CHUNK_SIZE);
+  std::vector<char> are_chunks_valid(num_chunks, true);
+  parallel_for_chunks(element.count, num_chunks, [&](size_t chunk_index, size_t begin, size_t end) {
+    bool is_valid = true;
+    for (size_t f = begin; f < end; f++) {
+      const std::byte *record = cursor.current + f * record_size;
+      is_valid = is_valid && read_binary_ply_scalar(record, property.list_count_type, cursor.is_swapped) == 3.0;
+      for (size_t k = 0; k < 3; k++) {
+        double index = read_binary_ply_scalar(record + count_size + k * index_size, property.type, cursor.is_swapped);
+        is_valid = is_valid && index >= 0.0 && index < static_cast<double>(num_vertices);
+        indices[f * 3 + k] = static_cast<unsigned int>(index);
+      }
+    }
+    are_chunks_valid[chunk_index] = is_valid;
+  });
+  for (char is_valid : are_chunks_valid) {
+    if (!is_valid) return {};
+  }
+  return indices;
+}
+
+[[nodiscard]] static bool read_binary_ply_data(std::string_view data, const PLY_Header &header,
+                                               const PLY_Layout &layout, Indexed_Triangle_Mesh &mesh) {
+  bool is_big_endian = (header.format == PLY_Format::Binary_Big_Endian);
+  Binary_Cursor cursor{
+      .current = reinterpret_cast<const std::byte *>(data.data()),
+      .end = reinterpret_cast<const std::byte *>(data.data() + data.size()),
+      .is_swapped = is_big_endian != (std::endian::native == std::endian::big),
+  };
+  std::vector<int64_t> polygon;
+  for (size_t e = 0; e < header.elements.size(); e++) {
+    const PLY_Element &element = header.elements[e];
+    std::optional<size_t> item_size = element.calc_binary_item_size();
+    if (e == layout.vertex_element) {
+      // Vertices with list properties are not supported
+      if (!item_size || static_cast<size_t>(cursor.end - cursor.current) / std::max(*item_size, size_t(1)) <
+                            element.count) {
+        return false;
+      }
+      size_t property_offsets[3] = {};
+      for (int i = 0; i < 3; i++) {
+        for (size_t p = 0; p < layout.position_properties[i]; p++) {
+          property_offsets[i] += get_ply_type_size(element.properties[p].type);
+        }
+      }
+      mesh.vertices.resize(element.count);
+      parallel_for(0, element.count, MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+          const std::byte *record = cursor.current + v * *item_size;
+          for (int i = 0; i < 3; i++) {
+            PLY_Type type = element.properties[layout.position_properties[i]].type;
+            mesh.vertices[v][i] = static_cast<float>(read_binary_ply_scalar(record + property_offsets[i], type,
+                                                                            cursor.is_swapped));
+          }
+        }
+      });
+      cursor.current += element.count * *item_size;
+    } else if (e == layout.face_element) {
+      if (std::optional<std::vector<unsigned int>> triangles =
+              read_binary_ply_triangles(cursor, element, mesh.vertices.size())) {
+        mesh.indices = std::move(*triangles);
+        cursor.current += element.count * (get_ply_type_size(element.properties[0].list_count_type) +
+                                           3 * get_ply_type_size(element.properties[0].type));
+        continue;
+      }
+      // Polygons, or faces with other properties
+      mesh.indices.clear();
+      for (size_t f = 0; f < element.count; f++) {
+        if (!read_binary_ply_item(cursor, element, layout.vertex_indices_property, polygon) ||
+            !append_ply_polygon(polygon, mesh.vertices.size(), mesh.indices)) {
+          return false;
+        }
+      }
+    } else if (item_size) {
+      if (cursor.get_remaining_size() / std::max(*item_size, size_t(1)) < element.count) return false;
+      cursor.current += element.count * *item_size;
+    } else {
+      for (size_t i = 0; i < element.count; i++) {
+        if (!read_binary_ply_item(cursor, element, element.properties.size(), polygon)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Starts of the non-blank lines of text, found in parallel
+[[nodiscard]] static std::vector<size_t> find_ply_lines(std::string_view text) {
+  size_t num_chunks = calc_num_parallel_chunks(text.size(), MIN_PARALLEL_TEXT_CHUNK_SIZE);
+  std::vector<std::vector<size_t>> chunk_lines(num_chunks);
+  parallel_for_chunks(text.size(), num_chunks, [&](size_t chunk_index, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (i != 0 && text[i - 1] != '\n') continue;
+      size_t line_end = text.find('\n', i);
+      if (line_end == std::string_view::npos) line_end = text.size();
+      std::string_view line = text.substr(i, line_end - i);
+      if (std::find_if(line.begin(), line.end(), [](char c) { return !is_whitespace(c); }) != line.end()) {
+        chunk_lines[chunk_index].push_back(i);
+      }
+      i = line_end; // Loop increment moves past the line break
+    }
+  });
+  return concatenate_chunks(chunk_lines);
+}
+
+// Items of ASCII files are one per line
+[[nodiscard]] static bool read_ascii_ply_data(std::string_view text, const PLY_Header &header,
+                                              const PLY_Layout &layout, Indexed_Triangle_Mesh &mesh) {
+  std::vector<size_t> lines = find_ply_lines(text);
+  size_t first_line = 0;
+  for (size_t e = 0; e < header.elements.size(); e++) {
+    const PLY_Element &element = header.elements[e];
+    if (lines.size() - first_line < element.count) return false;
+    // Reads the values of item i, list values are read into list when list_property is the index of one
+    auto read_item = [&](size_t i, std::vector<double> &values, size_t list_property, std::vector<int64_t> &list) {
+      size_t line_begin = lines[first_line + i];
+      Text_Cursor cursor{text.data() + line_begin, text.data() + text.size()};
+      const char *line_end = std::find(cursor.current, cursor.end, '\n');
+      for (size_t p = 0; p < element.properties.size(); p++) {
+        const PLY_Property &property = element.properties[p];
+        size_t count = 1;
+        if (property.is_list && !parse_number(cursor.read_token(), count)) return false;
+        // Count comes from the file, each value takes at least a digit and a separator of what is left of the line
+        if (count > static_cast<size_t>(line_end - cursor.current)) return false;
+        if (p == list_property) list.resize(count);
+        for (size_t k = 0; k < count; k++) {
+          double value = 0.0;
+          if (!parse_number(cursor.read_token(), value)) return false;
+          if (p == list_property) {
+            list[k] = static_cast<int64_t>(value);
+          } else if (!property.is_list) {
+            values[p] = value;
+          }
+        }
+      }
+      return true;
+    };
+
+    if (e == layout.vertex_element) {
+      mesh.vertices.resize(element.count);
+      size_t num_chunks = calc_num_parallel_chunks(element.count, MIN_PARALLEL_CHUNK_SIZE);
+      std::vector<char> are_chunks_valid(num_chunks, true);
+      parallel_for_chunks(element.count, num_chunks, [&](size_t chunk_index, size_t begin, size_t end) {
+        std::vector<double> values(element.properties.size());
+        std::vector<int64_t> list;
+        for (size_t v = begin; v < end && are_chunks_valid[chunk_index]; v++) {
+          are_chunks_valid[chunk_index] = read_item(v, values, element.properties.size(), list);
+          for (int i = 0; i < 3; i++) {
+            mesh.vertices[v][i] = static_cast<float>(values[layout.position_properties[i]]);
+          }
+        }
+      });
+      if (std::find(are_chunks_valid.begin(), are_chunks_valid.end(), false) != are_chunks_valid.end()) return false;
+    } else if (e == layout.face_element) {
+      size_t num_chunks = calc_num_parallel_chunks(element.count, MIN_PARALLEL_CHUNK_SIZE);
+      std::vector<std::vector<unsigned int>> chunk_indices(num_chunks);
+      std::vector<char> are_chunks_valid(num_chunks, true);
+      parallel_for_chunks(element.count, num_chunks, [&](size_t chunk_index, size_t begin, size_t end) {
+        std::vector<double> values(element.properties.size());
+        std::vector<int64_t> polygon;
+        for (size_t f = begin; f < end && are_chunks_valid[chunk_index]; f++) {
+          are_chunks_valid[chunk_index] =
+              read_item(f, values, layout.vertex_indices_property, polygon) &&
+              append_ply_polygon(polygon, mesh.vertices.size(), chunk_indices[chunk_index]);
+        }
+      });
+      if (std::find(are_chunks_valid.begin(), are_chunks_valid.end(), false) != are_chunks_valid.end()) return false;
+      mesh.indices = concatenate_chunks(chunk_indices);
+    }
+    first_line += element.count;
+  }
+  return true;
+}
+
+std::optional<Indexed_Triangle_Mesh> read_ply_mesh_file(const std::string &file_path) {
+  GEOBOX_PROFILE_SCOPE("Read PLY");
+  std::optional<Mapped_File> mapped_file = Mapped_File::open(file_path);
+  if (!mapped_file) return {};
+  std::string_view text(reinterpret_cast<const char *>(mapped_file->get_data()), mapped_file->get_size());
+
+  std::optional<PLY_Header> header = parse_ply_header(text);
+  if (!header) {
+    std::cerr << "Malformed PLY header: " << file_path << std::endl;
+    return {};
+  }
+  std::optional<PLY_Layout> layout = find_ply_layout(*header);
+  if (!layout) {
+    std::cerr << "PLY file has no vertex positions or no face vertex indices: " << file_path << std::endl;
+    return {};
+  }
+  const PLY_Element &vertex_element = header->elements[layout->vertex_element];
+  if (vertex_element.count > UINT_MAX) {
+    std::cerr << "Too many vertices in PLY file: " << file_path << std::endl;
+    return {};
+  }
+  // Faces refer to vertices, so vertices must come first
+  if (layout->face_element && *layout->face_element < layout->vertex_element) {
+    std::cerr << "PLY file has faces before vertices: " << file_path << std::endl;
+    return {};
+  }
+
+  Indexed_Triangle_Mesh mesh;
+  std::string_view data = text.substr(header->size);
+  bool is_read = (header->format == PLY_Format::ASCII) ? read_ascii_ply_data(data, *header, *layout, mesh)
+                                                        : read_binary_ply_data(data, *header, *layout, mesh);
+  if (!is_read) {
+    std::cerr << "Malformed PLY file: " << file_path << std::endl;
+    return {};
+  }
+  return mesh;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "indexed_triangle_mesh.hpp"
+
+// Vertex positions and faces of an ASCII or binary (little or big endian) PLY file, polygons are triangulated as fans
+// and other properties and elements are ignored, a file with no faces (a point cloud) gives a mesh with no indices
+[[nodiscard]] std::optional<Indexed_Triangle_Mesh> read_ply_mesh_file(const std::string &file_path);
@@ -1,79 +1,322 @@
-#include <fstream>  // for std::ifstream
-#include <iostream> // for std::cerr, std::endl, etc...
+#include <algorithm> // for std::min
+#include <bit>       // for std::endian
+#include <cstring>   // for std::memcpy
+#include <iostream>  // for std::cerr, std::endl, etc...
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "mapped_file.hpp"
+#include "parallel.hpp"
 #include "primitives.hpp"
+#include "profiler.hpp"
+#include "read_stl.hpp"
+#include "scratch_arena.hpp"
+#include "text_parsing.hpp"
+#include "vertex_welder.hpp"
 
 constexpr size_t BINARY_STL_HEADER_SIZE = 80;
+// Normal, 3 vertices and "attribute byte count"
+constexpr size_t BINARY_STL_TRIANGLE_RECORD_SIZE = sizeof(float[4][3]) + sizeof(uint16_t);
+constexpr size_t BINARY_STL_TRIANGLES_OFFSET = BINARY_STL_HEADER_SIZE + sizeof(uint32_t);
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 65536;
+// In bytes, a facet takes roughly 250 bytes of text
+constexpr size_t MIN_ASCII_PARALLEL_CHUNK_SIZE = 1 << 20;
+// In bytes, bounds the triangles parsed but not yet consumed when streaming
+constexpr size_t ASCII_STL_WINDOW_SIZE = 16 << 20;
+// In triangles, records of a block are dropped from memory once welded
+constexpr size_t BINARY_STL_STREAMING_BLOCK_SIZE = 1 << 16;
+
+// Vertices of a record are copied as is, which needs them to match the layout of Triangle
+static_assert(std::endian::native == std::endian::little, "Binary STL files are little endian");
+static_assert(sizeof(Triangle) == sizeof(float[3][3]));
 
 static size_t calc_expected_binary_stl_mesh_file_size(uint32_t num_triangles) {
-  return BINARY_STL_HEADER_SIZE + sizeof(uint32_t) + num_triangles * (sizeof(float[4][3]) + sizeof(uint16_t));
+  return BINARY_STL_TRIANGLES_OFFSET + num_triangles * BINARY_STL_TRIANGLE_RECORD_SIZE;
 }
 
-static std::vector<Triangle> read_stl_mesh_file_binary(std::ifstream &ifs, uint32_t num_triangles) {
-  std::vector<Triangle> triangles;
-  for (uint32_t i = 0; i < num_triangles; i++) {
-    ifs.seekg(sizeof(glm::vec3), std::ifstream::cur); // Skip normals
-    // Yes we can do the reading differently but this way is nice and explicit for now
-    Triangle &t = triangles.emplace_back();
-    ifs.read((char*)&t, sizeof(Triangle));
-    // Skip "attribute byte count"
-    ifs.seekg(sizeof(uint16_t), std::ifstream::cur);
+// Empty if file is not a binary STL file, which is then assumed to be an ASCII one
+static std::optional<uint32_t> read_binary_stl_num_triangles(const Mapped_File &mapped_file) {
+  if (mapped_file.get_size() < BINARY_STL_TRIANGLES_OFFSET) return {};
+  uint32_t num_triangles = 0;
+  std::memcpy(&num_triangles, mapped_file.get_data() + BINARY_STL_HEADER_SIZE, sizeof(uint32_t));
+  if (mapped_file.get_size() != calc_expected_binary_stl_mesh_file_size(num_triangles)) return {};
+  return num_triangles;
+}
+
+std::optional<Binary_STL_View> Binary_STL_View::open(const std::string &file_path) {
+  std::optional<Mapped_File> mapped_file = Mapped_File::open(file_path);
+  if (!mapped_file) return {};
+  std::optional<Binary_STL_View> view = from_mapped_file(std::move(*mapped_file));
+  if (!view) {
+    std::cerr << "Not a binary STL file: " << file_path << std::endl;
   }
-  return triangles;
+  return view;
+}
+
+std::optional<Binary_STL_View> Binary_STL_View::from_mapped_file(Mapped_File &&mapped_file) {
+  std::optional<uint32_t> num_triangles = read_binary_stl_num_triangles(mapped_file);
+  if (!num_triangles) return {};
+  return Binary_STL_View(std::move(mapped_file), *num_triangles);
+}
+
+Triangle Binary_STL_View::get_triangle(size_t i) const {
+  Triangle t;
+  // Records are 50 bytes long, so vertices are not aligned, memcpy instead of casting
+  const std::byte *record =
+      m_mapped_file.get_data() + BINARY_STL_TRIANGLES_OFFSET + i * BINARY_STL_TRIANGLE_RECORD_SIZE;
+  std::memcpy(&t, record + sizeof(glm::vec3), sizeof(Triangle)); // Skip normal
+  return t;
+}
+
+void Binary_STL_View::discard_triangles(size_t begin, size_t end) const {
+  m_mapped_file.discard(BINARY_STL_TRIANGLES_OFFSET + begin * BINARY_STL_TRIANGLE_RECORD_SIZE,
+                        (end - begin) * BINARY_STL_TRIANGLE_RECORD_SIZE);
+}
+
+void Binary_STL_View::copy_triangles(size_t begin, size_t end, Triangle *out) const {
+  parallel_for(begin, end, MIN_PARALLEL_CHUNK_SIZE, [&](size_t chunk_begin, size_t chunk_end) {
+    for (size_t i = chunk_begin; i < chunk_end; i++) {
+      out[i - begin] = get_triangle(i);
+    }
+  });
 }
 
-static std::vector<Triangle> read_stl_mesh_file_ascii(std::ifstream &ifs) {
+// Offset of the first "facet" keyword at or after offset, "endfacet" and words merely containing "facet" are skipped
+[[nodiscard]] static size_t find_ascii_stl_facet(std::string_view text, size_t offset) {
+  constexpr std::string_view FACET_KEYWORD = "facet";
+  for (size_t i = text.find(FACET_KEYWORD, offset); i != std::string_view::npos; i = text.find(FACET_KEYWORD, i + 1)) {
+    size_t keyword_end = i + FACET_KEYWORD.size();
+    bool starts_token = (i == 0) || is_whitespace(text[i - 1]);
+    bool ends_token = (keyword_end == text.size()) || is_whitespace(text[keyword_end]);
+    if (starts_token && ends_token) return i;
+  }
+  return std::string_view::npos;
+}
+
+// Parses facets whose "facet" keyword starts in [begin, end), empty if any of them is malformed
+[[nodiscard]] static std::optional<std::vector<Triangle>> parse_ascii_stl_chunk(std::string_view text, size_t begin,
+                                                                               size_t end) {
   std::vector<Triangle> triangles;
-  std::string token;
-  while (ifs.good()) {
-    ifs >> token;
-    if (token == "facet") {
-      ifs >> token;                   // expecting "normal"
-      ifs >> token >> token >> token; // Skip x, y and z of normal vector
-      ifs >> token;                   // expecting "outer"
-      ifs >> token;                   // expecting "loop"
-      Triangle &t = triangles.emplace_back();
-      for (int i = 0; i < 3; i++) {
-        glm::vec3 &vertex = t[i];
-        ifs >> token; // expecting "vertex"
-        ifs >> vertex.x >> vertex.y >> vertex.z;
+  // Reading may go past the end of the chunk to finish a facet
+  Text_Cursor cursor{text.data(), text.data() + text.size()};
+  for (size_t offset = find_ascii_stl_facet(text, begin); offset < end;
+       offset = find_ascii_stl_facet(text, static_cast<size_t>(cursor.current - text.data()))) {
+    cursor.current = text.data() + offset;
+    glm::vec3 normal; // Ignored, recalculated from vertices
+    if (!cursor.expect("facet") || !cursor.expect("normal") || !cursor.read_number(normal.x) ||
+        !cursor.read_number(normal.y) || !cursor.read_number(normal.z) || !cursor.expect("outer") ||
+        !cursor.expect("loop")) {
+      return {};
+    }
+    Triangle &t = triangles.emplace_back();
+    for (int i = 0; i < 3; i++) {
+      glm::vec3 &vertex = t[i];
+      if (!cursor.expect("vertex") || !cursor.read_number(vertex.x) || !cursor.read_number(vertex.y) ||
+          !cursor.read_number(vertex.z)) {
+        return {};
       }
-      ifs >> token; // expecting "endloop"
-      ifs >> token; // expecting "endfacet"
     }
+    if (!cursor.expect("endloop") || !cursor.expect("endfacet")) return {};
   }
   return triangles;
 }
 
+// Calls callback(block) with consecutive blocks of triangles in file order, false if the file is malformed,
+// file is parsed one window at a time, so only the triangles of a window are held in memory at once,
+// windows are split into chunks parsed in parallel, each facet is parsed by the chunk its "facet" keyword starts in
+template <typename Callback_Type>
+[[nodiscard]] static bool foreach_ascii_stl_triangle_block(const Mapped_File &mapped_file,
+                                                           const Callback_Type &callback) {
+  std::string_view text(reinterpret_cast<const char *>(mapped_file.get_data()), mapped_file.get_size());
+  for (size_t window_begin = 0; window_begin < text.size(); window_begin += ASCII_STL_WINDOW_SIZE) {
+    size_t window_size = std::min(ASCII_STL_WINDOW_SIZE, text.size() - window_begin);
+    size_t num_chunks = calc_num_parallel_chunks(window_size, MIN_ASCII_PARALLEL_CHUNK_SIZE);
+    std::vector<std::optional<std::vector<Triangle>>> chunk_triangles(num_chunks);
+    parallel_for_chunks(window_size, num_chunks, [&](size_t chunk_index, size_t begin, size_t end) {
+      chunk_triangles[chunk_index] = parse_ascii_stl_chunk(text, window_begin + begin, window_begin + end);
+    });
+    for (const std::optional<std::vector<Triangle>> &triangles : chunk_triangles) {
+      if (!triangles) return false;
+      callback(*triangles);
+    }
+    mapped_file.discard(window_begin, window_size);
+  }
+  return true;
+}
+
+// Empty if file can not be mapped or is empty
+[[nodiscard]] static std::optional<Mapped_File> open_stl_mesh_file(const std::string &file_path) {
+  std::optional<Mapped_File> mapped_file = Mapped_File::open(file_path);
+  if (mapped_file && mapped_file->get_size() == 0) {
+    std::cerr << "Empty file: " << file_path << std::endl;
+    return {};
+  }
+  return mapped_file;
+}
+
 std::optional<std::vector<Triangle>> read_stl_mesh_file(const std::string &file_path) {
-  std::ifstream ifs(file_path, std::ifstream::ate | std::ifstream::binary);
-  if (!ifs.is_open()) {
-    std::cerr << "Failed to open file: " << file_path << std::endl;
+  GEOBOX_PROFILE_SCOPE("Read STL");
+  std::optional<Mapped_File> mapped_file = open_stl_mesh_file(file_path);
+  if (!mapped_file) return {};
+
+  // Assume file is binary at first, a size matching the triangle count is a strong enough hint
+  if (std::optional<Binary_STL_View> view = Binary_STL_View::from_mapped_file(std::move(*mapped_file))) {
+    std::vector<Triangle> triangles(view->get_num_triangles());
+    view->copy_triangles(0, view->get_num_triangles(), triangles.data());
+    return triangles;
+  }
+
+  std::vector<Triangle> triangles;
+  if (!foreach_ascii_stl_triangle_block(*mapped_file, [&triangles](const std::vector<Triangle> &block) {
+        triangles.insert(triangles.end(), block.begin(), block.end());
+      })) {
+    std::cerr << "Malformed ASCII STL file: " << file_path << std::endl;
     return {};
   }
+  return triangles;
+}
 
-  auto file_end = ifs.tellg(); // file is already at end if it was opened in "ate" mode
-  ifs.seekg(0, std::ifstream::beg);
-  auto file_beg = ifs.tellg();
-  auto file_size = file_end - file_beg;
+std::optional<STL_Triangle_Soup> STL_Triangle_Soup::read(const std::string &file_path) {
+  GEOBOX_PROFILE_SCOPE("Read STL triangle soup");
+  std::optional<Mapped_File> mapped_file = open_stl_mesh_file(file_path);
+  if (!mapped_file) return {};
 
-  if (file_size == 0) {
-    std::cerr << "Empty file: " << file_path << std::endl;
+  STL_Triangle_Soup soup;
+  soup.m_binary_view = Binary_STL_View::from_mapped_file(std::move(*mapped_file));
+  if (!soup.m_binary_view &&
+      !foreach_ascii_stl_triangle_block(*mapped_file, [&soup](const std::vector<Triangle> &block) {
+        soup.m_triangles.insert(soup.m_triangles.end(), block.begin(), block.end());
+      })) {
+    std::cerr << "Malformed ASCII STL file: " << file_path << std::endl;
     return {};
   }
-  // Assume file is binary at first and skip binary header
-  ifs.seekg(BINARY_STL_HEADER_SIZE, std::ifstream::beg);
+  return soup;
+}
 
-  uint32_t num_triangles = 0;
-  ifs.read((char *)&num_triangles, sizeof(uint32_t));
+size_t STL_Triangle_Soup::get_num_triangles() const {
+  return m_binary_view ? m_binary_view->get_num_triangles() : m_triangles.size();
+}
 
-  if (file_size == calc_expected_binary_stl_mesh_file_size(num_triangles)) {
-    return read_stl_mesh_file_binary(ifs, num_triangles);
+Indexed_Triangle_Mesh STL_Triangle_Soup::weld() const {
+  GEOBOX_PROFILE_SCOPE("Weld STL triangle soup");
+  Scratch_Scope scratch;
+  Vertex_Welder welder(DEFAULT_WELD_RANGE, scratch.get_resource());
+  welder.reserve(get_num_triangles());
+  if (m_binary_view) {
+    for (size_t begin = 0; begin < m_binary_view->get_num_triangles(); begin += BINARY_STL_STREAMING_BLOCK_SIZE) {
+      size_t end = std::min(begin + BINARY_STL_STREAMING_BLOCK_SIZE, m_binary_view->get_num_triangles());
+      for (size_t i = begin; i < end; i++) {
+        welder.add_triangle(m_binary_view->get_triangle(i));
+      }
+      m_binary_view->discard_triangles(begin, end);
+    }
   } else {
-    ifs.seekg(0, std::ifstream::beg);
-    return read_stl_mesh_file_ascii(ifs);
+    for (const Triangle &triangle : m_triangles) {
+      welder.add_triangle(triangle);
+    }
   }
+  return welder.finish();
+}
+
+std::optional<Indexed_Triangle_Mesh> read_stl_mesh_file_welded(const std::string &file_path) {
+  std::optional<STL_Triangle_Soup> soup = STL_Triangle_Soup::read(file_path);
+  if (!soup) return {};
+  return soup->weld();
+}
+
+#ifdef GEOBOX_TEST_READ_STL
+#include <cstdio>     // for std::remove
+#include <filesystem> // for std::filesystem::temp_directory_path
+#include <fstream>    // for std::ofstream
+
+#include "testing.hpp"
+
+int main() {
+  std::vector<Triangle> triangles = {
+      {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}},
+      {{0, 0, 0}, {0, 1, 0}, {0, 0, 1.5f}},
+      {{-1, -2, -3}, {4, 5, 6}, {7, 8, 9}},
+  };
+
+  std::string binary_file_path = (std::filesystem::temp_directory_path() / "geobox_test_binary.stl").string();
+  {
+    std::ofstream ofs(binary_file_path, std::ofstream::binary);
+    char header[BINARY_STL_HEADER_SIZE] = "solid but actually binary";
+    ofs.write(header, BINARY_STL_HEADER_SIZE);
+    auto num_triangles = static_cast<uint32_t>(triangles.size());
+    ofs.write((const char *)&num_triangles, sizeof(uint32_t));
+    for (const Triangle &t : triangles) {
+      glm::vec3 normal(0.0f);
+      uint16_t attribute_byte_count = 0;
+      ofs.write((const char *)&normal, sizeof(glm::vec3));
+      ofs.write((const char *)&t, sizeof(Triangle));
+      ofs.write((const char *)&attribute_byte_count, sizeof(uint16_t));
+    }
+  }
+  std::optional<std::vector<Triangle>> binary_triangles = read_stl_mesh_file(binary_file_path);
+  runtime_assert(binary_triangles.has_value() && binary_triangles->size() == triangles.size());
+  std::optional<Binary_STL_View> view = Binary_STL_View::open(binary_file_path);
+  runtime_assert(view.has_value() && view->get_num_triangles() == triangles.size());
+  for (size_t i = 0; i < triangles.size(); i++) {
+    for (int k = 0; k < 3; k++) {
+      runtime_assert((*binary_triangles)[i][k] == triangles[i][k]);
+      runtime_assert(view->get_triangle(i)[k] == triangles[i][k]);
+    }
+  }
+  // Streaming welded read shares the vertices of both triangles at the origin and at (0, 1, 0)
+  std::optional<Indexed_Triangle_Mesh> welded = read_stl_mesh_file_welded(binary_file_path);
+  runtime_assert(welded.has_value() && welded->vertices.size() == 7 && welded->indices.size() == 9);
+  runtime_assert(welded->indices[3] == welded->indices[0] && welded->indices[4] == welded->indices[2]);
+  std::remove(binary_file_path.c_str());
+
+  std::string ascii_file_path = (std::filesystem::temp_directory_path() / "geobox_test_ascii.stl").string();
+  {
+    std::ofstream ofs(ascii_file_path);
+    ofs << "solid test\n";
+    for (const Triangle &t : triangles) {
+      ofs << "facet normal 0 0 0\nouter loop\n";
+      for (int k = 0; k < 3; k++) {
+        ofs << "vertex " << t[k].x << " " << t[k].y << " " << t[k].z << "\n";
+      }
+      ofs << "endloop\nendfacet\n";
+    }
+    ofs << "endsolid test\n";
+  }
+  std::optional<std::vector<Triangle>> ascii_triangles = read_stl_mesh_file(ascii_file_path);
+  runtime_assert(ascii_triangles.has_value() && ascii_triangles->size() == triangles.size());
+  std::optional<STL_Triangle_Soup> ascii_soup = STL_Triangle_Soup::read(ascii_file_path);
+  runtime_assert(ascii_soup.has_value() && ascii_soup->get_num_triangles() == triangles.size());
+  runtime_assert(ascii_soup->weld().vertices.size() == 7);
+  for (size_t i = 0; i < triangles.size(); i++) {
+    for (int k = 0; k < 3; k++) {
+      runtime_assert((*ascii_triangles)[i][k] == triangles[i][k]);
+    }
+  }
+  // Any split into chunks parses every facet exactly once
+  std::string ascii_text = "solid facets\n  facet normal 0 0 1\n    outer loop\n      vertex +1.5e+00 0 0\n"
+                           "      vertex 0 1 0\n      vertex 0 0 -2E-1\n    endloop\n  endfacet\nendsolid facets\n"
+                           "solid more\r\nfacet normal 0 0 0\r\nouter loop\r\nvertex 1 2 3\r\nvertex 4 5 6\r\n"
+                           "vertex 7 8 9\r\nendloop\r\nendfacet\r\nendsolid more\r\n";
+  for (size_t split = 0; split <= ascii_text.size(); split++) {
+    std::optional<std::vector<Triangle>> first = parse_ascii_stl_chunk(ascii_text, 0, split);
+    std::optional<std::vector<Triangle>> second = parse_ascii_stl_chunk(ascii_text, split, ascii_text.size());
+    runtime_assert(first.has_value() && second.has_value() && first->size() + second->size() == 2);
+    first->insert(first->end(), second->begin(), second->end());
+    runtime_assert((*first)[0][0] == glm::vec3(1.5f, 0, 0) && (*first)[0][2] == glm::vec3(0, 0, -0.2f));
+    runtime_assert((*first)[1][2] == glm::vec3(7, 8, 9));
+  }
+  runtime_assert(!parse_ascii_stl_chunk("facet normal 0 0 1 outer loop vertex 0 0 x", 0, 1).has_value());
+
+  std::optional<Indexed_Triangle_Mesh> ascii_welded = read_stl_mesh_file_welded(ascii_file_path);
+  runtime_assert(ascii_welded.has_value() && ascii_welded->vertices == welded->vertices);
+  runtime_assert(ascii_welded->indices == welded->indices);
+  // ASCII files are not binary STL files
+  runtime_assert(!Binary_STL_View::open(ascii_file_path).has_value());
+  std::remove(ascii_file_path.c_str());
+
+  runtime_assert(!read_stl_mesh_file(ascii_file_path).has_value());
+  return 0;
 }
+#endif
@@ -1,9 +1,62 @@
 #pragma once
 
+#include <cstddef>
 #include <optional>
 #include <string>
+#include <utility> // for std::move
 #include <vector>
 
+#include "indexed_triangle_mesh.hpp"
+#include "mapped_file.hpp"
 #include "primitives.hpp"
 
 [[nodiscard]] std::optional<std::vector<Triangle>> read_stl_mesh_file(const std::string &file_path);
+
+// Reads the triangle soup and welds it, see STL_Triangle_Soup
+[[nodiscard]] std::optional<Indexed_Triangle_Mesh> read_stl_mesh_file_welded(const std::string &file_path);
+
+// Triangles of a memory mapped binary STL file read in place, without copying the whole file into memory
+class Binary_STL_View {
+private:
+  Mapped_File m_mapped_file;
+  size_t m_num_triangles;
+
+  Binary_STL_View(Mapped_File mapped_file, size_t num_triangles)
+      : m_mapped_file(std::move(mapped_file)), m_num_triangles(num_triangles) {}
+
+public:
+  // Empty if file can not be mapped or its size does not match the triangle count of a binary STL file
+  [[nodiscard]] static std::optional<Binary_STL_View> open(const std::string &file_path);
+  // Takes over the mapping only if it is a binary STL file, otherwise leaves it untouched
+  [[nodiscard]] static std::optional<Binary_STL_View> from_mapped_file(Mapped_File &&mapped_file);
+
+  [[nodiscard]] size_t get_num_triangles() const { return m_num_triangles; }
+
+  [[nodiscard]] Triangle get_triangle(size_t i) const;
+
+  // Copies triangles [begin, end) into out, in parallel
+  void copy_triangles(size_t begin, size_t end, Triangle *out) const;
+
+  // Hints that triangles [begin, end) are not needed anymore, see Mapped_File::discard
+  void discard_triangles(size_t begin, size_t end) const;
+};
+
+// Triangles of an STL file before welding, binary files stay in their mapping and are read in place while welding,
+// so their triangle soup is never held in memory as a whole, ASCII files are parsed into memory, which takes less than
+// their text
+class STL_Triangle_Soup {
+private:
+  std::optional<Binary_STL_View> m_binary_view;
+  std::vector<Triangle> m_triangles;
+
+  STL_Triangle_Soup() = default;
+
+public:
+  // Empty if the file can not be mapped, is empty or is a malformed ASCII STL file
+  [[nodiscard]] static std::optional<STL_Triangle_Soup> read(const std::string &file_path);
+
+  [[nodiscard]] size_t get_num_triangles() const;
+
+  // Binary triangles are dropped from memory once welded, so peak memory stays close to the size of the welded mesh
+  [[nodiscard]] Indexed_Triangle_Mesh weld() const;
+};
@@ -0,0 +1,694 @@
+#include <algorithm> // for std::sort, std::set_intersection and std::binary_search
+#include <array>
+#include <cmath>     // for std::abs and std::sqrt
+#include <cstdint>
+#include <iterator> // for std::back_inserter
+#include <limits>
+#include <optional>
+#include <utility> // for std::pair and std::swap
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+
+#include "closest_point.hpp"
+#include "geobox_exceptions.hpp"
+#include "parallel.hpp"
+#include "remeshing.hpp"
+#include "vertex_adjacency.hpp"
+
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 4096;
+constexpr unsigned int INVALID_HALF_EDGE = std::numeric_limits<unsigned int>::max();
+// Each sub-pass only touches disjoint parts of the mesh, a pass repeats sub-passes until nothing changes
+constexpr unsigned int MAX_NUM_SUB_PASSES = 64;
+// Guards against running out of memory when the target edge length is too small for the mesh
+constexpr double MAX_NUM_EXPECTED_TRIANGLES = 50'000'000.0;
+// Edges between triangles whose normals are more than ~45 degrees apart are creases, creases of the input are kept like
+// boundaries and new edges are not flipped across creases, which would cut them off
+constexpr float CREASE_NORMALS_DOT_PRODUCT = 0.7f;
+// Avoids flipping back and forth between (nearly) co-circular configurations
+constexpr float DELAUNAY_COTANGENT_TOLERANCE = 1e-4f;
+
+namespace {
+// Triangle mesh with implicit half-edges, half-edge 3 * t + k goes from corner k to corner (k + 1) % 3 of triangle t,
+// connectivity (opposite half-edges, adjacency, vertex to triangle links) is rebuilt after each topology sub-pass
+class Remesher {
+private:
+  std::span<const glm::vec3> m_reference_vertices;
+  std::span<const unsigned int> m_reference_indices;
+  const BVH &m_reference_triangles_bvh;
+  float m_max_edge_length_squared;
+  float m_min_edge_length_squared;
+
+  std::vector<glm::vec3> m_vertices;
+  std::vector<unsigned int> m_indices;
+
+  // Connectivity
+  std::vector<unsigned int> m_opposite_half_edges;
+  std::vector<uint8_t> m_is_boundary_vertex;
+  // Crease half-edges, kept per triangle corner like indices, vertices on creases or boundaries never move
+  std::vector<uint8_t> m_is_crease_half_edge;
+  std::vector<uint8_t> m_is_fixed_vertex;
+  // Vertices in the middle of a straight crease can be collapsed along the crease, these have exactly two crease edges
+  std::vector<uint8_t> m_num_crease_edges;
+  std::vector<std::array<unsigned int, 2>> m_crease_neighbours;
+  Vertex_Adjacency m_adjacency;
+  Vertex_Triangles m_vertex_triangles;
+
+  [[nodiscard]] static unsigned int next(unsigned int h) { return (h % 3 == 2) ? h - 2 : h + 1; }
+  [[nodiscard]] static unsigned int prev(unsigned int h) { return (h % 3 == 0) ? h + 2 : h - 1; }
+  [[nodiscard]] unsigned int from(unsigned int h) const { return m_indices[h]; }
+  [[nodiscard]] unsigned int to(unsigned int h) const { return m_indices[next(h)]; }
+  // Vertex of the triangle of h that is not on h
+  [[nodiscard]] unsigned int opposite_vertex(unsigned int h) const { return m_indices[prev(h)]; }
+  [[nodiscard]] float length_squared(unsigned int h) const {
+    return glm::distance2(m_vertices[from(h)], m_vertices[to(h)]);
+  }
+  [[nodiscard]] size_t valence(unsigned int v) const {
+    return m_adjacency.offsets[v + 1] - m_adjacency.offsets[v];
+  }
+  [[nodiscard]] static bool is_crease(const glm::vec3 &normal_a, const glm::vec3 &normal_b) {
+    return glm::dot(normal_a, normal_b) <
+           CREASE_NORMALS_DOT_PRODUCT * std::sqrt(glm::length2(normal_a) * glm::length2(normal_b));
+  }
+  [[nodiscard]] glm::vec3 calc_triangle_normal(unsigned int t) const {
+    const glm::vec3 &a = m_vertices[m_indices[t * 3 + 0]];
+    const glm::vec3 &b = m_vertices[m_indices[t * 3 + 1]];
+    const glm::vec3 &c = m_vertices[m_indices[t * 3 + 2]];
+    return glm::cross(b - a, c - a);
+  }
+  [[nodiscard]] bool is_on_straight_crease(unsigned int v) const {
+    if (m_is_boundary_vertex[v] || m_num_crease_edges[v] != 2) return false;
+    glm::vec3 direction_a = m_vertices[m_crease_neighbours[v][0]] - m_vertices[v];
+    glm::vec3 direction_b = m_vertices[v] - m_vertices[m_crease_neighbours[v][1]];
+    return !is_crease(direction_a, direction_b);
+  }
+  [[nodiscard]] bool are_neighbours(unsigned int a, unsigned int b) const {
+    auto first = m_adjacency.neighbours.begin() + m_adjacency.offsets[a];
+    auto last = m_adjacency.neighbours.begin() + m_adjacency.offsets[a + 1];
+    return std::binary_search(first, last, b);
+  }
+
+  // Collapse of half-edge h, validated against the connectivity at the start of the sub-pass
+  struct Collapse_Candidate {
+    float edge_length_squared;
+    unsigned int h;
+    unsigned int removed;
+    unsigned int kept;
+    glm::vec3 new_position;
+  };
+
+  // Half-edges for which get_candidate(h) returns a value, evaluated in parallel over contiguous half-edge ranges and
+  // returned in half-edge order, get_candidate may only read the mesh
+  template <typename Candidate_Type, typename Get_Candidate_Type>
+  [[nodiscard]] std::vector<Candidate_Type> collect_candidates(const Get_Candidate_Type &get_candidate) const;
+  void rebuild_connectivity();
+  void remove_unused_vertices_and_triangles(const std::vector<uint8_t> &is_dead_triangle);
+  [[nodiscard]] bool split_long_edges_sub_pass();
+  [[nodiscard]] bool collapse_short_edges_sub_pass();
+  template <typename Should_Flip_Type>
+  [[nodiscard]] bool flip_edges_sub_pass(bool uses_valences, Should_Flip_Type should_flip);
+  [[nodiscard]] bool equalize_valences_sub_pass();
+  [[nodiscard]] bool make_delaunay_sub_pass();
+  [[nodiscard]] bool is_collapse_valid(unsigned int h, unsigned int removed, unsigned int kept,
+                                       const glm::vec3 &new_position) const;
+
+public:
+  Remesher(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices, const BVH &triangles_bvh,
+           float target_edge_length);
+
+  void split_long_edges();
+  void collapse_short_edges();
+  void equalize_valences();
+  void relax_tangentially_and_project();
+
+  [[nodiscard]] Indexed_Triangle_Mesh take_mesh() {
+    return {.vertices = std::move(m_vertices), .indices = std::move(m_indices)};
+  }
+};
+} // namespace
+
+Remesher::Remesher(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices, const BVH &triangles_bvh,
+                   float target_edge_length)
+    : m_reference_vertices(vertices), m_reference_indices(indices), m_reference_triangles_bvh(triangles_bvh) {
+  // Thresholds balance each other, a split edge is never short and a collapse never creates a long edge
+  float max_edge_length = target_edge_length * 4.0f / 3.0f;
+  float min_edge_length = target_edge_length * 4.0f / 5.0f;
+  m_max_edge_length_squared = max_edge_length * max_edge_length;
+  m_min_edge_length_squared = min_edge_length * min_edge_length;
+
+  m_vertices.assign(vertices.begin(), vertices.end());
+  m_indices.assign(indices.begin(), indices.end());
+  // Triangles with repeated vertices have no well-defined half-edges
+  std::vector<uint8_t> is_dead_triangle(m_indices.size() / 3, 0);
+  for (size_t t = 0; t < is_dead_triangle.size(); t++) {
+    unsigned int a = m_indices[t * 3 + 0];
+    unsigned int b = m_indices[t * 3 + 1];
+    unsigned int c = m_indices[t * 3 + 2];
+    is_dead_triangle[t] = (a == b) || (b == c) || (c == a);
+  }
+  m_is_crease_half_edge.assign(m_indices.size(), 0);
+  remove_unused_vertices_and_triangles(is_dead_triangle);
+  rebuild_connectivity();
+
+  for (unsigned int h = 0; h < m_indices.size(); h++) {
+    unsigned int opposite = m_opposite_half_edges[h];
+    if (opposite == INVALID_HALF_EDGE) continue;
+    m_is_crease_half_edge[h] = is_crease(calc_triangle_normal(h / 3), calc_triangle_normal(opposite / 3));
+  }
+  rebuild_connectivity();
+}
+
+template <typename Candidate_Type, typename Get_Candidate_Type>
+std::vector<Candidate_Type> Remesher::collect_candidates(const Get_Candidate_Type &get_candidate) const {
+  size_t num_half_edges = m_indices.size();
+  size_t num_chunks = calc_num_parallel_chunks(num_half_edges, MIN_PARALLEL_CHUNK_SIZE);
+  std::vector<std::vector<Candidate_Type>> chunk_candidates(num_chunks);
+  parallel_for_chunks(num_half_edges, num_chunks, [&](size_t chunk_index, size_t begin, size_t end) {
+    for (size_t h = begin; h < end; h++) {
+      std::optional<Candidate_Type> candidate = get_candidate(static_cast<unsigned int>(h));
+      if (candidate.has_value()) chunk_candidates[chunk_index].push_back(candidate.value());
+    }
+  });
+  return concatenate_chunks(chunk_candidates);
+}
+
+void Remesher::rebuild_connectivity() {
+  size_t num_half_edges = m_indices.size();
+
+  // Half-edges of the same undirected edge become adjacent after sorting, exactly two half-edges of opposite
+  // directions form an interior edge, anything else is a boundary or non-manifold edge
+  std::vector<std::pair<uint64_t, unsigned int>> edge_keys(num_half_edges);
+  parallel_for(0, num_half_edges, MIN_PARALLEL_CHUNK_SIZE, [this, &edge_keys](size_t begin, size_t end) {
+    for (size_t h = begin; h < end; h++) {
+      uint64_t a = from(static_cast<unsigned int>(h));
+      uint64_t b = to(static_cast<unsigned int>(h));
+      edge_keys[h] = {(std::min(a, b) << 32) | std::max(a, b), static_cast<unsigned int>(h)};
+    }
+  });
+  std::sort(edge_keys.begin(), edge_keys.end());
+
+  m_opposite_half_edges.assign(num_half_edges, INVALID_HALF_EDGE);
+  m_is_boundary_vertex.assign(m_vertices.size(), 0);
+  for (size_t i = 0; i < num_half_edges;) {
+    size_t j = i + 1;
+    while (j < num_half_edges && edge_keys[j].first == edge_keys[i].first) {
+      j++;
+    }
+    unsigned int h0 = edge_keys[i].second;
+    unsigned int h1 = edge_keys[i + 1 < j ? i + 1 : i].second;
+    if (j - i == 2 && from(h0) == to(h1)) {
+      m_opposite_half_edges[h0] = h1;
+      m_opposite_half_edges[h1] = h0;
+    } else {
+      m_is_boundary_vertex[from(h0)] = 1;
+      m_is_boundary_vertex[to(h0)] = 1;
+    }
+    i = j;
+  }
+
+  m_is_fixed_vertex = m_is_boundary_vertex;
+  m_num_crease_edges.assign(m_vertices.size(), 0);
+  m_crease_neighbours.resize(m_vertices.size());
+  for (unsigned int h = 0; h < num_half_edges; h++) {
+    if (!m_is_crease_half_edge[h]) continue;
+    // Both half-edges of a crease are flagged, each one adds its from vertex
+    unsigned int v = from(h);
+    m_is_fixed_vertex[v] = 1;
+    if (m_num_crease_edges[v] < 2) m_crease_neighbours[v][m_num_crease_edges[v]] = to(h);
+    if (m_num_crease_edges[v] < std::numeric_limits<uint8_t>::max()) m_num_crease_edges[v]++;
+  }
+
+  m_adjacency = build_vertex_adjacency(m_vertices.size(), m_indices);
+  m_vertex_triangles = build_vertex_triangles(m_vertices.size(), m_indices);
+}
+
+void Remesher::remove_unused_vertices_and_triangles(const std::vector<uint8_t> &is_dead_triangle) {
+  std::vector<unsigned int> indices;
+  std::vector<uint8_t> is_crease_half_edge;
+  indices.reserve(m_indices.size());
+  is_crease_half_edge.reserve(m_indices.size());
+  for (size_t t = 0; t < is_dead_triangle.size(); t++) {
+    if (is_dead_triangle[t]) continue;
+    indices.insert(indices.end(), m_indices.begin() + t * 3, m_indices.begin() + t * 3 + 3);
+    is_crease_half_edge.insert(is_crease_half_edge.end(), m_is_crease_half_edge.begin() + t * 3,
+                               m_is_crease_half_edge.begin() + t * 3 + 3);
+  }
+
+  std::vector<unsigned int> new_vertex_indices(m_vertices.size(), INVALID_HALF_EDGE);
+  std::vector<glm::vec3> vertices;
+  vertices.reserve(m_vertices.size());
+  for (unsigned int &v : indices) {
+    if (new_vertex_indices[v] == INVALID_HALF_EDGE) {
+      new_vertex_indices[v] = static_cast<unsigned int>(vertices.size());
+      vertices.push_back(m_vertices[v]);
+    }
+    v = new_vertex_indices[v];
+  }
+  m_vertices = std::move(vertices);
+  m_indices = std::move(indices);
+  m_is_crease_half_edge = std::move(is_crease_half_edge);
+}
+
+bool Remesher::split_long_edges_sub_pass() {
+  // Each edge once, longest first
+  using Candidate = std::pair<float, unsigned int>;
+  std::vector<Candidate> candidates = collect_candidates<Candidate>([this](unsigned int h) -> std::optional<Candidate> {
+    if (m_opposite_half_edges[h] != INVALID_HALF_EDGE && m_opposite_half_edges[h] < h) return std::nullopt;
+    float edge_length_squared = length_squared(h);
+    if (edge_length_squared <= m_max_edge_length_squared) return std::nullopt;
+    return Candidate{edge_length_squared, h};
+  });
+  if (candidates.empty()) return false;
+  std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+
+  // Triangles split in this sub-pass have stale half-edges, their other edges wait for the next sub-pass
+  std::vector<uint8_t> is_touched_triangle(m_indices.size() / 3, 0);
+  // Replaces triangle (a, b, c) of half-edge h = (a, b) with (a, m, c) and appends (m, b, c),
+  // halves of a crease stay creases and the new edge (m, c) is not one
+  auto split_triangle = [this](unsigned int h, unsigned int m) {
+    unsigned int b = to(h);
+    unsigned int c = opposite_vertex(h);
+    uint8_t is_crease_bc = m_is_crease_half_edge[next(h)];
+    m_indices[next(h)] = m;
+    m_is_crease_half_edge[next(h)] = 0;
+    m_indices.insert(m_indices.end(), {m, b, c});
+    m_is_crease_half_edge.insert(m_is_crease_half_edge.end(), {m_is_crease_half_edge[h], is_crease_bc, 0});
+  };
+  for (const auto &[edge_length_squared, h] : candidates) {
+    unsigned int opposite = m_opposite_half_edges[h];
+    if (is_touched_triangle[h / 3] || (opposite != INVALID_HALF_EDGE && is_touched_triangle[opposite / 3])) continue;
+    auto m = static_cast<unsigned int>(m_vertices.size());
+    m_vertices.push_back((m_vertices[from(h)] + m_vertices[to(h)]) * 0.5f);
+    split_triangle(h, m);
+    is_touched_triangle[h / 3] = 1;
+    if (opposite != INVALID_HALF_EDGE) {
+      split_triangle(opposite, m);
+      is_touched_triangle[opposite / 3] = 1;
+    }
+  }
+  return true;
+}
+
+bool Remesher::is_collapse_valid(unsigned int h, unsigned int removed, unsigned int kept,
+                                 const glm::vec3 &new_position) const {
+  unsigned int opposite = m_opposite_half_edges[h];
+  unsigned int c = opposite_vertex(h);
+  unsigned int d = opposite_vertex(opposite);
+
+  // Link condition, the only common neighbours are the two opposite vertices, otherwise the mesh becomes non-manifold
+  std::vector<unsigned int> common_neighbours;
+  std::set_intersection(m_adjacency.neighbours.begin() + m_adjacency.offsets[removed],
+                        m_adjacency.neighbours.begin() + m_adjacency.offsets[removed + 1],
+                        m_adjacency.neighbours.begin() + m_adjacency.offsets[kept],
+                        m_adjacency.neighbours.begin() + m_adjacency.offsets[kept + 1],
+                        std::back_inserter(common_neighbours));
+  if (common_neighbours.size() != 2) return false;
+  // Opposite vertices lose an edge, below 3 they would become degenerate (e.g. collapsing a tetrahedron)
+  if (valence(c) <= 3 || valence(d) <= 3) return false;
+
+  // No long edges may be created
+  for (unsigned int v : {removed, kept}) {
+    for (unsigned int i = m_adjacency.offsets[v]; i < m_adjacency.offsets[v + 1]; i++) {
+      unsigned int n = m_adjacency.neighbours[i];
+      if (n == removed || n == kept) continue;
+      if (glm::distance2(new_position, m_vertices[n]) > m_max_edge_length_squared) return false;
+    }
+  }
+
+  // Remaining triangles may not flip or degenerate
+  unsigned int collapsed_triangles[2] = {h / 3, opposite / 3};
+  for (unsigned int v : {removed, kept}) {
+    for (unsigned int i = m_vertex_triangles.offsets[v]; i < m_vertex_triangles.offsets[v + 1]; i++) {
+      unsigned int t = m_vertex_triangles.triangles[i];
+      if (t == collapsed_triangles[0] || t == collapsed_triangles[1]) continue;
+      glm::vec3 before[3];
+      glm::vec3 after[3];
+      for (unsigned int k = 0; k < 3; k++) {
+        unsigned int vi = m_indices[t * 3 + k];
+        before[k] = m_vertices[vi];
+        after[k] = (vi == removed || vi == kept) ? new_position : m_vertices[vi];
+      }
+      glm::vec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+      glm::vec3 normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+      if (glm::dot(normal_before, normal_after) <= 0.0f) return false;
+    }
+  }
+  return true;
+}
+
+bool Remesher::collapse_short_edges_sub_pass() {
+  // Each interior edge once, shortest first, edges with both vertices fixed are kept to keep boundaries and creases,
+  // except for crease edges that can be shortened along a straight crease
+  // Validity only depends on the neighbourhood of the edge, which no earlier collapse of this sub-pass touched once the
+  // edge is accepted below, so all candidates are validated in parallel up front
+  std::vector<Collapse_Candidate> candidates =
+      collect_candidates<Collapse_Candidate>([this](unsigned int h) -> std::optional<Collapse_Candidate> {
+        if (m_opposite_half_edges[h] == INVALID_HALF_EDGE || m_opposite_half_edges[h] < h) return std::nullopt;
+        unsigned int removed = from(h);
+        unsigned int kept = to(h);
+        if (m_is_fixed_vertex[removed] && m_is_fixed_vertex[kept] &&
+            !(m_is_crease_half_edge[h] && (is_on_straight_crease(removed) || is_on_straight_crease(kept)))) {
+          return std::nullopt;
+        }
+        float edge_length_squared = length_squared(h);
+        if (edge_length_squared >= m_min_edge_length_squared) return std::nullopt;
+        // Fixed vertices never move, unless collapsed along a crease
+        if (m_is_fixed_vertex[removed] && m_is_fixed_vertex[kept]) {
+          if (!is_on_straight_crease(removed)) std::swap(removed, kept);
+        } else if (m_is_fixed_vertex[removed]) {
+          std::swap(removed, kept);
+        }
+        glm::vec3 new_position =
+            m_is_fixed_vertex[kept] ? m_vertices[kept] : (m_vertices[removed] + m_vertices[kept]) * 0.5f;
+        if (!is_collapse_valid(h, removed, kept, new_position)) return std::nullopt;
+        return Collapse_Candidate{edge_length_squared, h, removed, kept, new_position};
+      });
+  if (candidates.empty()) return false;
+  std::sort(candidates.begin(), candidates.end(), [](const Collapse_Candidate &a, const Collapse_Candidate &b) {
+    return a.edge_length_squared != b.edge_length_squared ? a.edge_length_squared < b.edge_length_squared : a.h < b.h;
+  });
+
+  // Neighbourhoods of collapsed edges have stale connectivity, they wait for the next sub-pass
+  std::vector<uint8_t> is_touched_vertex(m_vertices.size(), 0);
+  std::vector<uint8_t> is_dead_triangle(m_indices.size() / 3, 0);
+  bool is_changed = false;
+  for (const auto &[edge_length_squared, h, removed, kept, new_position] : candidates) {
+    if (is_touched_vertex[removed] || is_touched_vertex[kept]) continue;
+
+    is_dead_triangle[h / 3] = 1;
+    is_dead_triangle[m_opposite_half_edges[h] / 3] = 1;
+    for (unsigned int i = m_vertex_triangles.offsets[removed]; i < m_vertex_triangles.offsets[removed + 1]; i++) {
+      unsigned int t = m_vertex_triangles.triangles[i];
+      for (unsigned int k = 0; k < 3; k++) {
+        if (m_indices[t * 3 + k] == removed) m_indices[t * 3 + k] = kept;
+      }
+    }
+    m_vertices[kept] = new_position;
+    for (unsigned int v : {removed, kept}) {
+      is_touched_vertex[v] = 1;
+      for (unsigned int i = m_adjacency.offsets[v]; i < m_adjacency.offsets[v + 1]; i++) {
+        is_touched_vertex[m_adjacency.neighbours[i]] = 1;
+      }
+    }
+    is_changed = true;
+  }
+  if (is_changed) remove_unused_vertices_and_triangles(is_dead_triangle);
+  return is_changed;
+}
+
+template <typename Should_Flip_Type>
+bool Remesher::flip_edges_sub_pass(bool uses_valences, Should_Flip_Type should_flip) {
+  // Flipped triangles have stale half-edges and the four vertices have stale valences and neighbours,
+  // affected edges wait for the next sub-pass, a new edge (c, d) is only possible if both c and d were not touched yet
+  // Flips never move vertices and the two triangles of an accepted flip are untouched, so whether a flip is wanted and
+  // keeps the surface is decided in parallel up front (valences only matter where no vertex is touched)
+  std::vector<unsigned int> candidates =
+      collect_candidates<unsigned int>([this, &should_flip](unsigned int h) -> std::optional<unsigned int> {
+        unsigned int opposite = m_opposite_half_edges[h];
+        if (opposite == INVALID_HALF_EDGE || opposite < h || m_is_crease_half_edge[h]) return std::nullopt;
+        unsigned int a = from(h);
+        unsigned int b = to(h);
+        unsigned int c = opposite_vertex(h);
+        unsigned int d = opposite_vertex(opposite);
+        if (c == d || are_neighbours(c, d)) return std::nullopt;
+        if (!should_flip(a, b, c, d)) return std::nullopt;
+
+        // Triangles (a, b, c) and (b, a, d) become (a, d, c) and (b, c, d)
+        const glm::vec3 &pa = m_vertices[a];
+        const glm::vec3 &pb = m_vertices[b];
+        const glm::vec3 &pc = m_vertices[c];
+        const glm::vec3 &pd = m_vertices[d];
+        glm::vec3 normal_abc = glm::cross(pb - pa, pc - pa);
+        glm::vec3 normal_bad = glm::cross(pa - pb, pd - pb);
+        if (is_crease(normal_abc, normal_bad)) return std::nullopt;
+        glm::vec3 normal = normal_abc + normal_bad;
+        if (glm::dot(glm::cross(pd - pa, pc - pa), normal) <= 0.0f) return std::nullopt;
+        if (glm::dot(glm::cross(pc - pb, pd - pb), normal) <= 0.0f) return std::nullopt;
+        return h;
+      });
+
+  std::vector<uint8_t> is_touched_vertex(m_vertices.size(), 0);
+  std::vector<uint8_t> is_touched_triangle(m_indices.size() / 3, 0);
+  bool is_changed = false;
+  for (unsigned int h : candidates) {
+    unsigned int opposite = m_opposite_half_edges[h];
+    if (is_touched_triangle[h / 3] || is_touched_triangle[opposite / 3]) continue;
+    unsigned int a = from(h);
+    unsigned int b = to(h);
+    unsigned int c = opposite_vertex(h);
+    unsigned int d = opposite_vertex(opposite);
+    bool is_any_vertex_touched =
+        is_touched_vertex[a] || is_touched_vertex[b] || is_touched_vertex[c] || is_touched_vertex[d];
+    if (uses_valences && is_any_vertex_touched) continue;
+    if (is_touched_vertex[c] && is_touched_vertex[d]) continue;
+
+    unsigned int t0 = h / 3;
+    unsigned int t1 = opposite / 3;
+    // Outer edges are (c, a), (b, c) of t0 and (a, d), (d, b) of t1
+    uint8_t is_crease_ca = m_is_crease_half_edge[prev(h)];
+    uint8_t is_crease_bc = m_is_crease_half_edge[next(h)];
+    uint8_t is_crease_ad = m_is_crease_half_edge[next(opposite)];
+    uint8_t is_crease_db = m_is_crease_half_edge[prev(opposite)];
+    m_is_crease_half_edge[t0 * 3 + 0] = is_crease_ad;
+    m_is_crease_half_edge[t0 * 3 + 1] = 0;
+    m_is_crease_half_edge[t0 * 3 + 2] = is_crease_ca;
+    m_is_crease_half_edge[t1 * 3 + 0] = is_crease_bc;
+    m_is_crease_half_edge[t1 * 3 + 1] = 0;
+    m_is_crease_half_edge[t1 * 3 + 2] = is_crease_db;
+    m_indices[t0 * 3 + 0] = a;
+    m_indices[t0 * 3 + 1] = d;
+    m_indices[t0 * 3 + 2] = c;
+    m_indices[t1 * 3 + 0] = b;
+    m_indices[t1 * 3 + 1] = c;
+    m_indices[t1 * 3 + 2] = d;
+    is_touched_triangle[t0] = 1;
+    is_touched_triangle[t1] = 1;
+    for (unsigned int v : {a, b, c, d}) {
+      is_touched_vertex[v] = 1;
+    }
+    is_changed = true;
+  }
+  return is_changed;
+}
+
+bool Remesher::equalize_valences_sub_pass() {
+  // Boundary vertices have half the neighbourhood of interior ones
+  auto deviation = [this](unsigned int v, int valence_change) {
+    int target_valence = m_is_boundary_vertex[v] ? 4 : 6;
+    return std::abs(static_cast<int>(valence(v)) + valence_change - target_valence);
+  };
+  return flip_edges_sub_pass(true, [&deviation](unsigned int a, unsigned int b, unsigned int c, unsigned int d) {
+    int deviation_before = deviation(a, 0) + deviation(b, 0) + deviation(c, 0) + deviation(d, 0);
+    int deviation_after = deviation(a, -1) + deviation(b, -1) + deviation(c, 1) + deviation(d, 1);
+    return deviation_after < deviation_before;
+  });
+}
+
+bool Remesher::make_delaunay_sub_pass() {
+  // Edge (a, b) is not locally Delaunay when the angles opposite to it sum up to more than pi,
+  // cot(angle at c) + cot(angle at d) < 0
+  auto calc_cotangent = [this](unsigned int apex, unsigned int a, unsigned int b) {
+    glm::vec3 u = m_vertices[a] - m_vertices[apex];
+    glm::vec3 v = m_vertices[b] - m_vertices[apex];
+    return glm::dot(u, v) / std::max(glm::length(glm::cross(u, v)), std::numeric_limits<float>::min());
+  };
+  return flip_edges_sub_pass(false, [&calc_cotangent](unsigned int a, unsigned int b, unsigned int c, unsigned int d) {
+    return calc_cotangent(c, a, b) + calc_cotangent(d, a, b) < -DELAUNAY_COTANGENT_TOLERANCE;
+  });
+}
+
+void Remesher::split_long_edges() {
+  for (unsigned int i = 0; i < MAX_NUM_SUB_PASSES && split_long_edges_sub_pass(); i++) {
+    rebuild_connectivity();
+    // Splitting slivers creates fans of new long edges towards their opposite vertices, which would be split again
+    // and again, flipping to a Delaunay triangulation in between replaces them with short edges
+    for (unsigned int j = 0; j < MAX_NUM_SUB_PASSES && make_delaunay_sub_pass(); j++) {
+      rebuild_connectivity();
+    }
+  }
+}
+
+void Remesher::collapse_short_edges() {
+  for (unsigned int i = 0; i < MAX_NUM_SUB_PASSES && collapse_short_edges_sub_pass(); i++) {
+    rebuild_connectivity();
+  }
+}
+
+void Remesher::equalize_valences() {
+  for (unsigned int i = 0; i < MAX_NUM_SUB_PASSES && equalize_valences_sub_pass(); i++) {
+    rebuild_connectivity();
+  }
+}
+
+void Remesher::relax_tangentially_and_project() {
+  size_t num_triangles = m_indices.size() / 3;
+  size_t num_vertices = m_vertices.size();
+
+  // Area weighted vertex normals
+  std::vector<glm::vec3> triangle_normals(num_triangles);
+  parallel_for(0, num_triangles, MIN_PARALLEL_CHUNK_SIZE, [this, &triangle_normals](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++) {
+      triangle_normals[t] = calc_triangle_normal(static_cast<unsigned int>(t));
+    }
+  });
+
+  // Vertices are partitioned into contiguous ranges, each range reads the shared previous positions and writes only its
+  // own new positions
+  std::vector<glm::vec3> new_vertices(num_vertices);
+  parallel_for(0, num_vertices, MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      const glm::vec3 &position = m_vertices[v];
+      unsigned int first = m_adjacency.offsets[v];
+      unsigned int last = m_adjacency.offsets[v + 1];
+      if (m_is_fixed_vertex[v] || first == last) {
+        new_vertices[v] = position;
+        continue;
+      }
+      glm::vec3 normal(0.0f);
+      for (unsigned int i = m_vertex_triangles.offsets[v]; i < m_vertex_triangles.offsets[v + 1]; i++) {
+        normal += triangle_normals[m_vertex_triangles.triangles[i]];
+      }
+      glm::vec3 centroid(0.0f);
+      for (unsigned int i = first; i < last; i++) {
+        centroid += m_vertices[m_adjacency.neighbours[i]];
+      }
+      centroid /= static_cast<float>(last - first);
+      // Move towards the centroid within the tangent plane only, so the surface does not shrink
+      glm::vec3 relaxed = centroid;
+      float normal_length_squared = glm::length2(normal);
+      if (normal_length_squared > 0.0f) {
+        normal /= std::sqrt(normal_length_squared);
+        relaxed += normal * glm::dot(normal, position - centroid);
+      }
+      new_vertices[v] =
+          closest_point_on_mesh(relaxed, m_reference_vertices, m_reference_indices, m_reference_triangles_bvh);
+    }
+  });
+  m_vertices = std::move(new_vertices);
+}
+
+Indexed_Triangle_Mesh remesh_isotropic(std::span<const glm::vec3> vertices, std::span<const unsigned int> indices,
+                                       const BVH &triangles_bvh, const Remeshing_Settings &settings) {
+  if (indices.empty()) {
+    throw GeoBox_Error("Empty mesh");
+  }
+
+  double total_edge_length = 0.0;
+  double total_area = 0.0;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const glm::vec3 &a = vertices[indices[i + 0]];
+    const glm::vec3 &b = vertices[indices[i + 1]];
+    const glm::vec3 &c = vertices[indices[i + 2]];
+    total_edge_length += glm::distance(a, b) + glm::distance(b, c) + glm::distance(c, a);
+    total_area += glm::length(glm::cross(b - a, c - a)) * 0.5f;
+  }
+  float target_edge_length = settings.target_edge_length;
+  if (target_edge_length <= 0.0f) {
+    target_edge_length = static_cast<float>(total_edge_length / static_cast<double>(indices.size()));
+  }
+  if (target_edge_length <= 0.0f) {
+    throw GeoBox_Error("Mesh has no non-degenerate edges");
+  }
+  // Area of an equilateral triangle is sqrt(3) / 4 * edge length^2
+  double equilateral_triangle_area = std::sqrt(3.0) / 4.0 * target_edge_length * target_edge_length;
+  if (total_area / equilateral_triangle_area > MAX_NUM_EXPECTED_TRIANGLES) {
+    throw GeoBox_Error("Target edge length is too small for mesh size");
+  }
+
+  Remesher remesher(vertices, indices, triangles_bvh, target_edge_length);
+  for (unsigned int i = 0; i < settings.num_iterations; i++) {
+    remesher.split_long_edges();
+    remesher.collapse_short_edges();
+    remesher.equalize_valences();
+    remesher.relax_tangentially_and_project();
+  }
+  return remesher.take_mesh();
+}
+
+#ifdef GEOBOX_TEST_REMESHING
+#include "math.hpp"
+#include "testing.hpp"
+
+[[nodiscard]] static BVH build_triangles_bvh(std::span<const glm::vec3> vertices,
+                                             std::span<const unsigned int> indices) {
+  std::vector<AABB> bounding_boxes;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const glm::vec3 &a = vertices[indices[i + 0]];
+    const glm::vec3 &b = vertices[indices[i + 1]];
+    const glm::vec3 &c = vertices[indices[i + 2]];
+    bounding_boxes.push_back({glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c))});
+  }
+  return BVH(bounding_boxes);
+}
+
+[[nodiscard]] static double calc_area(const Indexed_Triangle_Mesh &mesh) {
+  double area = 0.0;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    const glm::vec3 &a = mesh.vertices[mesh.indices[i + 0]];
+    const glm::vec3 &b = mesh.vertices[mesh.indices[i + 1]];
+    const glm::vec3 &c = mesh.vertices[mesh.indices[i + 2]];
+    area += glm::length(glm::cross(b - a, c - a)) * 0.5;
+  }
+  return area;
+}
+
+int main() {
+  Tolerance_Context tc(1e-9f, 1e-4f);
+  float target_edge_length = 0.1f;
+
+  // Closed unit cube, stays closed and manifold, on the cube surface and with edges close to the target length
+  std::vector<glm::vec3> cube_vertices = {
+      {-0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f},
+      {-0.5f, -0.5f, 0.5f},  {0.5f, -0.5f, 0.5f},  {0.5f, 0.5f, 0.5f},  {-0.5f, 0.5f, 0.5f},
+  };
+  std::vector<unsigned int> cube_indices = {
+      0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 1, 2, 6, 1, 6, 5, 2, 3, 7, 2, 7, 6, 3, 0, 4, 3, 4, 7,
+  };
+  BVH cube_bvh = build_triangles_bvh(cube_vertices, cube_indices);
+  Indexed_Triangle_Mesh cube = remesh_isotropic(cube_vertices, cube_indices, cube_bvh, {.target_edge_length = 0.1f});
+  runtime_assert(cube.indices.size() / 3 > 500);
+  for (const glm::vec3 &v : cube.vertices) {
+    float distance_from_center = std::max(std::abs(v.x), std::max(std::abs(v.y), std::abs(v.z)));
+    runtime_assert(is_close(tc, distance_from_center, 0.5f));
+  }
+  runtime_assert(is_watertight(cube));
+  runtime_assert(std::abs(calc_volume(cube) - 1.0f) < 1e-3f);
+  double total_edge_length = 0.0;
+  for (size_t i = 0; i < cube.indices.size(); i += 3) {
+    for (size_t j = 0; j < 3; j++) {
+      unsigned int a = cube.indices[i + j];
+      unsigned int b = cube.indices[i + (j + 1) % 3];
+      runtime_assert(a != b);
+      total_edge_length += glm::distance(cube.vertices[a], cube.vertices[b]);
+    }
+  }
+  // Euler characteristic of a sphere, every edge of a closed mesh is shared by two triangles
+  size_t num_edges = cube.indices.size() / 2;
+  runtime_assert(cube.vertices.size() + cube.indices.size() / 3 == num_edges + 2);
+  double mean_edge_length = total_edge_length / static_cast<double>(cube.indices.size());
+  runtime_assert(std::abs(mean_edge_length - target_edge_length) < 0.25 * target_edge_length);
+  // Creases are kept
+  runtime_assert(std::abs(calc_area(cube) - 6.0) < 1e-3);
+  for (const glm::vec3 &corner : cube_vertices) {
+    runtime_assert(std::find(cube.vertices.begin(), cube.vertices.end(), corner) != cube.vertices.end());
+  }
+
+  // Open unit square, boundary including its corners is kept
+  std::vector<glm::vec3> square_vertices = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}};
+  std::vector<unsigned int> square_indices = {0, 1, 2, 0, 2, 3};
+  BVH square_bvh = build_triangles_bvh(square_vertices, square_indices);
+  Indexed_Triangle_Mesh square =
+      remesh_isotropic(square_vertices, square_indices, square_bvh, {.target_edge_length = 0.1f});
+  runtime_assert(square.indices.size() / 3 > 100);
+  for (const glm::vec3 &v : square.vertices) {
+    runtime_assert(v.z == 0.0f);
+    runtime_assert(v.x >= 0.0f && v.x <= 1.0f && v.y >= 0.0f && v.y <= 1.0f);
+  }
+  for (const glm::vec3 &corner : square_vertices) {
+    runtime_assert(std::find(square.vertices.begin(), square.vertices.end(), corner) != square.vertices.end());
+  }
+  runtime_assert(std::abs(calc_area(square) - 1.0) < 1e-4);
+  return 0;
+}
+#endif
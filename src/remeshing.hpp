@@ -0,0 +1,26 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "bvh.hpp"
+#include "indexed_triangle_mesh.hpp"
+
+constexpr unsigned int DEFAULT_REMESHING_NUM_ITERATIONS = 5;
+
+struct Remeshing_Settings {
+  // Non-positive means the mean edge length of the input mesh
+  float target_edge_length = 0.0f;
+  unsigned int num_iterations = DEFAULT_REMESHING_NUM_ITERATIONS;
+};
+
+// Isotropic remeshing, each iteration splits long edges, collapses short edges, flips edges to equalize valences and
+// tangentially relaxes vertices which are then projected back onto the input surface,
+// boundary and non-manifold edges are only ever split, so open meshes keep their boundaries,
+// input mesh must be welded, triangles BVH is the one built from the input triangle bounding boxes
+// Mario Botsch and Leif Kobbelt, A Remeshing Approach to Multiresolution Modeling, SGP 2004
+[[nodiscard]] Indexed_Triangle_Mesh remesh_isotropic(std::span<const glm::vec3> vertices,
+                                                     std::span<const unsigned int> indices, const BVH &triangles_bvh,
+                                                     const Remeshing_Settings &settings);
@@ -0,0 +1,127 @@
+#include <algorithm> // for std::find and std::find_if
+#include <cassert>
+#include <iterator> // for std::distance
+
+#include <glad/glad.h>
+
+#include "render_state.hpp"
+
+constexpr std::array<unsigned int, NUM_TRACKED_BUFFER_TARGETS> TRACKED_BUFFER_TARGETS = {
+    GL_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_TEXTURE_BUFFER, GL_UNIFORM_BUFFER,
+};
+
+[[nodiscard]] static size_t get_buffer_target_index(unsigned int target) {
+  auto it = std::find(TRACKED_BUFFER_TARGETS.begin(), TRACKED_BUFFER_TARGETS.end(), target);
+  assert(it != TRACKED_BUFFER_TARGETS.end());
+  return static_cast<size_t>(std::distance(TRACKED_BUFFER_TARGETS.begin(), it));
+}
+
+Render_State::Render_State() { invalidate(); }
+
+Render_State &Render_State::get() {
+  static Render_State render_state;
+  return render_state;
+}
+
+void Render_State::use_program(unsigned int program) {
+  if (m_program == program) {
+    m_num_skipped_state_changes++;
+    return;
+  }
+  glUseProgram(program);
+  m_program = program;
+  m_num_state_changes++;
+}
+
+void Render_State::bind_vertex_array(unsigned int vertex_array) {
+  if (m_vertex_array == vertex_array) {
+    m_num_skipped_state_changes++;
+    return;
+  }
+  glBindVertexArray(vertex_array);
+  m_vertex_array = vertex_array;
+  m_num_state_changes++;
+}
+
+void Render_State::bind_buffer(unsigned int target, unsigned int buffer) {
+  unsigned int &bound_buffer = m_buffers[get_buffer_target_index(target)];
+  if (bound_buffer == buffer) {
+    m_num_skipped_state_changes++;
+    return;
+  }
+  glBindBuffer(target, buffer);
+  bound_buffer = buffer;
+  m_num_state_changes++;
+}
+
+void Render_State::bind_buffer_base(unsigned int target, unsigned int index, unsigned int buffer) {
+  // Indexed binding points are not shadowed, these are set once per buffer
+  glBindBufferBase(target, index, buffer);
+  m_buffers[get_buffer_target_index(target)] = buffer;
+  m_num_state_changes++;
+}
+
+void Render_State::bind_texture(int unit, unsigned int target, unsigned int texture) {
+  auto it = std::find_if(m_texture_bindings.begin(), m_texture_bindings.end(), [&](const Texture_Binding &binding) {
+    return binding.unit == unit && binding.target == target;
+  });
+  if (it != m_texture_bindings.end() && it->texture == texture) {
+    m_num_skipped_state_changes++;
+    return;
+  }
+  if (m_active_texture_unit != unit) {
+    glActiveTexture(GL_TEXTURE0 + static_cast<unsigned int>(unit));
+    m_active_texture_unit = unit;
+    m_num_state_changes++;
+  }
+  glBindTexture(target, texture);
+  if (it != m_texture_bindings.end()) {
+    it->texture = texture;
+  } else {
+    m_texture_bindings.push_back({unit, target, texture});
+  }
+  m_num_state_changes++;
+}
+
+void Render_State::delete_program(unsigned int program) {
+  glDeleteProgram(program);
+  // Deleting the program in use only flags it for deletion, it stays in use, but its name may be reused
+  if (m_program == program) m_program = UNKNOWN_BINDING;
+}
+
+void Render_State::delete_vertex_array(unsigned int vertex_array) {
+  glDeleteVertexArrays(1, &vertex_array);
+  // Deleting the bound VAO binds 0
+  if (vertex_array != 0 && m_vertex_array == vertex_array) m_vertex_array = 0;
+}
+
+void Render_State::delete_buffer(unsigned int buffer) {
+  glDeleteBuffers(1, &buffer);
+  if (buffer == 0) return;
+  // Deleting a bound buffer binds 0 to its targets
+  for (unsigned int &bound_buffer : m_buffers) {
+    if (bound_buffer == buffer) bound_buffer = 0;
+  }
+}
+
+void Render_State::delete_texture(unsigned int texture) {
+  glDeleteTextures(1, &texture);
+  if (texture == 0) return;
+  // Deleting a bound texture binds 0 to its targets
+  for (Texture_Binding &binding : m_texture_bindings) {
+    if (binding.texture == texture) binding.texture = 0;
+  }
+}
+
+void Render_State::invalidate() {
+  m_program = UNKNOWN_BINDING;
+  m_vertex_array = UNKNOWN_BINDING;
+  m_buffers.fill(UNKNOWN_BINDING);
+  m_active_texture_unit = -1;
+  m_texture_bindings.clear();
+}
+
+void Render_State::reset_statistics() {
+  m_num_state_changes = 0;
+  m_num_skipped_state_changes = 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Buffer targets whose bindings are shadowed, the element array binding is left out since it is part of the VAO
+constexpr size_t NUM_TRACKED_BUFFER_TARGETS = 5;
+
+// CPU shadow of the GL bindings of the app's context, binds matching the shadow are skipped without querying GL,
+// binds and deletes of the tracked kinds must go through it, since GL reuses the names of deleted objects
+class Render_State {
+private:
+  // Bindings not known since the last invalidate(), GL never generates this name
+  static constexpr unsigned int UNKNOWN_BINDING = ~0u;
+
+  struct Texture_Binding {
+    int unit;
+    unsigned int target;
+    unsigned int texture;
+  };
+
+  unsigned int m_program = UNKNOWN_BINDING;
+  unsigned int m_vertex_array = UNKNOWN_BINDING;
+  std::array<unsigned int, NUM_TRACKED_BUFFER_TARGETS> m_buffers;
+  int m_active_texture_unit = -1;
+  std::vector<Texture_Binding> m_texture_bindings;
+
+  size_t m_num_state_changes = 0;
+  size_t m_num_skipped_state_changes = 0;
+
+  Render_State();
+
+public:
+  Render_State(const Render_State &) = delete;
+  Render_State &operator=(const Render_State &) = delete;
+
+  // Of the app's only GL context, only use on the thread the context is current on
+  [[nodiscard]] static Render_State &get();
+
+  void use_program(unsigned int program);
+  void bind_vertex_array(unsigned int vertex_array);
+  // Target must be one of the tracked targets, see render_state.cpp
+  void bind_buffer(unsigned int target, unsigned int buffer);
+  // Also binds the buffer to the target's generic binding point, as GL does
+  void bind_buffer_base(unsigned int target, unsigned int index, unsigned int buffer);
+  void bind_texture(int unit, unsigned int target, unsigned int texture);
+
+  // Delete through these, so a new object reusing the name is not mistaken for a bound one
+  void delete_program(unsigned int program);
+  void delete_vertex_array(unsigned int vertex_array);
+  void delete_buffer(unsigned int buffer);
+  void delete_texture(unsigned int texture);
+
+  // Forgets all bindings, call after code that changes GL state directly (e.g. the ImGui renderer)
+  void invalidate();
+
+  // Calls that reached GL and calls skipped as redundant, since the last reset_statistics()
+  [[nodiscard]] size_t get_num_state_changes() const { return m_num_state_changes; }
+  [[nodiscard]] size_t get_num_skipped_state_changes() const { return m_num_skipped_state_changes; }
+  void reset_statistics();
+};
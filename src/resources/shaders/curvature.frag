@@ -0,0 +1,28 @@
+#version 330 core
+
+// Curvatures at or beyond +-curvature_range get the most saturated colours
+flat in float curvature_range;
+
+in vec3 vertex_position;
+in vec3 vertex_normal;
+in float vertex_curvature;
+noperspective in vec3 edge_distances;
+
+out vec4 fragment_color;
+
+// Diverging colour map, blue for negative, white for zero and red for positive curvature
+vec3 colour_map(float t) {
+  vec3 negative_color = vec3(0.23f, 0.30f, 0.75f);
+  vec3 zero_color = vec3(0.87f, 0.87f, 0.87f);
+  vec3 positive_color = vec3(0.71f, 0.02f, 0.15f);
+  return (t < 0.0f) ? mix(zero_color, negative_color, -t) : mix(zero_color, positive_color, t);
+}
+
+void main() {
+  float t = (curvature_range > 0.0f) ? clamp(vertex_curvature / curvature_range, -1.0f, 1.0f) : 0.0f;
+
+  // Headlight shading keeps the shape readable without tinting the colour map
+  vec3 view_direction = normalize(camera_position - vertex_position);
+  float diffuse = abs(dot(normalize(vertex_normal), view_direction));
+  fragment_color = vec4(apply_wireframe(colour_map(t) * (0.3f + 0.7f * diffuse), edge_distances), 1.0f);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout(location = 0) in vec3 a_vertex_position;
+layout(location = 1) in vec3 a_vertex_normal;
+layout(location = 2) in float a_vertex_curvature;
+layout(location = 3) in uint a_vertex_draw_id;
+
+// Passed to the geometry shader, which adds the distances to the triangle's edges
+out Vertex_Data {
+  vec3 position;
+  vec3 normal;
+  float curvature;
+  float curvature_range;
+}
+vertex_data;
+
+void main() {
+  Draw_Data data = fetch_draw_data(a_vertex_draw_id);
+  gl_Position = projection_matrix * view_matrix * data.model_matrix * vec4(a_vertex_position, 1.0f);
+  vertex_data.position = vec3(data.model_matrix * vec4(a_vertex_position, 1.0f));
+  vertex_data.normal = data.normal_matrix * a_vertex_normal;
+  vertex_data.curvature = a_vertex_curvature;
+  vertex_data.curvature_range = data.curvature_range;
+}
@@ -1,11 +1,10 @@
 #version 330 core
 
 uniform vec3 object_color;
-uniform vec3 light_color;
-uniform vec3 camera_position;
 
 in vec3 vertex_position;
 in vec3 vertex_normal;
+noperspective in vec3 edge_distances;
 
 out vec4 fragment_color;
 
@@ -23,5 +22,5 @@ void main() {
   vec3 diffuse = light_color * max(dot(vertex_normal, light_direction), 0.0f);
   vec3 specular = specular_strength * light_color * pow(max(dot(view_direction, reflect_direction), 0.0f), 32.0f);
   vec3 result = (ambient + diffuse + specular) * object_color;
-  fragment_color = vec4(result, 1.0f);
+  fragment_color = vec4(apply_wireframe(result, edge_distances), 1.0f);
 }
@@ -1,17 +1,18 @@
 #version 330 core
 layout(location = 0) in vec3 a_vertex_position;
 layout(location = 1) in vec3 a_vertex_normal;
+layout(location = 3) in uint a_vertex_draw_id;
 
-uniform mat4 model_matrix;
-uniform mat4 view_matrix;
-uniform mat4 projection_matrix;
-uniform mat3 normal_matrix;
-
-out vec3 vertex_position;
-out vec3 vertex_normal;
+// Passed to the geometry shader, which adds the distances to the triangle's edges
+out Vertex_Data {
+  vec3 position;
+  vec3 normal;
+}
+vertex_data;
 
 void main() {
-  gl_Position = projection_matrix * view_matrix * model_matrix * vec4(a_vertex_position, 1.0f);
-  vertex_position = vec3(model_matrix * vec4(a_vertex_position, 1.0f));
-  vertex_normal = normal_matrix * a_vertex_normal;
+  Draw_Data data = fetch_draw_data(a_vertex_draw_id);
+  gl_Position = projection_matrix * view_matrix * data.model_matrix * vec4(a_vertex_position, 1.0f);
+  vertex_data.position = vec3(data.model_matrix * vec4(a_vertex_position, 1.0f));
+  vertex_data.normal = data.normal_matrix * a_vertex_normal;
 }
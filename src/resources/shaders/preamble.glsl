@@ -0,0 +1,53 @@
+// Inserted after the #version line of every shader by the Shader class, declarations shared by all shaders go here
+
+// Shared by all shaders and updated once per frame, matches Frame_Uniforms in shader.hpp
+layout(std140) uniform Frame_Uniforms {
+  mat4 view_matrix;
+  mat4 projection_matrix;
+  vec3 camera_position;
+  vec3 light_color;
+  float wireframe_width;
+  vec2 viewport_size;
+};
+
+// Per object data of the geometry pool, texel layout matches Draw_Data in geometry_pool.hpp, the Shader class defines
+// DRAW_DATA_NUM_TEXELS from the same constant
+uniform samplerBuffer draw_data;
+
+struct Draw_Data {
+  mat4 model_matrix;
+  mat3 normal_matrix;
+  float curvature_range;
+};
+
+Draw_Data fetch_draw_data(uint draw_id) {
+  int first_texel = int(draw_id) * DRAW_DATA_NUM_TEXELS;
+  Draw_Data data;
+  data.model_matrix = mat4(texelFetch(draw_data, first_texel + 0), texelFetch(draw_data, first_texel + 1),
+                           texelFetch(draw_data, first_texel + 2), texelFetch(draw_data, first_texel + 3));
+  data.normal_matrix = mat3(texelFetch(draw_data, first_texel + 4).xyz, texelFetch(draw_data, first_texel + 5).xyz,
+                            texelFetch(draw_data, first_texel + 6).xyz);
+  data.curvature_range = texelFetch(draw_data, first_texel + 7).x;
+  return data;
+}
+
+// Height of each corner of a triangle over its opposite edge in pixels, from the clip space positions of the corners,
+// geometry shaders pass these on so the interpolated heights give each fragment its distances to the edges
+vec3 calc_edge_heights(vec4 clip_position0, vec4 clip_position1, vec4 clip_position2) {
+  vec2 p0 = 0.5f * viewport_size * clip_position0.xy / clip_position0.w;
+  vec2 p1 = 0.5f * viewport_size * clip_position1.xy / clip_position1.w;
+  vec2 p2 = 0.5f * viewport_size * clip_position2.xy / clip_position2.w;
+  vec2 e0 = p2 - p1;
+  vec2 e1 = p0 - p2;
+  vec2 e2 = p1 - p0;
+  float double_area = abs(e1.x * e2.y - e1.y * e2.x);
+  return double_area / max(vec3(length(e0), length(e1), length(e2)), 1e-6f);
+}
+
+// Darkens fragments within wireframe_width pixels of the triangle's edges, antialiased over one pixel
+vec3 apply_wireframe(vec3 color, vec3 edge_distances) {
+  if (wireframe_width <= 0.0f) return color;
+  float edge_distance = min(edge_distances.x, min(edge_distances.y, edge_distances.z));
+  float edge_factor = smoothstep(wireframe_width - 0.5f, wireframe_width + 0.5f, edge_distance);
+  return mix(vec3(0.0f), color, edge_factor);
+}
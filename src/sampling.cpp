@@ -0,0 +1,261 @@
+#include <algorithm> // for std::upper_bound and std::min
+#include <cassert>
+#include <cmath> // for std::sqrt, std::cos and std::sin
+#include <memory_resource>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "intersection.hpp"
+#include "math.hpp"
+#include "parallel.hpp"
+#include "primitives.hpp"
+#include "profiler.hpp"
+#include "ray.hpp"
+#include "ray_aabb_intersection.hpp"
+#include "sampling.hpp"
+#include "scratch_arena.hpp"
+
+// Fixed, so the points do not depend on the number of threads
+constexpr size_t SAMPLING_CHUNK_SIZE = 4096;
+
+// Engine of one chunk, seeded from the seed and the chunk index, so chunks are independent of each other
+[[nodiscard]] static std::mt19937 create_chunk_random_engine(uint64_t seed, size_t chunk_index) {
+  std::seed_seq seed_sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                              static_cast<uint32_t>(chunk_index), static_cast<uint32_t>(chunk_index >> 32)};
+  return std::mt19937(seed_sequence);
+}
+
+// Calls callback(random_engine, begin, end) for fixed size chunks of [0, count) in parallel
+template <typename Callback_Type>
+static void foreach_sampling_chunk(size_t count, uint64_t seed, const Callback_Type &callback) {
+  size_t num_chunks = (count + SAMPLING_CHUNK_SIZE - 1) / SAMPLING_CHUNK_SIZE;
+  parallel_for(0, num_chunks, 1, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; c++) {
+      std::mt19937 random_engine = create_chunk_random_engine(seed, c);
+      callback(random_engine, c, c * SAMPLING_CHUNK_SIZE, std::min((c + 1) * SAMPLING_CHUNK_SIZE, count));
+    }
+  });
+}
+
+// https://www.pbr-book.org/3ed-2018/Monte_Carlo_Integration/2D_Sampling_with_Multidimensional_Transformations#SamplingaTriangle
+[[nodiscard]] static glm::vec2 random_triangle_barycentric_coords_transform(float u0, float u1) {
+  assert(u0 >= 0.0f && u0 <= 1.0f);
+  assert(u1 >= 0.0f && u1 <= 1.0f);
+  float su0 = std::sqrt(u0);
+  return {1 - su0, u1 * su0};
+}
+
+// https://www.pbr-book.org/3ed-2018/Monte_Carlo_Integration/2D_Sampling_with_Multidimensional_Transformations#UniformSampleSphere
+[[nodiscard]] static glm::vec3 random_sphere_coords_transform(float u0, float u1) {
+  assert(u0 >= 0.0f && u0 <= 1.0f);
+  assert(u1 >= 0.0f && u1 <= 1.0f);
+  float z = 1.0f - 2.0f * u0;
+  float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+  float phi = 2 * glm::pi<float>() * u1;
+  return {r * std::cos(phi), r * std::sin(phi), z};
+}
+
+[[nodiscard]] static bool is_point_in_aabb(const glm::vec3 &p, const AABB &aabb) {
+  return glm::all(glm::greaterThanEqual(p, aabb.min) && glm::lessThanEqual(p, aabb.max));
+}
+
+std::vector<glm::vec3> sample_points_on_surface(std::span<const glm::vec3> vertices,
+                                                std::span<const unsigned int> indices,
+                                                std::span<const float> triangle_areas, size_t count, uint64_t seed) {
+  GEOBOX_PROFILE_SCOPE("Sample points on surface");
+  assert(indices.size() % 3 == 0);
+  assert(triangle_areas.size() == indices.size() / 3);
+  if (triangle_areas.empty() || count == 0) return {};
+
+  // Triangles are picked by binary search of the cumulative areas, accumulated in double precision so small triangles
+  // of large meshes keep their share
+  Scratch_Scope scratch;
+  std::pmr::vector<double> cumulative_areas(triangle_areas.size(), scratch.get_resource());
+  double total_area = 0.0;
+  for (size_t i = 0; i < triangle_areas.size(); i++) {
+    total_area += triangle_areas[i];
+    cumulative_areas[i] = total_area;
+  }
+  if (total_area <= 0.0) return {};
+
+  std::vector<glm::vec3> points(count);
+  foreach_sampling_chunk(count, seed, [&](std::mt19937 &random_engine, size_t, size_t begin, size_t end) {
+    std::uniform_real_distribution<double> area_distribution(0.0, total_area);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    for (size_t i = begin; i < end; i++) {
+      auto it = std::upper_bound(cumulative_areas.begin(), cumulative_areas.end(), area_distribution(random_engine));
+      // Upper bound of the total area itself is past the end
+      size_t triangle_index = std::min(static_cast<size_t>(it - cumulative_areas.begin()), triangle_areas.size() - 1);
+      const glm::vec3 &a = vertices[indices[triangle_index * 3 + 0]];
+      const glm::vec3 &b = vertices[indices[triangle_index * 3 + 1]];
+      const glm::vec3 &c = vertices[indices[triangle_index * 3 + 2]];
+      float u0 = distribution(random_engine);
+      float u1 = distribution(random_engine);
+      glm::vec2 uv = random_triangle_barycentric_coords_transform(u0, u1);
+      points[i] = (b - a) * uv.x + (c - a) * uv.y + a;
+    }
+  });
+  return points;
+}
+
+std::vector<glm::vec3> sample_directions(size_t count, uint64_t seed) {
+  std::vector<glm::vec3> directions(count);
+  foreach_sampling_chunk(count, seed, [&](std::mt19937 &random_engine, size_t, size_t begin, size_t end) {
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    for (size_t i = begin; i < end; i++) {
+      float u0 = distribution(random_engine);
+      float u1 = distribution(random_engine);
+      directions[i] = random_sphere_coords_transform(u0, u1);
+      assert(is_close(TC::get_default(), glm::length(directions[i]), 1.0f));
+    }
+  });
+  return directions;
+}
+
+// Whether the closest triangle hit by the ray is hit from behind, i.e. the ray starts inside the mesh
+[[nodiscard]] static bool is_closest_hit_from_behind(std::span<const glm::vec3> vertices,
+                                                     std::span<const unsigned int> indices,
+                                                     std::span<const glm::vec3> triangle_normals,
+                                                     const BVH &triangles_bvh, const Ray &ray) {
+  float closest_hit = 100000.0f;
+  bool is_closest_hit_from_behind = false;
+  triangles_bvh.foreach_primitive(
+      [&](unsigned int i) {
+        float dot_product = glm::dot(ray.direction, triangle_normals[i]);
+        if (is_close(TC::get_default(), dot_product, 0.0f)) {
+          // Skip triangles that are parallel and coplanar to the ray
+          return;
+        }
+        const glm::vec3 &a = vertices[indices[i * 3 + 0]];
+        const glm::vec3 &b = vertices[indices[i * 3 + 1]];
+        const glm::vec3 &c = vertices[indices[i * 3 + 2]];
+        std::optional<glm::vec3> v =
+            intersect(TC::get_default(), Triangle{a, b, c}, {ray.origin, ray.origin + 99999.0f * ray.direction});
+        if (!v.has_value()) {
+          return;
+        }
+        float t = glm::dot((v.value() - ray.origin), ray.direction);
+        if (t < closest_hit) {
+          closest_hit = t;
+          is_closest_hit_from_behind = (dot_product > 0.0f);
+        }
+      },
+      [&ray](const AABB &aabb) {
+        if (is_point_in_aabb(ray.origin, aabb))
+          // Rays from inside the AABB necessarily intersect the AABB
+          return true;
+        std::optional<float> t = ray_aabb_intersection(ray, aabb);
+        if (!t.has_value()) return false;
+        assert(t.value() >= 0.0f);
+        return true;
+      },
+      [](unsigned int) { return true; });
+  return is_closest_hit_from_behind;
+}
+
+std::vector<glm::vec3> sample_points_in_volume(std::span<const glm::vec3> vertices,
+                                               std::span<const unsigned int> indices,
+                                               std::span<const glm::vec3> triangle_normals, const BVH &triangles_bvh,
+                                               size_t count_before_filtering,
+                                               const std::vector<glm::vec3> &ray_directions, uint64_t seed) {
+  GEOBOX_PROFILE_SCOPE("Sample points in volume");
+  const AABB &aabb = triangles_bvh.get_aabb();
+  assert(aabb.max.x >= aabb.min.x);
+  assert(aabb.max.y >= aabb.min.y);
+  assert(aabb.max.z >= aabb.min.z);
+  size_t num_chunks = (count_before_filtering + SAMPLING_CHUNK_SIZE - 1) / SAMPLING_CHUNK_SIZE;
+  std::vector<std::vector<glm::vec3>> chunk_points(num_chunks);
+  foreach_sampling_chunk(
+      count_before_filtering, seed, [&](std::mt19937 &random_engine, size_t chunk_index, size_t begin, size_t end) {
+        std::uniform_real_distribution<float> x_distribution(aabb.min.x, aabb.max.x);
+        std::uniform_real_distribution<float> y_distribution(aabb.min.y, aabb.max.y);
+        std::uniform_real_distribution<float> z_distribution(aabb.min.z, aabb.max.z);
+        for (size_t i = begin; i < end; i++) {
+          float x = x_distribution(random_engine);
+          float y = y_distribution(random_engine);
+          glm::vec3 p{x, y, z_distribution(random_engine)};
+          size_t num_hits_from_behind = 0;
+          for (const glm::vec3 &direction : ray_directions) {
+            if (is_closest_hit_from_behind(vertices, indices, triangle_normals, triangles_bvh, {p, direction})) {
+              num_hits_from_behind++;
+            }
+          }
+          if (num_hits_from_behind > (ray_directions.size() / 2)) chunk_points[chunk_index].push_back(p);
+        }
+      });
+  return concatenate_chunks(chunk_points);
+}
+
+#ifdef GEOBOX_TEST_SAMPLING
+#include "testing.hpp"
+
+// Distance from the point to the surface of the axis aligned box, zero on the surface
+[[nodiscard]] static float calc_box_surface_distance(const glm::vec3 &p, const AABB &box) {
+  glm::vec3 outside = glm::max(glm::max(box.min - p, p - box.max), glm::vec3(0.0f));
+  if (outside != glm::vec3(0.0f)) return glm::length(outside);
+  glm::vec3 inside = glm::min(p - box.min, box.max - p);
+  return std::min(inside.x, std::min(inside.y, inside.z));
+}
+
+int main() {
+  // Box of 2 x 1 x 1 with outward facing triangles, areas of the 2 x 1 faces are twice the 1 x 1 ones
+  AABB box{.min = {0, 0, 0}, .max = {2, 1, 1}};
+  std::vector<glm::vec3> vertices = {{0, 0, 0}, {2, 0, 0}, {2, 1, 0}, {0, 1, 0},
+                                     {0, 0, 1}, {2, 0, 1}, {2, 1, 1}, {0, 1, 1}};
+  std::vector<unsigned int> indices = {
+      0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 7, 6, 3, 6, 2, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5,
+  };
+  std::vector<float> triangle_areas;
+  std::vector<glm::vec3> triangle_normals;
+  std::vector<AABB> triangle_bounding_boxes;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const glm::vec3 &a = vertices[indices[i + 0]];
+    const glm::vec3 &b = vertices[indices[i + 1]];
+    const glm::vec3 &c = vertices[indices[i + 2]];
+    glm::vec3 cross = glm::cross(b - a, c - a);
+    triangle_areas.push_back(glm::length(cross) * 0.5f);
+    triangle_normals.push_back(glm::normalize(cross));
+    triangle_bounding_boxes.push_back({.min = glm::min(a, glm::min(b, c)), .max = glm::max(a, glm::max(b, c))});
+  }
+  BVH bvh(triangle_bounding_boxes);
+
+  // Points are on the surface, spread over faces by area, and the same for the same seed
+  size_t count = 100000;
+  std::vector<glm::vec3> surface_points = sample_points_on_surface(vertices, indices, triangle_areas, count, 7);
+  runtime_assert(surface_points.size() == count);
+  size_t num_points_on_x_faces = 0;
+  for (const glm::vec3 &p : surface_points) {
+    runtime_assert(calc_box_surface_distance(p, box) < 1e-5f);
+    if (p.x < 1e-5f || p.x > 2.0f - 1e-5f) num_points_on_x_faces++;
+  }
+  // Faces at x = 0 and x = 2 make up 2 of the 10 units of area
+  runtime_assert(std::abs(static_cast<float>(num_points_on_x_faces) / static_cast<float>(count) - 0.2f) < 0.01f);
+  runtime_assert(sample_points_on_surface(vertices, indices, triangle_areas, count, 7) == surface_points);
+  runtime_assert(sample_points_on_surface(vertices, indices, triangle_areas, count, 8) != surface_points);
+
+  std::vector<glm::vec3> directions = sample_directions(1000, 3);
+  glm::vec3 mean_direction(0.0f);
+  for (const glm::vec3 &d : directions) {
+    runtime_assert(std::abs(glm::length(d) - 1.0f) < 1e-5f);
+    mean_direction += d / 1000.0f;
+  }
+  runtime_assert(glm::length(mean_direction) < 0.1f);
+
+  // Every point of the bounding box is inside the box
+  std::vector<glm::vec3> volume_points =
+      sample_points_in_volume(vertices, indices, triangle_normals, bvh, 10000, sample_directions(5, 3), 11);
+  runtime_assert(volume_points.size() > 9900);
+  for (const glm::vec3 &p : volume_points) {
+    runtime_assert(is_point_in_aabb(p, box));
+  }
+  runtime_assert(sample_points_in_volume(vertices, indices, triangle_normals, bvh, 10000, sample_directions(5, 3),
+                                         11) == volume_points);
+  return 0;
+}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "bvh.hpp"
+
+// Samplers run in parallel on fixed size chunks, each with its own random engine seeded from the seed and the chunk
+// index, so the same seed gives the same points regardless of the number of threads
+
+// Points uniformly distributed over the surface of the mesh, triangles are picked with probability proportional to
+// their area
+[[nodiscard]] std::vector<glm::vec3> sample_points_on_surface(std::span<const glm::vec3> vertices,
+                                                              std::span<const unsigned int> indices,
+                                                              std::span<const float> triangle_areas, size_t count,
+                                                              uint64_t seed);
+
+// Unit vectors uniformly distributed over the sphere
+[[nodiscard]] std::vector<glm::vec3> sample_directions(size_t count, uint64_t seed);
+
+// Points uniformly distributed in the bounding box of the mesh which are inside it, a point is inside when more than
+// half of the rays from it in the given directions first hit a triangle from behind, so the mesh should be closed and
+// consistently oriented with normals pointing outwards
+[[nodiscard]] std::vector<glm::vec3> sample_points_in_volume(std::span<const glm::vec3> vertices,
+                                                             std::span<const unsigned int> indices,
+                                                             std::span<const glm::vec3> triangle_normals,
+                                                             const BVH &triangles_bvh, size_t count_before_filtering,
+                                                             const std::vector<glm::vec3> &ray_directions,
+                                                             uint64_t seed);
@@ -0,0 +1,153 @@
+#include <algorithm> // for std::min and std::max
+#include <cassert>
+#include <memory> // for std::align and std::make_unique_for_overwrite
+
+#include "scratch_arena.hpp"
+
+// Blocks double in size up to the max, so an operation needing n bytes makes O(log n) heap allocations the first time
+constexpr size_t MIN_SCRATCH_BLOCK_SIZE = 64 * 1024;
+constexpr size_t MAX_SCRATCH_BLOCK_SIZE = 4 * 1024 * 1024;
+// Larger allocations go upstream, this also bounds what growing containers leave behind in the arena to about twice
+// this, since their outgrown buffers are only freed by rewinding
+constexpr size_t MAX_SCRATCH_ALLOCATION_SIZE = 1024 * 1024;
+// Capacity kept by a thread once it rewinds to the start, the rest is given back to the heap
+constexpr size_t MAX_RETAINED_SCRATCH_CAPACITY = 4 * 1024 * 1024;
+
+void *Scratch_Arena::do_allocate(size_t num_bytes, size_t alignment) {
+  if (num_bytes > MAX_SCRATCH_ALLOCATION_SIZE) {
+    return std::pmr::new_delete_resource()->allocate(num_bytes, alignment);
+  }
+  while (m_block_index < m_blocks.size()) {
+    Block &block = m_blocks[m_block_index];
+    void *p = block.data.get() + m_offset;
+    size_t space = block.size - m_offset;
+    if (std::align(alignment, num_bytes, p, space)) {
+      m_offset = static_cast<size_t>(static_cast<std::byte *>(p) - block.data.get()) + num_bytes;
+      return p;
+    }
+    // Rest of the block stays unused until rewinding
+    if (m_block_index + 1 == m_blocks.size()) break;
+    m_block_index++;
+    m_offset = 0;
+  }
+
+  size_t block_size =
+      m_blocks.empty() ? MIN_SCRATCH_BLOCK_SIZE : std::min(m_blocks.back().size * 2, MAX_SCRATCH_BLOCK_SIZE);
+  block_size = std::max(block_size, num_bytes + alignment);
+  m_blocks.push_back({std::make_unique_for_overwrite<std::byte[]>(block_size), block_size});
+  m_block_index = m_blocks.size() - 1;
+  m_offset = 0;
+  return do_allocate(num_bytes, alignment);
+}
+
+void Scratch_Arena::do_deallocate(void *p, size_t num_bytes, size_t alignment) {
+  // Containers deallocate with the size they allocated with, so this routes the same way as do_allocate
+  if (num_bytes > MAX_SCRATCH_ALLOCATION_SIZE) std::pmr::new_delete_resource()->deallocate(p, num_bytes, alignment);
+}
+
+void Scratch_Arena::rewind(Marker marker) {
+  assert(marker.block_index < m_blocks.size() || (marker.block_index == 0 && marker.offset == 0));
+  assert(marker.block_index < m_block_index || (marker.block_index == m_block_index && marker.offset <= m_offset));
+  m_block_index = marker.block_index;
+  m_offset = marker.offset;
+  if (marker.block_index == 0 && marker.offset == 0 && m_blocks.size() > 1) {
+    // Next operation of the same size fits in a single block, unless it needed more than is retained
+    size_t capacity = std::min(get_capacity(), MAX_RETAINED_SCRATCH_CAPACITY);
+    m_blocks.clear();
+    m_blocks.push_back({std::make_unique_for_overwrite<std::byte[]>(capacity), capacity});
+  }
+}
+
+size_t Scratch_Arena::get_capacity() const {
+  size_t capacity = 0;
+  for (const Block &block : m_blocks) {
+    capacity += block.size;
+  }
+  return capacity;
+}
+
+Scratch_Arena &Scratch_Arena::get_thread_arena() {
+  thread_local Scratch_Arena arena;
+  return arena;
+}
+
+#ifdef GEOBOX_TEST_SCRATCH_ARENA
+#include <cstdint>
+#include <thread>
+
+#include "testing.hpp"
+
+int main() {
+  Scratch_Arena arena;
+  Scratch_Arena::Marker start = arena.get_marker();
+
+  // Allocations are aligned and do not overlap
+  auto *a = static_cast<std::byte *>(arena.allocate(3, 1));
+  auto *b = static_cast<std::byte *>(arena.allocate(sizeof(double), alignof(double)));
+  auto *c = static_cast<std::byte *>(arena.allocate(100, 64));
+  runtime_assert(reinterpret_cast<uintptr_t>(b) % alignof(double) == 0);
+  runtime_assert(reinterpret_cast<uintptr_t>(c) % 64 == 0);
+  runtime_assert(b >= a + 3 && c >= b + sizeof(double));
+
+  // Rewinding reuses the memory
+  Scratch_Arena::Marker after_a = {0, 3};
+  arena.rewind(after_a);
+  runtime_assert(arena.allocate(sizeof(double), alignof(double)) == b);
+
+  // Allocations larger than a block get their own block, rewinding to the start merges blocks into one
+  void *large = arena.allocate(MIN_SCRATCH_BLOCK_SIZE * 3, 16);
+  void *larger = arena.allocate(MIN_SCRATCH_BLOCK_SIZE * 5, 16);
+  runtime_assert(large != larger);
+  size_t capacity = arena.get_capacity();
+  runtime_assert(capacity >= MIN_SCRATCH_BLOCK_SIZE * 9);
+  arena.rewind(start);
+  runtime_assert(arena.get_capacity() == capacity);
+  void *first = arena.allocate(MIN_SCRATCH_BLOCK_SIZE * 3, 16);
+  void *second = arena.allocate(MIN_SCRATCH_BLOCK_SIZE * 5, 16);
+  runtime_assert(static_cast<std::byte *>(second) == static_cast<std::byte *>(first) + MIN_SCRATCH_BLOCK_SIZE * 3);
+  runtime_assert(arena.get_capacity() == capacity);
+
+  // Large allocations go upstream and do not grow the arena
+  arena.rewind(start);
+  void *huge = arena.allocate(MAX_SCRATCH_ALLOCATION_SIZE + 1, 16);
+  runtime_assert(arena.get_capacity() == capacity);
+  arena.deallocate(huge, MAX_SCRATCH_ALLOCATION_SIZE + 1, 16);
+
+  // Growing containers and many medium allocations go past the retained capacity, which is given back on rewinding
+  for (size_t i = 0; i < 2 * MAX_RETAINED_SCRATCH_CAPACITY / MAX_SCRATCH_ALLOCATION_SIZE; i++) {
+    (void)arena.allocate(MAX_SCRATCH_ALLOCATION_SIZE, 16);
+  }
+  {
+    std::pmr::vector<int> growing(&arena);
+    for (int i = 0; i < 1000000; i++) {
+      growing.push_back(i);
+    }
+    runtime_assert(arena.get_capacity() > MAX_RETAINED_SCRATCH_CAPACITY);
+  }
+  arena.rewind(start);
+  runtime_assert(arena.get_capacity() == MAX_RETAINED_SCRATCH_CAPACITY);
+
+  // Nested scopes rewind the thread arena in order
+  Scratch_Arena &thread_arena = Scratch_Arena::get_thread_arena();
+  {
+    Scratch_Scope outer;
+    std::pmr::vector<int> outer_values({1, 2, 3}, outer.get_resource());
+    Scratch_Arena::Marker marker = thread_arena.get_marker();
+    {
+      Scratch_Scope inner;
+      std::pmr::vector<int> inner_values(1000, 7, inner.get_resource());
+      runtime_assert(thread_arena.get_marker().offset > marker.offset);
+    }
+    runtime_assert(thread_arena.get_marker().block_index == marker.block_index &&
+                   thread_arena.get_marker().offset == marker.offset);
+    runtime_assert(outer_values[2] == 3);
+  }
+  runtime_assert(thread_arena.get_marker().block_index == 0 && thread_arena.get_marker().offset == 0);
+
+  // Each thread has its own arena
+  Scratch_Arena *other_thread_arena = nullptr;
+  std::thread([&other_thread_arena]() { other_thread_arena = &Scratch_Arena::get_thread_arena(); }).join();
+  runtime_assert(other_thread_arena != &thread_arena);
+  return 0;
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <memory> // for std::unique_ptr
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for temporaries of an operation, deallocation is a no-op and memory is given back all at once by
+// rewinding to a marker, blocks up to a retained capacity are kept after rewinding to the start, so once warmed up,
+// operations of similar size make no heap allocations for their small temporaries, large allocations (e.g. whole mesh
+// weld or BVH build buffers) go to the upstream heap and are freed on deallocation, so threads do not keep their peak
+// footprint, not thread-safe, containers using an arena must only grow on the thread that owns it
+class Scratch_Arena final : public std::pmr::memory_resource {
+public:
+  struct Marker {
+    size_t block_index;
+    size_t offset;
+  };
+
+private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+
+  std::vector<Block> m_blocks;
+  // Allocations are made from block m_block_index at m_offset, blocks after it are free
+  size_t m_block_index = 0;
+  size_t m_offset = 0;
+
+  void *do_allocate(size_t num_bytes, size_t alignment) override;
+  void do_deallocate(void *p, size_t num_bytes, size_t alignment) override;
+  [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+public:
+  Scratch_Arena() = default;
+  Scratch_Arena(const Scratch_Arena &) = delete;
+  Scratch_Arena &operator=(const Scratch_Arena &) = delete;
+
+  [[nodiscard]] Marker get_marker() const { return {m_block_index, m_offset}; }
+
+  // Frees everything allocated after the marker was taken, rewinding to the start merges the blocks into one of at most
+  // the retained capacity
+  void rewind(Marker marker);
+
+  [[nodiscard]] size_t get_capacity() const;
+
+  // Arena of the calling thread, shared by every operation running on the thread
+  [[nodiscard]] static Scratch_Arena &get_thread_arena();
+};
+
+// Rewinds the arena of the calling thread when destroyed, so containers allocated from the scope must be destroyed
+// before it (declare the scope first), scopes nest, which also covers tasks run by a thread while it waits
+class Scratch_Scope {
+private:
+  Scratch_Arena &m_arena;
+  Scratch_Arena::Marker m_marker;
+
+public:
+  Scratch_Scope() : m_arena(Scratch_Arena::get_thread_arena()), m_marker(m_arena.get_marker()) {}
+  ~Scratch_Scope() { m_arena.rewind(m_marker); }
+
+  Scratch_Scope(const Scratch_Scope &) = delete;
+  Scratch_Scope &operator=(const Scratch_Scope &) = delete;
+
+  [[nodiscard]] std::pmr::memory_resource *get_resource() const { return &m_arena; }
+};
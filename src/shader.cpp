@@ -1,3 +1,5 @@
+#include <algorithm> // for std::max
+#include <cassert>
 #include <fstream>
 #include <iostream>
 #include <optional>
@@ -9,6 +11,8 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "geobox_exceptions.hpp"
+#include "geometry_pool.hpp"
+#include "render_state.hpp"
 #include "shader.hpp"
 
 static std::optional<std::string> read_file_as_string(const std::string &file_path) {
@@ -19,83 +23,171 @@ static std::optional<std::string> read_file_as_string(const std::string &file_pa
   return std::string(std::istreambuf_iterator(ifs), {});
 }
 
-Shader::Shader(const std::string &vertex_shader_source_path, const std::string &fragment_shader_source_path) {
-  std::optional<std::string> vertex_shader_source = read_file_as_string(vertex_shader_source_path);
-  if (!vertex_shader_source.has_value()) {
-    throw GeoBox_Error("Empty shader file: " + vertex_shader_source_path);
+// Throws GeoBox_Error with the info log on failure, stage_name is for the error message only, the preamble goes after
+// the #version line, which has to come first, followed by a #line directive so errors point at lines of the file
+[[nodiscard]] static unsigned int compile_shader(unsigned int type, const std::string &source_path,
+                                                 const std::string &preamble, const std::string &stage_name) {
+  std::optional<std::string> source = read_file_as_string(source_path);
+  if (!source.has_value()) {
+    throw GeoBox_Error("Empty shader file: " + source_path);
   }
-  std::optional<std::string> fragment_shader_source = read_file_as_string(fragment_shader_source_path);
-  if (!fragment_shader_source.has_value()) {
-    throw GeoBox_Error("Empty shader file: " + fragment_shader_source_path);
+  size_t version_end = source->rfind("#version", 0) == 0 ? source->find('\n') : std::string::npos;
+  if (version_end == std::string::npos) {
+    throw GeoBox_Error("Shader file does not start with a #version line: " + source_path);
   }
-
-  std::vector<char *> vertex_shader_sources = {vertex_shader_source->data()};
-  std::vector<char *> fragment_shader_sources = {fragment_shader_source->data()};
+  std::string version = source->substr(0, version_end + 1);
+  std::string lines = preamble + "\n#line 2\n";
+  std::vector<const char *> sources = {version.c_str(), lines.c_str(), source->c_str() + version_end + 1};
   int success;
 
   int max_info_log_length = 512;
   int actual_info_log_length = 0;
   std::vector<char> info_log(max_info_log_length);
 
-  auto get_info_log_string = [&]() { return std::string(info_log.begin(), info_log.begin() + actual_info_log_length); };
-
-  unsigned int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vertex_shader, (int)vertex_shader_sources.size(), vertex_shader_sources.data(), nullptr);
-  glCompileShader(vertex_shader);
-  glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &success);
+  unsigned int shader = glCreateShader(type);
+  glShaderSource(shader, (int)sources.size(), sources.data(), nullptr);
+  glCompileShader(shader);
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
   if (!success) {
-    glGetShaderInfoLog(vertex_shader, max_info_log_length, &actual_info_log_length, info_log.data());
-    throw GeoBox_Error("ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" + get_info_log_string());
+    glGetShaderInfoLog(shader, max_info_log_length, &actual_info_log_length, info_log.data());
+    glDeleteShader(shader);
+    throw GeoBox_Error("ERROR::SHADER::" + stage_name + "::COMPILATION_FAILED\n" +
+                       std::string(info_log.begin(), info_log.begin() + actual_info_log_length));
   }
+  return shader;
+}
 
-  unsigned int fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragment_shader, (int)fragment_shader_sources.size(), fragment_shader_sources.data(), nullptr);
-  glCompileShader(fragment_shader);
-  glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(fragment_shader, max_info_log_length, &actual_info_log_length, info_log.data());
-    throw GeoBox_Error("ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" + get_info_log_string());
+Shader::Shader(const std::string &vertex_shader_source_path, const std::string &fragment_shader_source_path)
+    : Shader(vertex_shader_source_path, std::nullopt, fragment_shader_source_path) {}
+
+Shader::Shader(const std::string &vertex_shader_source_path,
+               const std::optional<std::string> &geometry_shader_source_path,
+               const std::string &fragment_shader_source_path) {
+  // Constants shared with the C++ side are defined ahead of the preamble rather than repeated in it
+  std::string preamble = "#define DRAW_DATA_NUM_TEXELS " + std::to_string(DRAW_DATA_NUM_TEXELS) + "\n" +
+                         read_file_as_string(SHADER_PREAMBLE_PATH).value();
+  std::vector<unsigned int> shaders;
+  // Stages compiled before a failing one would otherwise leak
+  try {
+    shaders.push_back(compile_shader(GL_VERTEX_SHADER, vertex_shader_source_path, preamble, "VERTEX"));
+    if (geometry_shader_source_path.has_value()) {
+      shaders.push_back(compile_shader(GL_GEOMETRY_SHADER, geometry_shader_source_path.value(), preamble, "GEOMETRY"));
+    }
+    shaders.push_back(compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source_path, preamble, "FRAGMENT"));
+  } catch (...) {
+    for (unsigned int shader : shaders) {
+      glDeleteShader(shader);
+    }
+    throw;
   }
 
+  int success;
+  int max_info_log_length = 512;
+  int actual_info_log_length = 0;
+  std::vector<char> info_log(max_info_log_length);
+
   m_shader_program = glCreateProgram();
-  glAttachShader(m_shader_program, vertex_shader);
-  glAttachShader(m_shader_program, fragment_shader);
+  for (unsigned int shader : shaders) {
+    glAttachShader(m_shader_program, shader);
+  }
   glLinkProgram(m_shader_program);
+  for (unsigned int shader : shaders) {
+    glDeleteShader(shader);
+  }
   glGetProgramiv(m_shader_program, GL_LINK_STATUS, &success);
   if (!success) {
     glGetProgramInfoLog(m_shader_program, max_info_log_length, &actual_info_log_length, info_log.data());
-    throw GeoBox_Error("ERROR::SHADER::PROGRAM::LINK_FAILED\n" + get_info_log_string());
+    glDeleteProgram(m_shader_program);
+    throw GeoBox_Error("ERROR::SHADER::PROGRAM::LINK_FAILED\n" +
+                       std::string(info_log.begin(), info_log.begin() + actual_info_log_length));
   }
 
-  glDeleteShader(vertex_shader);
-  glDeleteShader(fragment_shader);
+  unsigned int frame_uniforms_block_index = glGetUniformBlockIndex(m_shader_program, FRAME_UNIFORMS_BLOCK_NAME);
+  if (frame_uniforms_block_index != GL_INVALID_INDEX) {
+    glUniformBlockBinding(m_shader_program, frame_uniforms_block_index, FRAME_UNIFORMS_BINDING);
+  }
+  int draw_data_sampler_location = glGetUniformLocation(m_shader_program, DRAW_DATA_SAMPLER_NAME);
+  if (draw_data_sampler_location != -1) {
+    Render_State::get().use_program(m_shader_program);
+    glUniform1i(draw_data_sampler_location, DRAW_DATA_TEXTURE_UNIT);
+  }
+  resolve_uniform_bindings();
 }
 
-Shader::~Shader() { glDeleteProgram(m_shader_program); }
+Shader::~Shader() { Render_State::get().delete_program(m_shader_program); }
+
+void Shader::use() const { Render_State::get().use_program(m_shader_program); }
+
+void Shader::resolve_uniform_bindings() {
+  int num_uniforms = 0;
+  int max_name_length = 0;
+  glGetProgramiv(m_shader_program, GL_ACTIVE_UNIFORMS, &num_uniforms);
+  glGetProgramiv(m_shader_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+  std::vector<char> name(static_cast<size_t>(std::max(max_name_length, 1)));
+  for (int i = 0; i < num_uniforms; i++) {
+    int name_length = 0;
+    int size = 0;
+    unsigned int type = 0;
+    glGetActiveUniform(m_shader_program, static_cast<unsigned int>(i), max_name_length, &name_length, &size, &type,
+                       name.data());
+    // Members of uniform blocks have no location, they are set through the block's buffer
+    int location = glGetUniformLocation(m_shader_program, name.data());
+    if (location == -1) continue;
+    m_uniform_bindings.push_back({std::string(name.data(), static_cast<size_t>(name_length)), location, type});
+  }
+}
+
+// GL type of uniforms settable from T
+template <typename T> [[nodiscard]] static unsigned int get_uniform_type();
+
+template <> unsigned int get_uniform_type<float>() { return GL_FLOAT; }
+
+template <> unsigned int get_uniform_type<glm::vec3>() { return GL_FLOAT_VEC3; }
+
+template <> unsigned int get_uniform_type<glm::mat3>() { return GL_FLOAT_MAT3; }
 
-void Shader::use() const { glUseProgram(m_shader_program); }
+template <> unsigned int get_uniform_type<glm::mat4>() { return GL_FLOAT_MAT4; }
 
-int Shader::get_uniform_location(std::string_view uniform_name) const {
-  return glGetUniformLocation(m_shader_program, uniform_name.data());
+template <typename T> Uniform<T> Shader::get_uniform(std::string_view uniform_name) const {
+  for (const Uniform_Binding &binding : m_uniform_bindings) {
+    if (binding.name != uniform_name) continue;
+    if (binding.type != get_uniform_type<T>()) {
+      throw GeoBox_Error("Uniform " + binding.name + " has a different type");
+    }
+    return Uniform<T>(binding.location);
+  }
+  return Uniform<T>();
+}
+
+template Uniform<float> Shader::get_uniform(std::string_view uniform_name) const;
+template Uniform<glm::vec3> Shader::get_uniform(std::string_view uniform_name) const;
+template Uniform<glm::mat3> Shader::get_uniform(std::string_view uniform_name) const;
+template Uniform<glm::mat4> Shader::get_uniform(std::string_view uniform_name) const;
+
+template <> void Uniform<float>::set(const float &value) const { glUniform1f(m_location, value); }
+
+template <> void Uniform<glm::vec3>::set(const glm::vec3 &value) const {
+  glUniform3f(m_location, value.x, value.y, value.z);
 }
 
-template <typename T> std::function<void(const T &)> Shader::get_uniform_setter(std::string_view /*uniform_name*/) {
-  throw GeoBox_Error("Not implemented");
+template <> void Uniform<glm::mat3>::set(const glm::mat3 &value) const {
+  glUniformMatrix3fv(m_location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-template <> std::function<void(const glm::vec3 &)> Shader::get_uniform_setter(std::string_view uniform_name) {
-  int uniform_location = get_uniform_location(uniform_name);
-  return [uniform_location](const glm::vec3 &v) { glUniform3f(uniform_location, v.x, v.y, v.z); };
+template <> void Uniform<glm::mat4>::set(const glm::mat4 &value) const {
+  glUniformMatrix4fv(m_location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-template <> std::function<void(const glm::mat4 &)> Shader::get_uniform_setter(std::string_view uniform_name) {
-  int uniform_location = get_uniform_location(uniform_name);
-  return
-      [uniform_location](const glm::mat4 &m) { glUniformMatrix4fv(uniform_location, 1, GL_FALSE, glm::value_ptr(m)); };
+Uniform_Buffer::Uniform_Buffer(size_t size, unsigned int binding) : m_size(size) {
+  glGenBuffers(1, &m_buffer_object);
+  Render_State::get().bind_buffer_base(GL_UNIFORM_BUFFER, binding, m_buffer_object);
+  glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_DYNAMIC_DRAW);
 }
 
-template <> std::function<void(const glm::mat3 &)> Shader::get_uniform_setter(std::string_view uniform_name) {
-  int uniform_location = get_uniform_location(uniform_name);
-  return
-      [uniform_location](const glm::mat3 &m) { glUniformMatrix3fv(uniform_location, 1, GL_FALSE, glm::value_ptr(m)); };
+Uniform_Buffer::~Uniform_Buffer() { Render_State::get().delete_buffer(m_buffer_object); }
+
+void Uniform_Buffer::update(const void *data, size_t size) {
+  assert(size == m_size);
+  Render_State::get().bind_buffer(GL_UNIFORM_BUFFER, m_buffer_object);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
 }
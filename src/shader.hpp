@@ -1,21 +1,107 @@
 #pragma once
 
-#include <functional>
+#include <cstddef>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Uniform block shared by all shaders, updated once per frame into a uniform buffer bound at FRAME_UNIFORMS_BINDING
+constexpr const char *FRAME_UNIFORMS_BLOCK_NAME = "Frame_Uniforms";
+constexpr unsigned int FRAME_UNIFORMS_BINDING = 0;
+
+// Inserted after the #version line of every shader source, declares the Frame_Uniforms block and the wireframe
+// functions
+constexpr const char *SHADER_PREAMBLE_PATH = "resources/shaders/preamble.glsl";
+
+// Texture buffer of per object Draw_Data (see geometry_pool.hpp), its sampler is bound to DRAW_DATA_TEXTURE_UNIT
+constexpr const char *DRAW_DATA_SAMPLER_NAME = "draw_data";
+constexpr int DRAW_DATA_TEXTURE_UNIT = 0;
+
+// Matches the std140 layout of the Frame_Uniforms block in the shader preamble, where vec3s take 16 bytes
+struct Frame_Uniforms {
+  glm::mat4 view_matrix;
+  glm::mat4 projection_matrix;
+  glm::vec3 camera_position;
+  float padding0 = 0.0f;
+  glm::vec3 light_color;
+  // In pixels, no wireframe is drawn over the surfaces when zero
+  float wireframe_width = 0.0f;
+  // In pixels, for measuring distances to triangle edges in screen space
+  glm::vec2 viewport_size;
+  glm::vec2 padding1{0.0f};
+};
+static_assert(sizeof(Frame_Uniforms) == 176, "Frame_Uniforms must match the std140 layout of the shaders");
+
+// Location of a uniform of a linked program, setting it is a single GL call on the program in use, uniforms the
+// program does not use have location -1, which GL ignores
+template <typename T> class Uniform {
+private:
+  int m_location = -1;
+
+public:
+  Uniform() = default;
+  explicit Uniform(int location) : m_location(location) {}
+
+  [[nodiscard]] bool is_active() const { return m_location != -1; }
+
+  void set(const T &value) const;
+};
+
+template <> void Uniform<float>::set(const float &value) const;
+template <> void Uniform<glm::vec3>::set(const glm::vec3 &value) const;
+template <> void Uniform<glm::mat3>::set(const glm::mat3 &value) const;
+template <> void Uniform<glm::mat4>::set(const glm::mat4 &value) const;
 
 class Shader {
 private:
+  struct Uniform_Binding {
+    std::string name;
+    int location;
+    unsigned int type;
+  };
+
   unsigned int m_shader_program;
-  [[nodiscard]] int get_uniform_location(std::string_view uniform_name) const;
+  // Active uniforms, resolved once after linking
+  std::vector<Uniform_Binding> m_uniform_bindings;
+
+  void resolve_uniform_bindings();
 
 public:
   // Disable copy
   Shader(const Shader &) = delete;
   Shader &operator=(const Shader &) = delete;
 
+  // Frame_Uniforms blocks of the sources are bound to FRAME_UNIFORMS_BINDING, draw_data samplers to
+  // DRAW_DATA_TEXTURE_UNIT
   Shader(const std::string &vertex_source_path, const std::string &fragment_source_path);
+  Shader(const std::string &vertex_source_path, const std::optional<std::string> &geometry_source_path,
+         const std::string &fragment_source_path);
   ~Shader();
   void use() const;
-  template <typename T> [[nodiscard]] std::function<void(const T &)> get_uniform_setter(std::string_view uniform_name);
+  // Looked up in the binding table, so call once and keep the result, throws GeoBox_Error if the uniform is active
+  // with a different type
+  template <typename T> [[nodiscard]] Uniform<T> get_uniform(std::string_view uniform_name) const;
+};
+
+// Buffer backing a uniform block at a binding point
+class Uniform_Buffer {
+private:
+  unsigned int m_buffer_object = 0;
+  size_t m_size;
+
+public:
+  // Buffer is deleted in destructor,
+  // avoid double delete by disabling copy constructor and copy assignment operator
+  Uniform_Buffer(const Uniform_Buffer &) = delete;
+  Uniform_Buffer &operator=(const Uniform_Buffer &) = delete;
+
+  Uniform_Buffer(size_t size, unsigned int binding);
+  ~Uniform_Buffer();
+
+  void update(const void *data, size_t size);
+
+  template <typename T> void update(const T &data) { update(&data, sizeof(T)); }
 };
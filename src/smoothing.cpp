@@ -0,0 +1,129 @@
+#include <cassert>
+#include <utility> // for std::swap
+#include <vector>
+
+#include "parallel.hpp"
+#include "smoothing.hpp"
+
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 8192;
+
+namespace {
+// Structure of arrays vertex positions, so per-component loops can be vectorized
+struct Vertex_Positions_SoA {
+  std::vector<float> x, y, z;
+
+  explicit Vertex_Positions_SoA(size_t num_vertices) : x(num_vertices), y(num_vertices), z(num_vertices) {}
+};
+} // namespace
+
+// Moves every vertex by factor * (average of neighbours - vertex), reading from source and writing to destination
+static void smoothing_step(const Vertex_Positions_SoA &source, Vertex_Positions_SoA &destination,
+                           const Vertex_Adjacency &adjacency, float factor) {
+  parallel_for(0, adjacency.num_vertices(), MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    const float *sx = source.x.data();
+    const float *sy = source.y.data();
+    const float *sz = source.z.data();
+    for (size_t v = begin; v < end; v++) {
+      unsigned int first = adjacency.offsets[v];
+      unsigned int last = adjacency.offsets[v + 1];
+      if (first == last) {
+        // Isolated vertex
+        destination.x[v] = sx[v];
+        destination.y[v] = sy[v];
+        destination.z[v] = sz[v];
+        continue;
+      }
+      float ax = 0.0f;
+      float ay = 0.0f;
+      float az = 0.0f;
+      for (unsigned int i = first; i < last; i++) {
+        unsigned int n = adjacency.neighbours[i];
+        ax += sx[n];
+        ay += sy[n];
+        az += sz[n];
+      }
+      float weight = 1.0f / static_cast<float>(last - first);
+      destination.x[v] = sx[v] + factor * (ax * weight - sx[v]);
+      destination.y[v] = sy[v] + factor * (ay * weight - sy[v]);
+      destination.z[v] = sz[v] + factor * (az * weight - sz[v]);
+    }
+  });
+}
+
+std::vector<glm::vec3> smooth(std::span<const glm::vec3> vertices, const Vertex_Adjacency &adjacency,
+                              const Smoothing_Settings &settings) {
+  assert(adjacency.num_vertices() == vertices.size());
+  size_t num_vertices = vertices.size();
+
+  // Double buffered, each step reads the previous positions of all neighbours
+  Vertex_Positions_SoA front(num_vertices);
+  Vertex_Positions_SoA back(num_vertices);
+  parallel_for(0, num_vertices, MIN_PARALLEL_CHUNK_SIZE, [&front, &vertices](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      front.x[v] = vertices[v].x;
+      front.y[v] = vertices[v].y;
+      front.z[v] = vertices[v].z;
+    }
+  });
+
+  for (unsigned int i = 0; i < settings.num_iterations; i++) {
+    smoothing_step(front, back, adjacency, settings.lambda);
+    std::swap(front, back);
+    if (settings.method == Smoothing_Method::Taubin) {
+      smoothing_step(front, back, adjacency, settings.mu);
+      std::swap(front, back);
+    }
+  }
+
+  std::vector<glm::vec3> result(num_vertices);
+  parallel_for(0, num_vertices, MIN_PARALLEL_CHUNK_SIZE, [&front, &result](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      result[v] = {front.x[v], front.y[v], front.z[v]};
+    }
+  });
+  return result;
+}
+
+#ifdef GEOBOX_TEST_SMOOTHING
+#include <glm/geometric.hpp>
+
+#include "math.hpp"
+#include "testing.hpp"
+
+int main() {
+  Tolerance_Context tc(1e-9f, 1e-4f);
+
+  // Octahedron, every vertex has 4 neighbours whose average is the origin
+  std::vector<glm::vec3> vertices = {
+      {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+  };
+  std::vector<unsigned int> indices = {
+      0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5,
+  };
+  Vertex_Adjacency adjacency = build_vertex_adjacency(vertices.size(), indices);
+  runtime_assert(adjacency.num_vertices() == vertices.size());
+  for (size_t v = 0; v < vertices.size(); v++) {
+    runtime_assert(adjacency.offsets[v + 1] - adjacency.offsets[v] == 4);
+  }
+
+  // Laplacian smoothing shrinks every vertex towards the origin by lambda
+  Smoothing_Settings laplacian{.method = Smoothing_Method::Laplacian, .num_iterations = 1, .lambda = 0.5f};
+  for (const glm::vec3 &v : smooth(vertices, adjacency, laplacian)) {
+    runtime_assert(is_close(tc, glm::length(v), 0.5f));
+  }
+
+  // Taubin smoothing inflates after shrinking, 0.5 - 0.53 * (0 - 0.5)
+  Smoothing_Settings taubin{.method = Smoothing_Method::Taubin, .num_iterations = 1, .lambda = 0.5f, .mu = -0.53f};
+  for (const glm::vec3 &v : smooth(vertices, adjacency, taubin)) {
+    runtime_assert(is_close(tc, glm::length(v), 0.765f));
+  }
+
+  // Zero iterations is the identity
+  laplacian.num_iterations = 0;
+  std::vector<glm::vec3> unchanged = smooth(vertices, adjacency, laplacian);
+  for (size_t v = 0; v < vertices.size(); v++) {
+    runtime_assert(unchanged[v] == vertices[v]);
+  }
+  return 0;
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "vertex_adjacency.hpp"
+
+enum class Smoothing_Method { Laplacian, Taubin };
+
+constexpr float DEFAULT_SMOOTHING_LAMBDA = 0.5f;
+// Taubin's shrink compensation factor, negative and slightly larger in magnitude than lambda
+constexpr float DEFAULT_SMOOTHING_MU = -0.53f;
+
+struct Smoothing_Settings {
+  Smoothing_Method method = Smoothing_Method::Laplacian;
+  unsigned int num_iterations = 1;
+  float lambda = DEFAULT_SMOOTHING_LAMBDA;
+  // Only used by Taubin smoothing
+  float mu = DEFAULT_SMOOTHING_MU;
+};
+
+// Uniform (umbrella operator) Laplacian smoothing,
+// Taubin smoothing alternates a shrinking lambda step with an inflating mu step to avoid shrinkage
+// https://doi.org/10.1145/218380.218473
+[[nodiscard]] std::vector<glm::vec3> smooth(std::span<const glm::vec3> vertices, const Vertex_Adjacency &adjacency,
+                                            const Smoothing_Settings &settings);
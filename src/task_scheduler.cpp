@@ -0,0 +1,288 @@
+#include <algorithm> // for std::max
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory> // for std::make_unique
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility> // for std::move
+
+#include "parallel.hpp"
+#include "task_scheduler.hpp"
+
+constexpr size_t NOT_A_WORKER = std::numeric_limits<size_t>::max();
+
+// Deques of the calling thread if it is a worker
+static thread_local size_t t_worker_index = NOT_A_WORKER;
+static thread_local Task_Priority t_current_priority = Task_Priority::Interactive;
+
+Task_Scheduler::Task_Scheduler(size_t num_workers) {
+  for (size_t i = 0; i < num_workers + 1; i++) {
+    m_deques.push_back(std::make_unique<Task_Deques>());
+  }
+  m_threads.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; i++) {
+    m_threads.emplace_back([this, i](const std::stop_token &stop_token) { work(i, stop_token); });
+  }
+}
+
+Task_Scheduler &Task_Scheduler::get() {
+  // At least one worker, so background work submitted by the main thread runs even on a single core
+  static Task_Scheduler scheduler(std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t(2)) - 1);
+  return scheduler;
+}
+
+Task_Priority Task_Scheduler::get_current_priority() { return t_current_priority; }
+
+void Task_Scheduler::set_max_concurrency(size_t max_concurrency) {
+  {
+    std::lock_guard lock(m_sleep_mutex);
+    m_max_concurrency.store(std::max(max_concurrency, static_cast<size_t>(1)), std::memory_order_relaxed);
+  }
+  m_sleep_condition.notify_all();
+}
+
+void Task_Scheduler::submit(Task task, Task_Priority priority) {
+  // Without workers, tasks only run when someone waits on them
+  size_t deques_index = (t_worker_index == NOT_A_WORKER) ? m_threads.size() : t_worker_index;
+  {
+    std::lock_guard lock(m_deques[deques_index]->mutex);
+    m_deques[deques_index]->tasks[static_cast<size_t>(priority)].push_back(std::move(task));
+  }
+  {
+    std::lock_guard lock(m_sleep_mutex);
+    m_num_queued_tasks.fetch_add(1, std::memory_order_relaxed);
+  }
+  // A sleeping worker beyond the concurrency limit would go back to sleep, taking the notification with it
+  if (m_max_concurrency.load(std::memory_order_relaxed) <= m_threads.size()) {
+    m_sleep_condition.notify_all();
+  } else {
+    m_sleep_condition.notify_one();
+  }
+}
+
+bool Task_Scheduler::try_pop_task(Task_Priority lowest_priority, Task &task, Task_Priority &priority) {
+  size_t num_deques = m_deques.size();
+  size_t own_index = (t_worker_index == NOT_A_WORKER) ? m_threads.size() : t_worker_index;
+  for (size_t p = 0; p <= static_cast<size_t>(lowest_priority); p++) {
+    // Own newest task first, its data is most likely still in cache, then the oldest tasks of everyone else, which
+    // tend to be the largest
+    for (size_t k = 0; k < num_deques; k++) {
+      Task_Deques &deques = *m_deques[(own_index + k) % num_deques];
+      std::lock_guard lock(deques.mutex);
+      std::deque<Task> &tasks = deques.tasks[p];
+      if (tasks.empty()) continue;
+      if (k == 0) {
+        task = std::move(tasks.back());
+        tasks.pop_back();
+      } else {
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      priority = static_cast<Task_Priority>(p);
+      m_num_queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Task_Scheduler::run_task(Task &task, Task_Priority priority) {
+  Task_Priority previous_priority = t_current_priority;
+  t_current_priority = priority;
+  task();
+  t_current_priority = previous_priority;
+}
+
+bool Task_Scheduler::try_run_task(Task_Priority lowest_priority) {
+  Task task;
+  Task_Priority priority;
+  if (!try_pop_task(lowest_priority, task, priority)) return false;
+  run_task(task, priority);
+  return true;
+}
+
+void Task_Scheduler::work(size_t worker_index, const std::stop_token &stop_token) {
+  t_worker_index = worker_index;
+  while (true) {
+    Task task;
+    Task_Priority priority;
+    if (is_worker_active(worker_index) && try_pop_task(Task_Priority::Background, task, priority)) {
+      run_task(task, priority);
+      continue;
+    }
+    std::unique_lock lock(m_sleep_mutex);
+    if (!m_sleep_condition.wait(lock, stop_token, [this, worker_index]() {
+          return is_worker_active(worker_index) && m_num_queued_tasks.load(std::memory_order_relaxed) > 0;
+        })) {
+      return;
+    }
+  }
+}
+
+Task_Group::~Task_Group() {
+  while (m_num_pending_tasks.load(std::memory_order_acquire) > 0) {
+    if (!m_scheduler.try_run_task(m_priority)) std::this_thread::yield();
+  }
+}
+
+void Task_Group::run(std::function<void()> task) {
+  m_num_pending_tasks.fetch_add(1, std::memory_order_relaxed);
+  m_scheduler.submit(
+      [this, task = std::move(task)]() {
+        try {
+          task();
+        } catch (...) {
+          std::lock_guard lock(m_exception_mutex);
+          if (!m_exception) m_exception = std::current_exception();
+        }
+        m_num_pending_tasks.fetch_sub(1, std::memory_order_release);
+      },
+      m_priority);
+}
+
+void Task_Group::wait() {
+  while (m_num_pending_tasks.load(std::memory_order_acquire) > 0) {
+    // Tasks of the group still running elsewhere leave nothing to help with
+    if (!m_scheduler.try_run_task(m_priority)) std::this_thread::yield();
+  }
+  if (m_exception) {
+    std::exception_ptr exception = m_exception;
+    m_exception = nullptr;
+    std::rethrow_exception(exception);
+  }
+}
+
+#ifdef GEOBOX_TEST_TASK_SCHEDULER
+#include <chrono>
+#include <numeric> // for std::iota and std::accumulate
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "testing.hpp"
+
+// Recursive fork-join, every level waits on a group of its own from inside a task
+static uint64_t sum_range(Task_Scheduler &scheduler, uint64_t begin, uint64_t end) {
+  if (end - begin <= 1000) {
+    uint64_t sum = 0;
+    for (uint64_t i = begin; i < end; i++) {
+      sum += i;
+    }
+    return sum;
+  }
+  uint64_t middle = begin + (end - begin) / 2;
+  uint64_t left = 0;
+  Task_Group task_group(Task_Scheduler::get_current_priority(), scheduler);
+  task_group.run([&]() { left = sum_range(scheduler, begin, middle); });
+  uint64_t right = sum_range(scheduler, middle, end);
+  task_group.wait();
+  return left + right;
+}
+
+int main() {
+  {
+    Task_Scheduler scheduler(4);
+    runtime_assert(scheduler.get_num_workers() == 4);
+    runtime_assert(sum_range(scheduler, 0, 1000000) == uint64_t(1000000) * 999999 / 2);
+
+    // First exception is rethrown by wait, the other tasks still run
+    std::atomic<int> num_runs = 0;
+    Task_Group task_group(Task_Priority::Interactive, scheduler);
+    for (int i = 0; i < 100; i++) {
+      task_group.run([&num_runs, i]() {
+        num_runs++;
+        if (i % 10 == 0) throw std::runtime_error("failed");
+      });
+    }
+    bool has_thrown = false;
+    try {
+      task_group.wait();
+    } catch (const std::runtime_error &) {
+      has_thrown = true;
+    }
+    runtime_assert(has_thrown && num_runs == 100);
+
+    // Background tasks run without anyone waiting on them
+    std::atomic<bool> is_done = false;
+    scheduler.submit([&is_done]() { is_done = true; }, Task_Priority::Background);
+    while (!is_done) {
+      std::this_thread::yield();
+    }
+
+    // Limited concurrency counts the waiting thread
+    scheduler.set_max_concurrency(2);
+    std::atomic<int> num_running = 0;
+    std::atomic<int> max_num_running = 0;
+    Task_Group limited_group(Task_Priority::Interactive, scheduler);
+    for (int i = 0; i < 50; i++) {
+      limited_group.run([&]() {
+        int n = ++num_running;
+        int max = max_num_running;
+        while (n > max && !max_num_running.compare_exchange_weak(max, n)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        num_running--;
+      });
+    }
+    limited_group.wait();
+    runtime_assert(max_num_running >= 1 && max_num_running <= 2);
+    scheduler.set_max_concurrency(std::numeric_limits<size_t>::max());
+  }
+
+  // Waiting on interactive work never picks up background work, waiting on background work picks up both
+  {
+    Task_Scheduler scheduler(0);
+    bool is_background_done = false;
+    bool is_interactive_done = false;
+    scheduler.submit([&]() { is_background_done = true; }, Task_Priority::Background);
+    Task_Group interactive_group(Task_Priority::Interactive, scheduler);
+    interactive_group.run([&]() {
+      is_interactive_done = true;
+      runtime_assert(Task_Scheduler::get_current_priority() == Task_Priority::Interactive);
+    });
+    interactive_group.wait();
+    runtime_assert(is_interactive_done && !is_background_done);
+    Task_Group background_group(Task_Priority::Background, scheduler);
+    background_group.run([]() { runtime_assert(Task_Scheduler::get_current_priority() == Task_Priority::Background); });
+    background_group.wait();
+    while (scheduler.try_run_task(Task_Priority::Background)) {
+    }
+    runtime_assert(is_background_done);
+  }
+
+  // Parallel loops on the shared scheduler, reduction is in chunk order
+  std::vector<uint64_t> values(1000000);
+  std::iota(values.begin(), values.end(), 0);
+  auto sum_chunk = [&values](size_t begin, size_t end) {
+    return std::accumulate(values.begin() + static_cast<ptrdiff_t>(begin), values.begin() + static_cast<ptrdiff_t>(end),
+                           uint64_t(0));
+  };
+  uint64_t sum = parallel_reduce(0, values.size(), 1000, uint64_t(0), sum_chunk,
+                                 [](uint64_t a, uint64_t b) { return a + b; });
+  runtime_assert(sum == uint64_t(1000000) * 999999 / 2);
+  std::vector<std::string> words = {"a", "b", "c", "d", "e", "f", "g", "h"};
+  std::string concatenated = parallel_reduce(
+      0, words.size(), 1, std::string(),
+      [&words](size_t begin, size_t end) {
+        std::string chunk;
+        for (size_t i = begin; i < end; i++) {
+          chunk += words[i];
+        }
+        return chunk;
+      },
+      [](std::string a, std::string b) { return a + b; });
+  runtime_assert(concatenated == "abcdefgh");
+
+  // Chunks are split by the given count rather than the current concurrency, more chunks than items leaves some empty
+  std::vector<size_t> chunk_sizes(5, 0);
+  parallel_for_chunks(3, chunk_sizes.size(), [&chunk_sizes](size_t chunk_index, size_t begin, size_t end) {
+    runtime_assert(begin <= end && end <= 3);
+    chunk_sizes[chunk_index] = end - begin;
+  });
+  runtime_assert(chunk_sizes == std::vector<size_t>({1, 1, 1, 0, 0}));
+  return 0;
+}
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception> // for std::exception_ptr
+#include <functional> // for std::function
+#include <limits>
+#include <memory> // for std::unique_ptr
+#include <mutex>
+#include <thread> // for std::jthread
+#include <vector>
+
+// Interactive work (e.g. an operation the user is waiting for) is always picked before background work (e.g. loading
+// files), tasks forked by a task inherit its priority
+enum class Task_Priority { Interactive, Background };
+constexpr size_t NUM_TASK_PRIORITIES = 2;
+
+// Work-stealing thread pool shared by every parallel operation, so features running at the same time split the cores
+// instead of each starting its own threads, each worker pushes and pops its own tasks at the back of its deques and
+// steals from the front of other deques when its own are empty, tasks submitted by other threads go to a shared deque
+class Task_Scheduler {
+public:
+  using Task = std::function<void()>;
+
+private:
+  struct Task_Deques {
+    std::mutex mutex;
+    std::deque<Task> tasks[NUM_TASK_PRIORITIES];
+  };
+
+  // One per worker, followed by the one shared by threads that are not workers
+  std::vector<std::unique_ptr<Task_Deques>> m_deques;
+  // Signed, decremented by whoever pops a task, which can happen before the submitter increments it
+  std::atomic<int64_t> m_num_queued_tasks = 0;
+  std::atomic<size_t> m_max_concurrency = std::numeric_limits<size_t>::max();
+  std::mutex m_sleep_mutex;
+  std::condition_variable_any m_sleep_condition;
+  // Started last and joined first, since workers use everything above
+  std::vector<std::jthread> m_threads;
+
+  [[nodiscard]] bool try_pop_task(Task_Priority lowest_priority, Task &task, Task_Priority &priority);
+  void run_task(Task &task, Task_Priority priority);
+  void work(size_t worker_index, const std::stop_token &stop_token);
+  [[nodiscard]] bool is_worker_active(size_t worker_index) const {
+    return worker_index + 1 < m_max_concurrency.load(std::memory_order_relaxed);
+  }
+
+public:
+  explicit Task_Scheduler(size_t num_workers);
+  ~Task_Scheduler() = default;
+
+  Task_Scheduler(const Task_Scheduler &) = delete;
+  Task_Scheduler &operator=(const Task_Scheduler &) = delete;
+
+  // Shared by the whole app, with a worker per hardware thread except the one calling it, which helps while waiting
+  [[nodiscard]] static Task_Scheduler &get();
+
+  [[nodiscard]] size_t get_num_workers() const { return m_threads.size(); }
+
+  // Limits the threads running tasks at once, the waiting thread counting as one, workers beyond the limit sleep,
+  // meant for measuring scaling, since with a limit of one, background work only runs when waited on
+  void set_max_concurrency(size_t max_concurrency);
+
+  [[nodiscard]] size_t get_max_concurrency() const { return m_max_concurrency.load(std::memory_order_relaxed); }
+
+  // Priority of the task running on the calling thread, interactive for threads not running a task
+  [[nodiscard]] static Task_Priority get_current_priority();
+
+  void submit(Task task, Task_Priority priority);
+
+  // Runs one queued task of at least the given priority, for threads waiting on other tasks, false if there was none,
+  // waiting on interactive work never picks up background work, which could take much longer than the wait
+  bool try_run_task(Task_Priority lowest_priority);
+};
+
+// Fork-join group of tasks, waiting runs queued tasks instead of blocking, so tasks can wait on groups of their own
+// without tying up workers, the first exception thrown by a task of the group is rethrown by wait
+class Task_Group {
+private:
+  Task_Scheduler &m_scheduler;
+  Task_Priority m_priority;
+  std::atomic<size_t> m_num_pending_tasks = 0;
+  std::mutex m_exception_mutex;
+  std::exception_ptr m_exception;
+
+public:
+  explicit Task_Group(Task_Priority priority = Task_Scheduler::get_current_priority(),
+                      Task_Scheduler &scheduler = Task_Scheduler::get())
+      : m_scheduler(scheduler), m_priority(priority) {}
+  // Tasks refer to the group, so it waits for them, swallowing their exceptions if wait was not called
+  ~Task_Group();
+
+  Task_Group(const Task_Group &) = delete;
+  Task_Group &operator=(const Task_Group &) = delete;
+
+  void run(std::function<void()> task);
+
+  void wait();
+};
@@ -1,7 +1,41 @@
 #pragma once
 
 #include <cstdlib>
+#include <map>
+#include <utility> // for std::pair
+
+#include <glm/geometric.hpp> // for glm::dot and glm::cross
+
+#include "indexed_triangle_mesh.hpp"
 
 void runtime_assert(bool value) {
   if (!value) std::abort();
 }
+
+// Closed and consistently oriented, every directed edge is matched by exactly one opposite directed edge
+[[nodiscard]] bool is_watertight(const Indexed_Triangle_Mesh &mesh) {
+  std::map<std::pair<unsigned int, unsigned int>, int> directed_edges;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    for (size_t j = 0; j < 3; j++) {
+      directed_edges[{mesh.indices[i + j], mesh.indices[i + (j + 1) % 3]}]++;
+    }
+  }
+  for (const auto &[edge, count] : directed_edges) {
+    auto it = directed_edges.find({edge.second, edge.first});
+    if (count != 1 || it == directed_edges.end() || it->second != 1) return false;
+  }
+  return true;
+}
+
+// Of a watertight mesh with outward facing triangles
+// https://en.wikipedia.org/w/index.php?title=Polyhedron&oldid=1218744446#Volume
+[[nodiscard]] float calc_volume(const Indexed_Triangle_Mesh &mesh) {
+  float volume = 0.0f;
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    const glm::vec3 &a = mesh.vertices[mesh.indices[i + 0]];
+    const glm::vec3 &b = mesh.vertices[mesh.indices[i + 1]];
+    const glm::vec3 &c = mesh.vertices[mesh.indices[i + 2]];
+    volume += glm::dot(a, glm::cross(b, c)) / 6.0f;
+  }
+  return volume;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <charconv> // for std::from_chars
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <system_error> // for std::errc
+
+[[nodiscard]] inline bool is_whitespace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// Cursor over whitespace separated tokens of a text file,
+// numbers are parsed with std::from_chars, which is locale independent unlike reading from streams
+struct Text_Cursor {
+  const char *current;
+  const char *end;
+
+  [[nodiscard]] bool is_at_end() const { return current == end; }
+
+  void skip_whitespace() {
+    while (current != end && is_whitespace(*current)) current++;
+  }
+
+  // Skips whitespace other than line breaks, for line based formats
+  void skip_spaces() {
+    while (current != end && is_whitespace(*current) && *current != '\n') current++;
+  }
+
+  // Moves past the next line break
+  void skip_line() {
+    while (current != end && *current != '\n') current++;
+    if (current != end) current++;
+  }
+
+  [[nodiscard]] bool is_at_line_end() {
+    skip_spaces();
+    return current == end || *current == '\n';
+  }
+
+  // Next token on the current line, empty at the end of the line
+  [[nodiscard]] std::string_view read_token() {
+    skip_spaces();
+    const char *token_begin = current;
+    while (current != end && !is_whitespace(*current)) current++;
+    return {token_begin, static_cast<size_t>(current - token_begin)};
+  }
+
+  [[nodiscard]] bool expect(std::string_view keyword) {
+    skip_whitespace();
+    if (static_cast<size_t>(end - current) < keyword.size() || std::string_view(current, keyword.size()) != keyword) {
+      return false;
+    }
+    current += keyword.size();
+    return current == end || is_whitespace(*current);
+  }
+
+  // Number followed by whitespace or the end of the text, leading whitespace (line breaks included) is skipped
+  template <typename T> [[nodiscard]] bool read_number(T &value) {
+    skip_whitespace();
+    if (current != end && *current == '+') current++; // std::from_chars does not accept a leading plus sign
+    auto [ptr, ec] = std::from_chars(current, end, value);
+    if (ec != std::errc() || (ptr != end && !is_whitespace(*ptr))) return false;
+    current = ptr;
+    return true;
+  }
+};
+
+// Parses a whole token as a number
+template <typename T> [[nodiscard]] bool parse_number(std::string_view token, T &value) {
+  if (!token.empty() && token.front() == '+') token.remove_prefix(1);
+  auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+  return ec == std::errc() && ptr == token.data() + token.size();
+}
@@ -0,0 +1,104 @@
+#include <algorithm> // for std::sort, std::unique and std::copy_n
+#include <cassert>
+#include <vector>
+
+#include "parallel.hpp"
+#include "vertex_adjacency.hpp"
+
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 16384;
+
+Vertex_Adjacency build_vertex_adjacency(size_t num_vertices, std::span<const unsigned int> indices) {
+  assert(indices.size() % 3 == 0);
+
+  // Count both directions of every triangle edge, shared edges are counted twice and deduplicated below, edges of
+  // degenerate triangles joining a vertex to itself are counted but skipped, so counts are upper bounds
+  std::vector<unsigned int> counts(num_vertices + 1, 0);
+  for (unsigned int vi : indices) {
+    counts[vi] += 2;
+  }
+  std::vector<unsigned int> offsets(num_vertices + 1, 0);
+  for (size_t i = 0; i < num_vertices; i++) {
+    offsets[i + 1] = offsets[i] + counts[i];
+  }
+
+  std::vector<unsigned int> neighbours(offsets.back());
+  std::vector<unsigned int> cursors(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    for (size_t j = 0; j < 3; j++) {
+      unsigned int a = indices[i + j];
+      unsigned int b = indices[i + (j + 1) % 3];
+      if (a == b) continue;
+      neighbours[cursors[a]++] = b;
+      neighbours[cursors[b]++] = a;
+    }
+  }
+
+  // Deduplicate each vertex's neighbours in place, up to its cursor, the unique count of each vertex is kept in counts
+  parallel_for(0, num_vertices, MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      auto first = neighbours.begin() + offsets[v];
+      auto last = neighbours.begin() + cursors[v];
+      std::sort(first, last);
+      counts[v] = static_cast<unsigned int>(std::unique(first, last) - first);
+    }
+  });
+
+  // Compact
+  Vertex_Adjacency adjacency;
+  adjacency.offsets.resize(num_vertices + 1, 0);
+  for (size_t v = 0; v < num_vertices; v++) {
+    adjacency.offsets[v + 1] = adjacency.offsets[v] + counts[v];
+  }
+  adjacency.neighbours.resize(adjacency.offsets.back());
+  parallel_for(0, num_vertices, MIN_PARALLEL_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; v++) {
+      std::copy_n(neighbours.begin() + offsets[v], counts[v], adjacency.neighbours.begin() + adjacency.offsets[v]);
+    }
+  });
+  return adjacency;
+}
+
+Vertex_Triangles build_vertex_triangles(size_t num_vertices, std::span<const unsigned int> indices) {
+  Vertex_Triangles vertex_triangles;
+  vertex_triangles.offsets.assign(num_vertices + 1, 0);
+  for (unsigned int vi : indices) {
+    vertex_triangles.offsets[vi + 1]++;
+  }
+  for (size_t v = 0; v < num_vertices; v++) {
+    vertex_triangles.offsets[v + 1] += vertex_triangles.offsets[v];
+  }
+  vertex_triangles.triangles.resize(indices.size());
+  std::vector<unsigned int> cursors(vertex_triangles.offsets.begin(), vertex_triangles.offsets.end() - 1);
+  for (size_t i = 0; i < indices.size(); i++) {
+    vertex_triangles.triangles[cursors[indices[i]]++] = static_cast<unsigned int>(i / 3);
+  }
+  return vertex_triangles;
+}
+
+#ifdef GEOBOX_TEST_VERTEX_ADJACENCY
+#include "testing.hpp"
+
+int main() {
+  // Two triangles sharing the edge 1-2
+  Vertex_Adjacency quad = build_vertex_adjacency(4, std::vector<unsigned int>{0, 1, 2, 2, 1, 3});
+  runtime_assert(quad.num_vertices() == 4);
+  runtime_assert(quad.offsets == std::vector<unsigned int>({0, 2, 5, 8, 10}));
+  runtime_assert(quad.neighbours == std::vector<unsigned int>({1, 2, 0, 2, 3, 0, 1, 3, 1, 2}));
+
+  // Degenerate triangles do not make vertices their own neighbours, a fully collapsed one adds no neighbours
+  Vertex_Adjacency degenerate = build_vertex_adjacency(4, std::vector<unsigned int>{0, 1, 2, 2, 2, 3, 3, 3, 3});
+  runtime_assert(degenerate.offsets == std::vector<unsigned int>({0, 2, 4, 7, 8}));
+  runtime_assert(degenerate.neighbours == std::vector<unsigned int>({1, 2, 0, 2, 0, 1, 3, 2}));
+  for (size_t v = 0; v < degenerate.num_vertices(); v++) {
+    for (unsigned int i = degenerate.offsets[v]; i < degenerate.offsets[v + 1]; i++) {
+      runtime_assert(degenerate.neighbours[i] != v);
+    }
+  }
+
+  // Triangles with repeated vertices are listed once per corner
+  Vertex_Triangles vertex_triangles = build_vertex_triangles(4, std::vector<unsigned int>{0, 1, 2, 2, 2, 3});
+  runtime_assert(vertex_triangles.offsets == std::vector<unsigned int>({0, 1, 2, 5, 6}));
+  runtime_assert(vertex_triangles.triangles == std::vector<unsigned int>({0, 0, 0, 1, 1, 1}));
+  return 0;
+}
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Compressed sparse row (CSR) vertex adjacency,
+// neighbours of vertex i are neighbours[offsets[i]], ..., neighbours[offsets[i + 1] - 1]
+struct Vertex_Adjacency {
+  std::vector<unsigned int> offsets;
+  std::vector<unsigned int> neighbours;
+
+  [[nodiscard]] size_t num_vertices() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+};
+
+// Vertices sharing a triangle edge are neighbours, each neighbour is listed once
+[[nodiscard]] Vertex_Adjacency build_vertex_adjacency(size_t num_vertices, std::span<const unsigned int> indices);
+
+// Triangles using each vertex in CSR form,
+// triangles of vertex i are triangles[offsets[i]], ..., triangles[offsets[i + 1] - 1]
+struct Vertex_Triangles {
+  std::vector<unsigned int> offsets;
+  std::vector<unsigned int> triangles;
+};
+
+// A triangle is listed once for each of its corners, so triangles with repeated vertices are listed repeatedly
+[[nodiscard]] Vertex_Triangles build_vertex_triangles(size_t num_vertices, std::span<const unsigned int> indices);
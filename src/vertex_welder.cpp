@@ -0,0 +1,148 @@
+#include <algorithm> // for std::min
+#include <cmath>     // for std::floor
+#include <utility>   // for std::move
+
+#include <glm/gtx/norm.hpp>
+
+#include "geobox_exceptions.hpp"
+#include "vertex_welder.hpp"
+
+// Keeps cell coordinates of huge (or infinite) coordinates within int64_t
+constexpr float MAX_CELL_COORDINATE = 1e18f;
+constexpr size_t MIN_NUM_SLOTS = 1024;
+
+Vertex_Welder::Vertex_Welder(float range, std::pmr::memory_resource *scratch_resource)
+    : m_range(range), m_inverse_cell_size(1.0f / (2.0f * range)), m_slots(MIN_NUM_SLOTS, EMPTY_SLOT, scratch_resource),
+      m_previous_in_cell(scratch_resource) {
+  if (!(range > 0.0f)) {
+    throw GeoBox_Error("Weld range must be positive");
+  }
+}
+
+void Vertex_Welder::reserve(size_t num_triangles) { m_indices.reserve(m_indices.size() + num_triangles * 3); }
+
+Vertex_Welder::Cell Vertex_Welder::calc_cell(const glm::vec3 &v) const {
+  auto to_cell_coordinate = [this](float x) {
+    float scaled = std::floor(x * m_inverse_cell_size);
+    if (!(scaled > -MAX_CELL_COORDINATE)) return static_cast<int64_t>(-MAX_CELL_COORDINATE); // Also NaN
+    return static_cast<int64_t>(std::min(scaled, MAX_CELL_COORDINATE));
+  };
+  return {to_cell_coordinate(v.x), to_cell_coordinate(v.y), to_cell_coordinate(v.z)};
+}
+
+// Slot holding the given cell, or the empty slot the cell would be inserted into
+size_t Vertex_Welder::find_slot(const Cell &cell) const {
+  auto hash = static_cast<uint64_t>(cell.x) * 73856093u ^ static_cast<uint64_t>(cell.y) * 19349663u ^
+              static_cast<uint64_t>(cell.z) * 83492791u;
+  hash ^= hash >> 29; // Mixes high bits into the masked low bits
+  size_t mask = m_slots.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    if (m_slots[i] == EMPTY_SLOT || calc_cell(m_vertices[m_slots[i]]) == cell) return i;
+  }
+}
+
+void Vertex_Welder::grow_slots() {
+  std::pmr::vector<unsigned int> old_slots(m_slots.size() * 2, EMPTY_SLOT, m_slots.get_allocator());
+  std::swap(m_slots, old_slots);
+  for (unsigned int vertex_index : old_slots) {
+    if (vertex_index != EMPTY_SLOT) m_slots[find_slot(calc_cell(m_vertices[vertex_index]))] = vertex_index;
+  }
+}
+
+unsigned int Vertex_Welder::add_vertex(const glm::vec3 &vertex) {
+  // Per axis, the neighbour cell on the side of the nearest cell boundary may also hold vertices within range
+  glm::vec3 scaled = vertex * m_inverse_cell_size;
+  Cell cell = calc_cell(vertex);
+  int64_t steps[3] = {
+      (scaled.x - std::floor(scaled.x) < 0.5f) ? -1 : 1,
+      (scaled.y - std::floor(scaled.y) < 0.5f) ? -1 : 1,
+      (scaled.z - std::floor(scaled.z) < 0.5f) ? -1 : 1,
+  };
+  unsigned int earliest = EMPTY_SLOT;
+  for (int i = 0; i < 8; i++) {
+    Cell neighbour_cell{
+        .x = cell.x + ((i & 1) ? steps[0] : 0),
+        .y = cell.y + ((i & 2) ? steps[1] : 0),
+        .z = cell.z + ((i & 4) ? steps[2] : 0),
+    };
+    for (unsigned int u = m_slots[find_slot(neighbour_cell)]; u != EMPTY_SLOT; u = m_previous_in_cell[u]) {
+      if (u < earliest && glm::distance2(vertex, m_vertices[u]) <= (m_range * m_range)) earliest = u;
+    }
+  }
+  if (earliest != EMPTY_SLOT) return earliest;
+
+  if (m_vertices.size() >= EMPTY_SLOT) {
+    throw Overflow_Check_Error("Too many unique vertices to weld");
+  }
+  auto new_index = static_cast<unsigned int>(m_vertices.size());
+  m_vertices.push_back(vertex);
+  size_t slot = find_slot(cell);
+  m_previous_in_cell.push_back(m_slots[slot]);
+  m_slots[slot] = new_index;
+  // Keeps load factor under 1 / 2, cells are at most as many as unique vertices
+  if (m_vertices.size() * 2 > m_slots.size()) grow_slots();
+  return new_index;
+}
+
+void Vertex_Welder::add_triangle(const Triangle &triangle) {
+  for (int i = 0; i < 3; i++) {
+    m_indices.push_back(add_vertex(triangle[i]));
+  }
+}
+
+Indexed_Triangle_Mesh Vertex_Welder::finish() {
+  m_vertices.shrink_to_fit();
+  Indexed_Triangle_Mesh mesh{.vertices = std::move(m_vertices), .indices = std::move(m_indices)};
+  m_vertices.clear();
+  m_indices.clear();
+  m_previous_in_cell.clear();
+  m_slots.assign(MIN_NUM_SLOTS, EMPTY_SLOT);
+  return mesh;
+}
+
+#ifdef GEOBOX_TEST_VERTEX_WELDER
+#include <random>
+
+#include "testing.hpp"
+
+int main() {
+  // Clusters of nearby points, some closer than the weld range and some just outside it
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> center_distribution(-10.0f, 10.0f);
+  std::uniform_real_distribution<float> offset_distribution(-1.5f * DEFAULT_WELD_RANGE, 1.5f * DEFAULT_WELD_RANGE);
+  std::vector<glm::vec3> points;
+  for (int c = 0; c < 300; c++) {
+    glm::vec3 center(center_distribution(rng), center_distribution(rng), center_distribution(rng));
+    for (int i = 0; i < 6; i++) {
+      glm::vec3 offset(offset_distribution(rng), offset_distribution(rng), offset_distribution(rng));
+      points.push_back(center + offset);
+    }
+  }
+  std::shuffle(points.begin(), points.end(), rng);
+  while (points.size() % 3 != 0) points.pop_back();
+
+  Vertex_Welder welder;
+  for (size_t i = 0; i < points.size(); i += 3) {
+    welder.add_triangle({points[i], points[i + 1], points[i + 2]});
+  }
+  Indexed_Triangle_Mesh mesh = welder.finish();
+  runtime_assert(mesh.indices.size() == points.size());
+
+  // Same result as greedily welding in order by brute force
+  std::vector<glm::vec3> expected_vertices;
+  for (size_t i = 0; i < points.size(); i++) {
+    unsigned int expected_index = static_cast<unsigned int>(expected_vertices.size());
+    for (unsigned int u = 0; u < expected_vertices.size(); u++) {
+      if (glm::distance2(points[i], expected_vertices[u]) <= DEFAULT_WELD_RANGE * DEFAULT_WELD_RANGE) {
+        expected_index = u;
+        break;
+      }
+    }
+    if (expected_index == expected_vertices.size()) expected_vertices.push_back(points[i]);
+    runtime_assert(mesh.indices[i] == expected_index);
+  }
+  runtime_assert(mesh.vertices == expected_vertices);
+  runtime_assert(expected_vertices.size() < points.size());
+  return 0;
+}
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "indexed_triangle_mesh.hpp"
+#include "primitives.hpp"
+
+constexpr float DEFAULT_WELD_RANGE = 0.0001f;
+
+// Incrementally welds vertices fed one triangle at a time, only the unique vertices and the indices are stored,
+// a vertex is welded to the earliest unique vertex within range, otherwise it becomes a new unique vertex
+class Vertex_Welder {
+private:
+  float m_range;
+  // Grid cells are twice the range wide, so vertices within range of a point lie in at most 8 cells around it
+  float m_inverse_cell_size;
+  std::vector<glm::vec3> m_vertices;
+  std::vector<unsigned int> m_indices;
+  // Open addressing hash table of grid cells, each slot holds the last unique vertex added to a cell or EMPTY_SLOT,
+  // the cell of a slot is recomputed from its vertex instead of being stored
+  std::pmr::vector<unsigned int> m_slots;
+  // Previous unique vertex in the same cell or EMPTY_SLOT
+  std::pmr::vector<unsigned int> m_previous_in_cell;
+
+  static constexpr unsigned int EMPTY_SLOT = UINT32_MAX;
+
+  struct Cell {
+    int64_t x, y, z;
+    bool operator==(const Cell &) const = default;
+  };
+
+  [[nodiscard]] Cell calc_cell(const glm::vec3 &v) const;
+  [[nodiscard]] size_t find_slot(const Cell &cell) const;
+  void grow_slots();
+
+public:
+  // Grid cells are only needed while welding, so they can live in a scratch arena that outlives the welder
+  explicit Vertex_Welder(float range = DEFAULT_WELD_RANGE,
+                         std::pmr::memory_resource *scratch_resource = std::pmr::get_default_resource());
+
+  // Number of triangles about to be added, avoids reallocations of indices
+  void reserve(size_t num_triangles);
+  void add_triangle(const Triangle &triangle);
+  [[nodiscard]] unsigned int add_vertex(const glm::vec3 &vertex);
+
+  [[nodiscard]] size_t get_num_unique_vertices() const { return m_vertices.size(); }
+
+  // Moves welded mesh out of the welder, leaving it empty
+  [[nodiscard]] Indexed_Triangle_Mesh finish();
+};
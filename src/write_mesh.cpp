@@ -0,0 +1,239 @@
+#include <algorithm> // for std::min
+#include <array>
+#include <bit>      // for std::endian
+#include <charconv> // for std::to_chars
+#include <cstdint>
+#include <cstring>  // for std::memcpy
+#include <fstream>  // for std::ofstream
+#include <iostream> // for std::cerr and std::endl
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "indexed_triangle_mesh.hpp"
+#include "parallel.hpp"
+#include "write_mesh.hpp"
+
+// Items formatted in memory before being written with one call, bounds memory used by formatted output
+constexpr size_t WRITE_BLOCK_SIZE = 1 << 18;
+constexpr size_t MIN_PARALLEL_CHUNK_SIZE = 4096;
+
+constexpr size_t BINARY_STL_HEADER_SIZE = 80;
+constexpr size_t BINARY_STL_TRIANGLE_RECORD_SIZE = sizeof(float[4][3]) + sizeof(uint16_t);
+constexpr size_t PLY_FACE_RECORD_SIZE = sizeof(uint8_t) + sizeof(uint32_t[3]);
+
+// Binary formats are written by copying floats and integers as is
+static_assert(std::endian::native == std::endian::little, "Binary STL and PLY files are written little endian");
+
+namespace {
+// Writes blocks of items formatted in parallel, chunk buffers are reused across blocks
+class Block_Writer {
+private:
+  std::ofstream &m_ofs;
+  std::vector<std::string> m_chunk_buffers;
+
+public:
+  explicit Block_Writer(std::ofstream &ofs) : m_ofs(ofs) {}
+
+  // Calls format_chunk(begin, end, buffer) to append items [begin, end) to buffer, buffers are written in order,
+  // stops at the first failed write, which leaves the stream in a failed state
+  template <typename Format_Chunk_Type> void write(size_t num_items, const Format_Chunk_Type &format_chunk) {
+    for (size_t block_begin = 0; block_begin < num_items && m_ofs; block_begin += WRITE_BLOCK_SIZE) {
+      size_t block_size = std::min(WRITE_BLOCK_SIZE, num_items - block_begin);
+      size_t num_chunks = calc_num_parallel_chunks(block_size, MIN_PARALLEL_CHUNK_SIZE);
+      if (m_chunk_buffers.size() < num_chunks) m_chunk_buffers.resize(num_chunks);
+      parallel_for_chunks(block_size, num_chunks, [&](size_t chunk_index, size_t begin, size_t end) {
+        m_chunk_buffers[chunk_index].clear();
+        format_chunk(block_begin + begin, block_begin + end, m_chunk_buffers[chunk_index]);
+      });
+      for (size_t i = 0; i < num_chunks; i++) {
+        m_ofs.write(m_chunk_buffers[i].data(), static_cast<std::streamsize>(m_chunk_buffers[i].size()));
+      }
+    }
+  }
+};
+} // namespace
+
+[[nodiscard]] static glm::vec3 calc_triangle_normal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+  glm::vec3 normal = glm::cross(b - a, c - a);
+  float length = glm::length(normal);
+  return (length > 0.0f) ? normal / length : glm::vec3(0.0f);
+}
+
+template <typename T> static void append_bytes(std::string &buffer, const T &value) {
+  buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static void append_floats(std::string &buffer, const glm::vec3 &v) {
+  // Longest shortest round trip float is 15 characters (e.g. -1.17549435e-38), plus separators
+  std::array<char, 64> chars;
+  char *current = chars.data();
+  for (int i = 0; i < 3; i++) {
+    *current++ = ' ';
+    current = std::to_chars(current, chars.data() + chars.size(), v[i]).ptr;
+  }
+  buffer.append(chars.data(), current);
+}
+
+[[nodiscard]] static bool open_output_file(const std::string &file_path, std::ofstream &ofs) {
+  ofs.open(file_path, std::ofstream::binary | std::ofstream::trunc);
+  if (!ofs.is_open()) {
+    std::cerr << "Failed to open file for writing: " << file_path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+[[nodiscard]] static bool report_write_result(const std::string &file_path, std::ofstream &ofs) {
+  ofs.close();
+  if (!ofs) {
+    std::cerr << "Failed to write file: " << file_path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool write_stl_mesh_file_binary(const std::string &file_path, const Indexed_Triangle_Mesh &mesh) {
+  size_t num_triangles = mesh.indices.size() / 3;
+  if (num_triangles > UINT32_MAX) {
+    std::cerr << "Too many triangles for a binary STL file: " << num_triangles << std::endl;
+    return false;
+  }
+  std::ofstream ofs;
+  if (!open_output_file(file_path, ofs)) return false;
+
+  std::array<char, BINARY_STL_HEADER_SIZE> header{};
+  std::string header_text = "Binary STL exported by GeoBox";
+  std::memcpy(header.data(), header_text.data(), header_text.size());
+  ofs.write(header.data(), header.size());
+  auto num_triangles_u32 = static_cast<uint32_t>(num_triangles);
+  ofs.write(reinterpret_cast<const char *>(&num_triangles_u32), sizeof(uint32_t));
+
+  Block_Writer writer(ofs);
+  writer.write(num_triangles, [&mesh](size_t begin, size_t end, std::string &buffer) {
+    buffer.reserve((end - begin) * BINARY_STL_TRIANGLE_RECORD_SIZE);
+    for (size_t t = begin; t < end; t++) {
+      const glm::vec3 &a = mesh.vertices[mesh.indices[t * 3 + 0]];
+      const glm::vec3 &b = mesh.vertices[mesh.indices[t * 3 + 1]];
+      const glm::vec3 &c = mesh.vertices[mesh.indices[t * 3 + 2]];
+      append_bytes(buffer, calc_triangle_normal(a, b, c));
+      append_bytes(buffer, a);
+      append_bytes(buffer, b);
+      append_bytes(buffer, c);
+      append_bytes(buffer, uint16_t(0)); // "attribute byte count"
+    }
+  });
+  return report_write_result(file_path, ofs);
+}
+
+bool write_stl_mesh_file_ascii(const std::string &file_path, const Indexed_Triangle_Mesh &mesh) {
+  std::ofstream ofs;
+  if (!open_output_file(file_path, ofs)) return false;
+
+  ofs << "solid geobox\n";
+  Block_Writer writer(ofs);
+  writer.write(mesh.indices.size() / 3, [&mesh](size_t begin, size_t end, std::string &buffer) {
+    for (size_t t = begin; t < end; t++) {
+      const glm::vec3 &a = mesh.vertices[mesh.indices[t * 3 + 0]];
+      const glm::vec3 &b = mesh.vertices[mesh.indices[t * 3 + 1]];
+      const glm::vec3 &c = mesh.vertices[mesh.indices[t * 3 + 2]];
+      buffer += "facet normal";
+      append_floats(buffer, calc_triangle_normal(a, b, c));
+      buffer += "\n outer loop\n  vertex";
+      append_floats(buffer, a);
+      buffer += "\n  vertex";
+      append_floats(buffer, b);
+      buffer += "\n  vertex";
+      append_floats(buffer, c);
+      buffer += "\n endloop\nendfacet\n";
+    }
+  });
+  ofs << "endsolid geobox\n";
+  return report_write_result(file_path, ofs);
+}
+
+bool write_ply_file(const std::string &file_path, const std::vector<glm::vec3> &vertices,
+                    const std::vector<unsigned int> &indices) {
+  std::ofstream ofs;
+  if (!open_output_file(file_path, ofs)) return false;
+
+  ofs << "ply\n"
+      << "format binary_little_endian 1.0\n"
+      << "comment exported by GeoBox\n"
+      << "element vertex " << vertices.size() << "\n"
+      << "property float x\n"
+      << "property float y\n"
+      << "property float z\n";
+  if (!indices.empty()) {
+    ofs << "element face " << indices.size() / 3 << "\n"
+        << "property list uchar uint vertex_indices\n";
+  }
+  ofs << "end_header\n";
+
+  // Vertices are already laid out as in the file
+  static_assert(sizeof(glm::vec3) == sizeof(float[3]));
+  ofs.write(reinterpret_cast<const char *>(vertices.data()),
+            static_cast<std::streamsize>(vertices.size() * sizeof(glm::vec3)));
+
+  Block_Writer writer(ofs);
+  writer.write(indices.size() / 3, [&indices](size_t begin, size_t end, std::string &buffer) {
+    buffer.reserve((end - begin) * PLY_FACE_RECORD_SIZE);
+    for (size_t t = begin; t < end; t++) {
+      append_bytes(buffer, uint8_t(3));
+      for (size_t k = 0; k < 3; k++) {
+        append_bytes(buffer, static_cast<uint32_t>(indices[t * 3 + k]));
+      }
+    }
+  });
+  return report_write_result(file_path, ofs);
+}
+
+#ifdef GEOBOX_TEST_WRITE_MESH
+#include <cstdio>     // for std::remove
+#include <filesystem> // for std::filesystem::temp_directory_path and std::filesystem::file_size
+
+#include "read_stl.hpp"
+#include "testing.hpp"
+
+int main() {
+  // Tetrahedron with coordinates that have no short decimal representation
+  Indexed_Triangle_Mesh mesh{
+      .vertices = {{0, 0, 0}, {1.0f / 3.0f, 0, 0}, {0, 0.1f, 0}, {0, 0, -0.7f}},
+      .indices = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3},
+  };
+  std::filesystem::path directory = std::filesystem::temp_directory_path();
+
+  for (bool is_binary : {true, false}) {
+    std::string file_path = (directory / (is_binary ? "geobox_test_binary.stl" : "geobox_test_ascii.stl")).string();
+    runtime_assert(is_binary ? write_stl_mesh_file_binary(file_path, mesh)
+                             : write_stl_mesh_file_ascii(file_path, mesh));
+    if (is_binary) runtime_assert(std::filesystem::file_size(file_path) == 84 + 4 * 50);
+    // Both formats read back exactly
+    std::optional<Indexed_Triangle_Mesh> read_mesh = read_stl_mesh_file_welded(file_path);
+    runtime_assert(read_mesh.has_value() && read_mesh->indices.size() == mesh.indices.size());
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+      runtime_assert(read_mesh->vertices[read_mesh->indices[i]] == mesh.vertices[mesh.indices[i]]);
+    }
+    std::remove(file_path.c_str());
+  }
+
+  std::string ply_file_path = (directory / "geobox_test.ply").string();
+  runtime_assert(write_ply_file(ply_file_path, mesh.vertices, mesh.indices));
+  std::ifstream ifs(ply_file_path, std::ifstream::binary);
+  std::string line;
+  size_t header_size = 0;
+  while (std::getline(ifs, line)) {
+    header_size += line.size() + 1;
+    if (line == "end_header") break;
+  }
+  runtime_assert(line == "end_header");
+  runtime_assert(std::filesystem::file_size(ply_file_path) == header_size + 4 * 12 + 4 * 13);
+  std::vector<glm::vec3> read_vertices(4);
+  ifs.read(reinterpret_cast<char *>(read_vertices.data()), 4 * sizeof(glm::vec3));
+  runtime_assert(read_vertices == mesh.vertices);
+  ifs.close();
+  std::remove(ply_file_path.c_str());
+  return 0;
+}
+#endif
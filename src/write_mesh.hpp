@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "indexed_triangle_mesh.hpp"
+
+// Writers return false and report to std::cerr on failure, existing files are overwritten
+
+[[nodiscard]] bool write_stl_mesh_file_binary(const std::string &file_path, const Indexed_Triangle_Mesh &mesh);
+
+// Coordinates are written in their shortest form that reads back as the exact same float
+[[nodiscard]] bool write_stl_mesh_file_ascii(const std::string &file_path, const Indexed_Triangle_Mesh &mesh);
+
+// Binary little endian PLY, with no faces for point clouds (empty indices)
+[[nodiscard]] bool write_ply_file(const std::string &file_path, const std::vector<glm::vec3> &vertices,
+                                  const std::vector<unsigned int> &indices);